@@ -0,0 +1,131 @@
+/*
+ * Benchmark text and binary transfer of values between connections.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "block.h"
+#include "valuearray.h"
+#include "valuestat.h"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+// a device info round: many scalars, an array and a statistics value
+#define DOUBLES   50
+#define ARRAY     200
+#define ROUNDS    5000
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+class BenchBlock:public rts2core::Block
+{
+	public:
+		BenchBlock ():rts2core::Block (0, NULL) { setTimeout (USEC_SEC / 100); }
+
+		virtual rts2core::Connection *createClientConnection (rts2core::NetworkAddress *in_addr) { return NULL; }
+		virtual int run () { return 0; }
+};
+
+static double transfer (bool binary, size_t &values)
+{
+	int sv[2];
+	if (socketpair (AF_UNIX, SOCK_STREAM, 0, sv))
+	{
+		std::cerr << "cannot create socket pair" << std::endl;
+		exit (1);
+	}
+
+	BenchBlock block;
+	rts2core::Connection *sender = new rts2core::Connection (sv[0], &block);
+	rts2core::Connection *receiver = new rts2core::Connection (sv[1], &block);
+	block.addConnection (receiver);
+
+	std::vector <rts2core::Value *> vals;
+	for (int i = 0; i < DOUBLES; i++)
+	{
+		std::ostringstream os;
+		os << "double_" << i;
+		vals.push_back (new rts2core::ValueDouble (os.str (), "", false));
+	}
+	rts2core::DoubleArray *arr = new rts2core::DoubleArray ("array", "", false);
+	vals.push_back (arr);
+	rts2core::ValueDoubleStat *stat = new rts2core::ValueDoubleStat ("stat", "", false);
+	vals.push_back (stat);
+	rts2core::ValueInteger *round = new rts2core::ValueInteger ("round", "", false);
+	vals.push_back (round);
+
+	for (std::vector <rts2core::Value *>::iterator iter = vals.begin (); iter != vals.end (); iter++)
+		receiver->metaInfo ((*iter)->getFlags (), (*iter)->getName (), "");
+
+	sender->setBinaryValues (binary);
+
+	srandom (42);
+	values = 0;
+
+	double t = now ();
+	for (int r = 1; r <= ROUNDS; r++)
+	{
+		for (int i = 0; i < DOUBLES; i++)
+			((rts2core::ValueDouble *) vals[i])->setValueDouble (random () / 1000.0);
+		arr->clear ();
+		for (int i = 0; i < ARRAY; i++)
+			arr->addValue (random () / 1000.0);
+		stat->addValue (random () / 1000.0);
+		stat->calculate ();
+		round->setValueInteger (r);
+
+		sender->startValueBatch ();
+		for (std::vector <rts2core::Value *>::iterator iter = vals.begin (); iter != vals.end (); iter++)
+			(*iter)->send (sender);
+		sender->endValueBatch ();
+		values += vals.size ();
+
+		while (receiver->getValueInteger ("round") != r)
+			block.oneRunLoop ();
+	}
+	t = now () - t;
+
+	for (std::vector <rts2core::Value *>::iterator iter = vals.begin (); iter != vals.end (); iter++)
+		delete *iter;
+	delete sender;
+
+	return t;
+}
+
+int main (int argc, char **argv)
+{
+	size_t values;
+
+	double tt = transfer (false, values);
+	std::cout << "text   " << values << " values in " << tt << " s, " << values / tt << " values/s" << std::endl;
+
+	double tb = transfer (true, values);
+	std::cout << "binary " << values << " values in " << tb << " s, " << values / tb << " values/s" << std::endl;
+
+	std::cout << "speedup " << tt / tb << std::endl;
+	return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * Benchmark centrald blocking matrix against per-connection blockDevice calls.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "../src/centrald/blockmatrix.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+// simulates 100 devices changing BOP state, as centrald does on every state change
+
+#define DEVICES   100
+#define CHANGES   1000
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static std::string devName (int i)
+{
+	std::ostringstream os;
+	os << "DEV" << i;
+	return os.str ();
+}
+
+int main (int argc, char **argv)
+{
+	char fn[] = "/tmp/bench_blockmatrixXXXXXX";
+	int fd = mkstemp (fn);
+	if (fd < 0)
+	{
+		perror ("mkstemp");
+		return 1;
+	}
+	close (fd);
+
+	// every third device is blocked only by devices with lower number divisible by 5
+	std::ofstream cfg (fn);
+	cfg << "[observatory]" << std::endl << "longitude = 15" << std::endl << "latitude = 50" << std::endl << "altitude = 500" << std::endl;
+	for (int i = 0; i < DEVICES; i += 3)
+	{
+		cfg << "[" << devName (i) << "]" << std::endl << "blocked_by =";
+		for (int j = 0; j < i; j += 5)
+			cfg << " " << devName (j);
+		cfg << std::endl;
+	}
+	cfg.close ();
+
+	rts2core::IniParser config;
+	if (config.loadFile (fn))
+	{
+		std::cerr << "cannot load " << fn << std::endl;
+		unlink (fn);
+		return 1;
+	}
+	unlink (fn);
+
+	std::vector <std::string> names;
+	std::vector <rts2_status_t> bops (DEVICES, 0);
+	rts2centrald::BlockMatrix matrix;
+	for (int i = 0; i < DEVICES; i++)
+	{
+		names.push_back (devName (i));
+		matrix.addSlot (names[i].c_str (), &config);
+	}
+
+	srandom (42);
+	std::vector <int> changes;
+	for (int c = 0; c < CHANGES; c++)
+		changes.push_back (random () % DEVICES);
+
+	// old code path - each change recomputes BOP of every device by walking all connections
+	double t = now ();
+	long sum_old = 0;
+	for (int c = 0; c < CHANGES; c++)
+	{
+		int d = changes[c];
+		bops[d] = bops[d] ? 0 : BOP_EXPOSURE;
+		for (int i = 0; i < DEVICES; i++)
+		{
+			rts2_status_t sta = 0;
+			for (int j = 0; j < DEVICES; j++)
+			{
+				if (config.blockDevice (names[i].c_str (), names[j].c_str ()) == false)
+					continue;
+				sta |= bops[j];
+			}
+			sum_old += sta;
+		}
+	}
+	double t_old = now () - t;
+
+	// blocking matrix - only dependent devices are recomputed
+	std::fill (bops.begin (), bops.end (), 0);
+	t = now ();
+	long sum_new = 0;
+	int sent = 0;
+	for (int c = 0; c < CHANGES; c++)
+	{
+		int d = changes[c];
+		bops[d] = bops[d] ? 0 : BOP_EXPOSURE;
+		std::vector <int> dependents;
+		matrix.setBopState (d, bops[d], dependents);
+		sent += dependents.size ();
+		for (int i = 0; i < DEVICES; i++)
+			sum_new += matrix.getBopFor (i);
+	}
+	double t_new = now () - t;
+
+	std::cout << "devices " << DEVICES << " state changes " << CHANGES << std::endl
+		<< "blockDevice loop " << t_old << " s, " << (CHANGES / t_old) << " changes/s" << std::endl
+		<< "blocking matrix  " << t_new << " s, " << (CHANGES / t_new) << " changes/s, " << sent << " BOP messages" << std::endl;
+
+	if (sum_old != sum_new)
+	{
+		std::cerr << "BOP states differ: " << sum_old << " " << sum_new << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * Benchmark allocation of image buffers.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "bufferpool.h"
+
+#include <iostream>
+
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+// 4k x 4k 16 bit frames, each received and copied to channel
+#define FRAME     (4096 * 4096 * 2 + 1024)
+#define FRAMES    50
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static long minorFaults ()
+{
+	struct rusage ru;
+	getrusage (RUSAGE_SELF, &ru);
+	return ru.ru_minflt;
+}
+
+// simulates readout to a buffer and copy of data to the channel
+static void exposure (char *readout, char *channel, int i)
+{
+	memset (readout, i, FRAME);
+	memcpy (channel, readout, FRAME);
+}
+
+int main (int argc, char **argv)
+{
+	long f = minorFaults ();
+	double t = now ();
+	for (int i = 0; i < FRAMES; i++)
+	{
+		char *readout = new char[FRAME];
+		char *channel = new char[FRAME];
+		exposure (readout, channel, i);
+		delete[] channel;
+		delete[] readout;
+	}
+	t = now () - t;
+	std::cout << "new/delete  " << t / FRAMES * 1000 << " ms/frame, " << (minorFaults () - f) / FRAMES << " page faults/frame" << std::endl;
+
+	rts2core::BufferPool &pool = rts2core::BufferPool::instance ();
+	f = minorFaults ();
+	t = now ();
+	for (int i = 0; i < FRAMES; i++)
+	{
+		char *readout = (char *) pool.allocate (FRAME);
+		char *channel = (char *) pool.allocate (FRAME);
+		exposure (readout, channel, i);
+		pool.release (channel);
+		pool.release (readout);
+	}
+	t = now () - t;
+	std::cout << "buffer pool " << t / FRAMES * 1000 << " ms/frame, " << (minorFaults () - f) / FRAMES << " page faults/frame" << std::endl;
+
+	rts2core::BufferPoolStats st;
+	pool.getStats (st);
+	std::cout << "pool hits " << st.hits << " misses " << st.misses << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Benchmark assembly of multi-channel images.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "rts2fits/image.h"
+
+#include <iostream>
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+// 16 amplifiers, each 1024x1024 USHORT, as produced by rts2-camd-dummy --channels 16
+
+#define CHANNELS  16
+#define WIDTH     1024
+#define HEIGHT    1024
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void fillChannels (rts2core::DataChannels &data)
+{
+	size_t chansize = sizeof (struct imghdr) + WIDTH * HEIGHT * sizeof (uint16_t);
+	srandom (42);
+	for (int ch = 0; ch < CHANNELS; ch++)
+	{
+		char *buf = new char[chansize];
+		struct imghdr *imgh = (struct imghdr *) buf;
+		imgh->data_type = htons (RTS2_DATA_USHORT);
+		imgh->flags = 0;
+		imgh->naxes = 2;
+		imgh->sizes[0] = htonl (WIDTH);
+		imgh->sizes[1] = htonl (HEIGHT);
+		imgh->binnings[0] = htons (1);
+		imgh->binnings[1] = htons (1);
+		imgh->filter = 0;
+		imgh->shutter = 0;
+		imgh->x = htons ((ch % 4) * WIDTH);
+		imgh->y = htons ((ch / 4) * HEIGHT);
+		imgh->channel = htons (ch + 1);
+
+		uint16_t *pix = (uint16_t *) (buf + sizeof (struct imghdr));
+		for (size_t i = 0; i < WIDTH * HEIGHT; i++)
+			pix[i] = 1000 + ch * 10 + random () % 50;
+
+		rts2core::DataRead *dr = new rts2core::DataRead (chansize, RTS2_DATA_USHORT);
+		dr->setChunkSizeFromData ();
+		dr->addData (buf, chansize);
+		data.push_back (dr);
+		delete[] buf;
+	}
+}
+
+static double writeImage (rts2core::DataChannels &data, const char *fn, bool parallel, off_t *fsize)
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+
+	rts2image::Image *image = new rts2image::Image (fn, &tv, true, false, true);
+
+	double t = now ();
+	if (parallel)
+	{
+		std::vector <rts2image::Channel *> added;
+		image->addChannels (&data, added, sysconf (_SC_NPROCESSORS_ONLN));
+		for (size_t i = 0; i < data.size (); i++)
+			image->writeChannel (added[i], data[i]->getDataBuff (), data[i]->getDataTop (), data.size ());
+	}
+	else
+	{
+		for (rts2core::DataChannels::iterator di = data.begin (); di != data.end (); di++)
+			image->writeData ((*di)->getDataBuff (), (*di)->getDataTop (), data.size ());
+	}
+	image->closeFile ();
+	t = now () - t;
+
+	struct stat st;
+	*fsize = (image->getChannelSize () == CHANNELS && stat (fn, &st) == 0) ? st.st_size : -1;
+
+	delete image;
+	unlink (fn);
+	return t;
+}
+
+int main (int argc, char **argv)
+{
+	rts2core::DataChannels data;
+	fillChannels (data);
+
+	off_t s_size, p_size;
+	double t_serial = writeImage (data, "/tmp/bench_channels_serial.fits", false, &s_size);
+	double t_parallel = writeImage (data, "/tmp/bench_channels_parallel.fits", true, &p_size);
+
+	std::cout << CHANNELS << " channels " << WIDTH << "x" << HEIGHT << std::endl
+		<< "serial " << t_serial << " s" << std::endl
+		<< "parallel " << t_parallel << " s, speedup " << t_serial / t_parallel << std::endl;
+
+	if (s_size <= 0 || s_size != p_size)
+	{
+		std::cerr << "serial and parallel images differ: " << s_size << " " << p_size << " bytes" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Benchmark cone search using sky pixels against full scan.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "skypix.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <libnova/libnova.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+// Synthetic catalogue of uniformly distributed positions, sorted by pixel
+// as a B-tree index on the pixel column would be. Indexed search finds
+// the pixel ranges by binary search and checks distance only on
+// candidates, as the database does with the pixel condition.
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+struct Entry
+{
+	int pix;
+	struct ln_equ_posn pos;
+
+	bool operator < (const Entry &e) const { return pix < e.pix; }
+};
+
+static bool pixLess (const Entry &e, int pix)
+{
+	return e.pix < pix;
+}
+
+int main (int argc, char **argv)
+{
+	int n = argc > 1 ? atoi (argv[1]) : 1000000;
+	double radius = argc > 2 ? atof (argv[2]) : 0.5;
+	int queries = argc > 3 ? atoi (argv[3]) : 200;
+
+	srandom (1);
+
+	std::vector <Entry> catalogue (n);
+	for (int i = 0; i < n; i++)
+	{
+		catalogue[i].pos.ra = random () / (double) RAND_MAX * 360.0;
+		// uniform on sphere
+		catalogue[i].pos.dec = asin (random () / (double) RAND_MAX * 2.0 - 1.0) * 180.0 / M_PI;
+		catalogue[i].pix = skypix (catalogue[i].pos.ra, catalogue[i].pos.dec);
+	}
+	std::sort (catalogue.begin (), catalogue.end ());
+
+	std::vector <struct ln_equ_posn> centers (queries);
+	for (int i = 0; i < queries; i++)
+	{
+		centers[i].ra = random () / (double) RAND_MAX * 360.0;
+		centers[i].dec = asin (random () / (double) RAND_MAX * 2.0 - 1.0) * 180.0 / M_PI;
+	}
+
+	long found_scan = 0;
+	double t = now ();
+	for (int i = 0; i < queries; i++)
+	{
+		for (std::vector <Entry>::iterator iter = catalogue.begin (); iter != catalogue.end (); iter++)
+		{
+			if (ln_get_angular_separation (&(centers[i]), &(iter->pos)) < radius)
+				found_scan++;
+		}
+	}
+	double t_scan = now () - t;
+
+	long found_pix = 0;
+	long candidates = 0;
+	size_t ranges_total = 0;
+	t = now ();
+	for (int i = 0; i < queries; i++)
+	{
+		rts2core::SkyPixRanges ranges;
+		rts2core::skyPixRanges (centers[i].ra, centers[i].dec, radius, ranges);
+		ranges_total += ranges.size ();
+		for (rts2core::SkyPixRanges::iterator r = ranges.begin (); r != ranges.end (); r++)
+		{
+			std::vector <Entry>::iterator iter = std::lower_bound (catalogue.begin (), catalogue.end (), r->first, pixLess);
+			for (; iter != catalogue.end () && iter->pix <= r->second; iter++)
+			{
+				candidates++;
+				if (ln_get_angular_separation (&(centers[i]), &(iter->pos)) < radius)
+					found_pix++;
+			}
+		}
+	}
+	double t_pix = now () - t;
+
+	std::cout << n << " positions, " << queries << " cones of radius " << radius << " deg" << std::endl
+		<< "full scan " << t_scan << " s, " << found_scan << " found" << std::endl
+		<< "sky pixels " << t_pix << " s, " << found_pix << " found, " << candidates << " candidates, "
+		<< (double) ranges_total / queries << " ranges per cone, speedup " << t_scan / t_pix << std::endl;
+
+	if (found_scan != found_pix)
+	{
+		std::cerr << "results differ" << std::endl;
+		return 1;
+	}
+	return 0;
+}
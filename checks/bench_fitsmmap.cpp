@@ -0,0 +1,115 @@
+/*
+ * Benchmark loading of FITS channels, read through CFITSIO and mapped from file.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "rts2fits/image.h"
+
+#include <iostream>
+
+#include <math.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+// 7240x7240 USHORT image, 100 MB of pixel data
+
+#define WIDTH     7240
+#define HEIGHT    7240
+
+#define FILENAME  "/tmp/bench_fitsmmap.fits"
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static int createFile ()
+{
+	fitsfile *fptr;
+	int status = 0;
+	long sizes[2] = {WIDTH, HEIGHT};
+
+	unlink (FILENAME);
+	fits_create_file (&fptr, FILENAME, &status);
+	fits_create_img (fptr, USHORT_IMG, 2, sizes, &status);
+
+	uint16_t *row = new uint16_t[WIDTH];
+	srandom (42);
+	for (long y = 0; y < HEIGHT && status == 0; y++)
+	{
+		for (long x = 0; x < WIDTH; x++)
+			row[x] = 1000 + random () % 50000;
+		fits_write_img_usht (fptr, 0, y * WIDTH + 1, WIDTH, row, &status);
+	}
+	delete[] row;
+
+	fits_close_file (fptr, &status);
+	return status;
+}
+
+/**
+ * Load image, compute statistics and optionally get data in native representation.
+ */
+static double loadImage (bool map, bool getData, double &average)
+{
+	double t = now ();
+
+	rts2image::Image image;
+	image.setMapChannels (map);
+	image.openFile (FILENAME, true, false);
+	image.computeStatistics ();
+	average = image.getAverage ();
+	if (getData && image.getChannelData (0) == NULL)
+		average = NAN;
+
+	return now () - t;
+}
+
+int main (int argc, char **argv)
+{
+	if (createFile ())
+	{
+		std::cerr << "cannot create " << FILENAME << std::endl;
+		return 1;
+	}
+
+	double a_read, a_map, a_mapdata;
+
+	// first load brings file to page cache
+	loadImage (false, false, a_read);
+
+	double t_read = loadImage (false, false, a_read);
+	double t_map = loadImage (true, false, a_map);
+	double t_mapdata = loadImage (true, true, a_mapdata);
+
+	unlink (FILENAME);
+
+	std::cout << WIDTH << "x" << HEIGHT << " USHORT image" << std::endl
+		<< "CFITSIO read + statistics " << t_read << " s" << std::endl
+		<< "mapped statistics " << t_map << " s, speedup " << t_read / t_map << std::endl
+		<< "mapped statistics + native data " << t_mapdata << " s, speedup " << t_read / t_mapdata << std::endl;
+
+	if (a_read != a_map || a_read != a_mapdata)
+	{
+		std::cerr << "averages differ: " << a_read << " " << a_map << " " << a_mapdata << std::endl;
+		return 1;
+	}
+	return 0;
+}
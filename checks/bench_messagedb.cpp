@@ -0,0 +1,84 @@
+/*
+ * Benchmark writing of messages into the database.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "rts2db/messagesink.h"
+
+#include <iostream>
+#include <sstream>
+
+#include <stdlib.h>
+#include <sys/time.h>
+
+// Needs running PostgreSQL with RTS2 database. Run as
+//   bench_messagedb [database] [number of messages]
+// Messages are inserted with originator msgbench; delete them with
+//   DELETE FROM message WHERE message_oname = 'msgbench';
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * Push messages to the sink, returns messages per second written to the database.
+ *
+ * @param unique  number of different message texts; low numbers simulate message storm
+ */
+static double run (const char *db, const char *name, int count, size_t batchSize, double duplicateWindow, int unique)
+{
+	rts2db::MessageSink sink (db, count + 100, batchSize, 1, duplicateWindow);
+	if (sink.start ())
+	{
+		std::cerr << "cannot connect to database " << db << std::endl;
+		exit (1);
+	}
+
+	double t = now ();
+	for (int i = 0; i < count; i++)
+	{
+		std::ostringstream os;
+		os << "benchmark message " << (i % unique);
+		rts2core::Message msg (now (), "msgbench", MESSAGE_INFO, os.str ().c_str ());
+		sink.push (msg);
+	}
+	double t_push = now () - t;
+	sink.flush ();
+	t = now () - t;
+
+	std::cout << name << ": " << count << " messages, push " << t_push << " s, written " << sink.getInserted () << " rows in " << t << " s, "
+		<< (count / t) << " msgs/s, suppressed " << sink.getSuppressed () << ", dropped " << sink.getDropped () << ", failed " << sink.getFailed () << std::endl;
+
+	return count / t;
+}
+
+int main (int argc, char **argv)
+{
+	const char *db = argc > 1 ? argv[1] : "stars";
+	int count = argc > 2 ? atoi (argv[2]) : 10000;
+
+	// single row inserts with commit after each message, as MessageDB::insertDB does
+	double single = run (db, "single row", count, 1, 0, count);
+	double batched = run (db, "batched", count, 500, 0, count);
+	run (db, "duplicate storm", count, 500, 10, 5);
+
+	std::cout << "batched speedup " << batched / single << std::endl;
+	return 0;
+}
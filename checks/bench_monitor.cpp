@@ -0,0 +1,196 @@
+/*
+ * Benchmark terminal output of rts2-mon device window.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "nmonitor.h"
+#include "valuestat.h"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// replay of a busy device: info round each second changes part of the
+// values, telescope position is updated five times per second
+
+#define VALUES         200
+#define FPS            10
+#define SECONDS        60
+#define ROUND_CHANGE   0.3
+
+class BenchBlock:public rts2core::Block
+{
+	public:
+		BenchBlock ():rts2core::Block (0, NULL) {}
+
+		virtual rts2core::Connection *createClientConnection (rts2core::NetworkAddress *in_addr) { return NULL; }
+		virtual int run () { return 0; }
+};
+
+static int valueTypes[] = {
+	RTS2_VALUE_DOUBLE, RTS2_VALUE_INTEGER, RTS2_VALUE_DOUBLE, RTS2_VALUE_RADEC, RTS2_VALUE_STRING,
+	RTS2_VALUE_DOUBLE, RTS2_VALUE_ALTAZ, RTS2_VALUE_BOOL, RTS2_VALUE_STAT | RTS2_VALUE_DOUBLE, RTS2_VALUE_TIME
+};
+
+static void changeValue (rts2core::Value *val)
+{
+	double r = random () / (double) RAND_MAX;
+	switch (val->getValueType ())
+	{
+		case RTS2_VALUE_DOUBLE:
+			if (val->getValueExtType () == RTS2_VALUE_STAT)
+			{
+				((rts2core::ValueDoubleStat *) val)->addValue (r);
+				((rts2core::ValueDoubleStat *) val)->calculate ();
+			}
+			else
+			{
+				((rts2core::ValueDouble *) val)->setValueDouble (r * 1000);
+			}
+			break;
+		case RTS2_VALUE_INTEGER:
+			((rts2core::ValueInteger *) val)->setValueInteger (r * 1000);
+			break;
+		case RTS2_VALUE_RADEC:
+			((rts2core::ValueRaDec *) val)->setValueRaDec (r * 360, r * 180 - 90);
+			break;
+		case RTS2_VALUE_ALTAZ:
+			((rts2core::ValueAltAz *) val)->setValueAltAz (r * 90, r * 360);
+			break;
+		case RTS2_VALUE_BOOL:
+			((rts2core::ValueBool *) val)->setValueBool (r > 0.5);
+			break;
+		case RTS2_VALUE_TIME:
+			((rts2core::ValueTime *) val)->setValueDouble (time (NULL) + r * 3600);
+			break;
+		default:
+			{
+				std::ostringstream os;
+				os << "state " << (int) (r * 100);
+				val->setValueCharArr (os.str ().c_str ());
+			}
+	}
+}
+
+static void replay (rts2core::Connection *conn, bool damageTracking, long &bytes, double &cpu)
+{
+	FILE *out = tmpfile ();
+	FILE *in = fopen ("/dev/null", "r");
+	SCREEN *scr = newterm ((char *) "xterm", out, in);
+	set_term (scr);
+	resizeterm (50, 160);
+
+	NDeviceWindow *window = new NDeviceWindow (conn, false);
+	window->resize (10, 1, 150, 48);
+	doupdate ();
+	fflush (out);
+	long start = ftell (out);
+
+	std::vector <rts2core::Value *> fast;
+	for (rts2core::ValueVector::iterator iter = conn->valueBegin (); iter != conn->valueEnd (); iter++)
+	{
+		if ((*iter)->getValueType () == RTS2_VALUE_RADEC || (*iter)->getValueType () == RTS2_VALUE_ALTAZ)
+			fast.push_back (*iter);
+		if (fast.size () == 4)
+			break;
+	}
+
+	srandom (42);
+	clock_t c = clock ();
+
+	for (int frame = 0; frame < SECONDS * FPS; frame++)
+	{
+		bool damaged = false;
+		if (frame % FPS == 3)
+		{
+			for (rts2core::ValueVector::iterator iter = conn->valueBegin (); iter != conn->valueEnd (); iter++)
+			{
+				if (random () < RAND_MAX * ROUND_CHANGE)
+				{
+					changeValue (*iter);
+					window->valueChanged (*iter);
+					damaged = true;
+				}
+			}
+		}
+		if (frame % 2 == 0)
+		{
+			for (std::vector <rts2core::Value *>::iterator iter = fast.begin (); iter != fast.end (); iter++)
+			{
+				changeValue (*iter);
+				window->valueChanged (*iter);
+			}
+			damaged = true;
+		}
+
+		if (damageTracking)
+		{
+			// skip frames without change, clock is updated every second
+			if (!damaged && frame % FPS != 0)
+				continue;
+		}
+		else
+		{
+			window->invalidate ();
+		}
+		curs_set (0);
+		window->draw ();
+		curs_set (1);
+		doupdate ();
+	}
+
+	cpu = (double) (clock () - c) / CLOCKS_PER_SEC;
+	fflush (out);
+	bytes = ftell (out) - start;
+
+	delete window;
+	endwin ();
+	delscreen (scr);
+	fclose (in);
+	fclose (out);
+}
+
+int main (int argc, char **argv)
+{
+	BenchBlock block;
+	rts2core::Connection *conn = new rts2core::Connection (&block);
+
+	for (int i = 0; i < VALUES; i++)
+	{
+		std::ostringstream os;
+		os << "value_" << i;
+		conn->metaInfo (valueTypes[i % (sizeof (valueTypes) / sizeof (int))], os.str (), "");
+	}
+	for (rts2core::ValueVector::iterator iter = conn->valueBegin (); iter != conn->valueEnd (); iter++)
+		changeValue (*iter);
+
+	long bytes;
+	double cpu;
+
+	replay (conn, false, bytes, cpu);
+	std::cout << "full redraw      " << bytes << " bytes/min, " << cpu << " s CPU" << std::endl;
+
+	replay (conn, true, bytes, cpu);
+	std::cout << "damage tracking  " << bytes << " bytes/min, " << cpu << " s CPU" << std::endl;
+
+	delete conn;
+	return 0;
+}
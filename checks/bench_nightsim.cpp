@@ -0,0 +1,120 @@
+/*
+ * Benchmark night simulation engine.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "rts2script/nightsim.h"
+#include "threadpool.h"
+
+#include <iostream>
+#include <sstream>
+
+#include <stdlib.h>
+#include <sys/time.h>
+
+// simulates full night with 500 queued targets, in four queue variants
+
+#define TARGETS   500
+#define THREADS   4
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+int main (int argc, char **argv)
+{
+	struct ln_lnlat_posn observer;
+	observer.lng = -17.88;
+	observer.lat = 28.76;
+
+	// 2018-01-15 20:00 UTC to 2018-01-16 07:00 UTC
+	double from = 1516046400;
+	double to = from + 11 * 3600;
+
+	double t = now ();
+
+	rts2plan::NightSimulator sim (&observer, from, to);
+
+	srandom (42);
+	for (int i = 0; i < TARGETS; i++)
+	{
+		std::ostringstream os;
+		os << "T" << i;
+		sim.addTarget (rts2plan::SimTarget (i + 1000, os.str ().c_str (), random () % 36000 / 100.0, random () % 12000 / 100.0 - 40, 120 + random () % 600));
+	}
+	sim.precompute (20);
+
+	double t_pre = now () - t;
+
+	std::vector <rts2plan::SimPolicy> policies;
+	policies.push_back (rts2plan::SimPolicy ("FIFO", QUEUE_FIFO));
+	policies.push_back (rts2plan::SimPolicy ("CIRCULAR", QUEUE_CIRCULAR));
+	policies.push_back (rts2plan::SimPolicy ("HIGHEST", QUEUE_HIGHEST));
+	policies.push_back (rts2plan::SimPolicy ("WESTEAST", QUEUE_WESTEAST));
+
+	for (std::vector <rts2plan::SimPolicy>::iterator iter = policies.begin (); iter != policies.end (); iter++)
+	{
+		iter->skipBelowHorizon = true;
+		for (int i = 0; i < TARGETS; i++)
+			iter->requests.push_back (rts2plan::SimRequest (i));
+	}
+
+	std::vector <rts2plan::SimTimeline> timelines;
+	rts2core::ThreadPool pool (THREADS);
+	pool.start ();
+	sim.runParallel (policies, timelines, &pool);
+
+	double t_all = now () - t;
+
+	std::cout << "targets " << TARGETS << " night " << (to - from) / 3600.0 << " h, " << sim.getSteps () << " steps" << std::endl
+		<< "precompute " << t_pre << " s" << std::endl;
+
+	int ret = 0;
+	for (size_t i = 0; i < policies.size (); i++)
+	{
+		double observed = 0;
+		for (rts2plan::SimTimeline::iterator iter = timelines[i].begin (); iter != timelines[i].end (); iter++)
+		{
+			if (iter->end <= iter->start || iter->start < from || iter->end > to)
+			{
+				std::cerr << policies[i].name << " invalid observation " << iter->tar_id << " " << iter->start << " " << iter->end << std::endl;
+				ret = 1;
+			}
+			if (iter != timelines[i].begin () && iter->start < (iter - 1)->end)
+			{
+				std::cerr << policies[i].name << " overlapping observation " << iter->tar_id << std::endl;
+				ret = 1;
+			}
+			observed += iter->end - iter->start;
+		}
+		std::cout << policies[i].name << " " << timelines[i].size () << " observations, " << observed / 3600.0 << " h observed" << std::endl;
+		if (timelines[i].empty ())
+			ret = 1;
+	}
+
+	std::cout << "total " << t_all << " s" << std::endl;
+
+	if (t_all > 1)
+	{
+		std::cerr << "simulation took more than 1 s" << std::endl;
+		ret = 1;
+	}
+	return ret;
+}
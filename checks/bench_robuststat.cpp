@@ -0,0 +1,128 @@
+/*
+ * Benchmark robust statistics against qsort based median.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "robuststat.h"
+#include "imghdr.h"
+
+#include <iostream>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+// 4 Mpix frame with sky background and stars
+
+#define WIDTH     2048
+#define HEIGHT    2048
+#define THREADS   4
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static int cmpuint16_t (const void *a, const void *b)
+{
+	return *((uint16_t *) a) > *((uint16_t *) b) ? 1 : -1;
+}
+
+static int cmpfloat (const void *a, const void *b)
+{
+	return *((float *) a) > *((float *) b) ? 1 : -1;
+}
+
+// median and MAD as calculated by XFitsImage::classical_median - copy, sort, sort deviations
+template <typename t> double qsortMedian (t *q, size_t n, double *mad, int (*cmp) (const void *, const void *))
+{
+	t *f = new t[n];
+	memcpy (f, q, n * sizeof (t));
+	qsort (f, n, sizeof (t), cmp);
+	double M = ((double) f[(n - 1) / 2] + f[n / 2]) / 2.0;
+	for (size_t i = 0; i < n; i++)
+		f[i] = (t) fabs (f[i] - M);
+	qsort (f, n, sizeof (t), cmp);
+	*mad = ((double) f[(n - 1) / 2] + f[n / 2]) / 2.0;
+	delete[] f;
+	return M;
+}
+
+template <typename t> int bench (const char *name, std::vector <t> &data, int16_t dataType, int (*cmp) (const void *, const void *))
+{
+	size_t n = data.size ();
+
+	double t0 = now ();
+	double qmad;
+	double qm = qsortMedian (&(data[0]), n, &qmad, cmp);
+	double t_qsort = now () - t0;
+
+	t0 = now ();
+	double mad;
+	double m = rts2core::robustMedian (&(data[0]), n, &mad);
+	double t_median = now () - t0;
+
+	t0 = now ();
+	rts2core::RobustStat st;
+	rts2core::robustStatistics (&(data[0]), dataType, n, 1, n, st, 3, 5, THREADS);
+	double t_clip = now () - t0;
+
+	std::vector <rts2core::StatRegion> regions;
+	for (size_t y = 0; y < HEIGHT; y += 256)
+		for (size_t x = 0; x < WIDTH; x += 256)
+			regions.push_back (rts2core::StatRegion (x, y, 256, 256));
+	t0 = now ();
+	rts2core::robustRegions (&(data[0]), dataType, WIDTH, regions, 3, 5, THREADS);
+	double t_regions = now () - t0;
+
+	std::cout << name << " qsort median " << qm << " MAD " << qmad << " " << t_qsort << " s" << std::endl
+		<< name << " median " << m << " MAD " << mad << " " << t_median << " s, speedup " << t_qsort / t_median << std::endl
+		<< name << " clipped median " << st.median << " sigma " << st.sigma << " mean " << st.mean << " (" << st.n << " pixels, " << st.iterations << " iterations) " << t_clip << " s" << std::endl
+		<< name << " " << regions.size () << " regions " << t_regions << " s" << std::endl;
+
+	// qsort MAD of integer types is calculated from truncated deviations
+	if (fabs (qm - m) > 1e-3 || fabs (qmad - mad) > 1)
+	{
+		std::cerr << name << " median or MAD differs from qsort" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int main (int argc, char **argv)
+{
+	size_t n = WIDTH * HEIGHT;
+	std::vector <uint16_t> u (n);
+	std::vector <float> f (n);
+
+	srandom (42);
+	for (size_t i = 0; i < n; i++)
+	{
+		u[i] = 1000 + random () % 40 + random () % 40;
+		// stars and hot pixels
+		if (random () % 500 == 0)
+			u[i] += random () % 50000;
+		f[i] = u[i] * 0.37;
+	}
+
+	int ret = bench ("ushort", u, RTS2_DATA_USHORT, cmpuint16_t);
+	ret |= bench ("float", f, RTS2_DATA_FLOAT, cmpfloat);
+	return ret;
+}
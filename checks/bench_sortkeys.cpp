@@ -0,0 +1,96 @@
+/*
+ * Benchmark sorting targets with precomputed positions.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "rts2db/appdb.h"
+#include "rts2db/target.h"
+#include "rts2db/targetset.h"
+#include "configuration.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <sys/time.h>
+
+// Needs running PostgreSQL with RTS2 database, see bench_targetset.cpp
+// for adding benchmark targets. Run as
+//   bench_sortkeys [--database db]
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+class BenchSortKeys:public rts2db::AppDb
+{
+	public:
+		BenchSortKeys (int argc, char **argv):rts2db::AppDb (argc, argv) {}
+
+	protected:
+		virtual int doProcessing ();
+};
+
+int BenchSortKeys::doProcessing ()
+{
+	struct ln_lnlat_posn *obs = rts2core::Configuration::instance ()->getObserver ();
+	double alt = rts2core::Configuration::instance ()->getObservatoryAltitude ();
+	double JD = ln_get_julian_from_sys ();
+
+	rts2db::TargetSet ts (obs, alt);
+	ts.load ();
+
+	std::vector <rts2db::Target *> targets;
+	for (rts2db::TargetSet::iterator iter = ts.begin (); iter != ts.end (); iter++)
+		targets.push_back (iter->second);
+
+	// positions computed in every comparison
+	std::vector <rts2db::Target *> s1 (targets);
+	double t = now ();
+	std::sort (s1.begin (), s1.end (), rts2db::sortByAltitude (obs, JD));
+	std::sort (s1.begin (), s1.end (), rts2db::sortWestEast (obs, JD));
+	double t_compare = now () - t;
+
+	// positions computed once, in parallel, shared by both sorts
+	std::vector <rts2db::Target *> s2 (targets);
+	t = now ();
+	rts2db::PositionCache cache (obs, JD);
+	cache.precompute (s2);
+	std::sort (s2.begin (), s2.end (), rts2db::sortByAltitude (obs, JD, &cache));
+	std::sort (s2.begin (), s2.end (), rts2db::sortWestEast (obs, JD, &cache));
+	double t_cache = now () - t;
+
+	std::cout << targets.size () << " targets" << std::endl
+		<< "positions in comparisons " << t_compare << " s" << std::endl
+		<< "precomputed positions " << t_cache << " s, speedup " << t_compare / t_cache << std::endl;
+
+	if (s1 != s2)
+	{
+		std::cerr << "sort results differ" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int main (int argc, char **argv)
+{
+	BenchSortKeys app (argc, argv);
+	return app.run ();
+}
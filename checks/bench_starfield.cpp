@@ -0,0 +1,101 @@
+/*
+ * Benchmark simulation of dummy camera images.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "../src/camd/starfield.h"
+#include "imghdr.h"
+#include "utilsfunc.h"
+
+#include <iostream>
+#include <vector>
+
+#include <math.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+// 4k x 4k frame with 100 stars
+#define WIDTH    4096
+#define HEIGHT   4096
+#define STARS    100
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+// loop used by the dummy camera before, per pixel random number and test of all stars
+static void scalarLoop (uint16_t *data, double *sx, double *sy)
+{
+	double s = 5;
+	int smax = ceil (s * 10);
+	s *= s;
+	for (size_t i = 0; i < (size_t) WIDTH * HEIGHT; i++, data++)
+	{
+		*data = 400 + 300 * random_num () - 150;
+		int x = i % WIDTH;
+		int y = i / WIDTH;
+		for (int j = 0; j < STARS; j++)
+		{
+			double aax = x - sx[j];
+			double aay = y - sy[j];
+			if (fabs (aax) < smax && fabs (aay) < smax)
+			{
+				aax *= aax;
+				aay *= aay;
+				*data += 20000 * exp (-(aax / (2 * s) + aay / (2 * s)));
+			}
+		}
+	}
+}
+
+int main (int argc, char **argv)
+{
+	std::vector <uint16_t> data ((size_t) WIDTH * HEIGHT);
+
+	double sx[STARS];
+	double sy[STARS];
+	for (int j = 0; j < STARS; j++)
+	{
+		sx[j] = random_num () * WIDTH;
+		sy[j] = random_num () * HEIGHT;
+	}
+
+	double t = now ();
+	scalarLoop (&(data[0]), sx, sy);
+	double ts = now () - t;
+	std::cout << "scalar loop       " << ts << " s" << std::endl;
+
+	int threads[] = {1, 0};
+	for (int i = 0; i < 2; i++)
+	{
+		rts2camd::StarField field (threads[i]);
+		field.setPSF (2.3548 * 5, 2.3548 * 5, 2.5);
+		field.setDetector (400, 100, 300 / sqrt (12), 1.5);
+		rts2camd::NoiseGenerator gen (1);
+		field.addRandomStars (STARS, WIDTH, HEIGHT, 20000, gen);
+
+		t = now ();
+		field.render (&(data[0]), RTS2_DATA_USHORT, WIDTH, HEIGHT, 0, 0, 1);
+		t = now () - t;
+		std::cout << "star field " << (threads[i] ? "1 thread " : "all CPUs ") << t << " s, speedup " << ts / t << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * Benchmark loading of target sets.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "rts2db/appdb.h"
+#include "rts2db/target.h"
+#include "rts2db/targetset.h"
+#include "configuration.h"
+
+#include <iostream>
+#include <list>
+
+#include <sys/time.h>
+
+// Needs running PostgreSQL with RTS2 database. Run as
+//   bench_targetset [--database db]
+// To benchmark with 10000 targets, add them with
+//   INSERT INTO targets (tar_id, type_id, tar_name, tar_ra, tar_dec, tar_enabled)
+//     SELECT nextval ('tar_id'), 'O', 'bench' || i, random () * 360, random () * 180 - 90, true FROM generate_series (1, 10000) AS i;
+// and delete them with
+//   DELETE FROM targets WHERE tar_name LIKE 'bench%';
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+class BenchTargetSet:public rts2db::AppDb
+{
+	public:
+		BenchTargetSet (int argc, char **argv):rts2db::AppDb (argc, argv) {}
+
+	protected:
+		virtual int doProcessing ();
+};
+
+int BenchTargetSet::doProcessing ()
+{
+	struct ln_lnlat_posn *obs = rts2core::Configuration::instance ()->getObserver ();
+	double alt = rts2core::Configuration::instance ()->getObservatoryAltitude ();
+
+	size_t pi = 0;
+
+	double t = now ();
+	rts2db::TargetSet bulk (obs, alt);
+	bulk.load ();
+	for (rts2db::TargetSet::iterator iter = bulk.begin (); iter != bulk.end (); iter++)
+		pi += iter->second->getPIName ().length ();
+	double t_bulk = now () - t;
+
+	std::list <int> ids;
+	for (rts2db::TargetSet::iterator iter = bulk.begin (); iter != bulk.end (); iter++)
+		ids.push_back (iter->first);
+
+	// per-target queries, as TargetSet::load did before targets were constructed from rows
+	t = now ();
+	for (std::list <int>::iterator iter = ids.begin (); iter != ids.end (); iter++)
+	{
+		rts2db::Target *tar = createTarget (*iter, obs, alt);
+		pi += tar->getPIName ().length ();
+		delete tar;
+	}
+	double t_single = now () - t;
+
+	std::cout << ids.size () << " targets" << std::endl
+		<< "per-target load " << t_single << " s" << std::endl
+		<< "bulk load " << t_bulk << " s, speedup " << t_single / t_bulk << std::endl;
+
+	return 0;
+}
+
+int main (int argc, char **argv)
+{
+	BenchTargetSet app (argc, argv);
+	return app.run ();
+}
@@ -0,0 +1,168 @@
+/*
+ * Benchmark lock-free queue and thread pool against TSQueue.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "mpmcqueue.h"
+#include "threadpool.h"
+#include "tsqueue.h"
+
+#include <iostream>
+#include <vector>
+
+#include <sched.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define ITEMS   2000000
+#define TASKS   200000
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static int producers;
+static int consumers;
+
+static TSQueue <long> tsqueue;
+static rts2core::MPMCQueue <long> mpmcqueue (4096);
+
+static void *tsProducer (void *arg)
+{
+	for (long i = 0; i < ITEMS / producers; i++)
+		tsqueue.push (i);
+	return NULL;
+}
+
+static void *tsConsumer (void *arg)
+{
+	long sum = 0;
+	for (long i = 0; i < ITEMS / producers * producers / consumers; i++)
+		sum += tsqueue.pop (true);
+	return (void *) sum;
+}
+
+static void *mpmcProducer (void *arg)
+{
+	for (long i = 0; i < ITEMS / producers; i++)
+	{
+		while (!mpmcqueue.push (i))
+			sched_yield ();
+	}
+	return NULL;
+}
+
+static void *mpmcConsumer (void *arg)
+{
+	long sum = 0;
+	long v;
+	for (long i = 0; i < ITEMS / producers * producers / consumers; i++)
+	{
+		while (!mpmcqueue.pop (v))
+			sched_yield ();
+		sum += v;
+	}
+	return (void *) sum;
+}
+
+static double runQueue (void *(*producer) (void *), void *(*consumer) (void *))
+{
+	std::vector <pthread_t> threads (producers + consumers);
+	double t = now ();
+	for (int i = 0; i < producers; i++)
+		pthread_create (&(threads[i]), NULL, producer, NULL);
+	for (int i = 0; i < consumers; i++)
+		pthread_create (&(threads[producers + i]), NULL, consumer, NULL);
+	for (size_t i = 0; i < threads.size (); i++)
+		pthread_join (threads[i], NULL);
+	return now () - t;
+}
+
+class SmallTask:public rts2core::PoolTask
+{
+	public:
+		SmallTask ():rts2core::PoolTask () { result = 0; }
+		virtual void run ()
+		{
+			for (int i = 0; i < 100; i++)
+				result += i;
+		}
+
+		long result;
+};
+
+static void *smallThread (void *arg)
+{
+	((SmallTask *) arg)->run ();
+	return NULL;
+}
+
+int main (int argc, char **argv)
+{
+	producers = argc > 1 ? atoi (argv[1]) : 2;
+	consumers = argc > 2 ? atoi (argv[2]) : 2;
+
+	double t_ts = runQueue (tsProducer, tsConsumer);
+	double t_mpmc = runQueue (mpmcProducer, mpmcConsumer);
+
+	std::cout << producers << " producers, " << consumers << " consumers, " << ITEMS << " items" << std::endl
+		<< "TSQueue " << t_ts << " s, " << ITEMS / t_ts << " items/s" << std::endl
+		<< "MPMCQueue " << t_mpmc << " s, " << ITEMS / t_mpmc << " items/s, speedup " << t_ts / t_mpmc << std::endl;
+
+	std::vector <SmallTask *> tasks;
+	for (int i = 0; i < TASKS; i++)
+		tasks.push_back (new SmallTask ());
+
+	// thread per task, as hand-written background jobs do
+	double t = now ();
+	for (int i = 0; i < TASKS; i += 100)
+	{
+		pthread_t threads[100];
+		for (int j = 0; j < 100; j++)
+			pthread_create (threads + j, NULL, smallThread, tasks[i + j]);
+		for (int j = 0; j < 100; j++)
+			pthread_join (threads[j], NULL);
+	}
+	double t_threads = now () - t;
+
+	for (int i = 0; i < TASKS; i++)
+	{
+		delete tasks[i];
+		tasks[i] = new SmallTask ();
+	}
+
+	rts2core::ThreadPool pool;
+	pool.start ();
+	t = now ();
+	for (int i = 0; i < TASKS; i++)
+		pool.submit (tasks[i]);
+	for (int i = 0; i < TASKS; i++)
+		tasks[i]->wait ();
+	double t_pool = now () - t;
+
+	for (int i = 0; i < TASKS; i++)
+		delete tasks[i];
+
+	std::cout << TASKS << " tasks" << std::endl
+		<< "thread per task " << t_threads << " s" << std::endl
+		<< "thread pool (" << pool.getThreads () << " threads) " << t_pool << " s, speedup " << t_threads / t_pool << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,207 @@
+#include <check.h>
+#include <check_utils.h>
+#include <stdlib.h>
+#include <poll.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/bb/bbrequests.h"
+
+using namespace rts2bb;
+
+/**
+ * Observatory records are not loaded from the database, observatory 1
+ * is served by the test server, all others are unknown.
+ */
+class TestRequests:public BBRequests
+{
+	public:
+		TestRequests (int port):BBRequests (5, 3600) { serverPort = port; loaded = 0; }
+
+		int loaded;
+
+	protected:
+		virtual Observatory *loadObservatory (int observatory_id)
+		{
+			if (observatory_id != 1)
+				throw rts2core::Error ("observatory not found");
+			loaded++;
+			std::ostringstream os;
+			os << "http://127.0.0.1:" << serverPort;
+			return new Observatory (observatory_id, os.str ().c_str (), "user", "password");
+		}
+
+	private:
+		int serverPort;
+};
+
+static std::vector <guint> statuses;
+static std::vector <std::string> errors;
+static std::vector <int> results;
+
+class TestRequest:public ObservatoryRequest
+{
+	public:
+		TestRequest (int observatory_id, const char *path):ObservatoryRequest (observatory_id, path) {}
+
+		virtual void finished (JsonParser *result)
+		{
+			statuses.push_back (getStatus ());
+			errors.push_back (getError ());
+			results.push_back (result ? json_node_get_int (json_parser_get_root (result)) : -1);
+		}
+};
+
+static void serverCallback (SoupServer *server, SoupMessage *msg, const char *path, GHashTable *query, SoupClientContext *client, gpointer data)
+{
+	if (strcmp (path, "/api/ok") == 0)
+	{
+		soup_message_set_status (msg, SOUP_STATUS_OK);
+		soup_message_set_response (msg, "application/json", SOUP_MEMORY_COPY, "42", 2);
+	}
+	else
+	{
+		soup_message_set_status (msg, SOUP_STATUS_INTERNAL_SERVER_ERROR);
+	}
+}
+
+static SoupServer *server;
+static TestRequests *requests;
+
+void setup_bbrequests (void)
+{
+	statuses.clear ();
+	errors.clear ();
+	results.clear ();
+
+	g_type_init ();
+
+	// server runs in the default main context, which is iterated by the test
+	server = soup_server_new (SOUP_SERVER_PORT, SOUP_ADDRESS_ANY_PORT, NULL);
+	ck_assert (server != NULL);
+	soup_server_add_handler (server, NULL, serverCallback, NULL, NULL);
+	soup_server_run_async (server);
+
+	requests = new TestRequests (soup_server_get_port (server));
+	ck_assert_int_eq (requests->start (), 0);
+}
+
+void teardown_bbrequests (void)
+{
+	delete requests;
+	soup_server_quit (server);
+	g_object_unref (server);
+}
+
+/**
+ * Serve requests until all are finished.
+ */
+static void waitFinished ()
+{
+	double end = getNow () + 10;
+	while (requests->getPending () > 0 && getNow () < end)
+	{
+		g_main_context_iteration (NULL, FALSE);
+		struct pollfd pfd;
+		pfd.fd = requests->getNotifyFd ();
+		pfd.events = POLLIN;
+		if (poll (&pfd, 1, 10) > 0)
+			requests->processFinished ();
+	}
+	ck_assert_int_eq (requests->getPending (), 0);
+}
+
+START_TEST(success)
+{
+	requests->que (new TestRequest (1, "/api/ok"));
+	waitFinished ();
+
+	ck_assert_int_eq (statuses.size (), 1);
+	ck_assert_int_eq (statuses[0], SOUP_STATUS_OK);
+	ck_assert (errors[0].empty ());
+	ck_assert_int_eq (results[0], 42);
+	ck_assert_int_eq (requests->loaded, 1);
+}
+END_TEST
+
+START_TEST(http_error)
+{
+	requests->que (new TestRequest (1, "/api/missing"));
+	requests->que (new TestRequest (1, "/api/ok"));
+	waitFinished ();
+
+	ck_assert_int_eq (statuses.size (), 2);
+	ck_assert_int_eq (statuses[0], SOUP_STATUS_INTERNAL_SERVER_ERROR);
+	ck_assert_int_eq (results[0], -1);
+	ck_assert_int_eq (statuses[1], SOUP_STATUS_OK);
+	ck_assert_int_eq (results[1], 42);
+	// server error does not invalidate cached observatory
+	ck_assert_int_eq (requests->loaded, 1);
+}
+END_TEST
+
+START_TEST(unknown_observatory)
+{
+	requests->que (new TestRequest (2, "/api/ok"));
+	waitFinished ();
+
+	ck_assert_int_eq (statuses.size (), 1);
+	ck_assert_int_eq (statuses[0], BB_STATUS_UNKNOWN_OBSERVATORY);
+	ck_assert_str_eq (errors[0].c_str (), "cannot load observatory 2: observatory not found");
+	ck_assert_int_eq (results[0], -1);
+}
+END_TEST
+
+START_TEST(unreachable)
+{
+	requests->que (new TestRequest (1, "/api/ok"));
+	waitFinished ();
+	ck_assert_int_eq (requests->loaded, 1);
+
+	// observatory is not reachable, record is reloaded for the next request
+	soup_server_disconnect (server);
+	requests->que (new TestRequest (1, "/api/ok"));
+	waitFinished ();
+	ck_assert (SOUP_STATUS_IS_TRANSPORT_ERROR (statuses[1]));
+
+	requests->que (new TestRequest (1, "/api/ok"));
+	waitFinished ();
+	ck_assert_int_eq (requests->loaded, 2);
+}
+END_TEST
+
+Suite * bbrequests_suite (void)
+{
+	Suite *s;
+	TCase *tc_bbrequests;
+
+	s = suite_create ("BB requests");
+	tc_bbrequests = tcase_create ("Requests to observatory HTTP server");
+	tcase_add_checked_fixture (tc_bbrequests, setup_bbrequests, teardown_bbrequests);
+	tcase_set_timeout (tc_bbrequests, 60);
+
+	tcase_add_test (tc_bbrequests, success);
+	tcase_add_test (tc_bbrequests, http_error);
+	tcase_add_test (tc_bbrequests, unknown_observatory);
+	tcase_add_test (tc_bbrequests, unreachable);
+	suite_add_tcase (s, tc_bbrequests);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = bbrequests_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,177 @@
+#include <check.h>
+#include <check_utils.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "block.h"
+#include "binvalue.h"
+#include "valuearray.h"
+#include "valuestat.h"
+
+class TestBlock:public rts2core::Block
+{
+	public:
+		TestBlock ():rts2core::Block (0, NULL) { setTimeout (USEC_SEC / 100); }
+
+		virtual rts2core::Connection *createClientConnection (rts2core::NetworkAddress *in_addr) { return NULL; }
+		virtual int run () { return 0; }
+};
+
+START_TEST(codec)
+{
+	rts2core::BinaryValueWriter writer;
+	writer.startValue ("first");
+	writer.addInteger (-12);
+	writer.addLong (1234567890123LL);
+	writer.addDouble (-1.25e-7);
+	writer.addString ("a b");
+	writer.endValue ();
+	writer.startValue ("second");
+	writer.addText ("1 2.5 nan");
+	writer.endValue ();
+	writer.startValue ("third");
+	writer.endValue ();
+
+	std::vector <char> frame (writer.getData (), writer.getData () + writer.size ());
+	rts2core::BinaryValueReader reader (&(frame[0]), frame.size ());
+
+	int i;
+	long long int l;
+	double d;
+	char *s;
+
+	ck_assert_int_eq (reader.nextValue (), 1);
+	ck_assert_str_eq (reader.getName (), "first");
+	ck_assert (reader.getText () == NULL);
+	ck_assert_int_eq (reader.paramInteger (&i), 0);
+	ck_assert_int_eq (i, -12);
+	ck_assert_int_eq (reader.paramLongLong (&l), 0);
+	ck_assert (l == 1234567890123LL);
+	// numbers are converted on request
+	ck_assert_int_eq (reader.paramString (&s), 0);
+	ck_assert_dbl_eq (atof (s), -1.25e-7, 10e-20);
+	ck_assert_int_eq (reader.paramString (&s), 0);
+	ck_assert_str_eq (s, "a b");
+	ck_assert (reader.paramEnd ());
+	ck_assert_int_eq (reader.paramDouble (&d), -1);
+
+	ck_assert_int_eq (reader.nextValue (), 1);
+	ck_assert_str_eq (reader.getName (), "second");
+	ck_assert_str_eq (reader.getText (), "1 2.5 nan");
+
+	ck_assert_int_eq (reader.nextValue (), 1);
+	ck_assert_str_eq (reader.getName (), "third");
+	ck_assert (reader.paramEnd ());
+	ck_assert_int_eq (reader.nextValue (), 0);
+
+	// truncated frame
+	rts2core::BinaryValueReader truncated (&(frame[0]), frame.size () - 20);
+	ck_assert_int_eq (truncated.nextValue (), 1);
+	ck_assert_int_eq (truncated.nextValue (), -1);
+}
+END_TEST
+
+START_TEST(connection)
+{
+	int sv[2];
+	ck_assert_int_eq (socketpair (AF_UNIX, SOCK_STREAM, 0, sv), 0);
+
+	TestBlock block;
+	rts2core::Connection *sender = new rts2core::Connection (sv[0], &block);
+	rts2core::Connection *receiver = new rts2core::Connection (sv[1], &block);
+	block.addConnection (receiver);
+
+	rts2core::ValueDouble *vd = new rts2core::ValueDouble ("double", "", false);
+	rts2core::ValueInteger *vi = new rts2core::ValueInteger ("integer", "", false);
+	rts2core::ValueString *vs = new rts2core::ValueString ("string", "", false);
+	rts2core::ValueRaDec *vr = new rts2core::ValueRaDec ("radec", "", false);
+	rts2core::ValueBool *vb = new rts2core::ValueBool ("bool", "", false);
+	rts2core::DoubleArray *va = new rts2core::DoubleArray ("array", "", false);
+	rts2core::ValueDoubleStat *vst = new rts2core::ValueDoubleStat ("stat", "", false);
+
+	rts2core::Value *values[] = {vd, vi, vs, vr, vb, va, vst};
+	for (int i = 0; i < 7; i++)
+		receiver->metaInfo (values[i]->getFlags (), values[i]->getName (), "");
+
+	vd->setValueDouble (M_PI);
+	vi->setValueInteger (-42);
+	vs->setValueCharArr ("text value");
+	vr->setValueRaDec (123.456789012345, -12.5);
+	vb->setValueBool (true);
+	for (int i = 0; i < 100; i++)
+		va->addValue (i / 7.0);
+	for (int i = 0; i < 10; i++)
+		vst->addValue (i);
+	vst->calculate ();
+
+	sender->setBinaryValues (true);
+	sender->startValueBatch ();
+	for (int i = 0; i < 7; i++)
+		values[i]->send (sender);
+	ck_assert_int_eq (sender->endValueBatch (), 0);
+
+	// text line between frames
+	sender->sendValue ("integer", 7);
+	vd->setValueDouble (-1e300);
+	vd->send (sender);
+
+	double end = getNow () + 5;
+	while (receiver->getValueDouble ("double") != -1e300 && getNow () < end)
+		block.oneRunLoop ();
+
+	ck_assert_dbl_eq (receiver->getValueDouble ("double"), -1e300, 1e285);
+	ck_assert_int_eq (receiver->getValueInteger ("integer"), 7);
+	ck_assert_str_eq (receiver->getValueChar ("string"), "text value");
+
+	rts2core::ValueRaDec *rr = (rts2core::ValueRaDec *) receiver->getValue ("radec");
+	// binary values are not rounded
+	ck_assert (rr->getRa () == 123.456789012345);
+	ck_assert (rr->getDec () == -12.5);
+	ck_assert (((rts2core::ValueBool *) receiver->getValue ("bool"))->getValueBool ());
+
+	rts2core::DoubleArray *ra = (rts2core::DoubleArray *) receiver->getValue ("array");
+	ck_assert_int_eq (ra->size (), 100);
+	for (int i = 0; i < 100; i++)
+		ck_assert ((*ra)[i] == i / 7.0);
+
+	rts2core::ValueDoubleStat *rst = (rts2core::ValueDoubleStat *) receiver->getValue ("stat");
+	ck_assert_int_eq (rst->getNumMes (), 10);
+	ck_assert_dbl_eq (rst->getValueDouble (), 4.5, 10e-10);
+	ck_assert_dbl_eq (rst->getMax (), 9, 10e-10);
+
+	for (int i = 0; i < 7; i++)
+		delete values[i];
+	delete sender;
+}
+END_TEST
+
+Suite * binvalue_suite (void)
+{
+	Suite *s;
+	TCase *tc_binvalue;
+
+	s = suite_create ("Binary values");
+	tc_binvalue = tcase_create ("Binary value frames");
+
+	tcase_add_test (tc_binvalue, codec);
+	tcase_add_test (tc_binvalue, connection);
+	suite_add_tcase (s, tc_binvalue);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = binvalue_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,129 @@
+#include <check.h>
+#include <check_utils.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bufferpool.h"
+
+START_TEST(size_classes)
+{
+	size_t page = sysconf (_SC_PAGESIZE);
+	ck_assert_int_eq (rts2core::BufferPool::sizeClass (1), page);
+	ck_assert_int_eq (rts2core::BufferPool::sizeClass (page), page);
+
+	// at most 25% wasted
+	for (size_t s = page + 1; s < 100 * 1024 * 1024; s = s * 3 / 2 + 17)
+	{
+		size_t c = rts2core::BufferPool::sizeClass (s);
+		ck_assert (c >= s);
+		ck_assert (c <= s * 1.25 + page || c - s < 2 * 1024 * 1024);
+		ck_assert_int_eq (c % page, 0);
+	}
+
+	// large buffers are multiples of huge pages
+	ck_assert_int_eq (rts2core::BufferPool::sizeClass (4096 * 4096 * 2) % (2 * 1024 * 1024), 0);
+	ck_assert_int_eq (rts2core::BufferPool::sizeClass (3 * 1024 * 1024 + 5) % (2 * 1024 * 1024), 0);
+}
+END_TEST
+
+START_TEST(reuse)
+{
+	rts2core::BufferPool pool;
+	rts2core::BufferPoolStats st;
+
+	char *b1 = (char *) pool.allocate (1000000);
+	ck_assert (b1 != NULL);
+	ck_assert (pool.owns (b1));
+	memset (b1, 1, 1000000);
+
+	pool.getStats (st);
+	ck_assert_int_eq (st.allocations, 1);
+	ck_assert_int_eq (st.misses, 1);
+	ck_assert_int_eq (st.used, rts2core::BufferPool::sizeClass (1000000));
+
+	pool.release (b1);
+	ck_assert (!pool.owns (b1));
+	pool.getStats (st);
+	ck_assert_int_eq (st.used, 0);
+	ck_assert_int_eq (st.cached, rts2core::BufferPool::sizeClass (1000000));
+
+	// the same class reuses buffer
+	char *b2 = (char *) pool.allocate (999000);
+	ck_assert (b2 == b1);
+	pool.getStats (st);
+	ck_assert_int_eq (st.hits, 1);
+	ck_assert_int_eq (st.cached, 0);
+
+	// other class maps new memory
+	char *b3 = (char *) pool.allocate (100);
+	ck_assert (b3 != b2);
+	pool.getStats (st);
+	ck_assert_int_eq (st.misses, 2);
+	ck_assert_int_eq (st.peak, rts2core::BufferPool::sizeClass (1000000) + rts2core::BufferPool::sizeClass (100));
+
+	pool.release (b2);
+	pool.release (b3);
+	pool.release (NULL);
+
+	pool.trim ();
+	pool.getStats (st);
+	ck_assert_int_eq (st.cached, 0);
+}
+END_TEST
+
+START_TEST(references)
+{
+	rts2core::BufferPool pool;
+	rts2core::BufferPoolStats st;
+
+	// readout hands buffer to writer, which passes it to analysis
+	char *b = (char *) pool.allocate (5000);
+	pool.retain (b);
+	pool.retain (b);
+	pool.release (b);
+	pool.release (b);
+	ck_assert (pool.owns (b));
+	pool.release (b);
+	ck_assert (!pool.owns (b));
+
+	// cache limit
+	pool.setCacheLimit (0);
+	b = (char *) pool.allocate (5000);
+	pool.release (b);
+	pool.getStats (st);
+	ck_assert_int_eq (st.cached, 0);
+	ck_assert_int_eq (st.used, 0);
+}
+END_TEST
+
+Suite * bufferpool_suite (void)
+{
+	Suite *s;
+	TCase *tc_bufferpool;
+
+	s = suite_create ("Buffer pool");
+	tc_bufferpool = tcase_create ("Buffer pool allocations");
+
+	tcase_add_test (tc_bufferpool, size_classes);
+	tcase_add_test (tc_bufferpool, reuse);
+	tcase_add_test (tc_bufferpool, references);
+	suite_add_tcase (s, tc_bufferpool);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = bufferpool_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
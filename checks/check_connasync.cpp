@@ -0,0 +1,235 @@
+#include <check.h>
+#include <check_utils.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "block.h"
+#include "connection/serial.h"
+#include "connection/async.h"
+
+/**
+ * Block running poll loop in tests.
+ */
+class TestBlock:public rts2core::Block
+{
+	public:
+		TestBlock ():rts2core::Block (0, NULL) { setTimeout (USEC_SEC / 100); }
+
+		virtual rts2core::Connection *createClientConnection (rts2core::NetworkAddress *in_addr) { return NULL; }
+		virtual int run () { return 0; }
+};
+
+static std::vector <std::string> replies;
+static std::vector <int> errors;
+static std::string unexpected;
+
+class TestRequest:public rts2core::AsyncRequest
+{
+	public:
+		TestRequest (const char *cmd, double timeout = 2):rts2core::AsyncRequest (cmd, timeout) {}
+
+		virtual void replied (const char *reply, size_t len) { replies.push_back (std::string (reply, len)); }
+		virtual void failed (int err) { errors.push_back (err); }
+};
+
+class TestAsync:public rts2core::ConnAsync
+{
+	public:
+		TestAsync (rts2core::Block *master, rts2core::Connection *port):rts2core::ConnAsync (master, port, "\r\n", 3) {}
+
+	protected:
+		virtual void unsolicited (const char *buf, size_t len) { unexpected.append (buf, len); }
+};
+
+static TestBlock *block;
+static rts2core::ConnSerial *port;
+static TestAsync *async;
+// master side of pseudo terminal - simulated instrument
+static int instrument;
+
+void setup_async (void)
+{
+	replies.clear ();
+	errors.clear ();
+	unexpected.clear ();
+
+	block = new TestBlock ();
+
+	instrument = posix_openpt (O_RDWR | O_NOCTTY);
+	ck_assert (instrument >= 0);
+	ck_assert_int_eq (grantpt (instrument), 0);
+	ck_assert_int_eq (unlockpt (instrument), 0);
+	fcntl (instrument, F_SETFL, O_NONBLOCK);
+
+	port = new rts2core::ConnSerial (ptsname (instrument), block, rts2core::BS9600, rts2core::C8, rts2core::NONE, 10);
+	ck_assert_int_eq (port->init (), 0);
+
+	async = new TestAsync (block, port);
+	block->addConnection (async);
+}
+
+void teardown_async (void)
+{
+	// block deletes async connection
+	delete block;
+	delete port;
+	close (instrument);
+}
+
+/**
+ * Run poll loop until condition is met or timeout expires.
+ */
+#define RUN_UNTIL(cond, timeout) { double _end = getNow () + timeout; while (!(cond) && getNow () < _end) block->oneRunLoop (); }
+
+/**
+ * Read commands received by simulated instrument.
+ */
+static std::string instrumentRead ()
+{
+	std::string ret;
+	char buf[100];
+	ssize_t l;
+	usleep (USEC_SEC / 100);
+	while ((l = read (instrument, buf, sizeof (buf))) > 0)
+		ret.append (buf, l);
+	return ret;
+}
+
+static void instrumentWrite (const char *reply)
+{
+	ck_assert_int_eq (write (instrument, reply, strlen (reply)), strlen (reply));
+}
+
+START_TEST(pipeline)
+{
+	block->oneRunLoop ();
+
+	async->queue (new TestRequest ("Q1\n"));
+	async->queue (new TestRequest ("Q2\n"));
+	async->queue (new TestRequest ("Q3\n"));
+	async->queue (new TestRequest ("Q4\n"));
+	async->queue (new TestRequest ("Q5\n"));
+
+	// only three requests can be in flight
+	ck_assert_str_eq (instrumentRead ().c_str (), "Q1\nQ2\nQ3\n");
+	ck_assert_int_eq (async->getQueueSize (), 5);
+
+	instrumentWrite ("A1\r\nA2\r\nA3\r\n");
+	RUN_UNTIL (replies.size () == 3, 1);
+	ck_assert_int_eq (replies.size (), 3);
+	ck_assert_str_eq (replies[0].c_str (), "A1");
+	ck_assert_str_eq (replies[2].c_str (), "A3");
+
+	ck_assert_str_eq (instrumentRead ().c_str (), "Q4\nQ5\n");
+
+	// reply split between reads
+	instrumentWrite ("A4\r\nA");
+	RUN_UNTIL (replies.size () == 4, 1);
+	instrumentWrite ("5\r");
+	block->oneRunLoop ();
+	ck_assert_int_eq (replies.size (), 4);
+	instrumentWrite ("\n");
+	RUN_UNTIL (replies.size () == 5, 1);
+	ck_assert_str_eq (replies[3].c_str (), "A4");
+	ck_assert_str_eq (replies[4].c_str (), "A5");
+	ck_assert (async->isIdle ());
+
+	instrumentWrite ("EVENT\r\n");
+	RUN_UNTIL (unexpected.length () > 0, 1);
+	ck_assert_str_eq (unexpected.c_str (), "EVENT\r\n");
+	ck_assert_int_eq (errors.size (), 0);
+}
+END_TEST
+
+START_TEST(framing)
+{
+	block->oneRunLoop ();
+
+	TestRequest *req = new TestRequest ("RESET\n");
+	req->setNoReply ();
+	async->queue (req);
+	ck_assert_int_eq (replies.size (), 1);
+	ck_assert_str_eq (replies[0].c_str (), "");
+
+	req = new TestRequest ("S\n");
+	req->setReplyLength (2);
+	async->queue (req);
+	req = new TestRequest ("T\n");
+	req->setReplyEnd ("#");
+	async->queue (req);
+	ck_assert_str_eq (instrumentRead ().c_str (), "RESET\nS\nT\n");
+
+	instrumentWrite ("OK12.5#");
+	RUN_UNTIL (replies.size () == 3, 1);
+	ck_assert_str_eq (replies[1].c_str (), "OK");
+	ck_assert_str_eq (replies[2].c_str (), "12.5");
+}
+END_TEST
+
+START_TEST(timeout)
+{
+	block->oneRunLoop ();
+
+	async->queue (new TestRequest ("Q1\n", 0.1));
+	async->queue (new TestRequest ("Q2\n", 5));
+	instrumentRead ();
+
+	// partial reply is dropped with timed out requests
+	instrumentWrite ("A");
+	double start = getNow ();
+	RUN_UNTIL (errors.size () == 2, 1);
+	ck_assert_int_eq (errors.size (), 2);
+	ck_assert_int_eq (errors[0], ETIMEDOUT);
+	ck_assert_int_eq (errors[1], ETIMEDOUT);
+	ck_assert (getNow () - start < 0.5);
+	ck_assert (async->isIdle ());
+
+	// resynchronized after timeout
+	async->queue (new TestRequest ("Q3\n"));
+	ck_assert_str_eq (instrumentRead ().c_str (), "Q3\n");
+	instrumentWrite ("A3\r\n");
+	RUN_UNTIL (replies.size () == 1, 1);
+	ck_assert_str_eq (replies[0].c_str (), "A3");
+
+	async->queue (new TestRequest ("Q4\n"));
+	async->clear ();
+	ck_assert_int_eq (errors.size (), 3);
+	ck_assert_int_eq (errors[2], ECANCELED);
+}
+END_TEST
+
+Suite * async_suite (void)
+{
+	Suite *s;
+	TCase *tc_async;
+
+	s = suite_create ("ConnAsync");
+	tc_async = tcase_create ("Asynchronous requests over pseudo terminal");
+
+	tcase_add_checked_fixture (tc_async, setup_async, teardown_async);
+	tcase_add_test (tc_async, pipeline);
+	tcase_add_test (tc_async, framing);
+	tcase_add_test (tc_async, timeout);
+	suite_add_tcase (s, tc_async);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = async_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,295 @@
+#include <check.h>
+#include <check_utils.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <vector>
+
+#include "../src/grb/gcntracker.h"
+#include "../src/grb/gcnparser.h"
+
+using namespace rts2grbd;
+
+// notices of a single Swift trigger, in order they were received:
+// type, RA, DEC, error box [deg], insert only
+struct RecordedNotice
+{
+	int type;
+	double ra;
+	double dec;
+	float errorbox;
+	bool insertOnly;
+};
+
+static RecordedNotice swiftTrigger[] =
+{
+	// BAT alert, slew to the last known Swift pointing
+	{60, 217.80, 36.35, 60.0, false},
+	// BAT position
+	{61, 217.9197, 36.3022, 0.05, false},
+	// BAT light curve, instrument error box is larger
+	{63, 217.9197, 36.3022, 4.0 / 60.0, false},
+	// BAT scaled map, only insert
+	{64, 217.9197, 36.3022, 4.0 / 60.0, true},
+	// XRT position
+	{67, 217.9203, 36.3003, 0.0016, false},
+	// UVOT position
+	{81, 217.9207, 36.3006, 19.0 / 3600.0, false},
+	// XRT centroid, only insert
+	{71, 217.9203, 36.3003, 0.25, true}
+};
+
+static gcnAction_t feed (GcnTracker &tracker, int grb_id, RecordedNotice &notice, int &tar_id)
+{
+	GcnPoint point;
+	point.grb_id = grb_id;
+	point.type = notice.type;
+	point.type_start = 60;
+	point.type_end = 99;
+	point.ra = notice.ra;
+	point.dec = notice.dec;
+	point.errorbox = notice.errorbox;
+	point.insertOnly = notice.insertOnly;
+	return tracker.process (point, false, false, tar_id);
+}
+
+START_TEST(replay)
+{
+	GcnTracker tracker;
+	int tar_id;
+
+	// without reserved ID, GRB must wait for the database
+	ck_assert_int_eq (feed (tracker, 306757, swiftTrigger[0], tar_id), GCN_SLOW);
+	ck_assert_int_eq (tar_id, -1);
+	ck_assert_int_eq (tracker.size (), 0);
+
+	tracker.reserve (50123);
+
+	gcnAction_t expected[] = {GCN_NEW, GCN_UPDATE, GCN_IGNORED, GCN_INSERT_ONLY, GCN_UPDATE, GCN_IGNORED, GCN_INSERT_ONLY};
+	for (size_t i = 0; i < sizeof (swiftTrigger) / sizeof (RecordedNotice); i++)
+	{
+		ck_assert_msg (feed (tracker, 306757, swiftTrigger[i], tar_id) == expected[i], "notice %d type %d", (int) i, swiftTrigger[i].type);
+		ck_assert_int_eq (tar_id, 50123);
+	}
+	ck_assert_int_eq (tracker.getReserved (), -1);
+
+	GcnKnown *known = tracker.find (306757, 60);
+	ck_assert (known != NULL);
+	ck_assert_dbl_eq (known->ra, 217.9203, 10e-6);
+	ck_assert_dbl_eq (known->dec, 36.3003, 10e-6);
+	ck_assert_dbl_eq (known->errorbox, 0.0016, 10e-6);
+	ck_assert (known->inDatabase == false);
+
+	// other trigger waits for the next reserved ID
+	ck_assert_int_eq (feed (tracker, 306758, swiftTrigger[0], tar_id), GCN_SLOW);
+	tracker.reserve (50124);
+	ck_assert_int_eq (feed (tracker, 306758, swiftTrigger[0], tar_id), GCN_NEW);
+	ck_assert_int_eq (tar_id, 50124);
+
+	// database decided differently - it is the authority
+	GcnKnown stored;
+	stored.tar_id = 50200;
+	stored.ra = 10;
+	stored.dec = 20;
+	stored.errorbox = 0.01;
+	tracker.stored (306758, 60, stored);
+	ck_assert (tracker.find (306758, 60)->inDatabase);
+	ck_assert_int_eq (feed (tracker, 306758, swiftTrigger[2], tar_id), GCN_IGNORED);
+	ck_assert_int_eq (tar_id, 50200);
+
+	tracker.forget (306758, 60);
+	ck_assert (tracker.find (306758, 60) == NULL);
+	ck_assert_int_eq (tracker.size (), 1);
+}
+END_TEST
+
+START_TEST(sources)
+{
+	GcnTracker tracker;
+	int tar_id;
+	tracker.reserve (100);
+
+	GcnPoint point;
+	point.grb_id = 1;
+	point.type_start = 60;
+	point.ra = 10;
+	point.dec = 20;
+	point.errorbox = 0.1;
+
+	// known sources are not followed
+	point.is_grb = false;
+	ck_assert_int_eq (tracker.process (point, false, false, tar_id), GCN_SLOW);
+
+	// retraction notices without position
+	point.is_grb = true;
+	point.ra = point.dec = -999;
+	ck_assert_int_eq (tracker.process (point, false, false, tar_id), GCN_SLOW);
+
+	// targets created disabled
+	point.ra = 10;
+	point.dec = 20;
+	ck_assert_int_eq (tracker.process (point, false, true, tar_id), GCN_NEW);
+	ck_assert (tracker.find (1, 60)->enabled == false);
+
+	// update without error box is always accepted
+	point.errorbox = NAN;
+	point.ra = 11;
+	ck_assert_int_eq (tracker.process (point, false, true, tar_id), GCN_UPDATE);
+	ck_assert_dbl_eq (tracker.find (1, 60)->errorbox, 0.1, 10e-6);
+	ck_assert_dbl_eq (tracker.find (1, 60)->ra, 11, 10e-6);
+	ck_assert (tracker.find (1, 60)->enabled == false);
+}
+END_TEST
+
+/**
+ * Records what the parser extracted from the packets.
+ */
+class RecordingParser:public GcnParser
+{
+	public:
+		RecordingParser ():GcnParser () { alive = 0; killed = 0; }
+
+		std::vector <GcnPoint> points;
+		std::vector <int> raw;
+		std::vector <int> notGrb;
+		int alive;
+		int killed;
+
+	protected:
+		virtual void imAlive () { alive++; }
+
+		virtual int addGcnPoint (int grb_id, int grb_seqn, int grb_type, double grb_ra, double grb_dec, bool grb_is_grb, time_t * grb_date, long grb_date_usec, float grb_errorbox, bool insertOnly, bool enabled)
+		{
+			GcnPoint point;
+			point.grb_id = grb_id;
+			point.seqn = grb_seqn;
+			point.type = grb_type;
+			point.ra = grb_ra;
+			point.dec = grb_dec;
+			point.is_grb = grb_is_grb;
+			point.errorbox = grb_errorbox;
+			point.insertOnly = insertOnly;
+			point.enabled = enabled;
+			points.push_back (point);
+			return 0;
+		}
+
+		virtual int addGcnRaw (int grb_id, int grb_seqn, int grb_type) { raw.push_back (grb_type); return 0; }
+		virtual int setNotGrb (int grb_id, int grb_seqn, int grb_type) { notGrb.push_back (grb_id); return 0; }
+		virtual int addSwiftPoint (double roll, char *name, float obstime, float merit) { return 0; }
+		virtual int addIntegralPoint (double ra, double dec, const time_t * t) { return 0; }
+		virtual void killSocket () { killed++; }
+};
+
+// write packet the way --record does - in network byte order
+static void recordPacket (int fd, int type, int trig, double ra, double dec, double error, int trigger_id)
+{
+	int32_t lbuf[SIZ_PKT];
+	int32_t nbuf[SIZ_PKT];
+	memset (lbuf, 0, sizeof (lbuf));
+	lbuf[PKT_TYPE] = type;
+	lbuf[PKT_SOD] = 4567800;
+	lbuf[BURST_TRIG] = trig;
+	lbuf[BURST_TJD] = 18200;
+	lbuf[BURST_SOD] = 4560000;
+	lbuf[BURST_RA] = (int32_t) (ra * 10000);
+	lbuf[BURST_DEC] = (int32_t) (dec * 10000);
+	lbuf[BURST_ERROR] = (int32_t) (error * 10000);
+	lbuf[TRIGGER_ID] = trigger_id;
+	for (int i = 0; i < SIZ_PKT; i++)
+		nbuf[i] = htonl (lbuf[i]);
+	ck_assert_int_eq (write (fd, nbuf, sizeof (nbuf)), sizeof (nbuf));
+}
+
+START_TEST(recorded_file)
+{
+	char fn[] = "/tmp/check_gcntracker_XXXXXX";
+	int fd = mkstemp (fn);
+	ck_assert (fd >= 0);
+
+	recordPacket (fd, TYPE_IM_ALIVE, 0, 0, 0, 0, 0);
+	// BAT position, GRB
+	recordPacket (fd, TYPE_SWIFT_BAT_GRB_POS_ACK_SRC, 306757, 217.9197, 36.3022, 0.05, 0x02);
+	// XRT position
+	recordPacket (fd, TYPE_SWIFT_XRT_POSITION_SRC, 306757, 217.9203, 36.3003, 0.0016, 0x02);
+	// BAT position, not GRB (known source)
+	recordPacket (fd, TYPE_SWIFT_BAT_GRB_POS_ACK_SRC, 306758, 83.6331, 22.0145, 0.05, 0x02 | 0x20);
+	// BAT NACK
+	recordPacket (fd, TYPE_SWIFT_BAT_GRB_POS_NACK_SRC, 306759, 0, 0, 0, 0);
+	recordPacket (fd, TYPE_KILL_SOCKET, 0, 0, 0, 0, 0);
+
+	// replay it as Grbd::replayNext does
+	ck_assert_int_eq (lseek (fd, 0, SEEK_SET), 0);
+
+	RecordingParser parser;
+	int32_t packet[SIZ_PKT];
+	std::vector <int> types;
+	while (read (fd, packet, sizeof (packet)) == sizeof (packet))
+		types.push_back (parser.parsePacket (packet));
+
+	close (fd);
+	unlink (fn);
+
+	ck_assert_int_eq (types.size (), 6);
+	ck_assert_int_eq (types[1], TYPE_SWIFT_BAT_GRB_POS_ACK_SRC);
+	ck_assert_int_eq (types[5], TYPE_KILL_SOCKET);
+
+	ck_assert_int_eq (parser.alive, 1);
+	ck_assert_int_eq (parser.killed, 1);
+
+	ck_assert_int_eq (parser.points.size (), 3);
+
+	ck_assert_int_eq (parser.points[0].grb_id, 306757);
+	ck_assert_int_eq (parser.points[0].type, TYPE_SWIFT_BAT_GRB_POS_ACK_SRC);
+	ck_assert_dbl_eq (parser.points[0].ra, 217.9197, 10e-5);
+	ck_assert_dbl_eq (parser.points[0].dec, 36.3022, 10e-5);
+	ck_assert_dbl_eq (parser.points[0].errorbox, 0.05, 10e-5);
+	ck_assert (parser.points[0].is_grb == true);
+	ck_assert (parser.points[0].insertOnly == false);
+
+	ck_assert_int_eq (parser.points[1].type, TYPE_SWIFT_XRT_POSITION_SRC);
+	ck_assert_dbl_eq (parser.points[1].errorbox, 0.0016, 10e-5);
+	ck_assert (parser.points[1].is_grb == true);
+
+	ck_assert_int_eq (parser.points[2].grb_id, 306758);
+	ck_assert (parser.points[2].is_grb == false);
+
+	// NACK marks GRB as not GRB and stores raw packet
+	ck_assert_int_eq (parser.notGrb.size (), 1);
+	ck_assert_int_eq (parser.notGrb[0], 306759);
+	ck_assert_int_eq (parser.raw.size (), 1);
+	ck_assert_int_eq (parser.raw[0], TYPE_SWIFT_BAT_GRB_POS_NACK_SRC);
+}
+END_TEST
+
+Suite * gcntracker_suite (void)
+{
+	Suite *s;
+	TCase *tc_gcntracker;
+
+	s = suite_create ("GCN tracker");
+	tc_gcntracker = tcase_create ("Recorded GCN notices");
+
+	tcase_add_test (tc_gcntracker, replay);
+	tcase_add_test (tc_gcntracker, sources);
+	tcase_add_test (tc_gcntracker, recorded_file);
+	suite_add_tcase (s, tc_gcntracker);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = gcntracker_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
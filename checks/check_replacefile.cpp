@@ -0,0 +1,160 @@
+#include <check.h>
+#include <check_utils.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "utilsfunc.h"
+
+static char dir[50];
+
+static std::string readFile (const std::string &fn)
+{
+	std::ifstream is (fn.c_str ());
+	std::ostringstream os;
+	os << is.rdbuf ();
+	return os.str ();
+}
+
+void setup_replacefile (void)
+{
+	strcpy (dir, "/tmp/rts2_replacefile_XXXXXX");
+	ck_assert (mkdtemp (dir) != NULL);
+}
+
+void teardown_replacefile (void)
+{
+	rmdir_r (dir);
+}
+
+START_TEST(replace)
+{
+	std::string fn = std::string (dir) + "/autosave";
+
+	ck_assert_int_eq (replaceFile (fn.c_str (), "a = \"1\"\n"), 0);
+	ck_assert (readFile (fn) == "a = \"1\"\n");
+
+	// shorter content, no trailing data of the old content
+	ck_assert_int_eq (replaceFile (fn.c_str (), "b = \"2\"\n"), 0);
+	ck_assert (readFile (fn) == "b = \"2\"\n");
+
+	// temporary file was renamed
+	struct stat sb;
+	ck_assert_int_eq (stat ((fn + ".tmp").c_str (), &sb), -1);
+
+	std::string large (1024 * 1024, 'x');
+	ck_assert_int_eq (replaceFile (fn.c_str (), large), 0);
+	ck_assert (readFile (fn) == large);
+
+	// permissions of the replaced file are kept
+	ck_assert_int_eq (chmod (fn.c_str (), 0640), 0);
+	ck_assert_int_eq (replaceFile (fn.c_str (), "c = \"3\"\n"), 0);
+	ck_assert_int_eq (stat (fn.c_str (), &sb), 0);
+	ck_assert_int_eq (sb.st_mode & 07777, 0640);
+}
+END_TEST
+
+START_TEST(failure)
+{
+	std::string fn = std::string (dir) + "/missing/autosave";
+	ck_assert_int_eq (replaceFile (fn.c_str (), "a = \"1\"\n"), -1);
+	ck_assert_int_eq (errno, ENOENT);
+
+	// file is replaced by a directory - rename fails, old content and no temporary file are kept
+	fn = std::string (dir) + "/autosave";
+	ck_assert_int_eq (mkdir (fn.c_str (), 0777), 0);
+	ck_assert_int_eq (replaceFile (fn.c_str (), "a = \"1\"\n"), -1);
+	struct stat sb;
+	ck_assert_int_eq (stat ((fn + ".tmp").c_str (), &sb), -1);
+	ck_assert_int_eq (stat (fn.c_str (), &sb), 0);
+	ck_assert (S_ISDIR (sb.st_mode));
+}
+END_TEST
+
+static void writeFile (const std::string &fn, const std::string &content)
+{
+	std::ofstream os (fn.c_str ());
+	os << content;
+}
+
+START_TEST(checkpoint)
+{
+	std::string fn = std::string (dir) + "/checkpoint";
+	std::vector <std::string> lines;
+
+	// missing checkpoint - nothing was done
+	ck_assert_int_eq (readCheckpoint (fn.c_str (), lines), 0);
+	ck_assert_int_eq (lines.size (), 0);
+
+	writeFile (fn, "/data/a.fits\n/data/b.fits\n");
+	ck_assert_int_eq (readCheckpoint (fn.c_str (), lines), 0);
+	ck_assert_int_eq (lines.size (), 2);
+	ck_assert_str_eq (lines[0].c_str (), "/data/a.fits");
+	ck_assert_str_eq (lines[1].c_str (), "/data/b.fits");
+	ck_assert (readFile (fn) == "/data/a.fits\n/data/b.fits\n");
+
+	// interrupted run left partial line, which is removed
+	writeFile (fn, "/data/a.fits\n/data/b.fits\n/data/c.f");
+	lines.clear ();
+	ck_assert_int_eq (readCheckpoint (fn.c_str (), lines), 0);
+	ck_assert_int_eq (lines.size (), 2);
+	ck_assert_str_eq (lines[1].c_str (), "/data/b.fits");
+	ck_assert (readFile (fn) == "/data/a.fits\n/data/b.fits\n");
+
+	// resumed run appends complete lines
+	FILE *f = fopen (fn.c_str (), "a");
+	ck_assert (f != NULL);
+	fprintf (f, "/data/c.fits\n");
+	fclose (f);
+	lines.clear ();
+	ck_assert_int_eq (readCheckpoint (fn.c_str (), lines), 0);
+	ck_assert_int_eq (lines.size (), 3);
+	ck_assert_str_eq (lines[2].c_str (), "/data/c.fits");
+
+	// only partial line
+	writeFile (fn, "/data/a");
+	lines.clear ();
+	ck_assert_int_eq (readCheckpoint (fn.c_str (), lines), 0);
+	ck_assert_int_eq (lines.size (), 0);
+	ck_assert (readFile (fn) == "");
+}
+END_TEST
+
+Suite * replacefile_suite (void)
+{
+	Suite *s;
+	TCase *tc_replacefile;
+
+	s = suite_create ("Replace file");
+	tc_replacefile = tcase_create ("Atomic file replace");
+	tcase_add_checked_fixture (tc_replacefile, setup_replacefile, teardown_replacefile);
+
+	tcase_add_test (tc_replacefile, replace);
+	tcase_add_test (tc_replacefile, failure);
+	tcase_add_test (tc_replacefile, checkpoint);
+	suite_add_tcase (s, tc_replacefile);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = replacefile_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,164 @@
+#include <check.h>
+#include <check_utils.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "robuststat.h"
+#include "imghdr.h"
+
+// reference median, by sorting
+static double sortMedian (std::vector <double> v)
+{
+	std::sort (v.begin (), v.end ());
+	size_t n = v.size ();
+	return (v[(n - 1) / 2] + v[n / 2]) / 2.0;
+}
+
+static double sortMAD (const std::vector <double> &v, double m)
+{
+	std::vector <double> d;
+	for (std::vector <double>::const_iterator iter = v.begin (); iter != v.end (); iter++)
+		d.push_back (fabs (*iter - m));
+	return sortMedian (d);
+}
+
+START_TEST(small_arrays)
+{
+	uint16_t u[] = {5, 1, 4, 2, 3};
+	double mad;
+	ck_assert_dbl_eq (rts2core::robustMedian (u, 5, &mad), 3, 1e-10);
+	ck_assert_dbl_eq (mad, 1, 1e-10);
+
+	ck_assert_dbl_eq (rts2core::robustMedian (u, 4, &mad), 3, 1e-10);
+	ck_assert_dbl_eq (mad, 1.5, 1e-10);
+
+	float f[] = {2.5, NAN, -1, 7, 3};
+	ck_assert_dbl_eq (rts2core::robustMedian (f, 5, &mad), 2.75, 1e-10);
+	ck_assert_dbl_eq (mad, 2, 1e-10);
+
+	int32_t l[] = {-100000, 5, 7, 100000};
+	ck_assert_dbl_eq (rts2core::robustMedian (l, 4, &mad), 6, 1e-10);
+	ck_assert_dbl_eq (mad, 49997.5, 1e-10);
+}
+END_TEST
+
+START_TEST(large_arrays)
+{
+	srandom (1);
+	size_t n = 300001;
+	std::vector <uint16_t> u (n);
+	std::vector <float> f (n);
+	std::vector <double> ref (n);
+	for (size_t i = 0; i < n; i++)
+	{
+		u[i] = 1000 + random () % 200 + ((i % 1000 == 0) ? 30000 : 0);
+		f[i] = u[i] / 3.0f;
+		ref[i] = u[i];
+	}
+	double m = sortMedian (ref);
+	double mad = sortMAD (ref, m);
+
+	double rmad;
+	ck_assert_dbl_eq (rts2core::robustMedian (&(u[0]), n, &rmad), m, 1e-10);
+	ck_assert_dbl_eq (rmad, mad, 1e-10);
+
+	ck_assert_dbl_eq (rts2core::robustMedian (&(f[0]), n, &rmad), (float) (m / 3.0), 1e-4);
+	ck_assert_dbl_eq (rmad, mad / 3.0, 1e-3);
+
+	// even number of values
+	ref.pop_back ();
+	m = sortMedian (ref);
+	ck_assert_dbl_eq (rts2core::robustMedian (&(u[0]), n - 1, &rmad), m, 1e-10);
+	ck_assert_dbl_eq (rmad, sortMAD (ref, m), 1e-10);
+}
+END_TEST
+
+START_TEST(clipping)
+{
+	srandom (2);
+	size_t n = 200000;
+	std::vector <uint16_t> u (n);
+	std::vector <double> d (n);
+	for (size_t i = 0; i < n; i++)
+	{
+		u[i] = 500 + random () % 21;
+		// 1% of hot pixels
+		if (i % 100 == 0)
+			u[i] = 60000;
+		d[i] = u[i];
+	}
+	rts2core::RobustStat hs, ds;
+	rts2core::robustStatistics (&(u[0]), n, 1, n, hs, 3, 5, 4);
+	rts2core::robustStatistics (&(d[0]), n, 1, n, ds, 3, 5);
+
+	ck_assert_dbl_eq (hs.min, 500, 1e-10);
+	ck_assert_dbl_eq (hs.max, 60000, 1e-10);
+	ck_assert_int_eq (hs.n, n - n / 100);
+	ck_assert_dbl_eq (hs.mean, 510, 0.2);
+	ck_assert (hs.iterations >= 1);
+
+	ck_assert_int_eq (ds.n, hs.n);
+	ck_assert_dbl_eq (ds.mean, hs.mean, 1e-6);
+	ck_assert_dbl_eq (ds.median, hs.median, 1e-10);
+	ck_assert_dbl_eq (ds.mad, hs.mad, 1e-10);
+}
+END_TEST
+
+START_TEST(regions)
+{
+	size_t w = 200, h = 100;
+	std::vector <int16_t> im (w * h);
+	for (size_t y = 0; y < h; y++)
+		for (size_t x = 0; x < w; x++)
+			im[y * w + x] = (x < 100) ? -10 + (x + y) % 3 : 100 + (x * y) % 5;
+
+	std::vector <rts2core::StatRegion> regions;
+	regions.push_back (rts2core::StatRegion (0, 0, 100, 100));
+	regions.push_back (rts2core::StatRegion (100, 0, 100, 100));
+	regions.push_back (rts2core::StatRegion (10, 10, 20, 30));
+
+	rts2core::robustRegions (&(im[0]), RTS2_DATA_SHORT, w, regions, 0, 0, 2);
+
+	ck_assert_dbl_eq (regions[0].stat.median, -9, 1e-10);
+	ck_assert_dbl_eq (regions[0].stat.min, -10, 1e-10);
+	ck_assert_dbl_eq (regions[0].stat.max, -8, 1e-10);
+	ck_assert_int_eq (regions[1].stat.n, 10000);
+	ck_assert_dbl_eq (regions[1].stat.min, 100, 1e-10);
+	ck_assert_int_eq (regions[2].stat.n, 600);
+	ck_assert_dbl_eq (regions[2].stat.max, -8, 1e-10);
+}
+END_TEST
+
+Suite * robuststat_suite (void)
+{
+	Suite *s;
+	TCase *tc_robuststat;
+
+	s = suite_create ("Robust statistics");
+	tc_robuststat = tcase_create ("Robust statistics tests");
+
+	tcase_add_test (tc_robuststat, small_arrays);
+	tcase_add_test (tc_robuststat, large_arrays);
+	tcase_add_test (tc_robuststat, clipping);
+	tcase_add_test (tc_robuststat, regions);
+	suite_add_tcase (s, tc_robuststat);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = robuststat_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
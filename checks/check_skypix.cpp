@@ -0,0 +1,119 @@
+#include <check.h>
+#include <check_utils.h>
+#include <stdlib.h>
+
+#include <libnova/libnova.h>
+
+#include "skypix.h"
+
+static bool inRanges (rts2core::SkyPixRanges &ranges, int pix)
+{
+	for (rts2core::SkyPixRanges::iterator iter = ranges.begin (); iter != ranges.end (); iter++)
+	{
+		if (pix >= iter->first && pix <= iter->second)
+			return true;
+	}
+	return false;
+}
+
+// check that all points inside cone are covered by ranges
+static void checkCone (double ra, double dec, double radius)
+{
+	rts2core::SkyPixRanges ranges;
+	rts2core::skyPixRanges (ra, dec, radius, ranges);
+
+	ck_assert (ranges.size () > 0);
+	for (size_t i = 1; i < ranges.size (); i++)
+		ck_assert (ranges[i - 1].second < ranges[i].first);
+
+	struct ln_equ_posn center, pos;
+	center.ra = ra;
+	center.dec = dec;
+	for (int i = 0; i < 2000; i++)
+	{
+		pos.dec = dec + (random () / (double) RAND_MAX * 2 - 1) * radius;
+		if (pos.dec > 90 || pos.dec < -90)
+			continue;
+		pos.ra = ra + (random () / (double) RAND_MAX * 2 - 1) * 180;
+		// points on the cone border
+		if (i % 2)
+			pos.dec = dec + ((i % 4 == 1) ? radius : -radius) * 0.999;
+		if (ln_get_angular_separation (&center, &pos) > radius)
+			continue;
+		ck_assert_msg (inRanges (ranges, skypix (pos.ra, pos.dec)), "position %f %f in cone %f %f %f not in ranges", pos.ra, pos.dec, ra, dec, radius);
+	}
+}
+
+START_TEST(pixels)
+{
+	ck_assert_int_eq (skypix (0, -90), 0);
+	ck_assert_int_eq (skypix (359.99999, 90), SKYPIX_ZONES * SKYPIX_CELLS - 1);
+	ck_assert_int_eq (skypix (-0.05, 0), skypix (359.95, 0));
+	ck_assert_int_eq (skypix (360.05, 0), skypix (0.05, 0));
+	ck_assert_int_eq (skypix (10.05, 0.05), (900 * SKYPIX_CELLS) + 100);
+}
+END_TEST
+
+START_TEST(cones)
+{
+	srandom (1);
+	checkCone (10, 20, 0.5);
+	checkCone (0.1, -30, 1);
+	checkCone (359.9, 45, 2);
+	checkCone (120, 85, 3);
+	checkCone (300, -89.5, 1);
+	checkCone (180, 0, 20);
+
+	for (int i = 0; i < 200; i++)
+		checkCone (random () / (double) RAND_MAX * 360, random () / (double) RAND_MAX * 180 - 90, random () / (double) RAND_MAX * 5);
+
+	rts2core::SkyPixRanges ranges;
+	// small cone away from RA 0 - one range per zone
+	rts2core::skyPixRanges (10, 20, 0.5, ranges);
+	ck_assert_int_eq (ranges.size (), 11);
+	// cone around the pole - one continuous range
+	rts2core::skyPixRanges (10, 89.8, 0.5, ranges);
+	ck_assert_int_eq (ranges.size (), 1);
+	ck_assert_int_eq (ranges[0].second, SKYPIX_ZONES * SKYPIX_CELLS - 1);
+}
+END_TEST
+
+START_TEST(condition)
+{
+	ck_assert_str_eq (rts2core::skyPixCondition ("tar_pix", 0, 0, 100).c_str (), "true");
+	// cone crossing RA 0
+	ck_assert_str_eq (rts2core::skyPixCondition ("tar_pix", 0.01, 0.05, 0.01).c_str (), "(tar_pix = 3240000 OR tar_pix = 3243599)");
+	ck_assert_str_eq (rts2core::skyPixCondition ("tar_pix", 10, 0.05, 0.02).c_str (), "(tar_pix BETWEEN 3240099 AND 3240100)");
+}
+END_TEST
+
+Suite * skypix_suite (void)
+{
+	Suite *s;
+	TCase *tc_skypix;
+
+	s = suite_create ("SkyPix");
+	tc_skypix = tcase_create ("Sky pixelization");
+
+	tcase_add_test (tc_skypix, pixels);
+	tcase_add_test (tc_skypix, cones);
+	tcase_add_test (tc_skypix, condition);
+	suite_add_tcase (s, tc_skypix);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = skypix_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,137 @@
+#include <check.h>
+#include <check_utils.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "../src/camd/starfield.h"
+#include "imghdr.h"
+
+START_TEST(noise)
+{
+	rts2camd::NoiseGenerator gen (1);
+
+	std::vector <float> u (100003);
+	gen.uniform (&(u[0]), u.size ());
+	double sum = 0;
+	for (size_t i = 0; i < u.size (); i++)
+	{
+		ck_assert (u[i] > 0 && u[i] <= 1);
+		sum += u[i];
+	}
+	ck_assert_dbl_eq (sum / u.size (), 0.5, 0.005);
+
+	std::vector <float> g (1000001);
+	gen.gaussian (&(g[0]), g.size ());
+	double s = 0, s2 = 0;
+	for (size_t i = 0; i < g.size (); i++)
+	{
+		s += g[i];
+		s2 += g[i] * g[i];
+	}
+	ck_assert_dbl_eq (s / g.size (), 0, 0.005);
+	ck_assert_dbl_eq (s2 / g.size (), 1, 0.01);
+
+	s = s2 = 0;
+	for (int i = 0; i < 100000; i++)
+	{
+		int p = gen.poisson (3.5);
+		s += p;
+		s2 += p * p;
+	}
+	s /= 100000;
+	ck_assert_dbl_eq (s, 3.5, 0.05);
+	ck_assert_dbl_eq (s2 / 100000 - s * s, 3.5, 0.1);
+}
+END_TEST
+
+START_TEST(psf_flux)
+{
+	rts2camd::StarField field;
+	field.setPSF (4, 4, 2.5);
+	field.setDetector (0, 0, 0, 0);
+	field.addStar (100, 100, 1e6);
+
+	std::vector <float> data (200 * 200);
+	field.render (&(data[0]), RTS2_DATA_FLOAT, 200, 200, 0, 0, 1);
+
+	double sum = 0;
+	int maxi = 0;
+	for (size_t i = 0; i < data.size (); i++)
+	{
+		sum += data[i];
+		if (data[i] > data[maxi])
+			maxi = i;
+	}
+	// flux outside of stamp is below 1%
+	ck_assert_dbl_eq (sum, 1e6, 1e4);
+	ck_assert_int_eq (maxi, 100 * 200 + 100);
+
+	// half of peak is reached at FWHM / 2
+	ck_assert_dbl_eq (data[100 * 200 + 102] / data[100 * 200 + 100], 0.5, 0.1);
+
+	// shifted frame (mosaic channel) sees star at the other position
+	std::fill (data.begin (), data.end (), 0);
+	field.render (&(data[0]), RTS2_DATA_FLOAT, 200, 200, 50, 50, 1);
+	ck_assert (data[50 * 200 + 50] > data[100 * 200 + 100]);
+}
+END_TEST
+
+START_TEST(threads)
+{
+	rts2camd::StarField single (1);
+	rts2camd::StarField multi (4);
+	rts2camd::NoiseGenerator gen (5);
+	single.addRandomStars (500, 640, 480, 30000, gen);
+	for (std::vector <rts2camd::SimStar>::const_iterator iter = single.getStars ().begin (); iter != single.getStars ().end (); iter++)
+		multi.addStar (iter->x, iter->y, iter->flux);
+	single.setDetector (400, 50, 5, 1.5);
+	multi.setDetector (400, 50, 5, 1.5);
+
+	std::vector <uint16_t> d1 (640 * 480);
+	std::vector <uint16_t> d2 (640 * 480);
+	single.render (&(d1[0]), RTS2_DATA_USHORT, 640, 480, 0, 0, 42);
+	multi.render (&(d2[0]), RTS2_DATA_USHORT, 640, 480, 0, 0, 42);
+	ck_assert (d1 == d2);
+
+	// background is bias + sky
+	double sum = 0;
+	for (int i = 0; i < 640; i++)
+		sum += d1[i];
+	ck_assert (sum / 640 > 440 && sum / 640 < 520);
+
+	multi.render (&(d2[0]), RTS2_DATA_USHORT, 640, 480, 0, 0, 43);
+	ck_assert (d1 != d2);
+}
+END_TEST
+
+Suite * starfield_suite (void)
+{
+	Suite *s;
+	TCase *tc_starfield;
+
+	s = suite_create ("Star field");
+	tc_starfield = tcase_create ("Star field simulator");
+
+	tcase_add_test (tc_starfield, noise);
+	tcase_add_test (tc_starfield, psf_flux);
+	tcase_add_test (tc_starfield, threads);
+	suite_add_tcase (s, tc_starfield);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = starfield_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,140 @@
+#include <check.h>
+#include <check_utils.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "telemetry.h"
+
+#define RING_FILE   "check_telemetry.ring"
+
+static void writeRecords (rts2core::TelemetryRing &ring, int from, int n)
+{
+	for (int i = from; i < from + n; i++)
+	{
+		rts2core::TelemetryRecord rec;
+		memset (&rec, 0, sizeof (rec));
+		rec.time = 1000 + i * 0.01;
+		rec.tarRa = i;
+		rec.error = i / 3600.0;
+		ring.write (rec);
+		ck_assert_int_eq (rec.seq, i);
+	}
+}
+
+void setup_telemetry (void)
+{
+	unlink (RING_FILE);
+}
+
+void teardown_telemetry (void)
+{
+	unlink (RING_FILE);
+}
+
+START_TEST(write_read)
+{
+	rts2core::TelemetryRing writer;
+	ck_assert_int_eq (writer.create (RING_FILE, 100), 0);
+	writeRecords (writer, 0, 50);
+
+	rts2core::TelemetryRing reader;
+	ck_assert_int_eq (reader.open (RING_FILE), 0);
+	ck_assert_int_eq (reader.getCount (), 50);
+	ck_assert_int_eq (reader.getFirst (), 0);
+
+	rts2core::TelemetryRecord rec;
+	ck_assert (reader.read (10, rec));
+	ck_assert_dbl_eq (rec.tarRa, 10, 1e-10);
+	ck_assert (!reader.read (50, rec));
+
+	// wrap around, first 30 records are overwritten
+	writeRecords (writer, 50, 80);
+	ck_assert_int_eq (reader.getCount (), 130);
+	ck_assert_int_eq (reader.getFirst (), 30);
+	ck_assert (!reader.read (10, rec));
+	ck_assert (reader.read (129, rec));
+	ck_assert_dbl_eq (rec.tarRa, 129, 1e-10);
+
+	std::vector <rts2core::TelemetryRecord> recs;
+	uint64_t next = reader.read (0, recs, 20);
+	ck_assert_int_eq (recs.size (), 20);
+	ck_assert_int_eq (recs[0].seq, 30);
+	ck_assert_int_eq (next, 50);
+
+	// one record per 0.1 second
+	recs.clear ();
+	next = reader.read (next, recs, 1000, 0.1);
+	ck_assert_int_eq (next, 130);
+	ck_assert_int_eq (recs.size (), 8);
+	ck_assert_int_eq (recs[1].seq, 60);
+
+	ck_assert_int_eq (reader.find (1000.995), 100);
+	ck_assert_int_eq (reader.find (0), 30);
+	ck_assert_int_eq (reader.find (2000), 130);
+}
+END_TEST
+
+START_TEST(reopen)
+{
+	rts2core::TelemetryRing writer;
+	ck_assert_int_eq (writer.create (RING_FILE, 100), 0);
+	writeRecords (writer, 0, 10);
+	writer.close ();
+
+	// records are kept when layout does not change
+	ck_assert_int_eq (writer.create (RING_FILE, 100), 0);
+	ck_assert_int_eq (writer.getCount (), 10);
+	writer.close ();
+
+	rts2core::TelemetryRing reader;
+	ck_assert_int_eq (reader.open (RING_FILE), 0);
+
+	// ring is reset when capacity changes, reader keeps the old ring
+	ck_assert_int_eq (writer.create (RING_FILE, 200), 0);
+	ck_assert_int_eq (writer.getCount (), 0);
+	ck_assert_int_eq (reader.getCount (), 10);
+	rts2core::TelemetryRecord rec;
+	ck_assert (reader.read (9, rec));
+	ck_assert_dbl_eq (rec.tarRa, 9, 1e-10);
+	writer.close ();
+
+	// truncated ring is refused
+	ck_assert_int_eq (truncate (RING_FILE, 1000), 0);
+	ck_assert_int_eq (reader.open (RING_FILE), -1);
+	ck_assert (!reader.isOpen ());
+
+	ck_assert_int_eq (reader.open ("nonexisting.ring"), -1);
+	ck_assert (!reader.isOpen ());
+}
+END_TEST
+
+Suite * telemetry_suite (void)
+{
+	Suite *s;
+	TCase *tc_telemetry;
+
+	s = suite_create ("Telemetry");
+	tc_telemetry = tcase_create ("Telemetry ring file");
+
+	tcase_add_checked_fixture (tc_telemetry, setup_telemetry, teardown_telemetry);
+	tcase_add_test (tc_telemetry, write_read);
+	tcase_add_test (tc_telemetry, reopen);
+	suite_add_tcase (s, tc_telemetry);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = telemetry_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
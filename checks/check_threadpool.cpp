@@ -0,0 +1,410 @@
+#include <check.h>
+#include <check_utils.h>
+#include <stdlib.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "block.h"
+#include "mpmcqueue.h"
+#include "threadpool.h"
+#include "conncompletion.h"
+#include "connmailbox.h"
+#include "snapshot.h"
+
+#define PRODUCERS   4
+#define CONSUMERS   4
+#define PER_PRODUCER  200000
+
+static rts2core::MPMCQueue <long> *queue;
+static std::vector <int> seen;
+static long consumed;
+
+static void *producer (void *arg)
+{
+	long base = (long) arg * PER_PRODUCER;
+	for (long i = 0; i < PER_PRODUCER; i++)
+	{
+		while (!queue->push (base + i))
+			sched_yield ();
+	}
+	return NULL;
+}
+
+static void *consumer (void *arg)
+{
+	long v;
+	while (__atomic_load_n (&consumed, __ATOMIC_RELAXED) < PRODUCERS * PER_PRODUCER)
+	{
+		if (queue->pop (v))
+		{
+			__atomic_add_fetch (&(seen[v]), 1, __ATOMIC_RELAXED);
+			__atomic_add_fetch (&consumed, 1, __ATOMIC_RELAXED);
+		}
+		else
+		{
+			sched_yield ();
+		}
+	}
+	return NULL;
+}
+
+START_TEST(mpmc_stress)
+{
+	queue = new rts2core::MPMCQueue <long> (100);
+	ck_assert_int_eq (queue->capacity (), 128);
+
+	long v;
+	ck_assert (queue->pop (v) == false);
+	for (int i = 0; i < 128; i++)
+		ck_assert (queue->push (i));
+	ck_assert (queue->push (128) == false);
+	ck_assert_int_eq (queue->size (), 128);
+	for (int i = 0; i < 128; i++)
+	{
+		ck_assert (queue->pop (v));
+		ck_assert_int_eq (v, i);
+	}
+	ck_assert (queue->empty ());
+
+	seen.assign (PRODUCERS * PER_PRODUCER, 0);
+	consumed = 0;
+
+	pthread_t threads[PRODUCERS + CONSUMERS];
+	for (long i = 0; i < PRODUCERS; i++)
+		pthread_create (threads + i, NULL, producer, (void *) i);
+	for (long i = 0; i < CONSUMERS; i++)
+		pthread_create (threads + PRODUCERS + i, NULL, consumer, NULL);
+	for (int i = 0; i < PRODUCERS + CONSUMERS; i++)
+		pthread_join (threads[i], NULL);
+
+	ck_assert_int_eq (consumed, PRODUCERS * PER_PRODUCER);
+	// every value received exactly once
+	for (size_t i = 0; i < seen.size (); i++)
+		ck_assert_int_eq (seen[i], 1);
+
+	delete queue;
+}
+END_TEST
+
+static long square (long x)
+{
+	return x * x;
+}
+
+static rts2core::ThreadPool *pool;
+
+/**
+ * Sums range, splitting it to subtasks.
+ */
+class SumTask:public rts2core::PoolTask
+{
+	public:
+		SumTask (long _from, long _to):rts2core::PoolTask () { from = _from; to = _to; sum = 0; }
+
+		virtual void run ()
+		{
+			if (to - from < 1000)
+			{
+				for (long i = from; i < to; i++)
+					sum += i;
+				return;
+			}
+			long mid = (from + to) / 2;
+			SumTask left (from, mid);
+			SumTask right (mid, to);
+			pool->submit (&left);
+			pool->submit (&right);
+			pool->wait (&left);
+			pool->wait (&right);
+			sum = left.sum + right.sum;
+		}
+
+		long from;
+		long to;
+		long sum;
+};
+
+class FailingTask:public rts2core::PoolTask
+{
+	public:
+		virtual void run () { throw rts2core::Error ("task failed"); }
+};
+
+class ThrowingTask:public rts2core::PoolTask
+{
+	public:
+		ThrowingTask (int _what):rts2core::PoolTask () { what = _what; }
+
+		virtual void run ()
+		{
+			if (what == 0)
+				throw std::runtime_error ("runtime error");
+			throw what;
+		}
+
+	private:
+		int what;
+};
+
+START_TEST(pool_tasks)
+{
+	pool = new rts2core::ThreadPool (4, 64);
+	ck_assert_int_eq (pool->start (), 0);
+
+	std::vector <rts2core::FunctionTask <long, long> *> tasks;
+	for (long i = 0; i < 10000; i++)
+	{
+		tasks.push_back (new rts2core::FunctionTask <long, long> (square, i));
+		pool->submit (tasks.back ());
+	}
+	long sum = 0;
+	for (long i = 0; i < 10000; i++)
+	{
+		sum += tasks[i]->get ();
+		delete tasks[i];
+	}
+	ck_assert_int_eq (sum, 333283335000L);
+
+	SumTask st (0, 10000000);
+	pool->submit (&st);
+	st.wait ();
+	ck_assert_int_eq (st.sum, 49999995000000L);
+
+	FailingTask ft;
+	pool->submit (&ft);
+	ft.wait ();
+	ck_assert (ft.isFailed ());
+	ck_assert_str_eq (ft.getError ().c_str (), "task failed");
+
+	ThrowingTask tt0 (0);
+	ThrowingTask tt1 (1);
+	pool->submit (&tt0);
+	pool->submit (&tt1);
+	tt0.wait ();
+	tt1.wait ();
+	ck_assert (tt0.isFailed ());
+	ck_assert_str_eq (tt0.getError ().c_str (), "runtime error");
+	ck_assert (tt1.isFailed ());
+	ck_assert_str_eq (tt1.getError ().c_str (), "unknown exception");
+
+	delete pool;
+
+	// tasks submitted before start wait in the injection queue, tasks which do not fit are refused
+	pool = new rts2core::ThreadPool (2, 4);
+	std::vector <rts2core::FunctionTask <long, long> *> queued;
+	for (long i = 0; i < 4; i++)
+	{
+		queued.push_back (new rts2core::FunctionTask <long, long> (square, i));
+		ck_assert_int_eq (pool->submit (queued.back ()), 0);
+	}
+	rts2core::FunctionTask <long, long> over (square, 4);
+	ck_assert_int_eq (pool->submit (&over), -1);
+	ck_assert_int_eq (pool->getPending (), 4);
+
+	ck_assert_int_eq (pool->start (), 0);
+	sum = 0;
+	for (long i = 0; i < 4; i++)
+	{
+		sum += queued[i]->get ();
+		delete queued[i];
+	}
+	ck_assert_int_eq (sum, 14);
+
+	delete pool;
+}
+END_TEST
+
+class TestBlock:public rts2core::Block
+{
+	public:
+		TestBlock ():rts2core::Block (0, NULL) { setTimeout (USEC_SEC / 100); }
+
+		virtual rts2core::Connection *createClientConnection (rts2core::NetworkAddress *in_addr) { return NULL; }
+		virtual int run () { return 0; }
+};
+
+static int numCompleted;
+static bool inMainThread;
+static pthread_t mainThread;
+
+class CompletionTask:public rts2core::PoolTask
+{
+	public:
+		virtual void run () { usleep (100); }
+		virtual void completed ()
+		{
+			numCompleted++;
+			inMainThread = inMainThread && pthread_equal (pthread_self (), mainThread);
+		}
+};
+
+START_TEST(completion)
+{
+	TestBlock block;
+	rts2core::ConnCompletion *conn = new rts2core::ConnCompletion (&block, 16);
+	ck_assert_int_eq (conn->init (), 0);
+	block.addConnection (conn);
+
+	rts2core::ThreadPool tp (4);
+	ck_assert_int_eq (tp.start (), 0);
+
+	numCompleted = 0;
+	inMainThread = true;
+	mainThread = pthread_self ();
+
+	// more tasks than completion queue size
+	for (int i = 0; i < 100; i++)
+		tp.submit (new CompletionTask (), conn);
+
+	double end = getNow () + 5;
+	while (numCompleted < 100 && getNow () < end)
+		block.oneRunLoop ();
+
+	ck_assert_int_eq (numCompleted, 100);
+	ck_assert (inMainThread);
+}
+END_TEST
+
+// snapshot value, consistent only if all members were written together
+struct SnapValue
+{
+	long a;
+	long b[16];
+};
+
+static rts2core::Snapshot <SnapValue> *snapshot;
+static bool snapDone;
+static bool snapConsistent;
+
+static void *snapReader (void *arg)
+{
+	uint64_t lastVer = 0;
+	SnapValue v;
+	while (!__atomic_load_n (&snapDone, __ATOMIC_ACQUIRE))
+	{
+		uint64_t ver = snapshot->read (v);
+		bool ok = ver >= lastVer && (ver == 0 || (long) ver == v.a);
+		for (int i = 0; i < 16; i++)
+			ok = ok && v.b[i] == v.a * i;
+		if (!ok)
+			__atomic_store_n (&snapConsistent, false, __ATOMIC_RELAXED);
+		lastVer = ver;
+	}
+	return NULL;
+}
+
+START_TEST(snapshots)
+{
+	snapshot = new rts2core::Snapshot <SnapValue> ();
+	snapDone = false;
+	snapConsistent = true;
+
+	SnapValue v;
+	ck_assert_int_eq (snapshot->read (v), 0);
+
+	pthread_t readers[4];
+	for (int i = 0; i < 4; i++)
+		pthread_create (readers + i, NULL, snapReader, NULL);
+
+	long published = 0;
+	while (published < 200000)
+	{
+		v.a = published + 1;
+		for (int i = 0; i < 16; i++)
+			v.b[i] = v.a * i;
+		if (snapshot->publish (v) != 0)
+			published++;
+	}
+
+	__atomic_store_n (&snapDone, true, __ATOMIC_RELEASE);
+	for (int i = 0; i < 4; i++)
+		pthread_join (readers[i], NULL);
+
+	ck_assert (snapConsistent);
+	ck_assert_int_eq (snapshot->getVersion (), 200000);
+	ck_assert_int_eq (snapshot->read (v), 200000);
+	ck_assert_int_eq (v.a, 200000);
+
+	delete snapshot;
+}
+END_TEST
+
+static int numRequests;
+
+class CountRequest:public rts2core::MailboxRequest
+{
+	public:
+		virtual void completed ()
+		{
+			numRequests++;
+			inMainThread = inMainThread && pthread_equal (pthread_self (), mainThread);
+		}
+};
+
+static void *mailboxPoster (void *arg)
+{
+	for (int i = 0; i < 50; i++)
+		((rts2core::ConnMailbox *) arg)->post (new CountRequest ());
+	return NULL;
+}
+
+START_TEST(mailbox)
+{
+	TestBlock block;
+	rts2core::ConnMailbox *conn = new rts2core::ConnMailbox (&block, 16);
+	ck_assert_int_eq (conn->init (), 0);
+	block.addConnection (conn);
+
+	numRequests = 0;
+	inMainThread = true;
+	mainThread = pthread_self ();
+
+	pthread_t posters[4];
+	for (int i = 0; i < 4; i++)
+		pthread_create (posters + i, NULL, mailboxPoster, conn);
+	for (int i = 0; i < 4; i++)
+		pthread_join (posters[i], NULL);
+
+	double end = getNow () + 5;
+	while (numRequests < 200 && getNow () < end)
+		block.oneRunLoop ();
+
+	ck_assert_int_eq (numRequests, 200);
+	ck_assert (inMainThread);
+}
+END_TEST
+
+Suite * threadpool_suite (void)
+{
+	Suite *s;
+	TCase *tc_pool;
+
+	s = suite_create ("ThreadPool");
+	tc_pool = tcase_create ("Lock-free queue, thread pool and completions");
+
+	tcase_set_timeout (tc_pool, 60);
+	tcase_add_test (tc_pool, mpmc_stress);
+	tcase_add_test (tc_pool, pool_tasks);
+	tcase_add_test (tc_pool, completion);
+	tcase_add_test (tc_pool, snapshots);
+	tcase_add_test (tc_pool, mailbox);
+	suite_add_tcase (s, tc_pool);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = threadpool_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,8 +4,11 @@
 
 #include "pluto/norad.h"
 #include "pluto/observe.h"
+#include "pluto/tleorbit.h"
 #include <libnova/libnova.h>
 
+#include <cmath>
+
 void setup_tle (void)
 {
 }
@@ -178,6 +181,129 @@ START_TEST(ISS)
 }
 END_TEST
 
+START_TEST(ISS_PASS)
+{
+	const char *tle1 = "1 25544U 98067A   16128.85424799  .00005564  00000-0  90091-4 0  9999";
+	const char *tle2 = "2 25544  51.6438 259.2325 0002021  92.7504  10.7493 15.54477273998701";
+
+	rts2pluto::TLEOrbit orbit;
+	ck_assert_int_eq (orbit.parse (tle1, tle2), 0);
+	ck_assert_int_eq (orbit.getEphem (), 1);
+
+	struct ln_date test_t;
+	test_t.years = 2016;
+	test_t.months = 5;
+	test_t.days = 10;
+	test_t.hours = 3;
+	test_t.minutes = 40;
+	test_t.seconds = 0;
+
+	double JD = ln_get_julian_day (&test_t);
+
+	struct ln_lnlat_posn observer;
+	observer.lng = -4.4643;
+	observer.lat = 40.4610;
+
+	// cached propagator must give the same positions as initialisation for every call
+	double sat_pos[3];
+	double jds[3] = {JD, JD + 0.003, JD + 0.01};
+	double batch_pos[9];
+	ck_assert_int_eq (orbit.propagate (jds, 3, batch_pos), 0);
+	for (int i = 0; i < 3; i++)
+	{
+		test_tle (tle1, tle2, jds[i], &observer, 791, sat_pos);
+		ck_assert_dbl_eq (batch_pos[3 * i], sat_pos[0], 1e-9);
+		ck_assert_dbl_eq (batch_pos[3 * i + 1], sat_pos[1], 1e-9);
+		ck_assert_dbl_eq (batch_pos[3 * i + 2], sat_pos[2], 1e-9);
+	}
+
+	rts2pluto::TLEObserver tobs (observer.lng, observer.lat, 791);
+
+	std::vector <rts2pluto::TLEPass> passes;
+	orbit.getPasses (JD, JD + 20 / 1440.0, tobs, 0, 10, passes);
+	ck_assert_int_eq (passes.size (), 1);
+
+	// set at 3:54:22, culmination at 3:49:08, 39 degrees
+	ck_assert_dbl_eq ((passes[0].set - JD) * 1440.0, 14 + 22 / 60.0, 1);
+	ck_assert_dbl_eq ((passes[0].culmination - JD) * 1440.0, 9 + 8 / 60.0, 1);
+	ck_assert_dbl_eq (passes[0].maxAltitude, 39, 2);
+	ck_assert ((passes[0].rise - JD) * 1440.0 < 7);
+
+	// no pass above 60 degrees
+	orbit.getPasses (JD, JD + 20 / 1440.0, tobs, 0, 60, passes);
+	ck_assert_int_eq (passes.size (), 0);
+
+	std::vector <rts2pluto::TLEOrbit> catalogue (4, orbit);
+	double all_pos[12];
+	ck_assert_int_eq (rts2pluto::propagateAll (catalogue, jds[1], all_pos), 0);
+	ck_assert_dbl_eq (all_pos[9], batch_pos[3], 1e-9);
+
+	rts2core::ThreadPool pool (2);
+	ck_assert_int_eq (pool.start (), 0);
+
+	std::vector <std::vector <rts2pluto::TLEPass> > all_passes;
+	rts2pluto::predictPasses (catalogue, JD, JD + 1, tobs, 0, 10, all_passes, pool);
+	pool.stop ();
+	ck_assert_int_eq (all_passes.size (), 4);
+	ck_assert (all_passes[0].size () >= 1);
+	ck_assert_int_eq (all_passes[3].size (), all_passes[0].size ());
+	ck_assert_dbl_eq (all_passes[3][0].set, all_passes[0][0].set, 1e-9);
+}
+END_TEST
+
+START_TEST(DEEP_PASS)
+{
+	// XMM, Molniya-like and geostationary orbits - all use SDP4 with deep space resonance terms
+	const char *tles[3][2] = {
+		{"1 25989U 99066A   16126.72024749 -.00000083  00000-0  00000+0 0  9995", "2 25989  67.4812  25.2476 8203967  94.8547 359.5975  0.50170988 18843"},
+		{"1 28163U 04005A   16128.50000000  .00000100  00000-0  00000+0 0  9992", "2 28163  62.9000 100.0000 7000000 270.0000  20.0000  2.00600000 90005"},
+		{"1 28884U 05041A   16128.50000000 -.00000200  00000-0  00000+0 0  9995", "2 28884   0.0500  90.0000 0002000 180.0000 200.0000  1.00270000 39001"}
+	};
+
+	std::vector <rts2pluto::TLEOrbit> catalogue;
+	for (int i = 0; i < 30; i++)
+	{
+		rts2pluto::TLEOrbit orbit;
+		ck_assert_int_eq (orbit.parse (tles[i % 3][0], tles[i % 3][1]), 0);
+		ck_assert_int_eq (orbit.getEphem (), 3);
+		catalogue.push_back (orbit);
+	}
+
+	double JD = 2457516.5;
+	rts2pluto::TLEObserver tobs (-4.4643, 40.4610, 791);
+
+	std::vector <std::vector <rts2pluto::TLEPass> > serial (catalogue.size ());
+	for (size_t i = 0; i < catalogue.size (); i++)
+		catalogue[i].getPasses (JD, JD + 3, tobs, 0, 0, serial[i]);
+
+	// parallel prediction must give exactly the same passes as serial one
+	rts2core::ThreadPool pool (4);
+	ck_assert_int_eq (pool.start (), 0);
+
+	for (int run = 0; run < 3; run++)
+	{
+		std::vector <std::vector <rts2pluto::TLEPass> > parallel;
+		rts2pluto::predictPasses (catalogue, JD, JD + 3, tobs, 0, 0, parallel, pool);
+		ck_assert_int_eq (parallel.size (), catalogue.size ());
+		for (size_t i = 0; i < catalogue.size (); i++)
+		{
+			ck_assert_int_eq (parallel[i].size (), serial[i].size ());
+			for (size_t j = 0; j < serial[i].size (); j++)
+			{
+				ck_assert ((std::isnan (parallel[i][j].rise) && std::isnan (serial[i][j].rise)) || parallel[i][j].rise == serial[i][j].rise);
+				ck_assert ((std::isnan (parallel[i][j].set) && std::isnan (serial[i][j].set)) || parallel[i][j].set == serial[i][j].set);
+				ck_assert (parallel[i][j].culmination == serial[i][j].culmination);
+				ck_assert (parallel[i][j].maxAltitude == serial[i][j].maxAltitude);
+			}
+		}
+	}
+	pool.stop ();
+
+	// XMM passes above horizon every ~2 days
+	ck_assert (serial[0].size () >= 1);
+}
+END_TEST
+
 START_TEST(XMM)
 {
 	const char *tle1 = "1 25989U 99066A   16126.72024749 -.00000083  00000-0  00000+0 0  9995";
@@ -220,6 +346,8 @@ Suite * tle_suite (void)
 	tcase_add_checked_fixture (tc_tle, setup_tle, teardown_tle);
 	tcase_add_test (tc_tle, PLUTO);
 	tcase_add_test (tc_tle, ISS);
+	tcase_add_test (tc_tle, ISS_PASS);
+	tcase_add_test (tc_tle, DEEP_PASS);
 //	tcase_add_test (tc_tle, XMM);
 	suite_add_tcase (s, tc_tle);
 
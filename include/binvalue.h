@@ -0,0 +1,169 @@
+/*
+ * Binary encoding of values for the device protocol.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_BINVALUE__
+#define __RTS2_BINVALUE__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @file Binary value frames.
+ *
+ * Frame is sent after PROTO_BINARY_VALUES header line, which holds frame
+ * size in bytes. Frame holds one or more value records. All numbers are
+ * little-endian.
+ *
+ * Record is uint32 size of the rest of the record, uint16 value name
+ * length, name followed by \0 and value parameters. Each parameter
+ * starts with uint8 type tag:
+ *
+ * - BINV_INT32  int32
+ * - BINV_INT64  int64
+ * - BINV_DOUBLE IEEE 754 double
+ * - BINV_STRING uint32 length, string followed by \0
+ * - BINV_TEXT   uint32 length, text followed by \0
+ *
+ * Text parameter holds all parameters of value without binary encoding,
+ * as they would be sent in PROTO_VALUE line.
+ */
+
+#define BINV_INT32       1
+#define BINV_INT64       2
+#define BINV_DOUBLE      3
+#define BINV_STRING      4
+#define BINV_TEXT        5
+
+/**
+ * Maximal size of frame accepted by receiver. Sender splits batches into
+ * frames of at most that size; values with larger binary record are sent
+ * as text.
+ */
+#define BINV_MAX_FRAME   (4 * 1024 * 1024)
+
+namespace rts2core
+{
+
+/**
+ * Builds binary value frame.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class BinaryValueWriter
+{
+	public:
+		BinaryValueWriter () { recordStart = 0; }
+
+		/**
+		 * Start new value record.
+		 */
+		void startValue (const char *name);
+
+		/**
+		 * Finish value record started with startValue.
+		 */
+		void endValue ();
+
+		void addInteger (int32_t v) { buf.push_back (BINV_INT32); putU32 ((uint32_t) v); }
+		void addLong (int64_t v) { buf.push_back (BINV_INT64); putU64 ((uint64_t) v); }
+		void addDouble (double v);
+		void addString (const char *v) { putString (BINV_STRING, v); }
+
+		/**
+		 * Add parameters formatted as text.
+		 */
+		void addText (const char *v) { putString (BINV_TEXT, v); }
+
+		const char *getData () { return &(buf[0]); }
+		size_t size () { return buf.size (); }
+		bool empty () { return buf.empty (); }
+		void clear () { buf.clear (); }
+
+		/**
+		 * Drop records written after given size.
+		 */
+		void truncate (size_t s) { buf.resize (s); recordStart = s; }
+
+	private:
+		std::vector <char> buf;
+		size_t recordStart;
+
+		void putU16 (uint16_t v);
+		void putU32 (uint32_t v);
+		void putU64 (uint64_t v);
+		void putString (uint8_t tag, const char *v);
+};
+
+/**
+ * Decodes binary value frame. Parameters are converted to the requested
+ * type, so values can be decoded with the same calls as text values.
+ * Strings returned point to the frame buffer, which must stay
+ * allocated while the reader is used.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class BinaryValueReader
+{
+	public:
+		BinaryValueReader (char *_data, size_t _len);
+
+		/**
+		 * Move to the next record.
+		 *
+		 * @return 1 if record is available, 0 at end of frame, -1 if frame is malformed
+		 */
+		int nextValue ();
+
+		const char *getName () { return name; }
+
+		/**
+		 * Returns text parameters of the current record, NULL if record holds typed parameters.
+		 */
+		char *getText ();
+
+		bool paramEnd () { return pos >= recordEnd; }
+
+		int paramInteger (int *num);
+		int paramLongLong (long long int *num);
+		int paramDouble (double *num);
+		int paramString (char **str);
+
+	private:
+		unsigned char *data;
+		size_t len;
+		size_t pos;
+		size_t recordEnd;
+		const char *name;
+
+		// numbers requested as strings
+		char numBuf[4][32];
+		int numBufI;
+
+		uint16_t getU16 ();
+		uint32_t getU32 ();
+		uint64_t getU64 ();
+
+		// parses next parameter, returns its tag or -1 on error
+		int nextParam (int64_t &l, double &d, char *&s);
+};
+
+}
+
+#endif // !__RTS2_BINVALUE__
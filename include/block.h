@@ -87,6 +87,8 @@
 #define PROTO_SHARED_FULL      "J"
 /** Shared memory segment ends prematurely. @ingroup RTS2Protocol */
 #define PROTO_SHARED_KILLED    "K"
+/** The command is followed by binary value frame, see binvalue.h. @ingroup RTS2Protocol */
+#define PROTO_BINARY_VALUES    "W"
 
 
 class Rts2ClientTCPDataConn;
@@ -664,6 +666,14 @@ class Block: public App
 		 */
 		void deleteTimers (int event_type);
 
+		/**
+		 * Remove timers with a given type and argument.
+		 *
+		 * @param event_type Type of event.
+		 * @param arg        Event argument.
+		 */
+		void deleteTimers (int event_type, void *arg);
+
 		/**
 		 * Updates metainformation about given value.
 		 *
@@ -706,10 +716,17 @@ class Block: public App
 		 */
 		bool isForWrite (int fd) { return getPollEvents (fd) & POLLOUT; }
 
+		/**
+		 * True if values from connected devices shall be requested in binary value frames.
+		 */
+		bool getBinaryValues () { return binaryValues; }
+
 	protected:
 
 		virtual Connection *createClientConnection (NetworkAddress * in_addr) = 0;
 
+		virtual int processOption (int in_opt);
+
 		virtual void childReturned (pid_t child_pid);
 
 		/**
@@ -806,6 +823,8 @@ class Block: public App
 		int port;
 		long int idle_timeout;	 // in usec
 
+		bool binaryValues;
+
 		struct pollfd *fds;
 		nfds_t pollsize;
 		nfds_t npolls;
@@ -0,0 +1,175 @@
+/*
+ * Pool of large data buffers.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_BUFFERPOOL__
+#define __RTS2_BUFFERPOOL__
+
+#include <map>
+#include <vector>
+#include <pthread.h>
+#include <stddef.h>
+
+namespace rts2core
+{
+
+/**
+ * Buffer pool statistics.
+ */
+struct BufferPoolStats
+{
+	// number of allocate calls
+	unsigned long allocations;
+	// allocations served from cached buffers
+	unsigned long hits;
+	// allocations which mapped new memory
+	unsigned long misses;
+	// buffers which cannot be locked in memory
+	unsigned long lockFailures;
+	// [bytes] buffers in use
+	size_t used;
+	// [bytes] free buffers kept for reuse
+	size_t cached;
+	// [bytes] maximal used size
+	size_t peak;
+};
+
+/**
+ * Process wide pool of large buffers - camera readout buffers, received
+ * image data, channel data and analysis arrays.
+ *
+ * Buffer sizes are rounded to size classes (4, 5, 6 or 7 times power of
+ * 2, so at most 25% is wasted), freed buffers are kept in per class
+ * free lists and reused by next allocations of the same class. Buffers
+ * are mapped from anonymous memory, backed by huge pages if they are
+ * large enough, faulted in when mapped and optionally locked in memory,
+ * so neither readout nor image processing pays for page faults.
+ *
+ * Buffers are reference counted. A stage passing buffer to the next
+ * stage (readout to FITS writing to analysis) either hands over its
+ * reference, or calls retain and later release, if it keeps using the
+ * buffer. Buffer is returned to the pool when the last reference is
+ * released.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class BufferPool
+{
+	public:
+		BufferPool ();
+		~BufferPool ();
+
+		/**
+		 * Returns process pool.
+		 */
+		static BufferPool &instance ();
+
+		/**
+		 * Allocate buffer with a single reference.
+		 *
+		 * @return buffer, NULL if memory cannot be mapped
+		 */
+		void *allocate (size_t size);
+
+		/**
+		 * Add reference to the buffer.
+		 */
+		void retain (void *buf);
+
+		/**
+		 * Release reference to the buffer. NULL is ignored.
+		 */
+		void release (void *buf);
+
+		/**
+		 * Returns true if buffer was allocated from the pool.
+		 */
+		bool owns (void *buf);
+
+		/**
+		 * Lock newly mapped buffers in memory.
+		 */
+		void setLock (bool _lock) { lock = _lock; }
+
+		/**
+		 * Set maximal size of free buffers kept for reuse.
+		 */
+		void setCacheLimit (size_t limit);
+
+		void getStats (BufferPoolStats &stats);
+
+		/**
+		 * Unmap all free buffers.
+		 */
+		void trim ();
+
+		/**
+		 * Returns size class of the request.
+		 */
+		static size_t sizeClass (size_t size);
+
+	private:
+		pthread_mutex_t mutex;
+
+		// size class, number of references and lock state of buffers in use
+		struct Buffer
+		{
+			size_t size;
+			int refs;
+			bool locked;
+		};
+
+		// free buffer of a size class
+		struct FreeBuffer
+		{
+			void *buf;
+			size_t size;
+			bool locked;
+		};
+
+		std::map <void *, Buffer> buffers;
+		std::map <size_t, std::vector <FreeBuffer> > freeBuffers;
+
+		bool lock;
+		size_t cacheLimit;
+
+		BufferPoolStats st;
+
+		/**
+		 * Map new buffer.
+		 *
+		 * @param locked  set to true if the buffer was locked in memory
+		 */
+		void *map (size_t size, bool &locked);
+
+		/**
+		 * Unmap buffers, called without mutex locked.
+		 */
+		void unmap (std::vector <FreeBuffer> &bufs);
+
+		/**
+		 * Remove the largest free buffers from free lists, until cached size is bellow limit. Must be called with mutex locked.
+		 *
+		 * @param removed  buffers removed from the free lists, which shall be unmapped after the mutex is unlocked
+		 */
+		void shrink (size_t limit, std::vector <FreeBuffer> &removed);
+};
+
+}
+
+#endif // !__RTS2_BUFFERPOOL__
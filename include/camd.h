@@ -25,6 +25,7 @@
 
 #include "scriptdevice.h"
 #include "imghdr.h"
+#include "robuststat.h"
 
 #define MAX_CHIPS  3
 #define MAX_DATA_RETRY 100
@@ -1019,6 +1020,12 @@ class Camera:public rts2core::ScriptDevice
 		// data time including transfer overhead
 		rts2core::ValueDouble *transferTime;
 
+		// buffer pool statistics
+		rts2core::ValueLong *poolUsed;
+		rts2core::ValueLong *poolCached;
+		rts2core::ValueLong *poolHits;
+		rts2core::ValueLong *poolMisses;
+
 		// connection which requries data to be send after end of exposure
 		rts2core::Connection *exposureConn;
 
@@ -1062,8 +1069,8 @@ class Camera:public rts2core::ScriptDevice
 		rts2core::ValueDouble *sum;
 		rts2core::ValueDouble *image_mode;
 
-		uint32_t *modeCount;
-		long long unsigned int modeCountSize;
+		// histogram of 8 and 16 bit pixel values, used to calculate mode
+		rts2core::Histogram modeHistogram;
 
 		rts2core::ValueLong *computedPix;
 
@@ -1118,13 +1125,9 @@ class Camera:public rts2core::ScriptDevice
 			double tMax = max->getValueDouble ();
 			int pixNum = 0;
 			t *tData = data;
-			if (modeCountSize < (((long long unsigned int) 1) << (sizeof (t) * 8)))
-			{
-				delete[] modeCount;
-				modeCountSize = ((long long unsigned int) 1) << (sizeof (t) * 8);
-				modeCount = new uint32_t[modeCountSize];
-				memset (modeCount, 0, modeCountSize * sizeof (uint32_t));
-			}
+			bool countMode = calculateStatistics->getValueInteger () != STATISTIC_NOMODE && std::numeric_limits <t>::is_integer && sizeof (t) <= 2;
+			if (countMode && !modeHistogram.covers (std::numeric_limits <t>::min (), std::numeric_limits <t>::max ()))
+				modeHistogram.reset (std::numeric_limits <t>::min (), std::numeric_limits <t>::max ());
 			while (((char *) tData) < ((char *) data) + dataSize)
 			{
 				t tD = *tData;
@@ -1133,10 +1136,11 @@ class Camera:public rts2core::ScriptDevice
 					tMin = tD;
 				if (tD > tMax)
 				  	tMax = tD;
-				modeCount[(long) tD]++;
 				tData++;
 				pixNum++;
 			}
+			if (countMode)
+				modeHistogram.add (data, pixNum, 1, pixNum);
 			sum->setValueDouble (sum->getValueDouble () + tSum);
 			if (tMin < min->getValueDouble ())
 				min->setValueDouble (tMin);
@@ -47,6 +47,15 @@
  */
 #define COMMAND_INFO            "info"
 
+/**
+ * Request binary value frames. @ingroup RTS2Command
+ *
+ * Asks the other side to send values in binary value frames (see
+ * binvalue.h) instead of text lines. Peers which do not know the
+ * command return an error and keep sending values as text.
+ */
+#define COMMAND_BINARY_VALUES   "binary_values"
+
 
 /**
  * Move command. @ingroup RTS2Command
@@ -463,6 +472,19 @@ class CommandKey:public Command
 		CommandKey (Block * _master, const char * device_name);
 };
 
+/**
+ * Request binary value frames from the other side.
+ *
+ * @ingroup RTS2Command
+ */
+class CommandBinaryValues:public Command
+{
+	public:
+		CommandBinaryValues (Block * _master);
+
+		virtual int commandReturnFailed (int status, Connection * conn);
+};
+
 /**
  * Common class for all command, which changed camera settings.
  *
@@ -808,6 +830,43 @@ class CommandExecGrb:public Command
 		int grb_id;
 };
 
+/**
+ * Execute GRB observation with position from GCN notice. Executor
+ * creates the target from command parameters, so it does not have to
+ * wait for the GRB daemon to store the target in the database.
+ *
+ * @ingroup RTS2Command
+ */
+class CommandExecGrbAlert:public CommandExecGrb
+{
+	public:
+		/**
+		 * @param _grb_id     GRB target ID
+		 * @param gcn_id      GCN trigger number
+		 * @param gcn_type    GCN packet type
+		 * @param ra          GRB J2000 RA (degrees)
+		 * @param dec         GRB J2000 DEC (degrees)
+		 * @param errorbox    position error (degrees), NAN if not known
+		 * @param grb_date    GRB time (ctime)
+		 * @param enabled     if target is enabled for observations
+		 * @param stored      if target is already stored in the database
+		 * @param received    time GCN packet was received (ctime)
+		 */
+		CommandExecGrbAlert (Block * _master, int _grb_id, int gcn_id, int gcn_type, double ra, double dec, double errorbox, double grb_date, bool enabled, bool stored, double received);
+};
+
+/**
+ * Inform executor that GRB target passed with CommandExecGrbAlert was
+ * stored in the database.
+ *
+ * @ingroup RTS2Command
+ */
+class CommandGrbStored:public Command
+{
+	public:
+		CommandGrbStored (Block * _master, int _grb_id);
+};
+
 class CommandQueueNow:public Command
 {
 	public:
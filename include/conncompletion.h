@@ -0,0 +1,91 @@
+/*
+ * Connection delivering finished pool tasks to the block event loop.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_CONNCOMPLETION__
+#define __RTS2_CONNCOMPLETION__
+
+#include "rts2-config.h"
+
+#include "connnosend.h"
+#include "threadpool.h"
+
+namespace rts2core
+{
+
+/**
+ * Delivers finished tasks to the block event loop. Tasks are posted
+ * from any thread to a lock-free queue, and the event loop is woken up
+ * by eventfd (pipe on systems without eventfd). Connection calls
+ * PoolTask::completed of the posted tasks from its receive method, so
+ * completions can safely access block data, and deletes the tasks.
+ *
+ * The connection must be initialized with init and added to the block
+ * with Block::addConnection.
+ *
+ * @ingroup RTS2Block
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class ConnCompletion:public ConnNoSend
+{
+	public:
+		ConnCompletion (Block *_master, size_t _queueSize = 1024);
+
+		/**
+		 * Deletes tasks posted, but not yet completed.
+		 */
+		virtual ~ConnCompletion ();
+
+		/**
+		 * Creates wakeup file descriptor.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		virtual int init ();
+
+		/**
+		 * Post task for completion. Can be called from any thread. Connection takes ownership of the task.
+		 */
+		void post (PoolTask *task);
+
+		virtual int receive (Block *block);
+
+		/**
+		 * Complete all posted tasks. Called from receive.
+		 *
+		 * @return number of completed tasks
+		 */
+		int processCompleted ();
+
+	private:
+		MPMCQueue <PoolTask *> done;
+
+		// tasks posted while the queue was full
+		std::deque <PoolTask *> overflow;
+		pthread_mutex_t overflowMutex;
+
+		// write end of wakeup pipe, sock if eventfd is used
+		int wakeFd;
+
+		void wakeup ();
+};
+
+}
+
+#endif // !__RTS2_CONNCOMPLETION__
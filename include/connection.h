@@ -34,6 +34,7 @@
 
 #include <status.h>
 
+#include "binvalue.h"
 #include "error.h"
 #include "data.h"
 #include "object.h"
@@ -278,6 +279,35 @@ class Connection:public Object
 		int sendValue (char *val_name, int val1, int val2, double val3, double val4, double val5, double val6);
 		int sendValueTime (std::string val_name, time_t * value);
 
+		/**
+		 * True if the other side accepted binary value frames.
+		 */
+		bool getBinaryValues () { return binaryValues; }
+
+		void setBinaryValues (bool _binaryValues) { binaryValues = _binaryValues; }
+
+		/**
+		 * Send value in binary value frame. Inside value batch, value
+		 * is added to the frame sent by endValueBatch.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int sendBinaryValue (Value *value);
+
+		/**
+		 * Collect values send with sendBinaryValue into single frame.
+		 * Batches can be nested, frame is sent when the outermost
+		 * batch ends.
+		 */
+		void startValueBatch () { valueBatch++; }
+
+		/**
+		 * End value batch, send collected values.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int endValueBatch ();
+
 		int sendProgress (double start, double end);
 
 		/**
@@ -540,6 +570,11 @@ class Connection:public Object
 		void setConnTimeout (int new_connTimeout) { connectionTimeout = new_connTimeout; }
 		int getConnTimeout () { return connectionTimeout; }
 
+		/**
+		 * Returns connection file descriptor, -1 if connection is not opened.
+		 */
+		int getSocket () { return sock; }
+
 		ServerState *getStateObject () { return serverState; }
 
 		DevClient *getOtherDevClient () { return otherDevice; }
@@ -575,6 +610,13 @@ class Connection:public Object
 		}
 		int valueSize () { return values.size (); }
 
+		/**
+		 * Returns number of changes of the value list - values added,
+		 * replaced or with changed flags. Value pointers obtained before the
+		 * change might be invalid.
+		 */
+		unsigned int getValuesGeneration () { return valuesGeneration; }
+
 		/**
 		 * Return time when values were valid.
 		 *
@@ -804,6 +846,21 @@ class Connection:public Object
 		int activeReadData;
 		int activeReadChannel;
 
+		// binary values are sent to the other side
+		bool binaryValues;
+		int valueBatch;
+		BinaryValueWriter binaryWriter;
+
+		// binary value frame being received, fill is -1 if no frame is received
+		std::vector <char> binaryFrame;
+		long binaryFrameFill;
+		// set while values from binary frame are parsed
+		BinaryValueReader *binaryParams;
+
+		int sendBinaryFrame ();
+		size_t addBinaryFrame (char *data, size_t size);
+		void processBinaryFrame ();
+
 		rts2core::DataSharedRead *sharedReadMemory;
 
 		std::map <int, DataAbstractWrite *> writeChannels;
@@ -844,6 +901,7 @@ class Connection:public Object
 		 * Holds connection values.
 		 */
 		ValueVector values;
+		unsigned int valuesGeneration;
 
 		/**
 		 * Time when last information was received.
@@ -0,0 +1,251 @@
+/*
+ * Asynchronous request/response engine for instrument ports.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_CONN_ASYNC__
+#define __RTS2_CONN_ASYNC__
+
+#include "connnosend.h"
+
+#include <deque>
+#include <string>
+#include <errno.h>
+
+namespace rts2core
+{
+
+/**
+ * Single request queued to ConnAsync. Request holds command sent to the
+ * instrument, describes how its reply is framed and receives the reply.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class AsyncRequest
+{
+	public:
+		/**
+		 * @param _cmd      command written to the port
+		 * @param _timeout  time (in seconds) to wait for the reply, counted from the moment command was written
+		 */
+		AsyncRequest (const std::string &_cmd, double _timeout = 2);
+		virtual ~AsyncRequest ();
+
+		/**
+		 * Called when reply to the request was received. Reply does
+		 * not include reply terminator and is null terminated.
+		 */
+		virtual void replied (const char *reply, size_t len) = 0;
+
+		/**
+		 * Called when request failed.
+		 *
+		 * @param err  ETIMEDOUT when reply was not received in time, ECANCELED when request was cleared, other errno on I/O error
+		 */
+		virtual void failed (int err);
+
+		/**
+		 * Returns length of the reply frame at the beginning of the buffer.
+		 * Default implementation uses either fixed reply length, or reply terminator.
+		 *
+		 * @param buf      buffer with data received so far
+		 * @param len      buffer length
+		 * @param dataLen  length of the reply data (without terminator)
+		 *
+		 * @return 0 if the buffer does not contain complete reply, otherwise number of bytes consumed by the reply
+		 */
+		virtual size_t frameLength (const char *buf, size_t len, size_t &dataLen);
+
+		/**
+		 * Set string terminating reply. If not set, connection default is used.
+		 */
+		void setReplyEnd (const char *_replyEnd) { replyEnd = _replyEnd; replyLength = 0; }
+
+		/**
+		 * Expect reply with fixed length.
+		 */
+		void setReplyLength (size_t _replyLength) { replyLength = _replyLength; }
+
+		/**
+		 * Command does not produce any reply. Request is finished (replied is called with empty reply) once command is written.
+		 */
+		void setNoReply () { expectReply = false; }
+
+		const std::string &getCommand () { return cmd; }
+
+		/**
+		 * Time (in seconds) between command write and reply.
+		 */
+		double getDuration () { return duration; }
+
+	private:
+		std::string cmd;
+		double timeout;
+
+		std::string replyEnd;
+		size_t replyLength;
+		bool expectReply;
+
+		// bytes of command already written
+		size_t written;
+		double sent;
+		double duration;
+
+		friend class ConnAsync;
+};
+
+/**
+ * Request calling member function of an object with the reply.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+template <class T> class AsyncMemberRequest:public AsyncRequest
+{
+	public:
+		typedef void (T::*reply_t) (const char *reply, size_t len);
+		typedef void (T::*failed_t) (AsyncRequest *req, int err);
+
+		AsyncMemberRequest (T *_obj, reply_t _reply, const std::string &_cmd, double _timeout = 2, failed_t _failed = NULL):AsyncRequest (_cmd, _timeout)
+		{
+			obj = _obj;
+			reply = _reply;
+			fail = _failed;
+		}
+
+		virtual void replied (const char *_reply, size_t len) { (obj->*reply) (_reply, len); }
+
+		virtual void failed (int err)
+		{
+			if (fail)
+				(obj->*fail) (this, err);
+			else
+				AsyncRequest::failed (err);
+		}
+
+	private:
+		T *obj;
+		reply_t reply;
+		failed_t fail;
+};
+
+/**
+ * Non-blocking request/response engine on top of a port connection (ConnSerial, ConnTCP).
+ *
+ * Requests are queued and written to the port; replies are read when the
+ * block poll loop reports the port is readable, split into frames and
+ * matched to the requests in order they were sent. Up to maxInFlight
+ * requests are written to the port before their replies arrive, so a
+ * driver can pipeline queries to instruments which process commands in
+ * order. Requests without reply in their timeout are failed with
+ * ETIMEDOUT; as reply order cannot be trusted after a timeout, all other
+ * requests in flight are failed as well and the input buffer is dropped.
+ *
+ * The connection must be added to the block with Block::addConnection,
+ * which takes ownership of it. Port connection is not owned. Synchronous
+ * calls on the port (ConnSerial::writeRead,..) shall be used only when
+ * isIdle returns true.
+ *
+ * @ingroup RTS2Block
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class ConnAsync:public ConnNoSend
+{
+	public:
+		/**
+		 * @param _master       controlling block
+		 * @param _port         connection with opened port
+		 * @param _replyEnd     default reply terminator
+		 * @param _maxInFlight  maximal number of requests written to the port and waiting for reply
+		 */
+		ConnAsync (Block *_master, Connection *_port, const char *_replyEnd = "\n", int _maxInFlight = 1);
+		virtual ~ConnAsync ();
+
+		/**
+		 * Queue request. Connection takes ownership of the request, and deletes it after it is replied or failed.
+		 */
+		void queue (AsyncRequest *req);
+
+		/**
+		 * Fail all queued and in flight requests.
+		 */
+		void clear (int err = ECANCELED);
+
+		/**
+		 * True if there isn't any request waiting or in flight.
+		 */
+		bool isIdle () { return waiting.empty () && inFlight.empty (); }
+
+		size_t getQueueSize () { return waiting.size () + inFlight.size (); }
+
+		void setMaxInFlight (int _maxInFlight) { maxInFlight = _maxInFlight; }
+
+		virtual int add (Block *block);
+		virtual int receive (Block *block);
+		virtual int writable (Block *block);
+		virtual int idle ();
+
+		virtual void postEvent (Event *event);
+
+	protected:
+		/**
+		 * Called with data received while no request is in flight. Default implementation logs and drops them.
+		 */
+		virtual void unsolicited (const char *buf, size_t len);
+
+	private:
+		Connection *port;
+		std::string replyEnd;
+		size_t maxInFlight;
+
+		std::deque <AsyncRequest *> waiting;
+		std::deque <AsyncRequest *> inFlight;
+
+		std::string input;
+
+		// time of the pending timeout timer, NAN if none is pending
+		double timerAt;
+		// port signalled end of file; do not poll it until new request is queued
+		bool portEOF;
+
+		int getFd () { return port->getSocket (); }
+
+		/**
+		 * Write waiting requests, up to maxInFlight requests in flight.
+		 */
+		void sendWaiting ();
+
+		/**
+		 * Match received data to requests in flight.
+		 */
+		void processInput ();
+
+		void checkTimeouts ();
+
+		/**
+		 * Discard data pending on the port, so late replies are not matched to the next request.
+		 */
+		void flushInput ();
+		void updateTimer ();
+
+		void finish (AsyncRequest *req, const char *reply, size_t len);
+		void fail (AsyncRequest *req, int err);
+};
+
+}
+
+#endif // !__RTS2_CONN_ASYNC__
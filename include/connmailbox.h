@@ -0,0 +1,92 @@
+/*
+ * Mailbox for requests posted to the block event loop from other threads.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_CONNMAILBOX__
+#define __RTS2_CONNMAILBOX__
+
+#include "block.h"
+#include "conncompletion.h"
+
+namespace rts2core
+{
+
+/**
+ * Request executed on the block event loop. Request is not run by a
+ * pool thread; its completed method is called from the event loop.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class MailboxRequest:public PoolTask
+{
+	public:
+		MailboxRequest ():PoolTask () {}
+
+		virtual void run () {}
+};
+
+/**
+ * Queue command for all connections of a given type.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+template <typename T> class MailboxCommand:public MailboxRequest
+{
+	public:
+		/**
+		 * @param _command   command, request takes its ownership
+		 */
+		MailboxCommand (Block *_master, int _deviceType, T *_command):MailboxRequest () { master = _master; deviceType = _deviceType; command = _command; }
+		virtual ~MailboxCommand () { delete command; }
+
+		virtual void completed () { master->queueCommandForType (deviceType, *command); }
+
+	private:
+		Block *master;
+		int deviceType;
+		T *command;
+};
+
+/**
+ * Command mailbox of the block. Threads which must not touch block data
+ * (RPC server threads,..) post requests to it, and the requests are
+ * executed from the block event loop, woken up by eventfd.
+ *
+ * @ingroup RTS2Block
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class ConnMailbox:public ConnCompletion
+{
+	public:
+		ConnMailbox (Block *_master, size_t _queueSize = 1024):ConnCompletion (_master, _queueSize) {}
+
+		/**
+		 * Queue command for all connections of the given type. Can be
+		 * called from any thread. Command shall be created with the
+		 * block as its owner; mailbox takes its ownership.
+		 */
+		template <typename T> void queueCommandForType (int deviceType, T *command)
+		{
+			post (new MailboxCommand <T> (getMaster (), deviceType, command));
+		}
+};
+
+}
+
+#endif // !__RTS2_CONNMAILBOX__
@@ -35,6 +35,10 @@
 namespace rts2core
 {
 
+class AutosaveTask;
+class ConnCompletion;
+class ThreadPool;
+
 /**
  * Abstract class for centrald and all devices.
  *
@@ -210,10 +214,24 @@ class Daemon:public Block
 		int loadValuesFile (const char *valuefile, bool use_extensions = false);
 
 		/**
-		 * Autosave values marked for autosaving.
+		 * Autosave values marked for autosaving. File content is
+		 * written by the autosave thread, once the daemon is running;
+		 * the call only queues it. Content queued while the previous
+		 * write is in progress replaces the older queued content.
+		 *
+		 * @return -2 if autosave file is not specified, -1 if the file cannot be written, 0 on success
 		 */
 		int autosaveValues ();
 
+		/**
+		 * Write autosave file from the main loop, after the running
+		 * write of the autosave thread finished. Used by autosave
+		 * command, which replies after the file is written.
+		 *
+		 * @return -2 if autosave file is not specified, -1 if the file cannot be written, 0 on success
+		 */
+		int writeAutosave ();
+
 	protected:
 		/**
 		 * Delete all saved reference of given value.
@@ -706,6 +724,49 @@ class Daemon:public Block
 		const char *optAutosaveFile;
 		const char *optDefaultsFile;
 
+		// [s] changes of autosave values during this window are written together
+		double autosaveWindow;
+		bool autosaveScheduled;
+		// changes not included in any content passed to the autosave thread
+		int autosaveChanges;
+
+		ThreadPool *autosavePool;
+		ConnCompletion *autosaveCompletion;
+		// write in progress, and content waiting for it
+		AutosaveTask *autosaveRunning;
+		AutosaveTask *autosaveQueued;
+
+		ValueInteger *autosavePending;
+		ValueInteger *autosaveWritten;
+		ValueInteger *autosaveFailed;
+
+		// set while Daemon::run runs the event loop
+		bool inRunLoop;
+		// endRunLoop was called, exit after the event loop ends
+		volatile bool exitRequested;
+
+		/**
+		 * Start autosave thread. Must be called after the daemon forks.
+		 */
+		void startAutosave ();
+
+		/**
+		 * Stop autosave thread, after it writes the running content.
+		 */
+		void stopAutosave ();
+
+		/**
+		 * Write all autosave content, which was not yet written.
+		 */
+		void flushAutosave ();
+
+		void autosaveCompleted (AutosaveTask *task);
+
+		// update autosave counters after content with given number of changes was written
+		void autosaveDone (int changes, bool failed);
+
+		friend class AutosaveTask;
+
 		/**
 		 * Switch running user to new user (and group, if provided with .)
 		 *
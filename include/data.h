@@ -82,26 +82,21 @@ class DataAbstractRead
 };
 
 /**
- * Represents data readed from connection.
+ * Represents data readed from connection. Data buffer is allocated from
+ * BufferPool, so it is reused by the next image and channels can keep
+ * reference to it instead of copying it.
  *
  * @author Petr Kubanek <petr@kubanek.net>
  */
 class DataRead:public DataAbstractRead
 {
 	public:
-		DataRead (size_t in_binaryReadDataSize, int in_type)
-		{
-			binaryReadDataSize = in_binaryReadDataSize;
-			binaryReadBuff = new char[binaryReadDataSize];
-			binaryReadTop = binaryReadBuff;
-			binaryReadType = in_type;
-			binaryReadChunkSize = -1;
-		}
+		/**
+		 * @throw rts2core::Error when data buffer cannot be allocated
+		 */
+		DataRead (size_t in_binaryReadDataSize, int in_type);
 
-		~DataRead (void)
-		{
-			delete[] binaryReadBuff;
-		}
+		~DataRead (void);
 
 		virtual int readDataSize (Connection *conn);
 
@@ -99,6 +99,12 @@
 /** Timeout for closign sequence. */
 #define EVENT_CLOSE_TIMEOUT              27
 
+/** Check for timeouts of asynchronous requests. */
+#define EVENT_ASYNC_TIMEOUT              28
+
+/** Write autosave file with values changed during the autosave window. */
+#define EVENT_AUTOSAVE                   29
+
 // events number below that number shoudl be considered RTS2-reserved
 #define RTS2_LOCAL_EVENT         1000
 
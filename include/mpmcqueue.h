@@ -0,0 +1,172 @@
+/*
+ * Bounded lock-free multi-producer multi-consumer queue.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __RTS2_MPMCQUEUE__
+#define __RTS2_MPMCQUEUE__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// size of cache line, used to keep producer and consumer counters apart
+#define RTS2_CACHE_LINE    64
+
+namespace rts2core
+{
+
+/**
+ * Bounded lock-free multi-producer multi-consumer ring queue.
+ *
+ * Each slot carries a sequence number, which tells producers and
+ * consumers whether the slot is free for the lap of the ring they are
+ * working on. Producers and consumers claim slots by compare and swap
+ * on their position counter, so neither push nor pop ever blocks. Push
+ * fails when the queue is full, pop fails when it is empty.
+ *
+ * T must be copyable; pointers are the intended use.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+template <class T> class MPMCQueue
+{
+	public:
+		/**
+		 * @param _capacity  queue capacity, rounded up to power of 2
+		 */
+		MPMCQueue (size_t _capacity = 1024)
+		{
+			size_t c = 2;
+			while (c < _capacity)
+				c <<= 1;
+			mask = c - 1;
+			cells = new Cell[c];
+			for (size_t i = 0; i < c; i++)
+				cells[i].sequence = i;
+			enqueuePos = 0;
+			dequeuePos = 0;
+		}
+
+		~MPMCQueue ()
+		{
+			delete[] cells;
+		}
+
+		/**
+		 * Add value to the queue.
+		 *
+		 * @return false if the queue is full
+		 */
+		bool push (const T &value)
+		{
+			Cell *cell;
+			size_t pos = __atomic_load_n (&enqueuePos, __ATOMIC_RELAXED);
+			while (true)
+			{
+				cell = cells + (pos & mask);
+				size_t seq = __atomic_load_n (&(cell->sequence), __ATOMIC_ACQUIRE);
+				intptr_t dif = (intptr_t) seq - (intptr_t) pos;
+				if (dif == 0)
+				{
+					if (__atomic_compare_exchange_n (&enqueuePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+						break;
+				}
+				else if (dif < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = __atomic_load_n (&enqueuePos, __ATOMIC_RELAXED);
+				}
+			}
+			cell->value = value;
+			__atomic_store_n (&(cell->sequence), pos + 1, __ATOMIC_RELEASE);
+			return true;
+		}
+
+		/**
+		 * Remove value from the queue.
+		 *
+		 * @return false if the queue is empty
+		 */
+		bool pop (T &value)
+		{
+			Cell *cell;
+			size_t pos = __atomic_load_n (&dequeuePos, __ATOMIC_RELAXED);
+			while (true)
+			{
+				cell = cells + (pos & mask);
+				size_t seq = __atomic_load_n (&(cell->sequence), __ATOMIC_ACQUIRE);
+				intptr_t dif = (intptr_t) seq - (intptr_t) (pos + 1);
+				if (dif == 0)
+				{
+					if (__atomic_compare_exchange_n (&dequeuePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+						break;
+				}
+				else if (dif < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = __atomic_load_n (&dequeuePos, __ATOMIC_RELAXED);
+				}
+			}
+			value = cell->value;
+			__atomic_store_n (&(cell->sequence), pos + mask + 1, __ATOMIC_RELEASE);
+			return true;
+		}
+
+		/**
+		 * Approximate number of values in the queue. Exact only if there are no concurrent pushes and pops.
+		 */
+		size_t size ()
+		{
+			size_t d = __atomic_load_n (&dequeuePos, __ATOMIC_RELAXED);
+			size_t e = __atomic_load_n (&enqueuePos, __ATOMIC_RELAXED);
+			return e > d ? e - d : 0;
+		}
+
+		bool empty () { return size () == 0; }
+
+		size_t capacity () { return mask + 1; }
+
+	private:
+		struct Cell
+		{
+			size_t sequence;
+			T value;
+		};
+
+		Cell *cells;
+		size_t mask;
+
+		char pad0[RTS2_CACHE_LINE];
+		size_t enqueuePos;
+		char pad1[RTS2_CACHE_LINE];
+		size_t dequeuePos;
+		char pad2[RTS2_CACHE_LINE];
+
+		// not copyable
+		MPMCQueue (const MPMCQueue &);
+		MPMCQueue &operator = (const MPMCQueue &);
+};
+
+}
+
+#endif // !__RTS2_MPMCQUEUE__
@@ -60,6 +60,10 @@
 
 #define OPT_DEFAULTS        1015
 
+#define OPT_BINARY_VALUES   1016
+
+#define OPT_AUTOSAVE_WINDOW 1017
+
 /**
  * Start of local option number playground.
  */
@@ -0,0 +1,246 @@
+/*
+ * Cached satellite propagator, batch propagation and pass prediction.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_TLEORBIT__
+#define __RTS2_TLEORBIT__
+
+#include "pluto/norad.h"
+#include "threadpool.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <algorithm>
+#include <vector>
+
+namespace rts2pluto
+{
+
+/**
+ * Observer location for satellite calculations.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class TLEObserver
+{
+	public:
+		/**
+		 * @param _lng       longitude (degrees, east positive)
+		 * @param _lat       latitude (degrees)
+		 * @param altitude   altitude above sea level (meters)
+		 */
+		TLEObserver (double _lng, double _lat, double altitude);
+
+		/**
+		 * Construct observer from precomputed parallax constants.
+		 *
+		 * @param _lng        longitude (degrees, east positive)
+		 * @param _lat        latitude (degrees)
+		 * @param rho_cos     rho cos phi'
+		 * @param rho_sin     rho sin phi'
+		 */
+		TLEObserver (double _lng, double _lat, double rho_cos, double rho_sin);
+
+		/**
+		 * Fill observer position vector (km) for given date.
+		 */
+		void getLocation (double JD, double *loc) const;
+
+		// longitude and latitude in radians
+		double lng;
+		double lat;
+		double rho_cos_phi;
+		double rho_sin_phi;
+};
+
+/**
+ * Satellite pass above horizon. Rise is NAN if the pass started before
+ * the searched interval, set is NAN if it ends after the interval.
+ */
+struct TLEPass
+{
+	double rise;
+	double culmination;
+	double set;
+	// culmination altitude in degrees
+	double maxAltitude;
+};
+
+/**
+ * Orbit from two line elements. The propagator is initialised once, when
+ * elements are parsed or ephemeris is changed, and the initialised state
+ * is reused by all position calculations. Deep space propagators (SDP4,
+ * SDP8) keep their resonance integrator in the parameter array, so they run
+ * on a private copy of it; a single TLEOrbit can then be used from multiple
+ * threads.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class TLEOrbit
+{
+	public:
+		TLEOrbit ();
+
+		/**
+		 * Parse TLE, select near-Earth or deep space ephemeris and initialise propagator.
+		 *
+		 * @return 0 on success, parse_elements error code otherwise
+		 */
+		int parse (const char *l1, const char *l2);
+
+		/**
+		 * Select ephemeris model (0 - SGP, 1 - SGP4, 2 - SGP8, 3 - SDP4, 4 - SDP8) and initialise it.
+		 *
+		 * @return -1 on invalid ephemeris, 0 on success
+		 */
+		int setEphem (int _ephem);
+
+		int getEphem () const { return ephem; }
+		const tle_t *getTLE () const { return &tle; }
+
+		/**
+		 * Calculate satellite position (and optionally velocity) in km.
+		 *
+		 * @return propagator error code, 0 on success
+		 */
+		int propagate (double JD, double *pos, double *vel = NULL) const;
+
+		/**
+		 * Propagate orbit to multiple epochs.
+		 *
+		 * @param JD   array of n dates
+		 * @param pos  array of 3 * n positions
+		 * @param vel  NULL or array of 3 * n velocities
+		 *
+		 * @return number of epochs with propagation error
+		 */
+		int propagate (const double *JD, size_t n, double *pos, double *vel = NULL) const;
+
+		/**
+		 * Topocentric RA and DEC (radians) and distance (km) of the satellite.
+		 */
+		int getRaDec (double JD, const TLEObserver &observer, double *ra, double *dec, double *distance) const;
+
+		/**
+		 * Topocentric altitude in degrees, NAN on propagation error.
+		 */
+		double getAltitude (double JD, const TLEObserver &observer) const;
+
+		/**
+		 * Find passes above horizon.
+		 *
+		 * @param from             search start (JD)
+		 * @param to               search end (JD)
+		 * @param horizon          rise and set altitude (degrees)
+		 * @param minCulmination   report only passes culminating above this altitude (degrees)
+		 * @param step             search step (days); NAN to derive it from the mean motion
+		 */
+		void getPasses (double from, double to, const TLEObserver &observer, double horizon, double minCulmination, std::vector <TLEPass> &passes, double step = NAN) const;
+
+	private:
+		tle_t tle;
+		int ephem;
+		double params[N_SAT_PARAMS];
+
+		/**
+		 * Propagate with given parameter array. Deep space models
+		 * modify the array, so it must be private to the caller.
+		 */
+		int propagate (double JD, double *_params, double *pos, double *vel) const;
+		double getAltitude (double JD, const TLEObserver &observer, double *_params) const;
+
+		double findCrossing (double t1, double t2, const TLEObserver &observer, double horizon, double *_params) const;
+		double findCulmination (double t1, double t2, const TLEObserver &observer, double *_params) const;
+};
+
+/**
+ * Propagate many orbits to single epoch.
+ *
+ * @param pos  array of 3 * orbits.size () positions
+ *
+ * @return number of orbits with propagation error
+ */
+int propagateAll (const std::vector <TLEOrbit> &orbits, double JD, double *pos);
+
+/**
+ * Predicts passes of a range of catalogue orbits.
+ */
+class PassTask:public rts2core::PoolTask
+{
+	public:
+		PassTask (const std::vector <TLEOrbit> &_orbits, size_t _begin, size_t _end, double _from, double _to, const TLEObserver &_observer, double _horizon, double _minCulmination, std::vector <std::vector <TLEPass> > &_passes):rts2core::PoolTask (), orbits (_orbits), observer (_observer), passes (_passes)
+		{
+			begin = _begin;
+			end = _end;
+			from = _from;
+			to = _to;
+			horizon = _horizon;
+			minCulmination = _minCulmination;
+		}
+
+		virtual void run ()
+		{
+			for (size_t i = begin; i < end; i++)
+				orbits[i].getPasses (from, to, observer, horizon, minCulmination, passes[i]);
+		}
+
+	private:
+		const std::vector <TLEOrbit> &orbits;
+		size_t begin;
+		size_t end;
+		double from;
+		double to;
+		const TLEObserver &observer;
+		double horizon;
+		double minCulmination;
+		std::vector <std::vector <TLEPass> > &passes;
+};
+
+/**
+ * Predict passes of all orbits in catalogue on the thread pool. passes is
+ * resized to number of orbits. Defined inline, so libpluto itself does not
+ * link with librts2.
+ */
+inline void predictPasses (const std::vector <TLEOrbit> &orbits, double from, double to, const TLEObserver &observer, double horizon, double minCulmination, std::vector <std::vector <TLEPass> > &passes, rts2core::ThreadPool &pool)
+{
+	passes.resize (orbits.size ());
+	size_t chunks = 4 * (pool.getThreads () > 0 ? pool.getThreads () : 1);
+	size_t chunk = (orbits.size () + chunks - 1) / chunks;
+	std::vector <PassTask *> tasks;
+	for (size_t b = 0; b < orbits.size (); b += chunk)
+	{
+		PassTask *t = new PassTask (orbits, b, std::min (b + chunk, orbits.size ()), from, to, observer, horizon, minCulmination, passes);
+		// run in the calling thread if pool does not accept the task
+		if (pool.submit (t))
+		{
+			t->run ();
+			delete t;
+			continue;
+		}
+		tasks.push_back (t);
+	}
+	for (std::vector <PassTask *>::iterator iter = tasks.begin (); iter != tasks.end (); iter++)
+	{
+		pool.wait (*iter);
+		delete *iter;
+	}
+}
+
+}
+
+#endif /* !__RTS2_TLEORBIT__ */
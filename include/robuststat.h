@@ -0,0 +1,479 @@
+/*
+ * Robust image statistics - median, MAD and sigma clipping.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_ROBUSTSTAT__
+#define __RTS2_ROBUSTSTAT__
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// scale MAD to standard deviation of normal distribution
+#define MAD_TO_SIGMA             1.4826
+
+// arrays smaller than this are selected directly, without sampling
+#define STAT_SAMPLING_LIMIT      100000
+// number of values in sample used to bracket median
+#define STAT_SAMPLE_SIZE         16384
+
+// maximal span of integer values processed with histogram
+#define STAT_HISTOGRAM_SPAN      (1 << 22)
+
+namespace rts2core
+{
+
+/**
+ * Result of robust statistics calculation. All values except min and max
+ * are calculated from values which survived sigma clipping.
+ */
+class RobustStat
+{
+	public:
+		RobustStat () { clear (); }
+
+		void clear ()
+		{
+			n = 0;
+			mean = median = mad = sigma = min = max = NAN;
+			iterations = 0;
+		}
+
+		// number of values used for statistics
+		size_t n;
+		double mean;
+		double median;
+		// median absolute deviation
+		double mad;
+		// MAD scaled to standard deviation
+		double sigma;
+		double min;
+		double max;
+		// number of performed clipping iterations
+		int iterations;
+};
+
+/**
+ * Rectangular region for robust statistics.
+ */
+class StatRegion
+{
+	public:
+		StatRegion (size_t _x, size_t _y, size_t _w, size_t _h) { x = _x; y = _y; w = _w; h = _h; }
+
+		size_t x;
+		size_t y;
+		size_t w;
+		size_t h;
+
+		RobustStat stat;
+};
+
+/**
+ * Counting histogram of integer values. Median, MAD and sigma clipping are
+ * calculated from cumulative counts in logarithmic time, so once histogram is
+ * filled, clipping iterations are almost free.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class Histogram
+{
+	public:
+		Histogram ();
+
+		/**
+		 * Set range of values and zero counts.
+		 */
+		void reset (long long _minValue, long long _maxValue);
+
+		/**
+		 * Zero counts, keeps range.
+		 */
+		void clear ();
+
+		bool covers (long long _minValue, long long _maxValue) const { return !counts.empty () && minValue <= _minValue && maxValue >= _maxValue; }
+
+		/**
+		 * Add values to histogram. Values must fit into histogram range.
+		 *
+		 * @param data    data array
+		 * @param w       number of values in a row
+		 * @param h       number of rows
+		 * @param stride  distance (in values) between rows
+		 */
+		template <typename t> void add (const t *data, size_t w, size_t h, size_t stride)
+		{
+			uint32_t *c = &(counts[0]);
+			for (size_t r = 0; r < h; r++)
+			{
+				const t *p = data + r * stride;
+				for (size_t i = 0; i < w; i++)
+					c[(long long) p[i] - minValue]++;
+			}
+			total += w * h;
+		}
+
+		/**
+		 * Add counts from other histogram with the same range.
+		 */
+		void merge (const Histogram &other);
+
+		size_t getCount () const { return total; }
+
+		/**
+		 * Return most frequent value.
+		 */
+		long long getMode () const;
+
+		/**
+		 * Calculate statistics, with optional sigma clipping.
+		 *
+		 * @param ret      calculated statistics
+		 * @param kappa    clipping limit in sigmas, 0 for no clipping
+		 * @param maxIter  maximal number of clipping iterations
+		 */
+		void getStat (RobustStat &ret, double kappa = 0, int maxIter = 0) const;
+
+	private:
+		long long minValue;
+		long long maxValue;
+		std::vector <uint32_t> counts;
+		size_t total;
+};
+
+/**
+ * Base of work split among threads by runParallel.
+ */
+class StatJob
+{
+	public:
+		virtual ~StatJob () {}
+
+		/**
+		 * Process i-th part of the job.
+		 */
+		virtual void run (size_t i) = 0;
+};
+
+/**
+ * Process count parts of the job in at most given number of threads.
+ * Parts are run by a thread pool shared by all calls.
+ *
+ * @throw rts2core::Error if a part failed
+ */
+void runParallel (StatJob *job, size_t count, int threads);
+
+// value functors for the selection. NAN marks excluded value.
+class ClipValue
+{
+	public:
+		ClipValue (double _lo = -INFINITY, double _hi = INFINITY) { lo = _lo; hi = _hi; }
+		template <typename t> double operator () (t v) const { return (v >= lo && v <= hi) ? (double) v : NAN; }
+
+		double lo;
+		double hi;
+};
+
+class ClipDeviation
+{
+	public:
+		ClipDeviation (double _m, double _lo = -INFINITY, double _hi = INFINITY) { m = _m; lo = _lo; hi = _hi; }
+		template <typename t> double operator () (t v) const { return (v >= lo && v <= hi) ? fabs (v - m) : NAN; }
+
+		double m;
+		double lo;
+		double hi;
+};
+
+/**
+ * Median of buffer. Buffer is reordered.
+ */
+double bufferMedian (std::vector <double> &buf);
+
+/**
+ * Calculate median of values returned by functor f. When there are more values than
+ * STAT_SAMPLING_LIMIT, sorted sample brackets the median and only values inside the
+ * bracket are collected and selected. Full copy is made only if the bracket misses
+ * the median.
+ *
+ * @param buf   working buffer
+ */
+template <typename t, typename F> double selectMedian (const t *data, size_t w, size_t h, size_t stride, const F &f, std::vector <double> &buf)
+{
+	size_t n = w * h;
+	buf.clear ();
+	if (n > STAT_SAMPLING_LIMIT)
+	{
+		size_t step = n / STAT_SAMPLE_SIZE;
+		for (size_t s = 0; s < STAT_SAMPLE_SIZE; s++)
+		{
+			// jitter sample position, so periodic patterns do not alias with the sample
+			size_t i = s * step + (s * 7919) % step;
+			double v = f (data[(i / w) * stride + i % w]);
+			if (!isnan (v))
+				buf.push_back (v);
+		}
+		if (!buf.empty ())
+		{
+			std::sort (buf.begin (), buf.end ());
+			size_t ns = buf.size ();
+			size_t delta = 2 * sqrt (ns) + 1;
+			double lo = (ns / 2 > delta) ? buf[ns / 2 - delta] : -INFINITY;
+			double hi = (ns / 2 + delta < ns) ? buf[ns / 2 + delta] : INFINITY;
+
+			buf.clear ();
+			size_t nlo = 0;
+			size_t nvalid = 0;
+			for (size_t r = 0; r < h; r++)
+			{
+				const t *p = data + r * stride;
+				for (size_t i = 0; i < w; i++)
+				{
+					double v = f (p[i]);
+					if (isnan (v))
+						continue;
+					nvalid++;
+					if (v < lo)
+						nlo++;
+					else if (v <= hi)
+						buf.push_back (v);
+				}
+			}
+			if (nvalid == 0)
+				return NAN;
+			size_t k1 = (nvalid - 1) / 2;
+			size_t k2 = nvalid / 2;
+			if (k1 >= nlo && k2 < nlo + buf.size ())
+			{
+				std::vector <double>::iterator m1 = buf.begin () + (k1 - nlo);
+				std::nth_element (buf.begin (), m1, buf.end ());
+				if (k1 == k2)
+					return *m1;
+				return (*m1 + *std::min_element (m1 + 1, buf.end ())) / 2.0;
+			}
+			buf.clear ();
+		}
+	}
+
+	for (size_t r = 0; r < h; r++)
+	{
+		const t *p = data + r * stride;
+		for (size_t i = 0; i < w; i++)
+		{
+			double v = f (p[i]);
+			if (!isnan (v))
+				buf.push_back (v);
+		}
+	}
+	return bufferMedian (buf);
+}
+
+/**
+ * Find out if values can be processed with histogram.
+ *
+ * @return true if histogram shall be used, lo and hi are then set to histogram range
+ */
+template <typename t> bool histogramRange (const t *data, size_t w, size_t h, size_t stride, long long &lo, long long &hi)
+{
+	if (!std::numeric_limits <t>::is_integer)
+		return false;
+	// 8 and 16 bit types - use full range
+	if (sizeof (t) <= 2)
+	{
+		lo = std::numeric_limits <t>::min ();
+		hi = std::numeric_limits <t>::max ();
+		return true;
+	}
+	if (w * h == 0)
+		return false;
+	t tMin = data[0];
+	t tMax = data[0];
+	for (size_t r = 0; r < h; r++)
+	{
+		const t *p = data + r * stride;
+		for (size_t i = 0; i < w; i++)
+		{
+			if (p[i] < tMin)
+				tMin = p[i];
+			else if (p[i] > tMax)
+				tMax = p[i];
+		}
+	}
+	// do not convert 64bit values which would not fit into signed long long
+	if ((double) tMax - (double) tMin >= STAT_HISTOGRAM_SPAN)
+		return false;
+	lo = tMin;
+	hi = tMax;
+	return true;
+}
+
+template <typename t> class HistogramJob:public StatJob
+{
+	public:
+		HistogramJob (const t *_data, size_t _w, size_t _h, size_t _stride, long long lo, long long hi, size_t _parts):hists (_parts)
+		{
+			data = _data;
+			w = _w;
+			h = _h;
+			stride = _stride;
+			for (typename std::vector <Histogram>::iterator iter = hists.begin (); iter != hists.end (); iter++)
+				iter->reset (lo, hi);
+		}
+
+		virtual void run (size_t i)
+		{
+			size_t rows = (h + hists.size () - 1) / hists.size ();
+			size_t r = i * rows;
+			if (r >= h)
+				return;
+			hists[i].add (data + r * stride, w, std::min (rows, h - r), stride);
+		}
+
+		std::vector <Histogram> hists;
+
+	private:
+		const t *data;
+		size_t w;
+		size_t h;
+		size_t stride;
+};
+
+/**
+ * Calculate robust (sigma clipped) statistics of values. NaNs are ignored.
+ *
+ * 8 and 16 bit integer values, and wider integer values with small span,
+ * are counted into histogram, which can be built in parallel threads.
+ * Other values are processed with sampled selection.
+ *
+ * @param data     data array
+ * @param w        number of values in a row
+ * @param h        number of rows
+ * @param stride   distance (in values) between rows
+ * @param ret      calculated statistics
+ * @param kappa    clipping limit in sigmas, 0 for no clipping
+ * @param maxIter  maximal number of clipping iterations
+ * @param threads  number of threads used for histogram
+ */
+template <typename t> void robustStatistics (const t *data, size_t w, size_t h, size_t stride, RobustStat &ret, double kappa = 3, int maxIter = 5, int threads = 1)
+{
+	ret.clear ();
+	long long lo, hi;
+	if (histogramRange (data, w, h, stride, lo, hi))
+	{
+		if (threads > 1 && w * h > STAT_SAMPLING_LIMIT)
+		{
+			HistogramJob <t> job (data, w, h, stride, lo, hi, threads);
+			runParallel (&job, threads, threads);
+			for (int i = 1; i < threads; i++)
+				job.hists[0].merge (job.hists[i]);
+			job.hists[0].getStat (ret, kappa, maxIter);
+		}
+		else
+		{
+			Histogram hist;
+			hist.reset (lo, hi);
+			hist.add (data, w, h, stride);
+			hist.getStat (ret, kappa, maxIter);
+		}
+		return;
+	}
+
+	std::vector <double> buf;
+	ClipValue clip;
+
+	while (true)
+	{
+		long double sum = 0;
+		size_t n = 0;
+		for (size_t r = 0; r < h; r++)
+		{
+			const t *p = data + r * stride;
+			for (size_t i = 0; i < w; i++)
+			{
+				double v = clip (p[i]);
+				if (isnan (v))
+					continue;
+				if (ret.iterations == 0)
+				{
+					if (!(v >= ret.min))
+						ret.min = v;
+					if (!(v <= ret.max))
+						ret.max = v;
+				}
+				sum += v;
+				n++;
+			}
+		}
+		if (n == 0)
+			return;
+		ret.n = n;
+		ret.mean = sum / n;
+		ret.median = selectMedian (data, w, h, stride, clip, buf);
+		ret.mad = selectMedian (data, w, h, stride, ClipDeviation (ret.median, clip.lo, clip.hi), buf);
+		ret.sigma = ret.mad * MAD_TO_SIGMA;
+
+		if (kappa <= 0 || ret.iterations >= maxIter || ret.sigma == 0)
+			return;
+
+		ClipValue nclip (ret.median - kappa * ret.sigma, ret.median + kappa * ret.sigma);
+		if (nclip.lo <= clip.lo && nclip.hi >= clip.hi)
+			return;
+		clip.lo = std::max (clip.lo, nclip.lo);
+		clip.hi = std::min (clip.hi, nclip.hi);
+		ret.iterations++;
+	}
+}
+
+/**
+ * Median and median absolute deviation of array.
+ */
+template <typename t> double robustMedian (const t *data, size_t n, double *mad = NULL)
+{
+	RobustStat ret;
+	robustStatistics (data, n, 1, n, ret, 0, 0);
+	if (mad)
+		*mad = ret.mad;
+	return ret.median;
+}
+
+/**
+ * Calculate robust statistics of data of RTS2_DATA_ type.
+ *
+ * @throw rts2core::Error on unknown data type
+ */
+void robustStatistics (const void *data, int16_t dataType, size_t w, size_t h, size_t stride, RobustStat &ret, double kappa = 3, int maxIter = 5, int threads = 1);
+
+/**
+ * Calculate robust statistics of multiple image regions, in parallel threads.
+ *
+ * @param data     image data
+ * @param dataType RTS2_DATA_ data type
+ * @param width    image width (row length)
+ * @param regions  regions; stat member is filled with calculated statistics
+ *
+ * @throw rts2core::Error on unknown data type
+ */
+void robustRegions (const void *data, int16_t dataType, size_t width, std::vector <StatRegion> &regions, double kappa = 3, int maxIter = 5, int threads = 1);
+
+}
+
+#endif // !__RTS2_ROBUSTSTAT__
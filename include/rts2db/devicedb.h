@@ -68,6 +68,11 @@ class DeviceDb:public rts2core::Device
 
 		bool emptyConnectString () { return connectString != NULL && strlen(connectString) == 0; }
 
+		/**
+		 * Returns connect string specified on command line, NULL if database from configuration file shall be used.
+		 */
+		const char *getConnectString () { return connectString; }
+
 	private:
 		char *connectString;
 		char *configFile;
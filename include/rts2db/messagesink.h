@@ -0,0 +1,186 @@
+/*
+ * Buffered writer of messages into the database.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_MESSAGESINK__
+#define __RTS2_MESSAGESINK__
+
+#include "message.h"
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+namespace rts2db
+{
+
+/**
+ * Buffered message sink. Messages are put into a bounded queue, which
+ * is written to the database by a background thread with its own
+ * database connection, using multi-row inserts. The queue is flushed
+ * when it holds batchSize messages, or flushInterval seconds after the
+ * last flush.
+ *
+ * When the queue is full, new messages are dropped and a message with
+ * number of dropped messages is inserted as soon as there is space in the
+ * queue. Messages identical to a message received less than
+ * duplicateWindow seconds ago (same originator, type and text) are not
+ * inserted; message with repetition count is inserted when the window
+ * expires.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class MessageSink
+{
+	public:
+		/**
+		 * @param _connectString    database connect string, NULL to use database from configuration file
+		 * @param _capacity         maximal number of messages in the queue
+		 * @param _batchSize        maximal number of messages written by a single insert
+		 * @param _flushInterval    maximal time (seconds) messages stay in the queue
+		 * @param _duplicateWindow  duplicate messages are suppressed for that many seconds; 0 disables suppression
+		 */
+		MessageSink (const char *_connectString, size_t _capacity = 10000, size_t _batchSize = 500, double _flushInterval = 1, double _duplicateWindow = 10);
+
+		/**
+		 * Flush queued messages and stop the flushing thread.
+		 */
+		~MessageSink ();
+
+		/**
+		 * Start flushing thread. Returns after the thread connected to the database.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int start ();
+
+		/**
+		 * Flush queued messages and stop the flushing thread.
+		 */
+		void stop ();
+
+		/**
+		 * Queue message for insertion.
+		 *
+		 * @return false if the message was dropped or suppressed as a duplicate
+		 */
+		bool push (rts2core::Message &msg);
+
+		/**
+		 * Wait until all queued messages are written.
+		 */
+		void flush ();
+
+		size_t getQueueSize ();
+
+		unsigned long getInserted () { return __atomic_load_n (&inserted, __ATOMIC_RELAXED); }
+		unsigned long getDropped () { return __atomic_load_n (&dropped, __ATOMIC_RELAXED); }
+		unsigned long getSuppressed () { return __atomic_load_n (&suppressed, __ATOMIC_RELAXED); }
+		unsigned long getFailed () { return __atomic_load_n (&failed, __ATOMIC_RELAXED); }
+
+		/**
+		 * Take the oldest error reported by the flushing thread. Errors
+		 * are not logged by the flushing thread; the caller shall log
+		 * them from its main loop.
+		 *
+		 * @return false if there isn't any error
+		 */
+		bool popError (std::string &err);
+
+	private:
+		std::string connectString;
+		size_t capacity;
+		size_t batchSize;
+		double flushInterval;
+		double duplicateWindow;
+
+		std::deque <rts2core::Message> queue;
+
+		struct Recent
+		{
+			double first;
+			unsigned long count;
+			rts2core::Message *msg;
+		};
+
+		// recently received messages, for duplicate suppression
+		std::map <std::string, Recent> recent;
+
+		// dropped since last report
+		unsigned long droppedReport;
+		std::string droppedOName;
+
+		// statistics, accessed atomically
+		unsigned long inserted;
+		unsigned long dropped;
+		unsigned long suppressed;
+		unsigned long failed;
+
+		// errors waiting for popError, protected by mutex
+		std::deque <std::string> errors;
+
+		// messages taken from the queue, but not yet written
+		size_t writing;
+
+		pthread_t thread;
+		pthread_mutex_t mutex;
+		pthread_cond_t queueCond;
+		pthread_cond_t flushedCond;
+
+		bool running;
+		bool stopping;
+		// -1 connection failed, 0 connecting, 1 connected
+		int connected;
+
+		static void *flushThread (void *arg);
+
+		void run ();
+
+		int connect ();
+		void disconnect ();
+
+		/**
+		 * Write messages with multi-row insert.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int insert (std::vector <rts2core::Message> &msgs);
+
+		/**
+		 * Queue summary of suppressed duplicates for expired entries. Must be called with mutex locked.
+		 *
+		 * @param all  queue summary of all entries with suppressed messages, regardless of expiration
+		 */
+		void expireRecent (double now, bool all);
+
+		/**
+		 * Queue report about dropped messages. Must be called with mutex locked.
+		 */
+		void reportDropped ();
+
+		/**
+		 * Record error for popError. Must be called with mutex unlocked.
+		 */
+		void addError (const std::string &err);
+};
+
+}
+
+#endif // !__RTS2_MESSAGESINK__
@@ -23,6 +23,8 @@
 #include "imgdisplay.h"
 #include <errno.h>
 #include <libnova/libnova.h>
+#include <map>
+#include <string>
 #include <ostream>
 #include <stdio.h>
 #include <time.h>
@@ -84,6 +86,32 @@ typedef counted_ptr <Constraint> ConstraintPtr;
 
 typedef std::vector < std::pair < time_t, time_t > > interval_arr_t;
 
+/**
+ * Values of a single row of the targets table. Filled by TargetSet, which
+ * reads rows of all targets in a single query and constructs targets from
+ * them, instead of querying database for every target.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class TargetRow
+{
+	public:
+		int tar_id;
+		char type_id;
+		std::string tar_name;
+		std::string tar_info;
+		float tar_priority;
+		float tar_bonus;
+		time_t tar_bonus_time;
+		time_t tar_next_observable;
+		bool tar_enabled;
+		int tar_telescope_mode;
+		double tar_ra;
+		double tar_dec;
+		double tar_pm_ra;
+		double tar_pm_dec;
+};
+
 /**
  * Execption raised when target name cannot be resolved.
  *
@@ -182,6 +210,40 @@ class Target:public Rts2Target
 		// load target data from give target id
 		void loadTarget (int in_tar_id);
 
+		/**
+		 * Fill target from values read by TargetSet. Only classes which
+		 * do not need any other data than targets table row shall be
+		 * loaded this way; see rowLoadable.
+		 */
+		virtual void loadRow (TargetRow &row);
+
+		/**
+		 * Fill cache of target scripts. Once called, getDBScript does not
+		 * query database and uses scripts added with addDBScript, until
+		 * invalidateDBScripts is called.
+		 */
+		void setDBScriptsLoaded () { dbScriptsLoaded = true; dbScriptsLoadedGeneration = __atomic_load_n (&dbScriptsGeneration, __ATOMIC_RELAXED); }
+		void addDBScript (const char *camera_name, const char *script) { dbScripts[std::string (camera_name)] = std::string (script); }
+
+		/**
+		 * Invalidate scripts cached by setDBScriptsLoaded in all targets.
+		 * Called when scripts might be changed in the database, so
+		 * getDBScript (and ScriptCache) sees the new scripts.
+		 */
+		static void invalidateDBScripts () { __atomic_add_fetch (&dbScriptsGeneration, 1, __ATOMIC_RELAXED); }
+
+		/**
+		 * Returns number of invalidateDBScripts calls, so caches of the scripts can find if they shall be revalidated.
+		 */
+		static unsigned int getDBScriptsGeneration () { return __atomic_load_n (&dbScriptsGeneration, __ATOMIC_RELAXED); }
+
+		/**
+		 * Fill cache of target labels. Once called, getPIName and
+		 * getProgramName do not query database.
+		 */
+		void setLabelsLoaded () { labelsLoaded = true; }
+		void addLoadedLabel (Label &label) { targetLabels.push_back (label); }
+
 		virtual int save (bool overwrite);
 		virtual int saveWithID (bool overwrite, int tar_id);
 
@@ -798,9 +860,9 @@ class Target:public Rts2Target
 		/**
 		 * Retrieve list of target labels.
 		 */
-		LabelsVector getLabels () { return labels.getTargetLabels (getTargetID ()); }
+		LabelsVector getLabels () { return labelsLoaded ? targetLabels : labels.getTargetLabels (getTargetID ()); }
 
-		void deleteLabels (int ltype) { labels.deleteTargetLabels (getTargetID (), ltype); }
+		void deleteLabels (int ltype) { labelsLoaded = false; labels.deleteTargetLabels (getTargetID (), ltype); }
 
 		/**
 		 * Add label to target. Might create new label if create parameter is set to true.
@@ -809,14 +871,14 @@ class Target:public Rts2Target
 		 * @param ltype  label type
 		 * @param create if true, new label will be created
 		 */
-		void addLabel (const char *label, int ltype, bool create) { labels.addLabel (getTargetID (), label, ltype, create); }
+		void addLabel (const char *label, int ltype, bool create) { labelsLoaded = false; labels.addLabel (getTargetID (), label, ltype, create); }
 
 		/**
 		 * Add label identified by label ID to the target.
 		 *
 		 * @param label_id   label ID.
 		 */
-		void addLabel (int label_id) { labels.addLabel (getTargetID (), label_id); }
+		void addLabel (int label_id) { labelsLoaded = false; labels.addLabel (getTargetID (), label_id); }
 
 		/**
 		 * Test if a target is associated with a label.
@@ -878,6 +940,16 @@ class Target:public Rts2Target
 
 		Labels labels;
 
+		std::map <std::string, std::string> dbScripts;
+		bool dbScriptsLoaded;
+		unsigned int dbScriptsLoadedGeneration;
+		static unsigned int dbScriptsGeneration;
+
+		LabelsVector targetLabels;
+		bool labelsLoaded;
+
+		LabelsVector getTargetLabels (int type);
+
 		// which constraints were sucessfully loaded
 		int constraintsLoaded;
 
@@ -901,6 +973,7 @@ class ConstTarget:public Target
 		ConstTarget (int in_tar_id, struct ln_lnlat_posn *in_obs, double in_altitude);
 		ConstTarget (int in_tar_id, struct ln_lnlat_posn *in_obs, double in_altitude, struct ln_equ_posn *pos);
 		virtual void load ();
+		virtual void loadRow (TargetRow &row);
 		virtual int saveWithID (bool overwrite, int tar_id);
 		virtual void getPosition (struct ln_equ_posn *pos, double JD);
 
@@ -1226,6 +1299,20 @@ Rts2InfoValStream & operator << (Rts2InfoValStream & _os, rts2db::Target & targe
  */
 rts2db::Target *createTarget (int tar_id, struct ln_lnlat_posn *obs, double altitude);
 
+/**
+ * Create target from targets table row. Targets of types which need other
+ * tables are loaded from database.
+ *
+ * @param row         row with target values
+ * @param obs         observer position
+ * @param altitude    observator altitude
+ *
+ * @return new target
+ *
+ * @throw rts2core::Error and descendants on error
+ */
+rts2db::Target *createTarget (rts2db::TargetRow &row, struct ln_lnlat_posn *obs, double altitude);
+
 /**
  * Create target by name.
  *
@@ -32,10 +32,43 @@ class TargetGRB:public ConstTarget
 	public:
 		TargetGRB (int in_tar_id, struct ln_lnlat_posn *in_obs, double _altitude, int in_maxBonusTimeout, int in_dayBonusTimeout, int in_fiveBonusTimeout);
 		virtual void load ();
+
+		/**
+		 * Fill target from GCN notice, without database access. Used
+		 * for fast response to GRB alerts - target might not be yet
+		 * stored in the database by GRB daemon. Observation record is
+		 * created when the database has the target, slew is not
+		 * delayed by it.
+		 *
+		 * @param grb_id    GCN trigger number
+		 * @param grb_type  GCN packet type
+		 * @param ra        J2000 RA (degrees)
+		 * @param dec       J2000 DEC (degrees)
+		 * @param _errorbox position error (degrees), NAN if not known
+		 * @param grb_date  GRB time (ctime)
+		 * @param enabled   target enabled flag
+		 * @param _stored   true if GRB daemon already stored the target
+		 */
+		void loadAlert (int grb_id, int grb_type, double ra, double dec, double _errorbox, double grb_date, bool enabled, bool _stored);
+
+		/**
+		 * Called when GRB daemon reports the target was stored in
+		 * the database. Pending observation record is written at the
+		 * next observation start.
+		 */
+		void setStored () { stored = true; }
+
+		/**
+		 * Returns name of target created for GRB.
+		 */
+		static std::string alertName (time_t grb_date, int grb_id);
+
 		virtual void getPosition (struct ln_equ_posn *pos, double JD);
 		virtual int compareWithTarget (Target * in_target, double grb_sep_limit);
 		virtual bool getScript (const char *deviceName, std::string & buf);
 		virtual int beforeMove ();
+		virtual moveType startSlew (struct ln_equ_posn *position, std::string &p1, std::string &p2, bool update_position, int plan_id = -1);
+		virtual int startObservation ();
 		virtual float getBonus (double JD);
 		// some logic needed to distinguish states when GRB position change
 		// from last observation. there was update etc..
@@ -95,6 +128,17 @@ class TargetGRB:public ConstTarget
 		double errorbox;
 		bool autodisabled;
 
+		// target was created from GCN notice, and was not yet loaded from the database
+		bool alert;
+		// GRB daemon reported target is in the database
+		bool stored;
+		// observation slew was not recorded, as target was not yet in the database
+		bool slewPending;
+		struct ln_equ_posn slewPosition;
+		int slewPlanId;
+
+		void setPacketType (int _type);
+
 		const char *getSatelite ();
 };
 
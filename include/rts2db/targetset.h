@@ -23,12 +23,18 @@
 #include <libnova/libnova.h>
 #include <list>
 #include <map>
+#include <string>
 #include <vector>
 #include <ostream>
 
 #include <math.h>
 #include "nan.h"
 
+namespace rts2core
+{
+class ThreadPool;
+}
+
 namespace rts2db
 {
 
@@ -221,6 +227,19 @@ class TargetSet:public std::map <int, Target * >
 	protected:
 		void printTypeWhere (std::ostream & _os, const char *target_type);
 
+		/**
+		 * Load targets matching the where condition. Targets rows,
+		 * their scripts and labels are read in three queries, and
+		 * targets are constructed from the rows. Only targets which
+		 * need other tables are loaded with their own queries.
+		 *
+		 * @param _where     SQL condition on targets table
+		 * @param _order_by  SQL ordering
+		 *
+		 * @throw SqlError if target set cannot be loaded.
+		 */
+		void loadWhere (const std::string &_where, const std::string &_order_by);
+
 		struct ln_lnlat_posn *obs;
 		double obs_altitude;
 
@@ -236,6 +255,20 @@ class TargetSetSelectable:public TargetSet
 		TargetSetSelectable (const char *target_type, struct ln_lnlat_posn *in_obs = NULL);
 };
 
+/**
+ * Set of enabled targets with non-negative priority, which are observable
+ * now. Used by selector to find new targets.
+ */
+class TargetSetObservable:public TargetSet
+{
+	public:
+		/**
+		 * @param exclude_ids    if not NULL, targets with those IDs are not loaded
+		 * @param exclude_types  if not NULL, targets of those types are not loaded
+		 */
+		TargetSetObservable (struct ln_lnlat_posn *in_obs = NULL, double in_altitude = NAN, const std::vector <int> *exclude_ids = NULL, const std::vector <char> *exclude_types = NULL);
+};
+
 /**
  * Create list of targets with similar name. The search is done by:
  *  - replacing all spaces in name with %
@@ -304,31 +337,117 @@ class TargetSetSingleton
 };
 
 /**
- * Sorting based on altitude.
+ * Position of target at cache JD, used as sort key.
+ */
+class TargetPosition
+{
+	public:
+		TargetPosition () { hrz.alt = hrz.az = NAN; above = false; ha = NAN; satisfied = NAN; satisfiedValid = false; }
+
+		struct ln_hrz_posn hrz;
+		bool above;
+		double ha;
+
+		// duration target satisfies constraints during next day, computed on first request
+		double satisfied;
+		bool satisfiedValid;
+};
+
+/**
+ * Positions of targets computed for a single JD. Sorting functors look
+ * keys up in the cache, so position of every target is computed once per
+ * sort instead of in every comparison, and only once for successive sorts
+ * sharing the cache. Targets are identified by their address - cache
+ * must be cleared when targets are deleted.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class PositionCache
+{
+	public:
+		PositionCache (struct ln_lnlat_posn *_observer = NULL, double _jd = NAN);
+
+		/**
+		 * Set cache JD. Cached positions are dropped if JD differs.
+		 */
+		void setJD (double _jd);
+
+		double getJD () { return JD; }
+		struct ln_lnlat_posn *getObserver () { return observer; }
+
+		/**
+		 * Returns position of target, computing it if it is not cached.
+		 */
+		TargetPosition &getPosition (Target *tar);
+
+		/**
+		 * Returns duration (in seconds) target satisfies its constraints during next day, NAN if it never does.
+		 */
+		double getSatisfiedDuration (Target *tar);
+
+		/**
+		 * Computes positions of targets which are not cached. Sets larger
+		 * than PARALLEL_POSITIONS are computed on pool threads; if pool is
+		 * NULL, temporary pool is used.
+		 */
+		void precompute (std::vector <Target *> &targets, rts2core::ThreadPool *pool = NULL);
+
+		template <typename it> void precompute (it first, it last, rts2core::ThreadPool *pool = NULL)
+		{
+			std::vector <Target *> targets;
+			for (; first != last; first++)
+				targets.push_back (*first);
+			precompute (targets, pool);
+		}
+
+		void clear () { positions.clear (); }
+
+		size_t size () { return positions.size (); }
+
+		static const size_t PARALLEL_POSITIONS = 512;
+
+	private:
+		struct ln_lnlat_posn *observer;
+		double JD;
+		std::map <Target *, TargetPosition> positions;
+};
+
+/**
+ * Sorting based on altitude. If position cache is not provided, functor
+ * computes positions in every comparison.
  */
 class sortByAltitude
 {
 	public:
-		sortByAltitude (struct ln_lnlat_posn *_observer = NULL, double _jd = NAN);
+		sortByAltitude (struct ln_lnlat_posn *_observer = NULL, double _jd = NAN, PositionCache *_cache = NULL);
 		bool operator () (Target *tar1, Target *tar2) { return doSort (tar1, tar2); }
 	protected:
 		bool doSort (Target *tar1, Target *tar2);
 		struct ln_lnlat_posn *observer;
 		double JD;
+		PositionCache *cache;
 };
 
 /**
- * Sort from westmost to eastmost objects
+ * Sort from westmost to eastmost objects. If position cache is not
+ * provided, functor computes positions in every comparison.
  */
 class sortWestEast
 {
 	public:
-		sortWestEast (struct ln_lnlat_posn *_observer = NULL, double _jd = NAN);
+		sortWestEast (struct ln_lnlat_posn *_observer = NULL, double _jd = NAN, PositionCache *_cache = NULL);
 		bool operator () (Target *tar1, Target *tar2) { return doSort (tar1, tar2); }
 	protected:
 		bool doSort (Target *tar1, Target *tar2);
+
+		/**
+		 * Returns sort key of the target - from cache, or newly computed into tmp.
+		 */
+		TargetPosition &getPosition (Target *tar, TargetPosition &tmp);
+
 		struct ln_lnlat_posn *observer;
 		double JD;
+		PositionCache *cache;
 };
 
 /**
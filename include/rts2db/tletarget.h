@@ -22,7 +22,7 @@
 
 #include "target.h"
 
-#include "pluto/norad.h"
+#include "pluto/tleorbit.h"
 
 namespace rts2db
 {
@@ -63,10 +63,9 @@ class TLETarget:public Target
 		std::string tle1;
 		std::string tle2;
 
-		tle_t tle;
+		rts2pluto::TLEOrbit orbit;
 
-		int ephem;
-		int is_deep;
+		rts2pluto::TLEObserver getTLEObserver ();
 
 		void getPosition (struct ln_equ_posn *pos, double JD, struct ln_equ_posn *parallax);
 };
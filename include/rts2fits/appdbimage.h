@@ -37,6 +37,7 @@ class AppDbImage:public rts2db::AppDb
 				try
 				{
 					rts2image::ImageDb *imagedb = new rts2image::ImageDb ();
+					imagedb->setMapChannels (readOnly);
 					imagedb->openFile (an_name, readOnly, false);
 					rts2image::ImageDb *image = getValueImageType (imagedb);
 					ret = processImage (image);
@@ -34,6 +34,7 @@ class AppImageCore:public rts2core::CliApp
 			{
 				const char *an_name = *img_iter;
 				Image *image = new Image ();
+				image->setMapChannels (readOnly);
 				image->openFile (an_name, readOnly, false);
 				ret = processImage (image);
 				delete image;
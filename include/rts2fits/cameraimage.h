@@ -91,6 +91,8 @@ class CameraImage
 
 		void writeData (char *_data, char *_fullTop, int nchan) { image->writeData (_data, _fullTop, nchan); dataWriten = true; }
 
+		void writeChannel (Channel *ch, char *_data, char *_fullTop, int nchan) { image->writeChannel (ch, _data, _fullTop, nchan); dataWriten = true; }
+
 		bool canDelete ();
 
 		/**
@@ -25,6 +25,7 @@
 #include <malloc.h>
 #endif
 #include <sys/types.h>
+#include <stddef.h>
 
 namespace rts2image
 {
@@ -63,6 +64,40 @@ class Channel
 		 */
 		Channel (int ch, char *_data, long dataSize, int _naxis, long *_sizes, int16_t _dataType);
 
+		/**
+		 * Creates channel sharing data of BufferPool buffer. Reference to
+		 * the buffer is retained and released when channel is deleted,
+		 * so the buffer is not copied. Data must not be modified while
+		 * channel exists.
+		 *
+		 * @param ch          channel number
+		 * @param _data       channel data, inside pool buffer
+		 * @param poolBuffer  pool buffer
+		 * @param _naxis      number of axis in channel
+		 * @param _sizes      size of image (size of this array must be equal to _naxis parameter)
+		 * @param _dataType   type of data in channel. Uses FITS datatype notation
+		 */
+		Channel (int ch, char *_data, void *poolBuffer, int _naxis, long *_sizes, int16_t _dataType);
+
+		/**
+		 * Creates channel mapped from uncompressed FITS file. Pixels
+		 * are kept in FITS (big endian, unsigned types with BZERO
+		 * offset) representation in the read-only file mapping, so
+		 * processes reading the same file share page cache. Data are
+		 * converted to native representation only when getData is
+		 * called; statistics are computed directly from the mapping.
+		 *
+		 * @param ch         channel number
+		 * @param fd         file descriptor of opened FITS file
+		 * @param offset     offset of the first pixel in the file
+		 * @param _naxis     number of axis in channel
+		 * @param _sizes     size of image (size of this array must be equal to _naxis parameter)
+		 * @param _dataType  type of data in channel. Uses FITS datatype notation
+		 *
+		 * @throw rts2core::Error when file cannot be mapped
+		 */
+		Channel (int ch, int fd, off_t offset, int _naxis, long *_sizes, int16_t _dataType);
+
 		~Channel ();
 
 		/**
@@ -90,7 +125,15 @@ class Channel
 		const long getHeight () { return naxis > 1 ? sizes[1] : 0; }
 		const long getNPixels () { return getWidth () * getHeight (); }
 
-		const char *getData () { return (char *) data; }
+		/**
+		 * Returns channel data in native representation. Data of mapped channel are converted on the first call.
+		 */
+		const char *getData ();
+
+		/**
+		 * True if channel data are mapped from file.
+		 */
+		bool isMapped () { return mapped != NULL; }
 
 		void computeStatistics (size_t _from = 0, size_t _dataSize = 0);
 
@@ -99,6 +142,14 @@ class Channel
 		int naxis;
 		long *sizes;
 		bool allocated;
+		// BufferPool buffer holding data
+		void *pooled;
+
+		// file mapping and its length
+		char *mapped;
+		size_t mappedLength;
+		// pixels in FITS representation, inside mapping
+		const char *raw;
 
 		int16_t dataType;
 
@@ -108,6 +159,11 @@ class Channel
 
 		// channel number
 		int channelnum;
+
+		/**
+		 * Convert mapped data to native representation.
+		 */
+		void convertRaw ();
 };
 
 class Channels:public std::vector<Channel *>
@@ -48,6 +48,13 @@ class DBFilters:public std::map <int, std::string>
 		 */
 		int getIndex (const char *filer);
 
+		/**
+		 * Get index of already loaded filter.
+		 *
+		 * @return filter index, -1 if filter is not known
+		 */
+		int findIndex (const char *filter);
+
 	private:
 		static DBFilters *pInstance;
 };
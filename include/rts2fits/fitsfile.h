@@ -33,6 +33,8 @@
 #define IMAGE_KEEP_DATA         0x04
 #define IMAGE_DONT_DELETE_DATA  0x08
 #define IMAGE_CANNOT_LOAD       0x10
+// map channels from the file, instead of reading them through CFITSIO
+#define IMAGE_MMAP              0x40
 
 // user defined flag
 #define IMAGE_FLAG_USER1        0x20
@@ -98,6 +98,8 @@ typedef enum
 { EXPOSURE_START, INFO_CALLED, EXPOSURE_END, TRIGGERED }
 imageWriteWhich_t;
 
+class ChannelJob;
+
 const void * getScaledData (int dataType, const void *data, size_t numpix, long smin, long smax, scaling_type scaling, int newType);
 
 /**
@@ -263,6 +265,29 @@ class Image:public FitsFile
 
 		int writeData (char *in_data, char *fullTop, int nchan);
 
+		/**
+		 * Create channels from received data. Channel data are copied
+		 * (if image keeps data) and channel statistics are computed
+		 * in parallel threads. Channels are appended to image channels
+		 * in data order, FITS file is not touched. Use writeChannel to
+		 * write channels to FITS file.
+		 *
+		 * @param data     received data channels
+		 * @param added    channels created from data, NULL for invalid data
+		 * @param threads  number of threads
+		 */
+		void addChannels (rts2core::DataChannels *data, std::vector <Channel *> &added, int threads);
+
+		/**
+		 * Write channel created by addChannels to FITS file.
+		 *
+		 * @param ch       channel
+		 * @param in_data  received data, including image header
+		 * @param fullTop  end of received data
+		 * @param nchan    number of channels, negative if data should not be written
+		 */
+		int writeChannel (Channel *ch, char *in_data, char *fullTop, int nchan);
+
 		/**
 		 * Fill image header structure.
 		 */
@@ -467,6 +492,15 @@ class Image:public FitsFile
 		void setUserFlag () { flags |= IMAGE_FLAG_USER1; }
 		bool hasUserFlag () { return flags & IMAGE_FLAG_USER1; }
 
+		/**
+		 * Set if channels of file opened read-only can be mapped
+		 * from the file, instead of being read to memory. Channels
+		 * are read to memory by default. Only uncompressed files
+		 * owned by the process user are mapped, as changes of the
+		 * file by other users would show in the mapped data.
+		 */
+		void setMapChannels (bool map) { if (map) flags |= IMAGE_MMAP; else flags &= ~IMAGE_MMAP; }
+
 		void closeData () { channels.clear (); }
 
 		// remove pointer to camera dataa
@@ -732,6 +766,8 @@ class Image:public FitsFile
 		virtual std::string expandVariable (std::string expression);
 
 	private:
+		friend class ChannelJob;
+
 		// if connection values should be written to FITS file. Connection values can also be written by template mechanism
 		bool writeConnection;
 
@@ -757,6 +793,16 @@ class Image:public FitsFile
 
 		void getHeaders ();
 
+		/**
+		 * Map current HDU from the file. Returns NULL if the HDU data
+		 * cannot be mapped - file is not opened read-only, is
+		 * compressed, or pixel values are scaled.
+		 */
+		Channel *mapChannel (int ch, int naxis, long *sizes);
+
+		// check header of received data, sets data type
+		bool checkImageData (char *in_data);
+
 		// if filename is NULL, will take name stored in this->getFileName ()
 		// if openFile will load header..
 		bool loadHeader;
@@ -70,6 +70,33 @@ class ImageDb:public Image
 
 		virtual int renameImage (const char *new_filename);
 
+		/**
+		 * Write current image path to the database.
+		 */
+		int updatePath ();
+
+		/**
+		 * Switch batch mode. In batch mode, database updates of an
+		 * image are enclosed in a savepoint instead of a transaction;
+		 * failed image rolls back only its own changes, and changes of
+		 * all images are committed together by commitBatch call. This
+		 * saves a commit (and its disk flush) per image during bulk
+		 * imports.
+		 */
+		static void setBatch (bool _batch);
+
+		/**
+		 * Commit database changes of the batch.
+		 *
+		 * @return -1 if the batch or its part was not committed, 0 on success
+		 */
+		static int commitBatch ();
+
+		/**
+		 * Number of failed database updates of all images.
+		 */
+		static unsigned long getSqlErrors () { return sqlErrors; }
+
 		friend std::ostream & operator << (std::ostream & _os, ImageDb & img_db);
 
 	protected:
@@ -82,6 +109,17 @@ class ImageDb:public Image
 		void getValueInd (const char *name, float &value, int &ind, char *comment = NULL);
 
 		int getDBFilter ();
+
+		// start, commit or roll back image database update - savepoint in batch mode, transaction otherwise
+		void beginUpdate ();
+		void commitUpdate ();
+		void rollbackUpdate ();
+
+	private:
+		static bool batch;
+		// batch was committed early and the commit failed
+		static bool batchFailed;
+		static unsigned long sqlErrors;
 };
 
 class ImageSkyDb:public ImageDb
@@ -135,6 +135,23 @@ class ConnImgProcess:public ConnImgOnlyProcess
 		int end_event;
 };
 
+/**
+ * Finish processing of the image with known astrometry status. Moves image
+ * to archive, trash or dark directory, sends correction to the telescope and
+ * posts EVENT_OK_ASTROMETRY or EVENT_NOT_ASTROMETRY (or end_event, if it is
+ * larger than 0) to master.
+ *
+ * Shared between external image processing script and in-process astrometry.
+ *
+ * @return final astrometry status (BAD if image cannot be opened; it is moved to bad directory)
+ */
+astrometry_stat_t processAstrometryResult (rts2core::Block *master, const std::string &imgPath, astrometry_stat_t astrometryStat, double ra, double dec, double ra_err, double dec_err, int end_event = -1, const char *last_good_jpeg = NULL, const char *last_trash_jpeg = NULL);
+
+/**
+ * Move image, which cannot be processed, to bad subdirectory of its directory.
+ */
+void moveToBad (const std::string &imgPath);
+
 class ConnObsProcess:public ConnProcess
 {
 	public:
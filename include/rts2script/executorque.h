@@ -25,14 +25,7 @@
 #include "rts2db/target.h"
 
 // queue modes
-#define QUEUE_FIFO                   0
-#define QUEUE_CIRCULAR               1
-#define QUEUE_HIGHEST                2
-#define QUEUE_WESTEAST               3
-// observe targets only when they pass meridian
-#define QUEUE_WESTEAST_MERIDIAN      4
-// order targets by time remaining till they become unobservable
-#define QUEUE_OUT_OF_LIMITS          5
+#include "rts2script/nightsim.h"
 
 // timer events for queued start/end
 #define EVENT_NEXT_START      RTS2_LOCAL_EVENT + 1400
@@ -189,6 +182,11 @@ class TargetQueue:public std::list <QueuedTarget>
 		 */
 		void sortWestEastMeridian (double jd);
 
+		/**
+		 * Compute positions of all queued targets for sorting.
+		 */
+		void precomputePositions (rts2db::PositionCache &cache);
+
 		/**
 		 * Sort targets by out-of-limits criteria. First are targets which
 		 * sets below limit as first.
@@ -296,6 +294,38 @@ class ExecutorQueue:public TargetQueue
 		 */
 		int selectNextSimulation (SimulQueueTargets &sq, double from, double to, double &e_end, struct ln_equ_posn *currentp, struct ln_equ_posn *nextp);
 
+		/**
+		 * Add queue targets to night simulator and fill policy with
+		 * queue settings and requests. Must be called before
+		 * NightSimulator::precompute.
+		 */
+		void fillSimulation (NightSimulator &sim, SimPolicy &policy);
+
+		/**
+		 * Prepare simulation of the queue with different queue types.
+		 * Queue targets and their visibility are copied to the returned
+		 * simulator, so it can be run on other thread with
+		 * NightSimulator::runParallel while the queue is changed.
+		 *
+		 * @param queueTypes  queue types (QUEUE_ constants) of simulated variants
+		 * @param policies    filled with policies of simulated variants
+		 *
+		 * @return simulator, which shall be deleted by the caller
+		 */
+		NightSimulator *prepareVariants (double from, double to, const std::vector <int> &queueTypes, std::vector <SimPolicy> &policies);
+
+		/**
+		 * Simulate the queue with different queue types, in parallel
+		 * on pool threads. Target visibility is calculated once from target
+		 * horizon and, if the queue tests them, from target
+		 * constraints.
+		 *
+		 * @param queueTypes  queue types (QUEUE_ constants) of simulated variants
+		 * @param timelines   filled with simulated observations, one timeline per variant
+		 * @param pool        pool running the variants; if NULL, temporary pool is used
+		 */
+		void simulateVariants (double from, double to, const std::vector <int> &queueTypes, std::vector <SimTimeline> &timelines, rts2core::ThreadPool *pool = NULL);
+
 		/**
 		 *
 		 * @param tryFirstPossible     try to set observation on the first possible place
@@ -0,0 +1,223 @@
+/*
+ * Fast-forward night simulation engine.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_NIGHTSIM__
+#define __RTS2_NIGHTSIM__
+
+#include <string>
+#include <vector>
+
+#include <math.h>
+#include <libnova/ln_types.h>
+
+// queue modes
+#define QUEUE_FIFO                   0
+#define QUEUE_CIRCULAR               1
+#define QUEUE_HIGHEST                2
+#define QUEUE_WESTEAST               3
+// observe targets only when they pass meridian
+#define QUEUE_WESTEAST_MERIDIAN      4
+// order targets by time remaining till they become unobservable
+#define QUEUE_OUT_OF_LIMITS          5
+
+namespace rts2core
+{
+class ThreadPool;
+}
+
+namespace rts2plan
+{
+
+/**
+ * Target entering night simulation. Position is assumed to be constant
+ * during the night.
+ */
+class SimTarget
+{
+	public:
+		SimTarget (int _tar_id, const char *_name, double _ra, double _dec, double _duration);
+
+		int tar_id;
+		std::string name;
+		double ra;
+		double dec;
+		// expected script duration in seconds
+		double duration;
+};
+
+/**
+ * Queue entry of simulated queue.
+ */
+class SimRequest
+{
+	public:
+		SimRequest (int _target, double _t_start = NAN, double _t_end = NAN, int _rep_n = -1, double _rep_separation = NAN);
+
+		// index of target in NightSimulator
+		int target;
+		double t_start;
+		double t_end;
+		int rep_n;
+		double rep_separation;
+};
+
+/**
+ * Queue variant - ordering of queue requests together with queue policy.
+ * Queue type is one of the QUEUE_ constants.
+ */
+class SimPolicy
+{
+	public:
+		SimPolicy (const char *_name, int _queueType);
+
+		std::string name;
+		int queueType;
+		bool removeAfterExecution;
+		bool skipBelowHorizon;
+		bool blockUntilVisible;
+
+		std::vector <SimRequest> requests;
+};
+
+/**
+ * Single simulated observation.
+ */
+struct SimObservation
+{
+	int tar_id;
+	// index of request in SimPolicy
+	int request;
+	double start;
+	double end;
+};
+
+typedef std::vector <SimObservation> SimTimeline;
+
+/**
+ * Simulates execution of queues during the night.
+ *
+ * Target altitudes, hour angles and visibility are precomputed once on a
+ * regular time grid. Simulation of queue variant then uses only this
+ * precomputed data, so variants can be simulated in parallel threads. When
+ * no target can be observed, the simulation jumps directly to the next time
+ * when a queue entry becomes visible or its time window opens, instead of
+ * probing the queue every step.
+ *
+ * Visibility is by default given by the minimal altitude. It can be
+ * refined with setVisible, e.g. to include horizon and target constraints.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class NightSimulator
+{
+	public:
+		/**
+		 * @param _observer  observer position
+		 * @param _from      simulation start (ctime)
+		 * @param _to        simulation end (ctime)
+		 * @param _step      [s] grid step
+		 */
+		NightSimulator (struct ln_lnlat_posn *_observer, double _from, double _to, double _step = 60);
+
+		/**
+		 * Add target to simulation. If target with the same ID is already present, its index is returned.
+		 *
+		 * @return target index
+		 */
+		int addTarget (const SimTarget &target);
+
+		/**
+		 * @return target index, -1 if target with given ID is not present
+		 */
+		int findTarget (int tar_id);
+
+		const SimTarget &getTarget (int target) const { return targets[target]; }
+
+		size_t getTargetCount () const { return targets.size (); }
+
+		size_t getSteps () const { return steps; }
+
+		double getFrom () const { return from; }
+		double getTo () const { return to; }
+
+		/**
+		 * Time of grid step.
+		 */
+		double getStepTime (size_t s) const { return from + s * step; }
+
+		/**
+		 * Calculate altitudes, hour angles and visibility of all targets. Must be called after all targets were added.
+		 *
+		 * @param minAlt minimal altitude (in degrees) of visible target
+		 */
+		void precompute (double minAlt = 0);
+
+		/**
+		 * Override target visibility at given grid step.
+		 */
+		void setVisible (int target, size_t s, bool v) { visible[target * steps + s] = v; }
+
+		bool isVisible (int target, double t) const;
+
+		double getAltitude (int target, double t) const { return alt[target * steps + getStep (t)]; }
+
+		double getHourAngle (int target, double t) const { return ha[target * steps + getStep (t)]; }
+
+		/**
+		 * Return time when target stops to be visible. Returns simulation end if target is visible till end.
+		 */
+		double visibleUntil (int target, double t) const;
+
+		/**
+		 * Return first time not sooner than t when target becomes visible, NAN if target does not become visible.
+		 */
+		double nextVisible (int target, double t) const;
+
+		/**
+		 * Simulate queue variant. Can be called from multiple threads.
+		 */
+		void run (const SimPolicy &policy, SimTimeline &timeline) const;
+
+		/**
+		 * Simulate multiple queue variants in parallel, on pool threads.
+		 *
+		 * @param pool  pool running the variants; if NULL, temporary pool is used
+		 */
+		void runParallel (const std::vector <SimPolicy> &policies, std::vector <SimTimeline> &timelines, rts2core::ThreadPool *pool = NULL) const;
+
+	private:
+		struct ln_lnlat_posn observer;
+		double from;
+		double to;
+		double step;
+		size_t steps;
+
+		std::vector <SimTarget> targets;
+
+		// indexed by target * steps + step
+		std::vector <float> alt;
+		std::vector <float> ha;
+		std::vector <char> visible;
+
+		size_t getStep (double t) const;
+};
+
+}
+
+#endif // !__RTS2_NIGHTSIM__
@@ -133,10 +133,11 @@ class Script:public Object, public std::list <Element *>
 		 *
 		 * @params cam_name Name of the camera.
 		 * @params target  Script target. It is used to suply informations to script.
+		 * @params bindTarget  if false, elements which modify the target (disable, boost, exe,..) do not keep target pointer. Such script can be used only for estimation, but can outlive the target.
 		 *
 		 * @return -1 on error, 0 on success.
 		 */
-		int setTarget (const char *cam_name, Rts2Target *target);
+		int setTarget (const char *cam_name, Rts2Target *target, bool bindTarget = true);
 
 		virtual void postEvent (rts2core::Event * event);
 
@@ -250,6 +251,8 @@ class Script:public Object, public std::list <Element *>
 
 		// counts comments
 		int commentNumber;
+		// if false, parsed elements do not keep target pointer
+		bool bindTarget;
 		// is >= 0 when script runs, will become -1 when script is deleted (in beging of script destructor
 		int executedCount;
 
@@ -340,7 +343,8 @@ typedef counted_ptr <Script> ScriptPtr;
 
 /**
  * Return maximal script duration. Computes script's length for
- * all cameras, and return maximal duration.
+ * all cameras, and return maximal duration. Parsed scripts and their
+ * durations are taken from ScriptCache.
  *
  * @param tar     target for which scripts will be retrieved
  * @param cameras list of cameras for which to retrieve scripts.
@@ -0,0 +1,142 @@
+/*
+ * Cache of parsed target scripts.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_SCRIPTCACHE__
+#define __RTS2_SCRIPTCACHE__
+
+#include "rts2script/script.h"
+
+#include <list>
+#include <map>
+#include <string>
+#include <pthread.h>
+#include <time.h>
+
+// maximal number of cached (target, camera) scripts
+#define SCRIPTCACHE_MAX_ENTRIES     2000
+// seconds for which cached script is used without comparing it with script in database
+#define SCRIPTCACHE_TTL             60
+
+namespace rts2script
+{
+
+/**
+ * Process-wide cache of parsed target scripts and their expected durations.
+ *
+ * Scripts are used for estimation only - to calculate expected duration or
+ * to inspect script elements. Cached script is returned without querying
+ * the database for SCRIPTCACHE_TTL seconds, or until
+ * rts2db::Target::invalidateDBScripts is called. Script text is then
+ * retrieved from the target and compared with the cached text, so a script
+ * modified in the database is parsed again. Script changed by other process
+ * (e.g. rts2-target) is therefore used in estimates for up to
+ * SCRIPTCACHE_TTL seconds after the change, unless the process invalidates
+ * scripts itself, as the selector does on every selection cycle. Parsing and duration
+ * calculation are performed only once for each unchanged (target, camera)
+ * script, expected durations are memoized per run number. At most
+ * SCRIPTCACHE_MAX_ENTRIES scripts are kept, least recently used are
+ * dropped first.
+ *
+ * Scripts used for execution are not taken from the cache, as they hold
+ * execution state. Cached scripts are parsed without binding elements to
+ * the target (see Script::setTarget), as they outlive target instances.
+ * Entries are keyed by target ID.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class ScriptCache
+{
+	public:
+		static ScriptCache *instance ();
+
+		/**
+		 * Return parsed script for given target and camera.
+		 *
+		 * @return script, or NULL pointer if script cannot be loaded
+		 */
+		ScriptPtr getScript (Rts2Target *tar, const char *cam_name);
+
+		/**
+		 * Return expected script duration, including telescope movement from tel position.
+		 *
+		 * @throw rts2core::Error when script cannot be retrieved
+		 */
+		double getExpectedDuration (Rts2Target *tar, const char *cam_name, struct ln_equ_posn *tel = NULL, int runnum = 0);
+
+		/**
+		 * Drop entries of cameras which are not in the list. Called when camera set changes.
+		 */
+		void setCameras (rts2db::CamList &cameras);
+
+		/**
+		 * Drop all cached scripts of the target. Scripts loaded in targets are invalidated as well.
+		 */
+		void invalidate (int tar_id);
+
+		/**
+		 * Drop all cached scripts. Scripts loaded in targets are invalidated as well.
+		 */
+		void clear ();
+
+		long getHits () { return hits; }
+		long getMisses () { return misses; }
+
+	private:
+		ScriptCache ();
+		~ScriptCache ();
+
+		static ScriptCache *pInstance;
+
+		typedef std::pair <int, std::string> CacheKey;
+
+		struct CacheEntry
+		{
+			// script text as returned by target, all lines joined
+			std::string text;
+			// rts2db::Target::getDBScriptsGeneration at time text was retrieved
+			unsigned int generation;
+			// time until which text is not compared with the database
+			time_t validUntil;
+			// position in lru list
+			std::list <CacheKey>::iterator lruPos;
+			// target acquisition state changes how acquire element is parsed
+			bool acquired;
+			ScriptPtr script;
+			// sum of element durations, without telescope movement, indexed by run number
+			std::map <int, double> durations;
+		};
+
+		std::map <CacheKey, CacheEntry> entries;
+		// keys of entries, most recently used first
+		std::list <CacheKey> lru;
+		std::list <std::string> cameras;
+
+		pthread_mutex_t cacheMutex;
+
+		long hits;
+		long misses;
+
+		// entries must be locked
+		CacheEntry *findEntry (Rts2Target *tar, const char *cam_name);
+		void eraseEntry (std::map <CacheKey, CacheEntry>::iterator iter);
+};
+
+}
+
+#endif // !__RTS2_SCRIPTCACHE__
@@ -0,0 +1,111 @@
+/*
+ * Sky pixelization for indexed cone searches.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_SKYPIX__
+#define __RTS2_SKYPIX__
+
+#include <math.h>
+
+/*
+ * Sky is divided to declination zones of SKYPIX_ZONE_HEIGHT degrees, every
+ * zone to SKYPIX_CELLS cells of equal RA width. Pixel number is
+ * zone * SKYPIX_CELLS + cell, so pixels of a zone form a continuous range
+ * and cone can be searched with a few BETWEEN conditions on a B-tree
+ * indexed pixel column.
+ *
+ * This header is used by both the database server module (C) and RTS2
+ * library, so pixels computed by trigger match pixels of queries.
+ */
+#define SKYPIX_ZONE_HEIGHT   0.1
+#define SKYPIX_ZONES         1800
+#define SKYPIX_CELLS         3600
+
+static inline int skypix_zone (double dec)
+{
+	int z = (int) floor ((dec + 90.0) / SKYPIX_ZONE_HEIGHT);
+	if (z < 0)
+		return 0;
+	if (z >= SKYPIX_ZONES)
+		return SKYPIX_ZONES - 1;
+	return z;
+}
+
+static inline int skypix_cell (double ra)
+{
+	int c;
+	ra = fmod (ra, 360.0);
+	if (ra < 0)
+		ra += 360.0;
+	c = (int) floor (ra * SKYPIX_CELLS / 360.0);
+	if (c >= SKYPIX_CELLS)
+		return SKYPIX_CELLS - 1;
+	return c;
+}
+
+/**
+ * Returns pixel containing given position.
+ *
+ * @param ra   right ascenation (degrees)
+ * @param dec  declination (degrees)
+ */
+static inline int skypix (double ra, double dec)
+{
+	return skypix_zone (dec) * SKYPIX_CELLS + skypix_cell (ra);
+}
+
+#ifdef __cplusplus
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rts2core
+{
+
+typedef std::vector <std::pair <int, int> > SkyPixRanges;
+
+/**
+ * Find ranges of pixels which cover cone. Ranges are sorted and
+ * disjunct; every position inside the cone has pixel in one of the
+ * ranges. Positions outside the cone can be in the ranges as well,
+ * so exact distance must be checked on candidates.
+ *
+ * @param ra      cone center RA (degrees)
+ * @param dec     cone center DEC (degrees)
+ * @param radius  cone radius (degrees)
+ * @param ranges  returned ranges, inclusive
+ */
+void skyPixRanges (double ra, double dec, double radius, SkyPixRanges &ranges);
+
+/**
+ * Returns SQL condition selecting rows with pixel column in cone. For
+ * too large cones, where index cannot help, returns "true".
+ *
+ * @param column  name of the pixel column
+ * @param ra      cone center RA (degrees)
+ * @param dec     cone center DEC (degrees)
+ * @param radius  cone radius (degrees)
+ */
+std::string skyPixCondition (const char *column, double ra, double dec, double radius);
+
+}
+
+#endif /* __cplusplus */
+
+#endif /* !__RTS2_SKYPIX__ */
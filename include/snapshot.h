@@ -0,0 +1,133 @@
+/*
+ * Lock-free publication of immutable, versioned value snapshots.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_SNAPSHOT__
+#define __RTS2_SNAPSHOT__
+
+#include "mpmcqueue.h"
+
+#include <stdint.h>
+
+namespace rts2core
+{
+
+/**
+ * Snapshot of values published by the block event loop for reading from
+ * other threads (RPC servers and similar frontends).
+ *
+ * Snapshot keeps a small ring of slots. Writer fills a slot which is not
+ * current and is not read by anybody, and then makes it current, so a
+ * published slot is never modified while it can be read. Readers mark
+ * the current slot as read, check it is still current and copy it out.
+ * Readers never take locks and never wait for the writer; they only
+ * retry when the slot was replaced between the two steps. Writer does
+ * not wait for readers either - if all other slots are being read,
+ * publish fails and the previous snapshot stays current.
+ *
+ * Only a single thread may publish. T must be copyable; copy of T
+ * shall not touch data shared with other threads.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+template <class T, int N = 4> class Snapshot
+{
+	public:
+		Snapshot ()
+		{
+			current = 0;
+			lastVersion = 0;
+			for (int i = 0; i < N; i++)
+			{
+				slots[i].readers = 0;
+				slots[i].version = 0;
+			}
+		}
+
+		/**
+		 * Publish new snapshot. Can be called only from the writer thread.
+		 *
+		 * @return version of the published snapshot, 0 if all slots were being read
+		 */
+		uint64_t publish (const T &value)
+		{
+			int cur = __atomic_load_n (&current, __ATOMIC_RELAXED);
+			for (int i = 1; i < N; i++)
+			{
+				Slot &s = slots[(cur + i) % N];
+				if (__atomic_load_n (&(s.readers), __ATOMIC_SEQ_CST) != 0)
+					continue;
+				s.value = value;
+				s.version = ++lastVersion;
+				__atomic_store_n (&current, (cur + i) % N, __ATOMIC_SEQ_CST);
+				return lastVersion;
+			}
+			return 0;
+		}
+
+		/**
+		 * Copy current snapshot. Can be called from any thread.
+		 *
+		 * @param value    returned snapshot
+		 * @return snapshot version, 0 if nothing was published yet
+		 */
+		uint64_t read (T &value)
+		{
+			while (true)
+			{
+				int cur = __atomic_load_n (&current, __ATOMIC_SEQ_CST);
+				Slot &s = slots[cur];
+				__atomic_add_fetch (&(s.readers), 1, __ATOMIC_SEQ_CST);
+				// slot could be refilled before it was marked
+				if (__atomic_load_n (&current, __ATOMIC_SEQ_CST) == cur)
+				{
+					value = s.value;
+					uint64_t ver = s.version;
+					__atomic_sub_fetch (&(s.readers), 1, __ATOMIC_RELEASE);
+					return ver;
+				}
+				__atomic_sub_fetch (&(s.readers), 1, __ATOMIC_RELEASE);
+			}
+		}
+
+		/**
+		 * Returns version of the last published snapshot. Can be called only from the writer thread.
+		 */
+		uint64_t getVersion () { return lastVersion; }
+
+	private:
+		struct Slot
+		{
+			T value;
+			uint64_t version;
+			int readers;
+			char pad[RTS2_CACHE_LINE];
+		};
+
+		Slot slots[N];
+		int current;
+		uint64_t lastVersion;
+
+		// not copyable
+		Snapshot (const Snapshot &);
+		Snapshot &operator = (const Snapshot &);
+};
+
+}
+
+#endif // !__RTS2_SNAPSHOT__
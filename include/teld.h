@@ -23,7 +23,8 @@
 #include <libnova/libnova.h>
 #include <sys/time.h>
 #include <time.h>
-#include "pluto/norad.h"
+#include "pluto/tleorbit.h"
+#include "telemetry.h"
 
 #include "device.h"
 #include "objectcheck.h"
@@ -968,6 +969,13 @@ class Telescope:public rts2core::Device
 		 */
 		void logTracking ();
 
+		/**
+		 * Writes tracking record to the binary telemetry ring.
+		 *
+		 * @param t   record time (ctime)
+		 */
+		void writeTelemetry (double t);
+
 		/**
 		 * Update tracking frequency. Should be run after new tracking vector
 		 * is send to the mount motion controller.
@@ -1390,8 +1398,15 @@ class Telescope:public rts2core::Device
 		rts2core::ValueDouble *tle_refresh;
 
 		rts2core::ValueDouble *trackingLogInterval;
+		rts2core::ValueBool *trackingTextLog;
+		rts2core::ValueString *telemetry_file;
+
+		const char *telemetryFile;
+		int telemetrySize;
+		rts2core::TelemetryRing telemetry;
 
-		tle_t tle;
+		// parsed TLE with initialised propagator
+		rts2pluto::TLEOrbit tleOrbit;
 
 		// Value for RA DEC differential tracking
 		rts2core::ValueRaDec *diffRaDec;
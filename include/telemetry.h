@@ -0,0 +1,171 @@
+/*
+ * Binary telemetry ring file.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_TELEMETRY__
+#define __RTS2_TELEMETRY__
+
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+// "RTST" in little endian
+#define TELEMETRY_MAGIC      0x54535452
+#define TELEMETRY_VERSION    1
+
+namespace rts2core
+{
+
+/**
+ * Single tracking telemetry record. All angles are in degrees.
+ */
+struct TelemetryRecord
+{
+	// record number, 0 for the first record written into the file
+	uint64_t seq;
+	// time (ctime, with microseconds)
+	double time;
+	// target position
+	double tarRa;
+	double tarDec;
+	// pointing model offsets
+	double modelRa;
+	double modelDec;
+	// target in telescope coordinates - target with model and corrections applied
+	double telTarRa;
+	double telTarDec;
+	double telTarAz;
+	double telTarAlt;
+	// telescope (encoders) position
+	double telRa;
+	double telDec;
+	// angular distance between telescope position and target in telescope coordinates
+	double error;
+};
+
+/**
+ * Header of the ring file.
+ */
+struct TelemetryHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t recordSize;
+	uint32_t capacity;
+	// number of records ever written
+	volatile uint64_t count;
+};
+
+/**
+ * Ring of fixed-size telemetry records in memory mapped file. Single
+ * process writes to the ring, any number of processes can read it.
+ * Readers detect records overwritten during read from the record
+ * sequence number, so no locking is needed.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class TelemetryRing
+{
+	public:
+		TelemetryRing ();
+		~TelemetryRing ();
+
+		/**
+		 * Open ring for writing. File is created if it does not exist or
+		 * has a different layout; records of an existing ring are kept.
+		 * Ring with a different layout is replaced by a new file, so
+		 * readers which mapped the old file are not affected.
+		 *
+		 * @param path       ring file path
+		 * @param capacity   number of records in the ring
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int create (const char *path, uint32_t capacity);
+
+		/**
+		 * Open ring for reading. Fails if the file is shorter than the
+		 * ring described by its header.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int open (const char *path);
+
+		void close ();
+
+		bool isOpen () { return header != NULL; }
+
+		/**
+		 * Write record to the ring. Sets seq member of the record.
+		 */
+		void write (TelemetryRecord &rec);
+
+		/**
+		 * Number of records ever written to the ring.
+		 */
+		uint64_t getCount () { return header ? header->count : 0; }
+
+		/**
+		 * Sequence number of the oldest record available in the ring.
+		 */
+		uint64_t getFirst ();
+
+		/**
+		 * Read single record.
+		 *
+		 * @return false if the record was not yet written or was already overwritten
+		 */
+		bool read (uint64_t n, TelemetryRecord &rec);
+
+		/**
+		 * Find first record with time equal or greater than given time.
+		 */
+		uint64_t find (double t);
+
+		/**
+		 * Read records, starting from record from, with at most one record per decimate seconds.
+		 *
+		 * @param from         first record to read; if it was overwritten, reading starts from the oldest record
+		 * @param records      records read are appended to this vector
+		 * @param maxRecords   maximal number of records to read
+		 * @param decimate     minimal time (seconds) between returned records
+		 *
+		 * @return sequence number of the next record to read
+		 */
+		uint64_t read (uint64_t from, std::vector <TelemetryRecord> &records, size_t maxRecords, double decimate = 0);
+
+	private:
+		int fd;
+		TelemetryHeader *header;
+		TelemetryRecord *records;
+		size_t mapSize;
+
+		int mapFile (bool writable);
+};
+
+/**
+ * Names of record columns, in order used by operator <<.
+ */
+extern const char *telemetryColumns[];
+
+std::ostream & operator << (std::ostream &os, const TelemetryRecord &rec);
+
+}
+
+#endif /* !__RTS2_TELEMETRY__ */
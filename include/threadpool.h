@@ -0,0 +1,229 @@
+/*
+ * Work-stealing thread pool.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __RTS2_THREADPOOL__
+#define __RTS2_THREADPOOL__
+
+#include "mpmcqueue.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+namespace rts2core
+{
+
+class ConnCompletion;
+class ThreadPool;
+
+/**
+ * Task executed by ThreadPool. Task is also a future - caller can
+ * wait for its completion and check if it failed.
+ *
+ * Task submitted without completion connection stays owned by the
+ * caller, which shall wait for it before deleting it. Task submitted
+ * with completion connection is owned by the connection after it is
+ * run; the connection calls its completed method from the block event
+ * loop and deletes it. Such task must not be waited for.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class PoolTask
+{
+	public:
+		PoolTask ();
+		virtual ~PoolTask ();
+
+		/**
+		 * Task body, called from a pool thread. Any exception thrown from it marks task as failed.
+		 */
+		virtual void run () = 0;
+
+		/**
+		 * Called from the block event loop after the task was run, if task was submitted with completion connection.
+		 */
+		virtual void completed () {}
+
+		/**
+		 * Wait until task is run.
+		 */
+		void wait ();
+
+		/**
+		 * True if task was run.
+		 */
+		bool isFinished () { return __atomic_load_n (&finished, __ATOMIC_ACQUIRE); }
+
+		/**
+		 * True if run failed with an error.
+		 */
+		bool isFailed () { return failed; }
+
+		const std::string &getError () { return error; }
+
+	private:
+		pthread_mutex_t mutex;
+		pthread_cond_t cond;
+		bool finished;
+		bool failed;
+		std::string error;
+
+		ConnCompletion *completion;
+
+		void finish ();
+
+		// not copyable
+		PoolTask (const PoolTask &);
+		PoolTask &operator = (const PoolTask &);
+
+		friend class ThreadPool;
+};
+
+/**
+ * Task calling a function, with result available through get.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+template <typename R, typename A> class FunctionTask:public PoolTask
+{
+	public:
+		FunctionTask (R (*_fn) (A), A _arg):PoolTask () { fn = _fn; arg = _arg; }
+
+		virtual void run () { result = fn (arg); }
+
+		/**
+		 * Wait for the task and return its result.
+		 */
+		R get () { wait (); return result; }
+
+	private:
+		R (*fn) (A);
+		A arg;
+		R result;
+};
+
+/**
+ * Pool of worker threads for background work.
+ *
+ * Every worker has its own task deque. Tasks submitted from a worker
+ * are put to the back of its deque and processed in LIFO order, which
+ * keeps data of split work in the worker cache. Tasks submitted from
+ * other threads go to a lock-free injection queue. Idle worker takes
+ * tasks from its deque, then from the injection queue, and then steals
+ * the oldest tasks from deques of other workers. Deques are protected
+ * by per-worker mutexes, which are contended only while stealing.
+ * Workers without work sleep on a condition variable.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class ThreadPool
+{
+	public:
+		/**
+		 * @param _threads  number of worker threads, 0 for number of processors
+		 * @param _queueSize  size of the injection queue; when it is full, tasks are distributed directly to worker deques
+		 */
+		ThreadPool (int _threads = 0, size_t _queueSize = 1024);
+
+		/**
+		 * Runs all submitted tasks and stops worker threads.
+		 */
+		~ThreadPool ();
+
+		/**
+		 * Start worker threads.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int start ();
+
+		/**
+		 * Wait for all submitted tasks and stop worker threads.
+		 */
+		void stop ();
+
+		/**
+		 * Submit task for execution.
+		 *
+		 * @param task        task to run
+		 * @param completion  if not NULL, task is passed to this connection after it is run
+		 *
+		 * @return -1 if task was not queued - pool is not running and its injection queue is full, 0 on success
+		 */
+		int submit (PoolTask *task, ConnCompletion *completion = NULL);
+
+		/**
+		 * Wait for the task. When called from a worker thread of this
+		 * pool, the worker runs other tasks while waiting, so tasks
+		 * which split their work and wait for the parts do not block
+		 * the pool.
+		 */
+		void wait (PoolTask *task);
+
+		int getThreads () { return threads; }
+
+		/**
+		 * Number of submitted tasks, which were not yet started.
+		 */
+		size_t getPending () { return __atomic_load_n (&pending, __ATOMIC_RELAXED); }
+
+	private:
+		struct Worker
+		{
+			ThreadPool *pool;
+			pthread_t thread;
+			pthread_mutex_t mutex;
+			std::deque <PoolTask *> tasks;
+		};
+
+		int threads;
+		std::vector <Worker *> workers;
+
+		MPMCQueue <PoolTask *> injection;
+
+		// identifies worker of the calling thread
+		pthread_key_t workerKey;
+
+		pthread_mutex_t sleepMutex;
+		pthread_cond_t sleepCond;
+
+		size_t pending;
+		int sleeping;
+		bool stopping;
+		bool running;
+
+		// worker which receives tasks when injection queue is full
+		size_t nextWorker;
+
+		static void *workerThread (void *arg);
+
+		void workerLoop (Worker *w);
+
+		/**
+		 * Take next task for the worker, NULL if there isn't any.
+		 */
+		PoolTask *take (Worker *w);
+
+		void execute (PoolTask *task);
+};
+
+}
+
+#endif // !__RTS2_THREADPOOL__
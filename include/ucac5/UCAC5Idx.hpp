@@ -17,7 +17,13 @@ class UCAC5Idx
 		UCAC5Idx ();
 		virtual ~UCAC5Idx ();
 
-		int openIdx (int dec_band);
+		/**
+		 * Open index file of the given declination band.
+		 *
+		 * @param dec_band declination band
+		 * @param base     directory with index files; if NULL, index is searched in the current directory
+		 */
+		int openIdx (int dec_band, const char *base = NULL);
 
 		int select (size_t offset, size_t length);
 
@@ -77,6 +77,11 @@ class UCAC5Record
 		double getRADeg () { return data.ira / (1000.0 * 3600.0); }
 		double getDecDeg () { return data.idc / (1000.0 * 3600.0); }
 
+		/**
+		 * Returns Gaia G magnitude, or UCAC model magnitude if G is not available.
+		 */
+		double getMag () { return data.gmag > 0 ? data.gmag / 1000.0 : data.umag / 1000.0; }
+
 		double getRARad () { return ln_deg_to_rad(getRADeg()); }
 		double getDecRad () { return ln_deg_to_rad(getDecDeg()); }
 	
@@ -82,6 +82,31 @@ int mkpath (const char *path, mode_t mode);
  */
 int rmdir_r (const char *dir);
 
+/**
+ * Atomically replace file content. Content is written to a temporary
+ * file, which is synced to disk and renamed over the file. The file
+ * thus contains either old or new content, even if the system crashes
+ * during the write.
+ *
+ * @param filename  file to replace
+ * @param content   new file content
+ *
+ * @return 0 on success, -1 and sets errno on error.
+ */
+int replaceFile (const char *filename, const std::string &content);
+
+/**
+ * Read checkpoint file, which records finished work items, one per
+ * line. Partially written last line, left by interrupted run, is not
+ * returned and is removed from the file, so new lines can be appended.
+ *
+ * @param filename  checkpoint file
+ * @param lines     complete lines of the file are appended to it
+ *
+ * @return 0 on success or if the file does not exist, -1 and sets errno on error.
+ */
+int readCheckpoint (const char *filename, std::vector <std::string> &lines);
+
 /**
  * Parses and initialize tm structure from char.
  *
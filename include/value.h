@@ -309,6 +309,7 @@
 namespace rts2core
 {
 
+class BinaryValueWriter;
 class Connection;
 
 /**
@@ -490,6 +491,15 @@ class Value
 		 */
 		virtual void send (Connection * connection);
 
+		/**
+		 * Encode value for binary value frame. Parameters must be
+		 * written in the order setValue reads them. Default
+		 * implementation writes text from getValue.
+		 *
+		 * @param writer Writer with started value record.
+		 */
+		virtual void writeBinary (BinaryValueWriter &writer);
+
 		/**
 		 * Reset value change bit, so changes will be recorded from now on.
 		 *
@@ -596,6 +606,7 @@ class ValueInteger:public Value
 		}
 		virtual int doOpValue (char op, Value * old_value);
 		virtual const char *getValue ();
+		virtual void writeBinary (BinaryValueWriter &writer);
 		virtual double getValueDouble () { return value; }
 		virtual float getValueFloat () { return value; }
 		virtual int getValueInteger () { return value; }
@@ -632,6 +643,7 @@ class ValueDouble:public Value
 		virtual int doOpValue (char op, Value * old_value);
 		void setValueDouble (double in_value);
 		virtual const char *getValue ();
+		virtual void writeBinary (BinaryValueWriter &writer);
 		virtual const char *getDisplayValue ();
 		virtual double getValueDouble () { return value; }
 		virtual float getValueFloat () { return value; }
@@ -722,6 +734,7 @@ class ValueFloat:public Value
 			}
 		}
 		virtual const char *getValue ();
+		virtual void writeBinary (BinaryValueWriter &writer);
 		virtual const char *getDisplayValue ();
 		virtual double getValueDouble () { return value; }
 		virtual float getValueFloat () { return value; }
@@ -934,6 +947,7 @@ class ValueLong:public Value
 		virtual int doOpValue (char op, Value * old_value);
 
 		virtual const char *getValue ();
+		virtual void writeBinary (BinaryValueWriter &writer);
 		virtual double getValueDouble () { return value; }
 		virtual float getValueFloat () { return value; }
 		virtual int getValueInteger () { return (int) value; }
@@ -1027,6 +1041,7 @@ class ValueRaDec: public Value
 		virtual int doOpValue (char op, Value * old_value);
 
 		virtual const char *getValue ();
+		virtual void writeBinary (BinaryValueWriter &writer);
 		virtual const char *getDisplaySubValue (const char *subv);
 		virtual double getValueDouble () { return NAN; }
 		virtual float getValueFloat () { return NAN; }
@@ -1119,6 +1134,7 @@ class ValueAltAz: public Value
 		virtual int doOpValue (char op, Value * old_value);
 
 		virtual const char *getValue ();
+		virtual void writeBinary (BinaryValueWriter &writer);
 		virtual double getValueDouble () { return NAN; }
 		virtual float getValueFloat () { return NAN; }
 		virtual int getValueInteger () { return INT_MAX; }
@@ -136,6 +136,7 @@ class DoubleArray: public ValueArray
 		virtual int setValues (std::vector <int> &index, Connection * conn);
 		virtual int setValueCharArr (const char *_value);
 		virtual const char *getValue ();
+		virtual void writeBinary (BinaryValueWriter &writer);
 		virtual void setFromValue (rts2core::Value *newValue);
 		virtual bool isEqual (rts2core::Value *other_val);
 
@@ -212,6 +213,7 @@ class IntegerArray: public ValueArray
 		virtual int setValues (std::vector <int> &index, Connection * conn);
 		virtual int setValueCharArr (const char *_value);
 		virtual const char *getValue ();
+		virtual void writeBinary (BinaryValueWriter &writer);
 		virtual void setFromValue (rts2core::Value *newValue);
 		virtual bool isEqual (rts2core::Value *other_val);
 
@@ -40,6 +40,7 @@ class ValueDoubleMinMax:public ValueDouble
 		virtual int checkNotNull ();
 		virtual int doOpValue (char op, Value * old_value);
 		virtual const char *getValue ();
+		virtual void writeBinary (BinaryValueWriter &writer);
 		virtual const char *getDisplayValue ();
 		virtual void setFromValue (Value * newValue);
 
@@ -81,6 +82,7 @@ class ValueIntegerMinMax:public ValueInteger
 		virtual int checkNotNull ();
 		virtual int doOpValue (char op, Value * old_value);
 		virtual const char *getValue ();
+		virtual void writeBinary (BinaryValueWriter &writer);
 		virtual const char *getDisplayValue ();
 		virtual void setFromValue (Value * newValue);
 
@@ -51,6 +51,7 @@ class ValueDoubleStat:public ValueDouble
 
 		virtual int setValue (Connection * connection);
 		virtual const char *getValue ();
+		virtual void writeBinary (BinaryValueWriter &writer);
 		virtual const char *getDisplayValue ();
 		virtual void send (Connection * connection);
 		virtual void setFromValue (Value * newValue);
@@ -138,6 +139,7 @@ class ValueDoubleTimeserie:public ValueDouble
 
 		virtual int setValue (Connection * connection);
 		virtual const char *getValue ();
+		virtual void writeBinary (BinaryValueWriter &writer);
 		virtual const char *getDisplayValue ();
 		virtual void send (Connection * connection);
 		virtual void setFromValue (Value * newValue);
@@ -34,24 +34,6 @@ static void lunar_solar_position( const double jd, double *lunar_xyzr, double *s
    *solar_xyzr++ = sqrt (solar.X * solar.X + solar.Y * solar.Y + solar.Z * solar.Z);
 }
 
-static void cached_lunar_solar_position( const double jd,
-                    double *lunar_xyzr, double *solar_xyzr)
-{
-   static double curr_jd = 0., lunar[4], solar[4];
-   size_t i;
-
-   if( curr_jd != jd)
-      {
-      curr_jd = jd;
-      lunar_solar_position( jd, lunar, solar);
-      }
-   for( i = 0; i < 4; i++)
-      {
-      lunar_xyzr[i] = lunar[i];
-      solar_xyzr[i] = solar[i];
-      }
-}
-
 static const double sin_obliq_2000 = 0.397777155931913701597179975942380896684;
 static const double cos_obliq_2000 = 0.917482062069181825744000384639406458043;
 
@@ -136,7 +118,7 @@ static int calc_accel( const double jd, const double *pos, double *accel)
 
    for( i = 0; i < 3; i++)
       accel[i] = accel_factor * pos[i];
-   cached_lunar_solar_position( jd, lunar_xyzr, solar_xyzr);
+   lunar_solar_position( jd, lunar_xyzr, solar_xyzr);
    for( obj_idx = 0; obj_idx < 2; obj_idx++)
       {
       double *opos = (obj_idx ? lunar_xyzr : solar_xyzr);
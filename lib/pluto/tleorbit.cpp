@@ -0,0 +1,307 @@
+/*
+ * Cached satellite propagator, batch propagation and pass prediction.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "pluto/tleorbit.h"
+#include "pluto/observe.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+// precision of rise, set and culmination times - 0.1 second
+#define TIME_PRECISION   (0.1 / 86400.0)
+
+using namespace rts2pluto;
+
+static inline double deg2rad (double d)
+{
+	return d * M_PI / 180.0;
+}
+
+static inline double rad2deg (double r)
+{
+	return r * 180.0 / M_PI;
+}
+
+TLEObserver::TLEObserver (double _lng, double _lat, double altitude)
+{
+	lng = deg2rad (_lng);
+	lat = deg2rad (_lat);
+	lat_alt_to_parallax (lat, altitude, &rho_cos_phi, &rho_sin_phi);
+}
+
+TLEObserver::TLEObserver (double _lng, double _lat, double rho_cos, double rho_sin)
+{
+	lng = deg2rad (_lng);
+	lat = deg2rad (_lat);
+	rho_cos_phi = rho_cos;
+	rho_sin_phi = rho_sin;
+}
+
+void TLEObserver::getLocation (double JD, double *loc) const
+{
+	observer_cartesian_coords (JD, lng, rho_cos_phi, rho_sin_phi, loc);
+}
+
+TLEOrbit::TLEOrbit ()
+{
+	memset (&tle, 0, sizeof (tle));
+	ephem = -1;
+}
+
+int TLEOrbit::parse (const char *l1, const char *l2)
+{
+	int ret = parse_elements (l1, l2, &tle);
+	if (ret != 0)
+	{
+		ephem = -1;
+		return ret;
+	}
+
+	int e = 1;
+	int is_deep = select_ephemeris (&tle);
+	if (is_deep && (e == 1 || e == 2))
+		e += 2;	/* switch to an SDx */
+	if (!is_deep && (e == 3 || e == 4))
+		e -= 2;	/* switch to an SGx */
+	return setEphem (e);
+}
+
+int TLEOrbit::setEphem (int _ephem)
+{
+	switch (_ephem)
+	{
+		case 0:
+			SGP_init (params, &tle);
+			break;
+		case 1:
+			SGP4_init (params, &tle);
+			break;
+		case 2:
+			SGP8_init (params, &tle);
+			break;
+		case 3:
+			SDP4_init (params, &tle);
+			break;
+		case 4:
+			SDP8_init (params, &tle);
+			break;
+		default:
+			ephem = -1;
+			return -1;
+	}
+	ephem = _ephem;
+	return 0;
+}
+
+int TLEOrbit::propagate (double JD, double *pos, double *vel) const
+{
+	if (ephem == 3 || ephem == 4)
+	{
+		double work[N_SAT_PARAMS];
+		memcpy (work, params, sizeof (params));
+		return propagate (JD, work, pos, vel);
+	}
+	return propagate (JD, (double *) params, pos, vel);
+}
+
+int TLEOrbit::propagate (double JD, double *_params, double *pos, double *vel) const
+{
+	double t_since = (JD - tle.epoch) * 1440.;
+	switch (ephem)
+	{
+		case 0:
+			return SGP (t_since, &tle, _params, pos, vel);
+		case 1:
+			return SGP4 (t_since, &tle, _params, pos, vel);
+		case 2:
+			return SGP8 (t_since, &tle, _params, pos, vel);
+		case 3:
+			return SDP4 (t_since, &tle, _params, pos, vel);
+		case 4:
+			return SDP8 (t_since, &tle, _params, pos, vel);
+	}
+	pos[0] = pos[1] = pos[2] = NAN;
+	return -1;
+}
+
+int TLEOrbit::propagate (const double *JD, size_t n, double *pos, double *vel) const
+{
+	int failed = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		if (propagate (JD[i], pos + 3 * i, vel ? vel + 3 * i : NULL))
+			failed++;
+	}
+	return failed;
+}
+
+int TLEOrbit::getRaDec (double JD, const TLEObserver &observer, double *ra, double *dec, double *distance) const
+{
+	double observer_loc[3], sat_pos[3];
+	observer.getLocation (JD, observer_loc);
+	int ret = propagate (JD, sat_pos);
+	get_satellite_ra_dec_delta (observer_loc, sat_pos, ra, dec, distance);
+	return ret;
+}
+
+double TLEOrbit::getAltitude (double JD, const TLEObserver &observer) const
+{
+	double work[N_SAT_PARAMS];
+	memcpy (work, params, sizeof (params));
+	return getAltitude (JD, observer, work);
+}
+
+double TLEOrbit::getAltitude (double JD, const TLEObserver &observer, double *_params) const
+{
+	double observer_loc[3], sat_pos[3];
+	double ra, dec, distance;
+	if (propagate (JD, _params, sat_pos, NULL))
+		return NAN;
+	observer.getLocation (JD, observer_loc);
+	get_satellite_ra_dec_delta (observer_loc, sat_pos, &ra, &dec, &distance);
+	// observer position vector rotates with local sidereal time
+	double ha = atan2 (observer_loc[1], observer_loc[0]) - ra;
+	return rad2deg (asin (sin (observer.lat) * sin (dec) + cos (observer.lat) * cos (dec) * cos (ha)));
+}
+
+void TLEOrbit::getPasses (double from, double to, const TLEObserver &observer, double horizon, double minCulmination, std::vector <TLEPass> &passes, double step) const
+{
+	passes.clear ();
+	if (ephem < 0)
+		return;
+
+	if (std::isnan (step))
+	{
+		// about 90 samples per revolution, xno is in radians per minute
+		step = 2 * M_PI / tle.xno / 90.0 / 1440.0;
+		if (step < 10 / 86400.0)
+			step = 10 / 86400.0;
+		else if (step > 300 / 86400.0)
+			step = 300 / 86400.0;
+	}
+
+	// private copy of the propagator state, deep space models update it
+	double work[N_SAT_PARAMS];
+	memcpy (work, params, sizeof (params));
+
+	TLEPass pass;
+	double t = from;
+	double alt = getAltitude (t, observer, work);
+	bool up = alt > horizon;
+	if (up)
+	{
+		pass.rise = NAN;
+		pass.culmination = t;
+		pass.maxAltitude = alt;
+	}
+
+	while (t < to)
+	{
+		double tn = t + step;
+		if (tn > to)
+			tn = to;
+		double altn = getAltitude (tn, observer, work);
+		if (!up && altn > horizon)
+		{
+			up = true;
+			pass.rise = findCrossing (t, tn, observer, horizon, work);
+			pass.culmination = tn;
+			pass.maxAltitude = altn;
+		}
+		else if (up && altn <= horizon)
+		{
+			up = false;
+			pass.set = findCrossing (t, tn, observer, horizon, work);
+			double c1 = std::max (std::isnan (pass.rise) ? from : pass.rise, pass.culmination - step);
+			pass.culmination = findCulmination (c1, std::min (pass.set, pass.culmination + step), observer, work);
+			pass.maxAltitude = getAltitude (pass.culmination, observer, work);
+			if (pass.maxAltitude >= minCulmination)
+				passes.push_back (pass);
+		}
+		else if (up && altn > pass.maxAltitude)
+		{
+			pass.culmination = tn;
+			pass.maxAltitude = altn;
+		}
+		t = tn;
+	}
+
+	// pass continues after end of interval
+	if (up && pass.maxAltitude >= minCulmination)
+	{
+		pass.set = NAN;
+		passes.push_back (pass);
+	}
+}
+
+double TLEOrbit::findCrossing (double t1, double t2, const TLEObserver &observer, double horizon, double *_params) const
+{
+	bool up1 = getAltitude (t1, observer, _params) > horizon;
+	while (t2 - t1 > TIME_PRECISION)
+	{
+		double tm = (t1 + t2) / 2.0;
+		if ((getAltitude (tm, observer, _params) > horizon) == up1)
+			t1 = tm;
+		else
+			t2 = tm;
+	}
+	return (t1 + t2) / 2.0;
+}
+
+double TLEOrbit::findCulmination (double t1, double t2, const TLEObserver &observer, double *_params) const
+{
+	// golden section search for altitude maximum
+	const double gr = (sqrt (5.0) - 1) / 2.0;
+	double a = t2 - gr * (t2 - t1);
+	double b = t1 + gr * (t2 - t1);
+	double alt_a = getAltitude (a, observer, _params);
+	double alt_b = getAltitude (b, observer, _params);
+	while (t2 - t1 > TIME_PRECISION)
+	{
+		if (alt_a > alt_b)
+		{
+			t2 = b;
+			b = a;
+			alt_b = alt_a;
+			a = t2 - gr * (t2 - t1);
+			alt_a = getAltitude (a, observer, _params);
+		}
+		else
+		{
+			t1 = a;
+			a = b;
+			alt_a = alt_b;
+			b = t1 + gr * (t2 - t1);
+			alt_b = getAltitude (b, observer, _params);
+		}
+	}
+	return (t1 + t2) / 2.0;
+}
+
+int rts2pluto::propagateAll (const std::vector <TLEOrbit> &orbits, double JD, double *pos)
+{
+	int failed = 0;
+	for (size_t i = 0; i < orbits.size (); i++)
+	{
+		if (orbits[i].propagate (JD, pos + 3 * i))
+			failed++;
+	}
+	return failed;
+}
@@ -0,0 +1,271 @@
+/*
+ * Binary encoding of values for the device protocol.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "binvalue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace rts2core;
+
+void BinaryValueWriter::startValue (const char *name)
+{
+	recordStart = buf.size ();
+	// size, filled by endValue
+	putU32 (0);
+	size_t l = strlen (name);
+	putU16 (l);
+	buf.insert (buf.end (), name, name + l + 1);
+}
+
+void BinaryValueWriter::endValue ()
+{
+	uint32_t s = buf.size () - recordStart - 4;
+	for (int i = 0; i < 4; i++)
+		buf[recordStart + i] = (s >> (8 * i)) & 0xff;
+}
+
+void BinaryValueWriter::addDouble (double v)
+{
+	uint64_t u;
+	memcpy (&u, &v, sizeof (u));
+	buf.push_back (BINV_DOUBLE);
+	putU64 (u);
+}
+
+void BinaryValueWriter::putU16 (uint16_t v)
+{
+	buf.push_back (v & 0xff);
+	buf.push_back (v >> 8);
+}
+
+void BinaryValueWriter::putU32 (uint32_t v)
+{
+	for (int i = 0; i < 4; i++)
+		buf.push_back ((v >> (8 * i)) & 0xff);
+}
+
+void BinaryValueWriter::putU64 (uint64_t v)
+{
+	for (int i = 0; i < 8; i++)
+		buf.push_back ((v >> (8 * i)) & 0xff);
+}
+
+void BinaryValueWriter::putString (uint8_t tag, const char *v)
+{
+	size_t l = strlen (v);
+	buf.push_back (tag);
+	putU32 (l);
+	buf.insert (buf.end (), v, v + l + 1);
+}
+
+BinaryValueReader::BinaryValueReader (char *_data, size_t _len)
+{
+	data = (unsigned char *) _data;
+	len = _len;
+	pos = 0;
+	recordEnd = 0;
+	name = NULL;
+	numBufI = 0;
+}
+
+int BinaryValueReader::nextValue ()
+{
+	pos = recordEnd;
+	if (pos >= len)
+		return 0;
+	if (len - pos < 6)
+		return -1;
+	uint32_t s = getU32 ();
+	if (s > len - pos || s < 3)
+		return -1;
+	recordEnd = pos + s;
+	uint16_t l = getU16 ();
+	if (pos + l + 1 > recordEnd || data[pos + l] != '\0')
+		return -1;
+	name = (const char *) (data + pos);
+	pos += l + 1;
+	return 1;
+}
+
+char *BinaryValueReader::getText ()
+{
+	if (pos >= recordEnd || data[pos] != BINV_TEXT)
+		return NULL;
+	size_t p = pos;
+	int64_t l;
+	double d;
+	char *s;
+	if (nextParam (l, d, s) != BINV_TEXT || !paramEnd ())
+	{
+		pos = p;
+		return NULL;
+	}
+	return s;
+}
+
+int BinaryValueReader::paramInteger (int *num)
+{
+	long long int n;
+	if (paramLongLong (&n))
+		return -1;
+	*num = n;
+	return 0;
+}
+
+int BinaryValueReader::paramLongLong (long long int *num)
+{
+	int64_t l;
+	double d;
+	char *s;
+	char *end;
+	switch (nextParam (l, d, s))
+	{
+		case BINV_INT32:
+		case BINV_INT64:
+			*num = l;
+			return 0;
+		case BINV_DOUBLE:
+			*num = (long long int) d;
+			return 0;
+		case BINV_STRING:
+		case BINV_TEXT:
+			*num = strtoll (s, &end, 10);
+			return *end ? -1 : 0;
+	}
+	return -1;
+}
+
+int BinaryValueReader::paramDouble (double *num)
+{
+	int64_t l;
+	double d;
+	char *s;
+	char *end;
+	switch (nextParam (l, d, s))
+	{
+		case BINV_INT32:
+		case BINV_INT64:
+			*num = l;
+			return 0;
+		case BINV_DOUBLE:
+			*num = d;
+			return 0;
+		case BINV_STRING:
+		case BINV_TEXT:
+			*num = strtod (s, &end);
+			return *end ? -1 : 0;
+	}
+	return -1;
+}
+
+int BinaryValueReader::paramString (char **str)
+{
+	int64_t l;
+	double d;
+	char *s;
+	switch (nextParam (l, d, s))
+	{
+		case BINV_INT32:
+		case BINV_INT64:
+			*str = numBuf[numBufI];
+			snprintf (*str, sizeof (numBuf[0]), "%lli", (long long int) l);
+			break;
+		case BINV_DOUBLE:
+			*str = numBuf[numBufI];
+			snprintf (*str, sizeof (numBuf[0]), "%.20le", d);
+			break;
+		case BINV_STRING:
+		case BINV_TEXT:
+			*str = s;
+			return 0;
+		default:
+			return -1;
+	}
+	numBufI = (numBufI + 1) % 4;
+	return 0;
+}
+
+uint16_t BinaryValueReader::getU16 ()
+{
+	uint16_t ret = data[pos] | (data[pos + 1] << 8);
+	pos += 2;
+	return ret;
+}
+
+uint32_t BinaryValueReader::getU32 ()
+{
+	uint32_t ret = 0;
+	for (int i = 0; i < 4; i++)
+		ret |= ((uint32_t) data[pos + i]) << (8 * i);
+	pos += 4;
+	return ret;
+}
+
+uint64_t BinaryValueReader::getU64 ()
+{
+	uint64_t ret = 0;
+	for (int i = 0; i < 8; i++)
+		ret |= ((uint64_t) data[pos + i]) << (8 * i);
+	pos += 8;
+	return ret;
+}
+
+int BinaryValueReader::nextParam (int64_t &l, double &d, char *&s)
+{
+	if (pos >= recordEnd)
+		return -1;
+	int tag = data[pos];
+	pos++;
+	uint64_t u;
+	uint32_t sl;
+	switch (tag)
+	{
+		case BINV_INT32:
+			if (recordEnd - pos < 4)
+				return -1;
+			l = (int32_t) getU32 ();
+			break;
+		case BINV_INT64:
+			if (recordEnd - pos < 8)
+				return -1;
+			l = (int64_t) getU64 ();
+			break;
+		case BINV_DOUBLE:
+			if (recordEnd - pos < 8)
+				return -1;
+			u = getU64 ();
+			memcpy (&d, &u, sizeof (d));
+			break;
+		case BINV_STRING:
+		case BINV_TEXT:
+			if (recordEnd - pos < 4)
+				return -1;
+			sl = getU32 ();
+			if (sl >= recordEnd - pos || data[pos + sl] != '\0')
+				return -1;
+			s = (char *) (data + pos);
+			pos += sl + 1;
+			break;
+		default:
+			return -1;
+	}
+	return tag;
+}
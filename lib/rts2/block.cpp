@@ -67,6 +67,9 @@ Block::Block (int in_argc, char **in_argv):App (in_argc, in_argv)
 	stateMasterConn = NULL;
 	// allocate ports dynamically
 	port = 0;
+
+	binaryValues = false;
+	addOption (OPT_BINARY_VALUES, "binary-values", 0, "request values from devices in binary frames; devices not supporting them send text");
 }
 
 
@@ -94,6 +97,19 @@ Block::~Block (void)
 	blockUsers.clear ();
 }
 
+int Block::processOption (int in_opt)
+{
+	switch (in_opt)
+	{
+		case OPT_BINARY_VALUES:
+			binaryValues = true;
+			break;
+		default:
+			return App::processOption (in_opt);
+	}
+	return 0;
+}
+
 void Block::setPort (int in_port)
 {
 	port = in_port;
@@ -1001,6 +1017,19 @@ void Block::deleteTimers (int event_type)
 	}
 }
 
+void Block::deleteTimers (int event_type, void *arg)
+{
+	for (std::map <double, Event *>::iterator iter = timers.begin (); iter != timers.end (); )
+	{
+		if (iter->second->getType () == event_type && iter->second->getArg () == arg)
+		{
+			if (pushToDelete (iter))
+				delete (iter->second);
+		}
+		iter++;
+	}
+}
+
 void Block::valueMaskError (Value *val, int32_t err)
 {
   	if ((val->getFlags () & RTS2_VALUE_ERRORMASK) != err)
@@ -0,0 +1,238 @@
+/*
+ * Pool of large data buffers.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "bufferpool.h"
+
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// [bytes] huge page size; buffers of this or larger size are rounded to it
+#define HUGE_PAGE      (2 * 1024 * 1024)
+// [bytes] default size of free buffers kept for reuse
+#define CACHE_LIMIT    (1024L * 1024L * 1024L)
+
+using namespace rts2core;
+
+BufferPool::BufferPool ()
+{
+	pthread_mutex_init (&mutex, NULL);
+	lock = false;
+	cacheLimit = CACHE_LIMIT;
+	memset (&st, 0, sizeof (st));
+}
+
+BufferPool::~BufferPool ()
+{
+	trim ();
+	pthread_mutex_destroy (&mutex);
+}
+
+BufferPool &BufferPool::instance ()
+{
+	static BufferPool pool;
+	return pool;
+}
+
+size_t BufferPool::sizeClass (size_t size)
+{
+	static size_t pageSize = sysconf (_SC_PAGESIZE);
+	if (size <= pageSize)
+		return pageSize;
+	// largest power of two not exceeding size, classes are its 4/4, 5/4, 6/4 and 7/4 multiples
+	size_t p = pageSize;
+	while (p <= size / 2)
+		p *= 2;
+	size_t step = p / 4 > pageSize ? p / 4 : pageSize;
+	size_t c = ((size + step - 1) / step) * step;
+	if (c >= HUGE_PAGE)
+		c = ((c + HUGE_PAGE - 1) / HUGE_PAGE) * HUGE_PAGE;
+	return c;
+}
+
+void *BufferPool::allocate (size_t size)
+{
+	size_t c = sizeClass (size);
+	void *buf = NULL;
+	bool locked = false;
+
+	pthread_mutex_lock (&mutex);
+	st.allocations++;
+	std::map <size_t, std::vector <FreeBuffer> >::iterator iter = freeBuffers.find (c);
+	if (iter != freeBuffers.end () && !iter->second.empty ())
+	{
+		buf = iter->second.back ().buf;
+		locked = iter->second.back ().locked;
+		iter->second.pop_back ();
+		st.cached -= c;
+		st.hits++;
+	}
+	pthread_mutex_unlock (&mutex);
+
+	// mapping and faulting in can take long, do not block other threads
+	if (buf == NULL)
+	{
+		buf = map (c, locked);
+		if (buf == NULL)
+			return NULL;
+	}
+
+	pthread_mutex_lock (&mutex);
+	Buffer &b = buffers[buf];
+	b.size = c;
+	b.refs = 1;
+	b.locked = locked;
+	st.used += c;
+	if (st.used > st.peak)
+		st.peak = st.used;
+	pthread_mutex_unlock (&mutex);
+
+	return buf;
+}
+
+void BufferPool::retain (void *buf)
+{
+	pthread_mutex_lock (&mutex);
+	std::map <void *, Buffer>::iterator iter = buffers.find (buf);
+	if (iter != buffers.end ())
+		iter->second.refs++;
+	pthread_mutex_unlock (&mutex);
+}
+
+void BufferPool::release (void *buf)
+{
+	if (buf == NULL)
+		return;
+	pthread_mutex_lock (&mutex);
+	std::map <void *, Buffer>::iterator iter = buffers.find (buf);
+	if (iter == buffers.end () || --(iter->second.refs) > 0)
+	{
+		pthread_mutex_unlock (&mutex);
+		return;
+	}
+	FreeBuffer fb;
+	fb.buf = buf;
+	fb.size = iter->second.size;
+	fb.locked = iter->second.locked;
+	buffers.erase (iter);
+	st.used -= fb.size;
+	freeBuffers[fb.size].push_back (fb);
+	st.cached += fb.size;
+	std::vector <FreeBuffer> removed;
+	shrink (cacheLimit, removed);
+	pthread_mutex_unlock (&mutex);
+
+	unmap (removed);
+}
+
+bool BufferPool::owns (void *buf)
+{
+	pthread_mutex_lock (&mutex);
+	bool ret = buffers.find (buf) != buffers.end ();
+	pthread_mutex_unlock (&mutex);
+	return ret;
+}
+
+void BufferPool::setCacheLimit (size_t limit)
+{
+	std::vector <FreeBuffer> removed;
+	pthread_mutex_lock (&mutex);
+	cacheLimit = limit;
+	shrink (cacheLimit, removed);
+	pthread_mutex_unlock (&mutex);
+	unmap (removed);
+}
+
+void BufferPool::getStats (BufferPoolStats &stats)
+{
+	pthread_mutex_lock (&mutex);
+	stats = st;
+	pthread_mutex_unlock (&mutex);
+}
+
+void BufferPool::trim ()
+{
+	std::vector <FreeBuffer> removed;
+	pthread_mutex_lock (&mutex);
+	shrink (0, removed);
+	pthread_mutex_unlock (&mutex);
+	unmap (removed);
+}
+
+void *BufferPool::map (size_t size, bool &locked)
+{
+	void *buf = MAP_FAILED;
+#ifdef MAP_HUGETLB
+	// reserved huge pages, mapping fails if there are not enough of them
+	if (size % HUGE_PAGE == 0)
+		buf = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+#endif
+	if (buf == MAP_FAILED)
+	{
+		buf = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (buf == MAP_FAILED)
+			return NULL;
+#ifdef MADV_HUGEPAGE
+		// transparent huge pages, must be requested before pages are faulted in
+		if (size >= HUGE_PAGE)
+			madvise (buf, size, MADV_HUGEPAGE);
+#endif
+		// fault in pages now, not during readout
+		static size_t pageSize = sysconf (_SC_PAGESIZE);
+		for (size_t i = 0; i < size; i += pageSize)
+			((volatile char *) buf)[i] = 0;
+	}
+
+	locked = lock && mlock (buf, size) == 0;
+	bool lockFailed = lock && !locked;
+
+	pthread_mutex_lock (&mutex);
+	st.misses++;
+	if (lockFailed)
+		st.lockFailures++;
+	pthread_mutex_unlock (&mutex);
+
+	return buf;
+}
+
+void BufferPool::unmap (std::vector <FreeBuffer> &bufs)
+{
+	for (std::vector <FreeBuffer>::iterator iter = bufs.begin (); iter != bufs.end (); iter++)
+	{
+		if (iter->locked)
+			munlock (iter->buf, iter->size);
+		munmap (iter->buf, iter->size);
+	}
+}
+
+void BufferPool::shrink (size_t limit, std::vector <FreeBuffer> &removed)
+{
+	std::map <size_t, std::vector <FreeBuffer> >::reverse_iterator iter = freeBuffers.rbegin ();
+	while (st.cached > limit && iter != freeBuffers.rend ())
+	{
+		if (iter->second.empty ())
+		{
+			iter++;
+			continue;
+		}
+		removed.push_back (iter->second.back ());
+		iter->second.pop_back ();
+		st.cached -= iter->first;
+	}
+}
@@ -30,6 +30,7 @@
 #include <iomanip>
 
 #include "camd.h"
+#include "bufferpool.h"
 #include "cliwheel.h"
 #include "clifocuser.h"
 #include "timestamp.h"
@@ -51,6 +52,8 @@
 #define OPT_COMMENTS          OPT_LOCAL + 421
 #define OPT_HISTORIES         OPT_LOCAL + 422
 #define OPT_RTS2_COOLING      OPT_LOCAL + 423
+#define OPT_POOL_LOCK         OPT_LOCAL + 424
+#define OPT_POOL_CACHE        OPT_LOCAL + 425
 
 #define EVENT_TEMP_CHECK      RTS2_LOCAL_EVENT + 676
 
@@ -165,8 +168,7 @@ long Camera::isExposing ()
 
 int Camera::endExposure (int ret)
 {
-	if (modeCount)
-		memset (modeCount, 0, modeCountSize * sizeof (uint32_t));
+	modeHistogram.clear ();
 	if (exposureConn)
 	{
 		logStream (MESSAGE_INFO) << "end exposure for " << exposureConn->getName () << sendLog;
@@ -469,10 +471,6 @@ Camera::Camera (int in_argc, char **in_argv, rounding_t binning_rounding):rts2co
 	createValue (sum, "sum", "sum of pixels readed out", false);
 	createValue (image_mode, "image_mode", "mode (most often pixel value)", false);
 
-	// mode histogram
-	modeCount = NULL;
-	modeCountSize = 0;
-
 	createValue (computedPix, "computed", "number of pixels so far computed", false);
 
 	createValue (calculateCenter, "center_cal", "calculate center box statistics", false, RTS2_VALUE_WRITABLE | RTS2_DT_ONOFF);
@@ -550,6 +548,11 @@ Camera::Camera (int in_argc, char **in_argv, rounding_t binning_rounding):rts2co
 	createValue (readoutTime, "readout_time", "[s] data readout time", false, RTS2_DT_TIMEINTERVAL);
 	createValue (transferTime, "transfer_time", "[s] data transfer time, including overhead", false, RTS2_DT_TIMEINTERVAL);
 
+	createValue (poolUsed, "pool_used", "[bytes] data buffers in use", false, RTS2_DT_BYTESIZE);
+	createValue (poolCached, "pool_cached", "[bytes] free data buffers kept for reuse", false, RTS2_DT_BYTESIZE);
+	createValue (poolHits, "pool_hits", "data buffers allocations served from pool", false);
+	createValue (poolMisses, "pool_misses", "data buffers allocations which mapped new memory", false);
+
 	createValue (camFocVal, "focpos", "position of focuser", false, RTS2_VALUE_WRITABLE, CAM_EXPOSING);
 
 	camFilterVal = NULL;
@@ -585,6 +588,8 @@ Camera::Camera (int in_argc, char **in_argv, rounding_t binning_rounding):rts2co
 	addOption (OPT_TRIMS_END, "trimend", 1, "trimmed (good data) XY ends on unbinned chip - x1:y1,..");
 	addOption (OPT_CHANNELS_STARTS, "chanstarts", 1, "channel starts - X1:Y1,:..");
 	addOption (OPT_CHANNELS_DELTAS, "chandeltas", 1, "channel deltas - DX1:DY1,..");
+	addOption (OPT_POOL_LOCK, "pool-lock", 0, "lock data buffers in memory");
+	addOption (OPT_POOL_CACHE, "pool-cache", 1, "[MB] size of free data buffers kept for reuse");
 }
 
 Camera::~Camera ()
@@ -592,10 +597,14 @@ Camera::~Camera ()
 	delete sharedData;
 	delete fhd;
 
+	if (dataBuffers)
+	{
+		for (int i = 0; i < getNumChannels (); i++)
+			rts2core::BufferPool::instance ().release (dataBuffers[i]);
+	}
 	delete[] dataBuffers;
 	delete[] dataWritten;
 	
-	delete[] modeCount;
 }
 
 int Camera::willConnect (rts2core::NetworkAddress * in_addr)
@@ -766,6 +775,14 @@ int Camera::info ()
 		viter->filter->setValueInteger (getFilterNum (*niter));
 	}
 	camFocVal->setValueInteger (getFocPos ());
+
+	rts2core::BufferPoolStats st;
+	rts2core::BufferPool::instance ().getStats (st);
+	poolUsed->setValueLong (st.used);
+	poolCached->setValueLong (st.cached);
+	poolHits->setValueLong (st.hits);
+	poolMisses->setValueLong (st.misses);
+
 	return rts2core::ScriptDevice::info ();
 }
 
@@ -884,6 +901,12 @@ int Camera::processOption (int in_opt)
 				wcs_aux->setValueArray (cwcs);
 			}
 			break;
+		case OPT_POOL_LOCK:
+			rts2core::BufferPool::instance ().setLock (true);
+			break;
+		case OPT_POOL_CACHE:
+			rts2core::BufferPool::instance ().setCacheLimit (atol (optarg) * 1024 * 1024);
+			break;
 		case OPT_WITHSHM:
 			// autoscale
 			if (optarg == NULL)
@@ -1010,17 +1033,9 @@ int Camera::sendReadoutData (char *data, size_t dataSize, int chan)
 		average->setValueDouble (sum->getValueDouble () / computedPix->getValueLong ());
 
 		// find maximal mode value
-		if (modeCount != NULL)
+		if (modeHistogram.getCount () > 0)
 		{
-			uint32_t modeNum = 0;
-			for (unsigned int i = 0; i < modeCountSize; i++)
-			{
-				if (modeCount[i] > modeNum)
-				{
-					image_mode->setValueInteger (i);
-					modeNum = modeCount[i];
-				}
-			}
+			image_mode->setValueInteger (modeHistogram.getMode ());
 			sendValueAll (image_mode);
 		}
 
@@ -1571,11 +1586,19 @@ void Camera::findSepStars (uint16_t *data)
 		return;
 	}
 
-	uint16_t *imback = (uint16_t *) malloc (getUsedWidthBinned () * getUsedHeightBinned () * sizeof (uint16_t));
+	uint16_t *imback = (uint16_t *) rts2core::BufferPool::instance ().allocate (getUsedWidthBinned () * getUsedHeightBinned () * sizeof (uint16_t));
+	if (imback == NULL)
+	{
+		logStream (MESSAGE_ERROR) << "SEP: cannot allocate background array" << sendLog;
+		sep_bkg_free (bkg);
+		return;
+	}
 	status = sep_bkg_array (bkg, imback, SEP_TUINT16);
+	rts2core::BufferPool::instance ().release (imback);
 	if (status)
 	{
 		logStream (MESSAGE_ERROR) << "SEP: cannot construct background array:" << status << sendLog;
+		sep_bkg_free (bkg);
 		return;
 	}
 
@@ -1583,6 +1606,7 @@ void Camera::findSepStars (uint16_t *data)
 	if (status)
 	{
 		logStream (MESSAGE_ERROR) << "SEP: cannot subtract background:" << status << sendLog;
+		sep_bkg_free (bkg);
 		return;
 	}
 
@@ -1595,23 +1619,23 @@ void Camera::findSepStars (uint16_t *data)
 	if (status)
 	{
 		logStream (MESSAGE_ERROR) << "SEP: cannot extract sources:" << status << sendLog;
+		sep_bkg_free (bkg);
 		return;
 	}
 
 	/* aperture photometry */
-	double *flux, *fluxerr, *fluxt, *fluxerrt, *area, *areat;
-	short *flag, *flagt;
+	std::vector <double> flux (catalog->nobj);
+	std::vector <double> fluxerr (catalog->nobj);
+	std::vector <double> area (catalog->nobj);
+	std::vector <short> flag (catalog->nobj);
 
 	im.noise = &(bkg->globalrms);  /* set image noise level */
 	im.ndtype = SEP_TUINT16;
-	fluxt = flux = (double *)malloc(catalog->nobj * sizeof(double));
-	fluxerrt = fluxerr = (double *)malloc(catalog->nobj * sizeof(double));
-	areat = area = (double *)malloc(catalog->nobj * sizeof(double));
-	flagt = flag = (short *)malloc(catalog->nobj * sizeof(short));
-	for (int i=0; i<catalog->nobj; i++, fluxt++, fluxerrt++, flagt++, areat++)
-		sep_sum_circle(&im, catalog->x[i], catalog->y[i], 5.0, 5, 0, fluxt, fluxerrt, areat, flagt);
-
+	for (int i=0; i<catalog->nobj; i++)
+		sep_sum_circle(&im, catalog->x[i], catalog->y[i], 5.0, 5, 0, &(flux[i]), &(fluxerr[i]), &(area[i]), &(flag[i]));
 
+	sep_catalog_free (catalog);
+	sep_bkg_free (bkg);
 }
 
 int Camera::camStartExposure (bool careBlock)
@@ -1697,6 +1721,13 @@ int Camera::camStartExposureWithoutCheck ()
 	sepY->clear ();
 	sepFluxes->clear ();
 
+	// get readout buffers before exposure, so readout does not wait for memory
+	if (sharedData == NULL)
+	{
+		for (int i = 0; i < getNumChannels (); i++)
+			getDataBuffer (i);
+	}
+
 	ret = startExposure ();
 	if (!(ret == 0 || ret == 1))
 		return ret;
@@ -2187,7 +2218,7 @@ char* Camera::getDataBuffer (int chan)
 		return ((char *) sharedData->getChannelData (chan)) + sizeof (imghdr);
 	// if dataBuffesr is null, allocate it
 	if (dataBuffers[chan] == NULL && suggestBufferSize () > 0)
-		dataBuffers[chan] = new char[getHeight () * getWidth () * maxPixelByteSize ()];
+		dataBuffers[chan] = (char *) rts2core::BufferPool::instance ().allocate (getHeight () * getWidth () * maxPixelByteSize ());
 	return dataBuffers[chan];
 }
 
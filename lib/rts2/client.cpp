@@ -101,6 +101,9 @@ void ConnClient::connConnected ()
  	Connection::connConnected ();
 	master->getSingleCentralConn ()->queCommand (new CommandKey (master, getName ()));
 	setConnState (CONN_AUTH_PENDING);
+	// will be send after authorization
+	if (master->getBinaryValues ())
+		queCommand (new CommandBinaryValues (master));
 }
 
 void ConnClient::setKey (int in_key)
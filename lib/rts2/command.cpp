@@ -158,6 +158,16 @@ CommandKey::CommandKey (Block * _master, const char *device_name):Command (_mast
 	setCommand (_os);
 }
 
+CommandBinaryValues::CommandBinaryValues (Block * _master):Command (_master, COMMAND_BINARY_VALUES " 1")
+{
+}
+
+int CommandBinaryValues::commandReturnFailed (int status, Connection * conn)
+{
+	logStream (MESSAGE_DEBUG) << conn->getName () << " does not support binary values, values will be received as text" << sendLog;
+	return Command::commandReturnFailed (status, conn);
+}
+
 CommandCameraSettings::CommandCameraSettings (DevClientCamera * _camera):Command (_camera->getMaster ())
 {
 }
@@ -622,6 +632,20 @@ CommandExecGrb::CommandExecGrb (Block * _master, int _grb_id):Command (_master)
 	setCommand (_os);
 }
 
+CommandExecGrbAlert::CommandExecGrbAlert (Block * _master, int _grb_id, int gcn_id, int gcn_type, double ra, double dec, double errorbox, double grb_date, bool enabled, bool stored, double received):CommandExecGrb (_master, _grb_id)
+{
+	std::ostringstream _os;
+	_os << "grb_alert " << _grb_id << " " << gcn_id << " " << gcn_type << " " << std::fixed << ra << " " << dec << " " << errorbox << " " << grb_date << " " << (enabled ? 1 : 0) << " " << (stored ? 1 : 0) << " " << received;
+	setCommand (_os);
+}
+
+CommandGrbStored::CommandGrbStored (Block * _master, int _grb_id):Command (_master)
+{
+	std::ostringstream _os;
+	_os << "grb_stored " << _grb_id;
+	setCommand (_os);
+}
+
 CommandQueueNow::CommandQueueNow (Block *_master, const char *queue, int tar_id):Command (_master)
 {
 	std::ostringstream _os;
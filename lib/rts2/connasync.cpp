@@ -0,0 +1,349 @@
+/*
+ * Asynchronous request/response engine for instrument ports.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "connection/async.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+using namespace rts2core;
+
+AsyncRequest::AsyncRequest (const std::string &_cmd, double _timeout)
+{
+	cmd = _cmd;
+	timeout = _timeout;
+
+	replyLength = 0;
+	expectReply = true;
+
+	written = 0;
+	sent = NAN;
+	duration = NAN;
+}
+
+AsyncRequest::~AsyncRequest ()
+{
+}
+
+void AsyncRequest::failed (int err)
+{
+	logStream (MESSAGE_ERROR) << "request " << cmd << " failed: " << strerror (err) << sendLog;
+}
+
+size_t AsyncRequest::frameLength (const char *buf, size_t len, size_t &dataLen)
+{
+	if (replyLength > 0)
+	{
+		if (len < replyLength)
+			return 0;
+		dataLen = replyLength;
+		return replyLength;
+	}
+	if (replyEnd.length () == 0 || len < replyEnd.length ())
+		return 0;
+	const char *end = std::search (buf, buf + len, replyEnd.begin (), replyEnd.end ());
+	if (end == buf + len)
+		return 0;
+	dataLen = end - buf;
+	return dataLen + replyEnd.length ();
+}
+
+ConnAsync::ConnAsync (Block *_master, Connection *_port, const char *_replyEnd, int _maxInFlight):ConnNoSend (_master)
+{
+	port = _port;
+	replyEnd = _replyEnd;
+	maxInFlight = _maxInFlight;
+
+	timerAt = NAN;
+	portEOF = false;
+}
+
+ConnAsync::~ConnAsync ()
+{
+	getMaster ()->deleteTimers (EVENT_ASYNC_TIMEOUT, this);
+	clear ();
+}
+
+void ConnAsync::queue (AsyncRequest *req)
+{
+	if (req->replyLength == 0 && req->replyEnd.length () == 0)
+		req->replyEnd = replyEnd;
+	req->written = 0;
+	portEOF = false;
+
+	waiting.push_back (req);
+	sendWaiting ();
+	updateTimer ();
+}
+
+void ConnAsync::clear (int err)
+{
+	input.clear ();
+	// requests might be queued from failed callbacks
+	std::deque <AsyncRequest *> failed;
+	failed.swap (inFlight);
+	failed.insert (failed.end (), waiting.begin (), waiting.end ());
+	waiting.clear ();
+	for (std::deque <AsyncRequest *>::iterator iter = failed.begin (); iter != failed.end (); iter++)
+		fail (*iter, err);
+}
+
+int ConnAsync::add (Block *block)
+{
+	int fd = getFd ();
+	if (fd < 0 || portEOF)
+		return 0;
+	short events = POLLIN | POLLPRI;
+	// command waiting for the port to become writable
+	if (!waiting.empty () && inFlight.size () < maxInFlight)
+		events |= POLLOUT;
+	block->addPollFD (fd, events);
+	return 0;
+}
+
+int ConnAsync::receive (Block *block)
+{
+	int fd = getFd ();
+	if (fd < 0 || !(block->getPollEvents (fd) & (POLLIN | POLLPRI | POLLHUP | POLLERR)))
+		return 0;
+
+	char rbuf[1024];
+	ssize_t ret = read (fd, rbuf, sizeof (rbuf));
+	if (ret < 0)
+	{
+		if (errno == EINTR || errno == EAGAIN)
+			return 0;
+		logStream (MESSAGE_ERROR) << "error reading from port: " << strerror (errno) << sendLog;
+		portEOF = true;
+		clear (errno);
+		return 0;
+	}
+	if (ret == 0)
+	{
+		logStream (MESSAGE_ERROR) << "port was closed" << sendLog;
+		portEOF = true;
+		clear (EPIPE);
+		return 0;
+	}
+
+	if (debugComm)
+	{
+		LogStream ls = logStream (MESSAGE_DEBUG);
+		ls << "readed from port '";
+		ls.logArr (rbuf, ret);
+		ls << "'" << sendLog;
+	}
+
+	input.append (rbuf, ret);
+	processInput ();
+	sendWaiting ();
+	updateTimer ();
+	return 0;
+}
+
+int ConnAsync::writable (Block *block)
+{
+	int fd = getFd ();
+	if (fd >= 0 && block->isForWrite (fd))
+	{
+		sendWaiting ();
+		updateTimer ();
+	}
+	return 0;
+}
+
+int ConnAsync::idle ()
+{
+	checkTimeouts ();
+	return ConnNoSend::idle ();
+}
+
+void ConnAsync::postEvent (Event *event)
+{
+	switch (event->getType ())
+	{
+		case EVENT_ASYNC_TIMEOUT:
+			if (event->getArg () != this)
+				break;
+			timerAt = NAN;
+			checkTimeouts ();
+			updateTimer ();
+			break;
+	}
+	ConnNoSend::postEvent (event);
+}
+
+void ConnAsync::unsolicited (const char *buf, size_t len)
+{
+	LogStream ls = logStream (MESSAGE_WARNING);
+	ls << "dropping unexpected data '";
+	ls.logArr (buf, len);
+	ls << "'" << sendLog;
+}
+
+void ConnAsync::sendWaiting ()
+{
+	int fd = getFd ();
+	if (fd < 0)
+		return;
+
+	while (!waiting.empty () && inFlight.size () < maxInFlight)
+	{
+		AsyncRequest *req = waiting.front ();
+		ssize_t ret = write (fd, req->cmd.c_str () + req->written, req->cmd.length () - req->written);
+		if (ret < 0)
+		{
+			if (errno == EINTR || errno == EAGAIN)
+				return;
+			logStream (MESSAGE_ERROR) << "cannot write to port: " << strerror (errno) << sendLog;
+			waiting.pop_front ();
+			fail (req, errno);
+			continue;
+		}
+		req->written += ret;
+		// wait for poll to report port is writable
+		if (req->written < req->cmd.length ())
+			return;
+
+		if (debugComm)
+			logStream (MESSAGE_DEBUG) << "written to port '" << req->cmd << "'" << sendLog;
+
+		waiting.pop_front ();
+		req->sent = getNow ();
+		if (req->expectReply)
+			inFlight.push_back (req);
+		else
+			finish (req, "", 0);
+	}
+}
+
+void ConnAsync::processInput ()
+{
+	while (!input.empty ())
+	{
+		if (inFlight.empty ())
+		{
+			unsolicited (input.c_str (), input.length ());
+			input.clear ();
+			return;
+		}
+		AsyncRequest *req = inFlight.front ();
+		size_t dataLen = 0;
+		size_t l = req->frameLength (input.data (), input.length (), dataLen);
+		if (l == 0)
+			return;
+		inFlight.pop_front ();
+		std::string reply (input, 0, dataLen);
+		input.erase (0, l);
+		finish (req, reply.c_str (), reply.length ());
+	}
+}
+
+void ConnAsync::checkTimeouts ()
+{
+	double now = getNow ();
+	std::deque <AsyncRequest *>::iterator iter;
+	for (iter = inFlight.begin (); iter != inFlight.end (); iter++)
+	{
+		if ((*iter)->sent + (*iter)->timeout < now)
+			break;
+	}
+	if (iter == inFlight.end ())
+		return;
+
+	LogStream ls = logStream (MESSAGE_ERROR);
+	ls << "timeout waiting for reply to " << (*iter)->cmd;
+	if (!input.empty ())
+	{
+		ls << ", dropping '";
+		ls.logArr (input.c_str (), input.length ());
+		ls << "'";
+	}
+	ls << sendLog;
+
+	// replies to the other requests in flight cannot be matched
+	input.clear ();
+	flushInput ();
+	std::deque <AsyncRequest *> failed;
+	failed.swap (inFlight);
+	for (iter = failed.begin (); iter != failed.end (); iter++)
+		fail (*iter, ETIMEDOUT);
+
+	sendWaiting ();
+}
+
+void ConnAsync::flushInput ()
+{
+	int fd = getFd ();
+	if (fd < 0)
+		return;
+	if (isatty (fd))
+	{
+		// do not discard partially written command
+		tcflush (fd, (!waiting.empty () && waiting.front ()->written > 0) ? TCIFLUSH : TCIOFLUSH);
+		return;
+	}
+	char rbuf[1024];
+	while (recv (fd, rbuf, sizeof (rbuf), MSG_DONTWAIT) > 0)
+		;
+}
+
+void ConnAsync::updateTimer ()
+{
+	if (inFlight.empty ())
+		return;
+	double deadline = NAN;
+	for (std::deque <AsyncRequest *>::iterator iter = inFlight.begin (); iter != inFlight.end (); iter++)
+	{
+		double d = (*iter)->sent + (*iter)->timeout;
+		if (std::isnan (deadline) || d < deadline)
+			deadline = d;
+	}
+	if (!std::isnan (timerAt) && timerAt <= deadline)
+		return;
+	if (!std::isnan (timerAt))
+		getMaster ()->deleteTimers (EVENT_ASYNC_TIMEOUT, this);
+	timerAt = deadline;
+	// make sure the request is timed out when timer fires
+	getMaster ()->addTimer (deadline - getNow () + 0.001, new Event (EVENT_ASYNC_TIMEOUT, this));
+}
+
+void ConnAsync::finish (AsyncRequest *req, const char *reply, size_t len)
+{
+	req->duration = getNow () - req->sent;
+	try
+	{
+		req->replied (reply, len);
+	}
+	catch (Error &er)
+	{
+		logStream (MESSAGE_ERROR) << "while processing reply to " << req->cmd << ": " << er << sendLog;
+	}
+	delete req;
+}
+
+void ConnAsync::fail (AsyncRequest *req, int err)
+{
+	req->failed (err);
+	delete req;
+}
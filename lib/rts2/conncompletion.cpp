@@ -0,0 +1,154 @@
+/*
+ * Connection delivering finished pool tasks to the block event loop.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "conncompletion.h"
+#include "block.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef RTS2_HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+
+using namespace rts2core;
+
+ConnCompletion::ConnCompletion (Block *_master, size_t _queueSize):ConnNoSend (_master), done (_queueSize)
+{
+	wakeFd = -1;
+	pthread_mutex_init (&overflowMutex, NULL);
+}
+
+ConnCompletion::~ConnCompletion ()
+{
+	PoolTask *task;
+	while (done.pop (task))
+		delete task;
+	for (std::deque <PoolTask *>::iterator iter = overflow.begin (); iter != overflow.end (); iter++)
+		delete *iter;
+
+#ifndef RTS2_HAVE_SYS_EVENTFD_H
+	if (wakeFd >= 0)
+		close (wakeFd);
+#endif
+	pthread_mutex_destroy (&overflowMutex);
+}
+
+int ConnCompletion::init ()
+{
+#ifdef RTS2_HAVE_SYS_EVENTFD_H
+	sock = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (sock < 0)
+	{
+		logStream (MESSAGE_ERROR) << "cannot create eventfd: " << strerror (errno) << sendLog;
+		return -1;
+	}
+	wakeFd = sock;
+#else
+	int fds[2];
+	if (pipe (fds))
+	{
+		logStream (MESSAGE_ERROR) << "cannot create completion pipe: " << strerror (errno) << sendLog;
+		return -1;
+	}
+	fcntl (fds[0], F_SETFL, O_NONBLOCK);
+	fcntl (fds[1], F_SETFL, O_NONBLOCK);
+	sock = fds[0];
+	wakeFd = fds[1];
+#endif
+	return 0;
+}
+
+void ConnCompletion::post (PoolTask *task)
+{
+	if (!done.push (task))
+	{
+		pthread_mutex_lock (&overflowMutex);
+		overflow.push_back (task);
+		pthread_mutex_unlock (&overflowMutex);
+	}
+	wakeup ();
+}
+
+int ConnCompletion::receive (Block *block)
+{
+	if (sock >= 0 && block->isForRead (sock))
+	{
+		// clear wakeup before processing, so tasks posted during processing wake the loop again
+#ifdef RTS2_HAVE_SYS_EVENTFD_H
+		uint64_t cnt;
+		if (read (sock, &cnt, sizeof (cnt)) < 0 && errno != EAGAIN)
+			logStream (MESSAGE_ERROR) << "cannot read eventfd: " << strerror (errno) << sendLog;
+#else
+		char rbuf[100];
+		while (read (sock, rbuf, sizeof (rbuf)) > 0)
+			;
+#endif
+		processCompleted ();
+		return 1;
+	}
+	return 0;
+}
+
+int ConnCompletion::processCompleted ()
+{
+	int ret = 0;
+	PoolTask *task;
+	while (true)
+	{
+		if (!done.pop (task))
+		{
+			pthread_mutex_lock (&overflowMutex);
+			if (overflow.empty ())
+			{
+				pthread_mutex_unlock (&overflowMutex);
+				break;
+			}
+			task = overflow.front ();
+			overflow.pop_front ();
+			pthread_mutex_unlock (&overflowMutex);
+		}
+		try
+		{
+			task->completed ();
+		}
+		catch (Error &er)
+		{
+			logStream (MESSAGE_ERROR) << "while completing task: " << er << sendLog;
+		}
+		delete task;
+		ret++;
+	}
+	return ret;
+}
+
+void ConnCompletion::wakeup ()
+{
+#ifdef RTS2_HAVE_SYS_EVENTFD_H
+	uint64_t one = 1;
+	if (write (wakeFd, &one, sizeof (one)) < 0 && errno != EAGAIN)
+#else
+	char c = 0;
+	// full pipe already wakes the loop
+	if (write (wakeFd, &c, 1) < 0 && errno != EAGAIN)
+#endif
+		logStream (MESSAGE_ERROR) << "cannot wake up event loop: " << strerror (errno) << sendLog;
+}
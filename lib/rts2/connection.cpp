@@ -39,6 +39,7 @@
 #include <sys/shm.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 
@@ -86,6 +87,7 @@ Connection::Connection (Block * in_master):Object ()
 
 	commandInProgress = false;
 	info_time = NULL;
+	valuesGeneration = 0;
 	last_info_time = 0;
 
 	time (&lastGoodSend);
@@ -95,6 +97,11 @@ Connection::Connection (Block * in_master):Object ()
 	activeReadData = -1;
 	dataConn = 0;
 
+	binaryValues = false;
+	valueBatch = 0;
+	binaryFrameFill = -1;
+	binaryParams = NULL;
+
 	sharedReadMemory = NULL;
 }
 
@@ -129,6 +136,7 @@ Connection::Connection (int in_sock, Block * in_master):Object ()
 
 	commandInProgress = false;
 	info_time = NULL;
+	valuesGeneration = 0;
 
 	time (&lastGoodSend);
 	lastData = lastGoodSend;
@@ -137,6 +145,11 @@ Connection::Connection (int in_sock, Block * in_master):Object ()
 	activeReadData = -1;
 	dataConn = 0;
 
+	binaryValues = false;
+	valueBatch = 0;
+	binaryFrameFill = -1;
+	binaryParams = NULL;
+
 	sharedReadMemory = NULL;
 }
 
@@ -822,6 +835,30 @@ void Connection::processLine ()
 			ret = -1;
 		}
 	}
+	else if (isCommand (PROTO_BINARY_VALUES))
+	{
+		long int frameSize;
+		if (paramNextLong (&frameSize) || frameSize < 0 || !paramEnd ())
+		{
+			connectionError (-2);
+			ret = -2;
+		}
+		else if (frameSize > BINV_MAX_FRAME)
+		{
+			logStream (MESSAGE_ERROR) << "binary value frame of " << frameSize << " bytes is larger than allowed " << BINV_MAX_FRAME << " bytes, closing connection" << sendLog;
+			connectionError (-2);
+			ret = -2;
+		}
+		else
+		{
+			// frame is read in processBuffer and receive
+			binaryFrame.resize (frameSize);
+			binaryFrameFill = 0;
+			if (frameSize == 0)
+				binaryFrameFill = -1;
+			ret = -1;
+		}
+	}
 	else if (isCommand (PROTO_BINARY_KILLED))
 	{
 		int dC;
@@ -1009,6 +1046,13 @@ void Connection::processBuffer ()
 				memmove (buf_top, buf_top + readSize, (full_data_end - buf_top) - readSize + 1);
 				full_data_end -= readSize;
 			}
+			// binary value frame
+			if (binaryFrameFill >= 0)
+			{
+				size_t readSize = addBinaryFrame (buf_top, full_data_end - buf_top);
+				memmove (buf_top, buf_top + readSize, (full_data_end - buf_top) - readSize + 1);
+				full_data_end -= readSize;
+			}
 			command_start = buf_top;
 		}
 	}
@@ -1046,6 +1090,21 @@ int Connection::receive (Block *block)
 			dataReceived ();
 			return data_size;
 		}
+		// we are receiving binary value frame
+		if (binaryFrameFill >= 0)
+		{
+			data_size = read (sock, &(binaryFrame[binaryFrameFill]), binaryFrame.size () - binaryFrameFill);
+			if (data_size == -1 && errno == EINTR)
+				return 0;
+			if (data_size <= 0)
+			{
+				connectionError (data_size);
+				return -1;
+			}
+			successfullRead ();
+			addBinaryFrame (NULL, data_size);
+			return data_size;
+		}
 		checkBufferSize ();
 		data_size = read (sock, buf_top, buf_size - (buf_top - buf));
 		// ignore EINTR
@@ -1296,6 +1355,14 @@ int Connection::command ()
 			return -2;
 		return master->statusInfo (this);
 	}
+	else if (isCommand (COMMAND_BINARY_VALUES))
+	{
+		int enable;
+		if (paramNextInteger (&enable) || !paramEnd ())
+			return -2;
+		setBinaryValues (enable);
+		return 0;
+	}
 	else if (isCommand (PROTO_PROGRESS))
 	{
 		if (paramNextDouble (&statusStart)
@@ -1789,6 +1856,84 @@ int Connection::sendValueTime (std::string val_name, time_t * value)
 	return sendMsg (_os);
 }
 
+int Connection::sendBinaryValue (Value *value)
+{
+	// keep frames below BINV_MAX_FRAME - neither collected records nor the new record can exceed half of it
+	if (binaryWriter.size () >= BINV_MAX_FRAME / 2 && sendBinaryFrame ())
+		return -1;
+	size_t start = binaryWriter.size ();
+	binaryWriter.startValue (value->getName ().c_str ());
+	value->writeBinary (binaryWriter);
+	binaryWriter.endValue ();
+	if (binaryWriter.size () - start > BINV_MAX_FRAME / 2)
+	{
+		binaryWriter.truncate (start);
+		if (!binaryWriter.empty () && sendBinaryFrame ())
+			return -1;
+		return sendValueRaw (value->getName (), value->getValue ());
+	}
+	if (valueBatch > 0)
+		return 0;
+	return sendBinaryFrame ();
+}
+
+int Connection::endValueBatch ()
+{
+	if (valueBatch > 0)
+		valueBatch--;
+	if (valueBatch > 0 || binaryWriter.empty ())
+		return 0;
+	return sendBinaryFrame ();
+}
+
+int Connection::sendBinaryFrame ()
+{
+	if (sock == -1)
+	{
+		binaryWriter.clear ();
+		return -1;
+	}
+	char header[50];
+	snprintf (header, sizeof (header), PROTO_BINARY_VALUES " %lu\n", (unsigned long) binaryWriter.size ());
+
+	// header and frame are written together
+	struct iovec iov[2];
+	iov[0].iov_base = header;
+	iov[0].iov_len = strlen (header);
+	iov[1].iov_base = (void *) binaryWriter.getData ();
+	iov[1].iov_len = binaryWriter.size ();
+
+	int iovcnt = 2;
+	struct iovec *top = iov;
+	while (iovcnt > 0)
+	{
+		ssize_t ret = writev (sock, top, iovcnt);
+		if (ret == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			logStream (MESSAGE_ERROR) << "cannot send binary values to " << getName () << ": " << strerror (errno) << sendLog;
+			binaryWriter.clear ();
+			connectionError (-1);
+			return -1;
+		}
+		while (iovcnt > 0 && (size_t) ret >= top->iov_len)
+		{
+			ret -= top->iov_len;
+			top++;
+			iovcnt--;
+		}
+		if (iovcnt > 0)
+		{
+			top->iov_base = (char *) top->iov_base + ret;
+			top->iov_len -= ret;
+		}
+	}
+	binaryWriter.clear ();
+	successfullSend ();
+	return 0;
+}
+
 int Connection::sendProgress (double start, double end)
 {
 	std::ostringstream _os;
@@ -1840,6 +1985,8 @@ int Connection::isConnState (conn_state_t in_conn_state)
 
 bool Connection::paramEnd ()
 {
+	if (binaryParams)
+		return binaryParams->paramEnd ();
 	while (isspace (*command_buf_top))
 		command_buf_top++;
 	return !*command_buf_top;
@@ -1847,6 +1994,8 @@ bool Connection::paramEnd ()
 
 int Connection::paramNextString (char **str, const char *enddelim)
 {
+	if (binaryParams)
+		return binaryParams->paramString (str);
 	while (isspace (*command_buf_top))
 		command_buf_top++;
 	if (!*command_buf_top)
@@ -1894,6 +2043,8 @@ int Connection::paramNextStringNull (char **str)
 
 int Connection::paramNextInteger (int *num)
 {
+	if (binaryParams)
+		return binaryParams->paramInteger (num);
 	char *str_num;
 	char *num_end;
 	if (paramNextString (&str_num, ","))
@@ -1906,6 +2057,14 @@ int Connection::paramNextInteger (int *num)
 
 int Connection::paramNextLong (long int *num)
 {
+	if (binaryParams)
+	{
+		long long int l;
+		if (binaryParams->paramLongLong (&l))
+			return -1;
+		*num = l;
+		return 0;
+	}
 	char *str_num;
 	char *num_end;
 	if (paramNextString (&str_num, ","))
@@ -1918,6 +2077,8 @@ int Connection::paramNextLong (long int *num)
 
 int Connection::paramNextLongLong (long long int *num)
 {
+	if (binaryParams)
+		return binaryParams->paramLongLong (num);
 	char *str_num;
 	char *num_end;
 	if (paramNextString (&str_num, ","))
@@ -1954,6 +2115,8 @@ int Connection::paramNextSSizeT (ssize_t * num)
 
 int Connection::paramNextDouble (double *num)
 {
+	if (binaryParams)
+		return binaryParams->paramDouble (num);
 	char *str_num;
 	int ret;
 	if (paramNextString (&str_num, ","))
@@ -1971,6 +2134,8 @@ int Connection::paramNextDouble (double *num)
 
 int Connection::paramNextDoubleTime (double *num)
 {
+	if (binaryParams)
+		return binaryParams->paramDouble (num);
 	char *str_num;
 	if (paramNextString (&str_num, ","))
 		return -1;
@@ -2043,6 +2208,14 @@ int Connection::paramNextDoubleTime (double *num)
 
 int Connection::paramNextFloat (float *num)
 {
+	if (binaryParams)
+	{
+		double d;
+		if (binaryParams->paramDouble (&d))
+			return -1;
+		*num = d;
+		return 0;
+	}
 	char *str_num;
 	int ret;
 	if (paramNextString (&str_num, ","))
@@ -2055,6 +2228,8 @@ int Connection::paramNextFloat (float *num)
 
 int Connection::paramNextHMS (double *num)
 {
+	if (binaryParams)
+		return binaryParams->paramDouble (num);
 	char *str_num;
 	if (paramNextString (&str_num))
 		return -1;
@@ -2070,6 +2245,8 @@ int Connection::paramNextHMS (double *num)
 
 int Connection::paramNextDMS (double *num)
 {
+	if (binaryParams)
+		return binaryParams->paramDouble (num);
 	char *str_num;
 	if (paramNextString (&str_num))
 		return -1;
@@ -2091,6 +2268,49 @@ int Connection::paramNextTimeval (struct timeval *tv)
 	return 0;
 }
 
+size_t Connection::addBinaryFrame (char *data, size_t size)
+{
+	size_t s = std::min (size, binaryFrame.size () - binaryFrameFill);
+	// data read directly to the frame are passed as NULL
+	if (data)
+		memcpy (&(binaryFrame[binaryFrameFill]), data, s);
+	binaryFrameFill += s;
+	if ((size_t) binaryFrameFill == binaryFrame.size ())
+		processBinaryFrame ();
+	return s;
+}
+
+void Connection::processBinaryFrame ()
+{
+	binaryFrameFill = -1;
+
+	BinaryValueReader reader (&(binaryFrame[0]), binaryFrame.size ());
+	int ret;
+	while ((ret = reader.nextValue ()) == 1)
+	{
+		char *text = reader.getText ();
+		if (text)
+		{
+			// parse as text value
+			char *old_top = command_buf_top;
+			command_buf_top = text;
+			commandValue (reader.getName ());
+			command_buf_top = old_top;
+		}
+		else
+		{
+			binaryParams = &reader;
+			commandValue (reader.getName ());
+			binaryParams = NULL;
+		}
+	}
+	if (ret < 0)
+	{
+		logStream (MESSAGE_ERROR) << "invalid binary value frame from " << getName () << sendLog;
+		connectionError (-2);
+	}
+}
+
 void Connection::newDataConn (int data_conn)
 {
 	if (otherDevice)
@@ -2147,6 +2367,7 @@ void Connection::addValue (Value * value, const ValueVector::iterator eiter)
 	if (value->isValue (RTS2_VALUE_INFOTIME))
 		info_time = (ValueTime *) value;
 	values.insert (eiter, value);
+	valuesGeneration++;
 }
 
 int Connection::metaInfo (int rts2Type, std::string m_name, std::string desc)
@@ -2160,6 +2381,8 @@ int Connection::metaInfo (int rts2Type, std::string m_name, std::string desc)
 		{
 			existing_value->setFlags (rts2Type);
 			existing_value->setDescription (desc);
+			// flags decide if value is displayed
+			valuesGeneration++;
 			return -1;
 		}
 		eiter = values.removeValue (m_name.c_str ());
@@ -31,6 +31,9 @@
 #include <sys/wait.h>
 
 #include "daemon.h"
+#include "conncompletion.h"
+#include "threadpool.h"
+#include "utilsfunc.h"
 
 #ifndef LOCK_SH
 #define   LOCK_SH   1    /* shared lock */
@@ -52,6 +55,40 @@
 
 using namespace rts2core;
 
+namespace rts2core
+{
+
+/**
+ * Writes autosave file content from the autosave thread.
+ */
+class AutosaveTask:public PoolTask
+{
+	public:
+		AutosaveTask (Daemon *_master, const std::string &_content, int _changes):PoolTask (), content (_content)
+		{
+			master = _master;
+			changes = _changes;
+		}
+
+		virtual void run ()
+		{
+			if (replaceFile (master->autosaveFile, content))
+				throw Error (std::string ("cannot write autosave file ") + master->autosaveFile + ": " + strerror (errno));
+		}
+
+		virtual void completed ()
+		{
+			master->autosaveCompleted (this);
+		}
+
+		Daemon *master;
+		std::string content;
+		// number of value changes written by the task
+		int changes;
+};
+
+}
+
 void Daemon::addConnectionSock (int in_sock)
 {
 	Connection *conn = createConnection (in_sock);
@@ -85,6 +122,22 @@ Daemon::Daemon (int _argc, char **_argv, int _init_state):rts2core::Block (_argc
 	optAutosaveFile = NULL;
 	optDefaultsFile = NULL;
 
+	autosaveWindow = 1;
+	autosaveScheduled = false;
+	autosaveChanges = 0;
+
+	autosavePool = NULL;
+	autosaveCompletion = NULL;
+	autosaveRunning = NULL;
+	autosaveQueued = NULL;
+
+	autosavePending = NULL;
+	autosaveWritten = NULL;
+	autosaveFailed = NULL;
+
+	inRunLoop = false;
+	exitRequested = false;
+
 	state = _init_state;
 
 	state_start = state_expected_end = NAN;
@@ -105,11 +158,13 @@ Daemon::Daemon (int _argc, char **_argv, int _init_state):rts2core::Block (_argc
 	addOption (OPT_VALUEFILE, "valuefile", 1, "file with values which should be created on the device");
 	addOption (OPT_MODEFILE, "modefile", 1, "file holding device modes");
 	addOption (OPT_AUTOSAVE, "autosave", 1, "autosave file");
+	addOption (OPT_AUTOSAVE_WINDOW, "autosave-window", 1, "[s] autosave values changed during this interval together (default to 1 second, 0 to save every change)");
 	addOption (OPT_DEFAULTS, "defaults", 1, "file with default values");
 }
 
 Daemon::~Daemon (void)
 {
+	flushAutosave ();
 	if (listen_sock >= 0)
 		close (listen_sock);
 	if (lock_file > 0)
@@ -145,6 +200,9 @@ int Daemon::processOption (int in_opt)
 		case OPT_AUTOSAVE:
 			optAutosaveFile = optarg;
 			break;
+		case OPT_AUTOSAVE_WINDOW:
+			autosaveWindow = atof (optarg);
+			break;
 		case OPT_DEFAULTS:
 			optDefaultsFile = optarg;
 			break;
@@ -403,6 +461,12 @@ int Daemon::initValues ()
 	ret = loadValuesFile (optAutosaveFile);
 	if (ret)
 		return ret;
+	if (optAutosaveFile)
+	{
+		createValue (autosavePending, "autosave_pending", "number of autosave value changes not yet written to the autosave file", false);
+		createValue (autosaveWritten, "autosave_written", "number of autosave file writes", false);
+		createValue (autosaveFailed, "autosave_failed", "number of failed autosave file writes", false);
+	}
 	autosaveFile = optAutosaveFile;
 	return 0;
 }
@@ -479,8 +543,15 @@ int Daemon::run ()
 	beforeRun ();
 	if (setupAutoRestart () != -1)
 		return 0;
+	startAutosave ();
+	inRunLoop = true;
 	while (!getEndLoop ())
 		oneRunLoop ();
+	inRunLoop = false;
+	// endRunLoop, which can be called from signal handler, only ended the loop
+	flushAutosave ();
+	if (exitRequested)
+		exit (0);
 	return 0;
 }
 
@@ -494,6 +565,12 @@ void Daemon::endRunLoop ()
 		autorestart = -1;
 	}
 	Block::endRunLoop ();
+	// run loop exits after the current iteration and writes pending autosave values
+	if (inRunLoop)
+	{
+		exitRequested = true;
+		return;
+	}
 	exit (0);
 }
 
@@ -542,6 +619,10 @@ void Daemon::postEvent (Event *event)
 				return;
 			}
 			break;
+		case EVENT_AUTOSAVE:
+			autosaveScheduled = false;
+			autosaveValues ();
+			break;
 	}
 	rts2core::Block::postEvent (event);
 }
@@ -937,8 +1018,21 @@ err:
 
 void Daemon::valueChanged (Value *changed_value)
 {
-	if (changed_value->isAutosave ())
-		autosaveValues ();
+	if (changed_value->isAutosave () && autosaveFile)
+	{
+		autosaveChanges++;
+		autosavePending->inc ();
+		sendValueAll (autosavePending);
+		if (autosaveWindow <= 0)
+		{
+			autosaveValues ();
+		}
+		else if (!autosaveScheduled)
+		{
+			addTimer (autosaveWindow, new Event (EVENT_AUTOSAVE, this));
+			autosaveScheduled = true;
+		}
+	}
 }
 
 int Daemon::baseInfo ()
@@ -960,12 +1054,14 @@ int Daemon::baseInfo (Connection * conn)
 
 int Daemon::sendBaseInfo (Connection * conn)
 {
+	conn->startValueBatch ();
 	for (ValueVector::iterator iter = constValues.begin ();
 		iter != constValues.end (); iter++)
 	{
 		Value *val = *iter;
 		val->send (conn);
 	}
+	conn->endValueBatch ();
 	return 0;
 }
 
@@ -1039,6 +1135,8 @@ int Daemon::sendInfo (Connection * conn, bool forceSend)
 {
 	if (!isRunning (conn))
 		return -1;
+	// values changed together are sent in single binary frame
+	conn->startValueBatch ();
 	for (CondValueVector::iterator iter = values.begin (); iter != values.end (); iter++)
 	{
 		Value *val = (*iter)->getValue ();
@@ -1051,6 +1149,7 @@ int Daemon::sendInfo (Connection * conn, bool forceSend)
 		info_time->send (conn);
 	if (uptime->needSend ())
 		uptime->send (conn);
+	conn->endValueBatch ();
 	return 0;
 }
 
@@ -1503,7 +1602,13 @@ int Daemon::autosaveValues ()
 	if (autosaveFile == NULL)
 		return -2;
 
-	std::ofstream of (autosaveFile, std::ios_base::out | std::ios_base::trunc);
+	if (autosaveScheduled)
+	{
+		deleteTimers (EVENT_AUTOSAVE);
+		autosaveScheduled = false;
+	}
+
+	std::ostringstream of;
 	of << "; THIS FILE WAS AUTOGENERATED! All changes will be probably overwritten." << std::endl
 		<< "; Generated on " << Timestamp () << "." << std::endl
 		<< std::endl;
@@ -1516,11 +1621,149 @@ int Daemon::autosaveValues ()
 		}
 	}
 
-	of.close ();
+	AutosaveTask *task = new AutosaveTask (this, of.str (), autosaveChanges);
+	autosaveChanges = 0;
+
+	if (autosavePool == NULL)
+	{
+		// autosave thread is not running, write from the main loop
+		int ret = 0;
+		try
+		{
+			task->run ();
+		}
+		catch (Error &er)
+		{
+			logStream (MESSAGE_ERROR) << er << sendLog;
+			ret = -1;
+		}
+		autosaveDone (task->changes, ret != 0);
+		delete task;
+		return ret;
+	}
 
+	if (autosaveRunning == NULL)
+	{
+		autosaveRunning = task;
+		autosavePool->submit (task, autosaveCompletion);
+	}
+	else
+	{
+		// only the latest content is written after the running write
+		if (autosaveQueued)
+		{
+			task->changes += autosaveQueued->changes;
+			delete autosaveQueued;
+		}
+		autosaveQueued = task;
+	}
 	return 0;
 }
 
+int Daemon::writeAutosave ()
+{
+	if (autosaveFile == NULL)
+		return -2;
+	bool restart = autosavePool != NULL;
+	stopAutosave ();
+	int ret = autosaveValues ();
+	if (restart)
+		startAutosave ();
+	return ret;
+}
+
+void Daemon::startAutosave ()
+{
+	if (autosaveFile == NULL || autosavePool)
+		return;
+	// completion connection is kept when the thread is restarted
+	bool newCompletion = (autosaveCompletion == NULL);
+	if (newCompletion)
+		autosaveCompletion = new ConnCompletion (this);
+	autosavePool = new ThreadPool (1);
+	if (autosavePool->start () || (newCompletion && autosaveCompletion->init ()))
+	{
+		logStream (MESSAGE_WARNING) << "cannot start autosave thread, autosave file will be written from the main loop" << sendLog;
+		delete autosavePool;
+		autosavePool = NULL;
+		if (newCompletion)
+		{
+			delete autosaveCompletion;
+			autosaveCompletion = NULL;
+		}
+		return;
+	}
+	if (newCompletion)
+		addConnection (autosaveCompletion);
+}
+
+void Daemon::stopAutosave ()
+{
+	if (autosavePool == NULL)
+		return;
+	// queued content is replaced by the current values
+	if (autosaveQueued)
+	{
+		autosaveChanges += autosaveQueued->changes;
+		delete autosaveQueued;
+		autosaveQueued = NULL;
+	}
+	// waits for the running write
+	delete autosavePool;
+	autosavePool = NULL;
+	autosaveCompletion->processCompleted ();
+}
+
+void Daemon::flushAutosave ()
+{
+	stopAutosave ();
+	if (autosaveChanges > 0)
+		autosaveValues ();
+}
+
+void Daemon::autosaveCompleted (AutosaveTask *task)
+{
+	if (task->isFailed ())
+		logStream (MESSAGE_ERROR) << task->getError () << sendLog;
+	autosaveRunning = NULL;
+	autosaveDone (task->changes, task->isFailed ());
+	if (autosaveQueued && autosavePool)
+	{
+		autosaveRunning = autosaveQueued;
+		autosaveQueued = NULL;
+		autosavePool->submit (autosaveRunning, autosaveCompletion);
+	}
+}
+
+void Daemon::autosaveDone (int changes, bool failed)
+{
+	if (failed)
+	{
+		autosaveFailed->inc ();
+		sendValueAll (autosaveFailed);
+		// changes will be written with the next content
+		if (autosaveQueued)
+		{
+			autosaveQueued->changes += changes;
+		}
+		else
+		{
+			autosaveChanges += changes;
+			// retry even if no other value changes
+			if (!autosaveScheduled)
+			{
+				addTimer (autosaveWindow > 0 ? autosaveWindow : 1, new Event (EVENT_AUTOSAVE, this));
+				autosaveScheduled = true;
+			}
+		}
+		return;
+	}
+	autosaveWritten->inc ();
+	autosavePending->setValueInteger (autosavePending->getValueInteger () - changes);
+	sendValueAll (autosaveWritten);
+	sendValueAll (autosavePending);
+}
+
 void Daemon::switchUser (const char *usrgrp)
 {
 	char *user = (char *) usrgrp;
@@ -17,6 +17,7 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include "bufferpool.h"
 #include "connection.h"
 #include "data.h"
 
@@ -28,6 +29,22 @@
 
 using namespace rts2core;
 
+DataRead::DataRead (size_t in_binaryReadDataSize, int in_type)
+{
+	binaryReadDataSize = in_binaryReadDataSize;
+	binaryReadBuff = (char *) BufferPool::instance ().allocate (binaryReadDataSize);
+	if (binaryReadBuff == NULL)
+		throw Error ("cannot allocate data buffer");
+	binaryReadTop = binaryReadBuff;
+	binaryReadType = in_type;
+	binaryReadChunkSize = -1;
+}
+
+DataRead::~DataRead (void)
+{
+	BufferPool::instance ().release (binaryReadBuff);
+}
+
 int DataRead::readDataSize (Connection *conn)
 {
 	return conn->paramNextSSizeT (&binaryReadChunkSize);
@@ -187,6 +187,8 @@ void DevConnection::connConnected ()
 		{
 			(*iter)-> queCommand (new CommandKey (getMaster (), getName ()));
 			setConnState (CONN_AUTH_PENDING);
+			if (master->getBinaryValues ())
+				queCommand (new CommandBinaryValues (master));
 			return;
 		}
 	}
@@ -573,7 +575,7 @@ int Device::commandAuthorized (Connection * conn)
 	}
 	else if (conn->isCommand ("autosave"))
 	{
-		return autosaveValues ();
+		return writeAutosave ();
 	}
 	// we need to try that - due to other device commands
 	return -5;
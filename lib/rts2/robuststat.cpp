@@ -0,0 +1,377 @@
+/*
+ * Robust image statistics - median, MAD and sigma clipping.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "robuststat.h"
+#include "error.h"
+#include "imghdr.h"
+#include "threadpool.h"
+
+#include <pthread.h>
+
+using namespace rts2core;
+
+namespace rts2core
+{
+
+/**
+ * Runs parts of the job, taking their indices from counter shared with other parts.
+ */
+class StatPartTask:public PoolTask
+{
+	public:
+		StatPartTask (StatJob *_job, size_t _count, size_t *_next):PoolTask () { job = _job; count = _count; next = _next; }
+
+		virtual void run ()
+		{
+			size_t i;
+			while ((i = __atomic_fetch_add (next, 1, __ATOMIC_RELAXED)) < count)
+				job->run (i);
+		}
+
+	private:
+		StatJob *job;
+		size_t count;
+		size_t *next;
+};
+
+// pool shared by all statistics calls, created on the first parallel call
+static ThreadPool *statPool = NULL;
+static pthread_once_t statPoolOnce = PTHREAD_ONCE_INIT;
+
+static void createStatPool ()
+{
+	ThreadPool *pool = new ThreadPool ();
+	if (pool->start ())
+	{
+		delete pool;
+		return;
+	}
+	statPool = pool;
+}
+
+/**
+ * Cumulative counts of histogram window, used to find ranks of values and deviations.
+ */
+class CumulativeCounts
+{
+	public:
+		CumulativeCounts (const std::vector <uint32_t> &counts):cum (counts.size () + 1), cumSum (counts.size () + 1)
+		{
+			cum[0] = 0;
+			cumSum[0] = 0;
+			for (size_t i = 0; i < counts.size (); i++)
+			{
+				cum[i + 1] = cum[i] + counts[i];
+				cumSum[i + 1] = cumSum[i] + (uint64_t) i * counts[i];
+			}
+		}
+
+		// number of values with index in [a, b], clamped to [lo, hi]
+		uint64_t count (long long a, long long b) const
+		{
+			if (a < lo)
+				a = lo;
+			if (b > hi)
+				b = hi;
+			if (a > b)
+				return 0;
+			return cum[b + 1] - cum[a];
+		}
+
+		// sum of value indices in window
+		uint64_t sum () const { return cumSum[hi + 1] - cumSum[lo]; }
+
+		// index of k-th smallest value in window
+		long long rank (uint64_t k) const
+		{
+			return std::upper_bound (cum.begin () + lo + 1, cum.begin () + hi + 2, cum[lo] + k) - cum.begin () - 1;
+		}
+
+		// twice of k-th smallest absolute deviation from median, median2 is twice the median index
+		long long deviationRank (uint64_t k, long long median2) const
+		{
+			// deviations have the same parity as median2
+			long long p = median2 & 1;
+			long long j_lo = 0;
+			long long j_hi = hi - lo + 1;
+			while (j_lo < j_hi)
+			{
+				long long j = (j_lo + j_hi) / 2;
+				long long d2 = p + 2 * j;
+				if (count ((median2 - d2) / 2, (median2 + d2) / 2) >= k + 1)
+					j_hi = j;
+				else
+					j_lo = j + 1;
+			}
+			return p + 2 * j_lo;
+		}
+
+		long long lo;
+		long long hi;
+
+	private:
+		std::vector <uint64_t> cum;
+		std::vector <uint64_t> cumSum;
+};
+
+template <typename t> class RegionJob:public StatJob
+{
+	public:
+		RegionJob (const t *_data, size_t _width, std::vector <StatRegion> &_regions, double _kappa, int _maxIter):regions (_regions)
+		{
+			data = _data;
+			width = _width;
+			kappa = _kappa;
+			maxIter = _maxIter;
+		}
+
+		virtual void run (size_t i)
+		{
+			StatRegion &r = regions[i];
+			robustStatistics (data + r.y * width + r.x, r.w, r.h, width, r.stat, kappa, maxIter);
+		}
+
+	private:
+		const t *data;
+		size_t width;
+		std::vector <StatRegion> &regions;
+		double kappa;
+		int maxIter;
+};
+
+template <typename t> void regionStatistics (const t *data, size_t width, std::vector <StatRegion> &regions, double kappa, int maxIter, int threads)
+{
+	RegionJob <t> job (data, width, regions, kappa, maxIter);
+	runParallel (&job, regions.size (), threads);
+}
+
+}
+
+Histogram::Histogram ()
+{
+	minValue = 0;
+	maxValue = -1;
+	total = 0;
+}
+
+void Histogram::reset (long long _minValue, long long _maxValue)
+{
+	minValue = _minValue;
+	maxValue = _maxValue;
+	counts.assign (maxValue - minValue + 1, 0);
+	total = 0;
+}
+
+void Histogram::clear ()
+{
+	std::fill (counts.begin (), counts.end (), 0);
+	total = 0;
+}
+
+void Histogram::merge (const Histogram &other)
+{
+	for (size_t i = 0; i < counts.size (); i++)
+		counts[i] += other.counts[i];
+	total += other.total;
+}
+
+long long Histogram::getMode () const
+{
+	if (counts.empty ())
+		return 0;
+	return minValue + (std::max_element (counts.begin (), counts.end ()) - counts.begin ());
+}
+
+void Histogram::getStat (RobustStat &ret, double kappa, int maxIter) const
+{
+	ret.clear ();
+	if (total == 0)
+		return;
+
+	CumulativeCounts cc (counts);
+
+	long long imin = 0;
+	while (counts[imin] == 0)
+		imin++;
+	long long imax = counts.size () - 1;
+	while (counts[imax] == 0)
+		imax--;
+
+	ret.min = minValue + imin;
+	ret.max = minValue + imax;
+
+	cc.lo = imin;
+	cc.hi = imax;
+
+	while (true)
+	{
+		uint64_t n = cc.count (cc.lo, cc.hi);
+		if (n == 0)
+			return;
+		ret.n = n;
+		ret.mean = minValue + (double) cc.sum () / n;
+
+		uint64_t k1 = (n - 1) / 2;
+		uint64_t k2 = n / 2;
+		long long median2 = cc.rank (k1) + cc.rank (k2);
+		ret.median = minValue + median2 / 2.0;
+		ret.mad = (cc.deviationRank (k1, median2) + cc.deviationRank (k2, median2)) / 4.0;
+		ret.sigma = ret.mad * MAD_TO_SIGMA;
+
+		if (kappa <= 0 || ret.iterations >= maxIter || ret.sigma == 0)
+			return;
+
+		long long nlo = std::max (cc.lo, (long long) ceil (median2 / 2.0 - kappa * ret.sigma));
+		long long nhi = std::min (cc.hi, (long long) floor (median2 / 2.0 + kappa * ret.sigma));
+		if ((nlo == cc.lo && nhi == cc.hi) || nlo > nhi)
+			return;
+		cc.lo = nlo;
+		cc.hi = nhi;
+		ret.iterations++;
+	}
+}
+
+double rts2core::bufferMedian (std::vector <double> &buf)
+{
+	if (buf.empty ())
+		return NAN;
+	size_t k1 = (buf.size () - 1) / 2;
+	std::vector <double>::iterator m1 = buf.begin () + k1;
+	std::nth_element (buf.begin (), m1, buf.end ());
+	if (buf.size () % 2)
+		return *m1;
+	return (*m1 + *std::min_element (m1 + 1, buf.end ())) / 2.0;
+}
+
+void rts2core::runParallel (StatJob *job, size_t count, int threads)
+{
+	if (threads > 1 && count > 1)
+		pthread_once (&statPoolOnce, createStatPool);
+
+	// run in the calling thread if pool cannot be started
+	if (threads <= 1 || count <= 1 || statPool == NULL)
+	{
+		for (size_t i = 0; i < count; i++)
+			job->run (i);
+		return;
+	}
+
+	size_t next = 0;
+	std::vector <StatPartTask *> parts;
+	for (int i = 0; i < threads && (size_t) i < count; i++)
+	{
+		StatPartTask *part = new StatPartTask (job, count, &next);
+		if (statPool->submit (part))
+		{
+			delete part;
+			break;
+		}
+		parts.push_back (part);
+	}
+
+	// submitted parts run all indices; if none was submitted, run them in the calling thread
+	if (parts.empty ())
+	{
+		StatPartTask all (job, count, &next);
+		all.run ();
+	}
+
+	std::string error;
+	for (std::vector <StatPartTask *>::iterator iter = parts.begin (); iter != parts.end (); iter++)
+	{
+		statPool->wait (*iter);
+		if ((*iter)->isFailed ())
+			error = (*iter)->getError ();
+		delete *iter;
+	}
+	if (!error.empty ())
+		throw Error (error);
+}
+
+void rts2core::robustStatistics (const void *data, int16_t dataType, size_t w, size_t h, size_t stride, RobustStat &ret, double kappa, int maxIter, int threads)
+{
+	switch (dataType)
+	{
+		case RTS2_DATA_BYTE:
+			robustStatistics ((const uint8_t *) data, w, h, stride, ret, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_SHORT:
+			robustStatistics ((const int16_t *) data, w, h, stride, ret, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_LONG:
+			robustStatistics ((const int32_t *) data, w, h, stride, ret, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_LONGLONG:
+			robustStatistics ((const int64_t *) data, w, h, stride, ret, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_FLOAT:
+			robustStatistics ((const float *) data, w, h, stride, ret, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_DOUBLE:
+			robustStatistics ((const double *) data, w, h, stride, ret, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_SBYTE:
+			robustStatistics ((const int8_t *) data, w, h, stride, ret, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_USHORT:
+			robustStatistics ((const uint16_t *) data, w, h, stride, ret, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_ULONG:
+			robustStatistics ((const uint32_t *) data, w, h, stride, ret, kappa, maxIter, threads);
+			break;
+		default:
+			throw rts2core::Error ("unknow dataType");
+	}
+}
+
+void rts2core::robustRegions (const void *data, int16_t dataType, size_t width, std::vector <StatRegion> &regions, double kappa, int maxIter, int threads)
+{
+	switch (dataType)
+	{
+		case RTS2_DATA_BYTE:
+			regionStatistics ((const uint8_t *) data, width, regions, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_SHORT:
+			regionStatistics ((const int16_t *) data, width, regions, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_LONG:
+			regionStatistics ((const int32_t *) data, width, regions, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_LONGLONG:
+			regionStatistics ((const int64_t *) data, width, regions, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_FLOAT:
+			regionStatistics ((const float *) data, width, regions, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_DOUBLE:
+			regionStatistics ((const double *) data, width, regions, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_SBYTE:
+			regionStatistics ((const int8_t *) data, width, regions, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_USHORT:
+			regionStatistics ((const uint16_t *) data, width, regions, kappa, maxIter, threads);
+			break;
+		case RTS2_DATA_ULONG:
+			regionStatistics ((const uint32_t *) data, width, regions, kappa, maxIter, threads);
+			break;
+		default:
+			throw rts2core::Error ("unknow dataType");
+	}
+}
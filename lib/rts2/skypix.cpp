@@ -0,0 +1,103 @@
+/*
+ * Sky pixelization for indexed cone searches.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "skypix.h"
+
+#include <sstream>
+
+// cones spanning more zones are searched without pixel condition
+#define SKYPIX_MAX_ZONES   300
+
+using namespace rts2core;
+
+static void addRange (SkyPixRanges &ranges, int from, int to)
+{
+	// merge with previous range, full zones form continuous ranges
+	if (!ranges.empty () && ranges.back ().second + 1 >= from)
+	{
+		if (to > ranges.back ().second)
+			ranges.back ().second = to;
+		return;
+	}
+	ranges.push_back (std::pair <int, int> (from, to));
+}
+
+void rts2core::skyPixRanges (double ra, double dec, double radius, SkyPixRanges &ranges)
+{
+	ranges.clear ();
+
+	int z1 = skypix_zone (dec - radius);
+	int z2 = skypix_zone (dec + radius);
+
+	// maximal RA distance of cone point from cone center, valid for all declinations
+	double alpha = 180;
+	if (fabs (dec) + radius < 89.9)
+	{
+		double s = sin (radius * M_PI / 180.0) / cos (dec * M_PI / 180.0);
+		if (s < 1)
+			alpha = asin (s) * 180.0 / M_PI;
+	}
+
+	int c1 = 0;
+	int c2 = SKYPIX_CELLS - 1;
+	bool wrap = false;
+	if (alpha < 180)
+	{
+		c1 = skypix_cell (ra - alpha);
+		c2 = skypix_cell (ra + alpha);
+		wrap = c1 > c2;
+	}
+
+	for (int z = z1; z <= z2; z++)
+	{
+		int base = z * SKYPIX_CELLS;
+		if (wrap)
+		{
+			addRange (ranges, base, base + c2);
+			addRange (ranges, base + c1, base + SKYPIX_CELLS - 1);
+		}
+		else
+		{
+			addRange (ranges, base + c1, base + c2);
+		}
+	}
+}
+
+std::string rts2core::skyPixCondition (const char *column, double ra, double dec, double radius)
+{
+	if (skypix_zone (dec + radius) - skypix_zone (dec - radius) > SKYPIX_MAX_ZONES)
+		return std::string ("true");
+
+	SkyPixRanges ranges;
+	skyPixRanges (ra, dec, radius, ranges);
+
+	std::ostringstream os;
+	os << "(";
+	for (SkyPixRanges::iterator iter = ranges.begin (); iter != ranges.end (); iter++)
+	{
+		if (iter != ranges.begin ())
+			os << " OR ";
+		if (iter->first == iter->second)
+			os << column << " = " << iter->first;
+		else
+			os << column << " BETWEEN " << iter->first << " AND " << iter->second;
+	}
+	os << ")";
+	return os.str ();
+}
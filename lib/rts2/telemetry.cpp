@@ -0,0 +1,231 @@
+/*
+ * Binary telemetry ring file.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "telemetry.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// marks record being written
+#define SEQ_WRITING    (~((uint64_t) 0))
+
+using namespace rts2core;
+
+const char *rts2core::telemetryColumns[] = {"seq", "time", "tar_ra", "tar_dec", "model_ra", "model_dec", "tel_tar_ra", "tel_tar_dec", "tel_tar_az", "tel_tar_alt", "tel_ra", "tel_dec", "error", NULL};
+
+TelemetryRing::TelemetryRing ()
+{
+	fd = -1;
+	header = NULL;
+	records = NULL;
+	mapSize = 0;
+}
+
+TelemetryRing::~TelemetryRing ()
+{
+	close ();
+}
+
+int TelemetryRing::create (const char *path, uint32_t capacity)
+{
+	close ();
+
+	size_t size = sizeof (TelemetryHeader) + (size_t) capacity * sizeof (TelemetryRecord);
+
+	fd = ::open (path, O_RDWR);
+	if (fd >= 0)
+	{
+		TelemetryHeader h;
+		struct stat st;
+		if (fstat (fd, &st) == 0 && (size_t) st.st_size == size && pread (fd, &h, sizeof (h), 0) == sizeof (h)
+			&& h.magic == TELEMETRY_MAGIC && h.version == TELEMETRY_VERSION && h.recordSize == sizeof (TelemetryRecord) && h.capacity == capacity)
+			return mapFile (true);
+		::close (fd);
+		fd = -1;
+	}
+
+	// new file or different layout. Readers might have the old file mapped,
+	// so it is not truncated - new ring is prepared aside and renamed over it
+	std::string tmpname = std::string (path) + ".tmp";
+	fd = ::open (tmpname.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return -1;
+
+	TelemetryHeader h;
+	memset (&h, 0, sizeof (h));
+	h.magic = TELEMETRY_MAGIC;
+	h.version = TELEMETRY_VERSION;
+	h.recordSize = sizeof (TelemetryRecord);
+	h.capacity = capacity;
+	h.count = 0;
+	if (ftruncate (fd, size) || pwrite (fd, &h, sizeof (h), 0) != sizeof (h) || rename (tmpname.c_str (), path))
+	{
+		unlink (tmpname.c_str ());
+		close ();
+		return -1;
+	}
+
+	return mapFile (true);
+}
+
+int TelemetryRing::open (const char *path)
+{
+	close ();
+
+	fd = ::open (path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	return mapFile (false);
+}
+
+void TelemetryRing::close ()
+{
+	if (header)
+		munmap (header, mapSize);
+	if (fd >= 0)
+		::close (fd);
+	fd = -1;
+	header = NULL;
+	records = NULL;
+	mapSize = 0;
+}
+
+void TelemetryRing::write (TelemetryRecord &rec)
+{
+	uint64_t n = header->count;
+	TelemetryRecord *r = records + (n % header->capacity);
+
+	rec.seq = n;
+
+	r->seq = SEQ_WRITING;
+	__sync_synchronize ();
+	memcpy (((char *) r) + sizeof (r->seq), ((char *) &rec) + sizeof (rec.seq), sizeof (rec) - sizeof (rec.seq));
+	__sync_synchronize ();
+	r->seq = n;
+	__sync_synchronize ();
+	header->count = n + 1;
+}
+
+uint64_t TelemetryRing::getFirst ()
+{
+	if (header == NULL)
+		return 0;
+	uint64_t c = header->count;
+	return c > header->capacity ? c - header->capacity : 0;
+}
+
+bool TelemetryRing::read (uint64_t n, TelemetryRecord &rec)
+{
+	if (header == NULL || n >= header->count)
+		return false;
+	TelemetryRecord *r = records + (n % header->capacity);
+	uint64_t s = r->seq;
+	__sync_synchronize ();
+	memcpy (&rec, r, sizeof (rec));
+	__sync_synchronize ();
+	return s == n && r->seq == n;
+}
+
+uint64_t TelemetryRing::find (double t)
+{
+	uint64_t lo = getFirst ();
+	uint64_t hi = getCount ();
+	TelemetryRecord rec;
+	while (lo < hi)
+	{
+		uint64_t m = lo + (hi - lo) / 2;
+		// overwritten records are older than any record in the ring
+		if (!read (m, rec) || rec.time < t)
+			lo = m + 1;
+		else
+			hi = m;
+	}
+	return lo;
+}
+
+uint64_t TelemetryRing::read (uint64_t from, std::vector <TelemetryRecord> &recs, size_t maxRecords, double decimate)
+{
+	uint64_t first = getFirst ();
+	if (from < first)
+		from = first;
+
+	uint64_t end = getCount ();
+	double last = recs.empty () ? -1 : recs.back ().time;
+	size_t num = 0;
+
+	TelemetryRecord rec;
+	for (; from < end && num < maxRecords; from++)
+	{
+		if (!read (from, rec))
+			continue;
+		if (decimate > 0 && last >= 0 && rec.time - last < decimate)
+			continue;
+		recs.push_back (rec);
+		last = rec.time;
+		num++;
+	}
+	return from;
+}
+
+int TelemetryRing::mapFile (bool writable)
+{
+	TelemetryHeader h;
+	if (pread (fd, &h, sizeof (h), 0) != sizeof (h) || h.magic != TELEMETRY_MAGIC || h.version != TELEMETRY_VERSION || h.recordSize != sizeof (TelemetryRecord))
+	{
+		close ();
+		return -1;
+	}
+
+	mapSize = sizeof (TelemetryHeader) + (size_t) h.capacity * sizeof (TelemetryRecord);
+	// accessing mapping past end of a shorter file raises SIGBUS
+	struct stat st;
+	if (fstat (fd, &st) || (size_t) st.st_size < mapSize)
+	{
+		close ();
+		return -1;
+	}
+	void *m = mmap (NULL, mapSize, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+	if (m == MAP_FAILED)
+	{
+		header = NULL;
+		close ();
+		return -1;
+	}
+	header = (TelemetryHeader *) m;
+	records = (TelemetryRecord *) (((char *) m) + sizeof (TelemetryHeader));
+	return 0;
+}
+
+std::ostream & rts2core::operator << (std::ostream &os, const TelemetryRecord &rec)
+{
+	os << rec.seq << " " << rec.time << " "
+		<< rec.tarRa << " " << rec.tarDec << " "
+		<< rec.modelRa << " " << rec.modelDec << " "
+		<< rec.telTarRa << " " << rec.telTarDec << " "
+		<< rec.telTarAz << " " << rec.telTarAlt << " "
+		<< rec.telRa << " " << rec.telDec << " "
+		<< rec.error;
+	return os;
+}
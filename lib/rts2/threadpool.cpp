@@ -0,0 +1,315 @@
+/*
+ * Work-stealing thread pool.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "threadpool.h"
+#include "conncompletion.h"
+#include "error.h"
+
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+
+using namespace rts2core;
+
+PoolTask::PoolTask ()
+{
+	finished = false;
+	failed = false;
+	completion = NULL;
+
+	pthread_mutex_init (&mutex, NULL);
+	pthread_cond_init (&cond, NULL);
+}
+
+PoolTask::~PoolTask ()
+{
+	pthread_cond_destroy (&cond);
+	pthread_mutex_destroy (&mutex);
+}
+
+void PoolTask::wait ()
+{
+	// always lock, so task is not deleted before finish releases the mutex
+	pthread_mutex_lock (&mutex);
+	while (!finished)
+		pthread_cond_wait (&cond, &mutex);
+	pthread_mutex_unlock (&mutex);
+}
+
+void PoolTask::finish ()
+{
+	pthread_mutex_lock (&mutex);
+	__atomic_store_n (&finished, true, __ATOMIC_RELEASE);
+	pthread_cond_broadcast (&cond);
+	pthread_mutex_unlock (&mutex);
+}
+
+ThreadPool::ThreadPool (int _threads, size_t _queueSize):injection (_queueSize)
+{
+	threads = _threads;
+	if (threads <= 0)
+		threads = sysconf (_SC_NPROCESSORS_ONLN);
+	if (threads <= 0)
+		threads = 1;
+
+	pthread_key_create (&workerKey, NULL);
+	pthread_mutex_init (&sleepMutex, NULL);
+	pthread_cond_init (&sleepCond, NULL);
+
+	pending = 0;
+	sleeping = 0;
+	stopping = false;
+	running = false;
+
+	nextWorker = 0;
+}
+
+ThreadPool::~ThreadPool ()
+{
+	stop ();
+
+	pthread_cond_destroy (&sleepCond);
+	pthread_mutex_destroy (&sleepMutex);
+	pthread_key_delete (workerKey);
+}
+
+int ThreadPool::start ()
+{
+	if (running)
+		return 0;
+
+	stopping = false;
+
+	for (int i = 0; i < threads; i++)
+	{
+		Worker *w = new Worker ();
+		w->pool = this;
+		pthread_mutex_init (&(w->mutex), NULL);
+		workers.push_back (w);
+	}
+
+	// workers inherit blocked signals, so signal handlers run in the main
+	// thread and interrupt its poll call
+	sigset_t all, old;
+	sigfillset (&all);
+	pthread_sigmask (SIG_BLOCK, &all, &old);
+
+	// start threads after all workers exist, so they can steal from each other
+	for (std::vector <Worker *>::iterator iter = workers.begin (); iter != workers.end (); iter++)
+	{
+		if (pthread_create (&((*iter)->thread), NULL, workerThread, (void *) (*iter)))
+		{
+			pthread_sigmask (SIG_SETMASK, &old, NULL);
+			for (std::vector <Worker *>::iterator di = iter; di != workers.end (); di++)
+			{
+				pthread_mutex_destroy (&((*di)->mutex));
+				delete *di;
+			}
+			workers.erase (iter, workers.end ());
+			running = true;
+			stop ();
+			return -1;
+		}
+	}
+	pthread_sigmask (SIG_SETMASK, &old, NULL);
+	running = true;
+	return 0;
+}
+
+void ThreadPool::stop ()
+{
+	if (!running)
+		return;
+
+	pthread_mutex_lock (&sleepMutex);
+	stopping = true;
+	pthread_cond_broadcast (&sleepCond);
+	pthread_mutex_unlock (&sleepMutex);
+
+	for (std::vector <Worker *>::iterator iter = workers.begin (); iter != workers.end (); iter++)
+	{
+		pthread_join ((*iter)->thread, NULL);
+		pthread_mutex_destroy (&((*iter)->mutex));
+		delete *iter;
+	}
+	workers.clear ();
+	running = false;
+}
+
+int ThreadPool::submit (PoolTask *task, ConnCompletion *completion)
+{
+	task->completion = completion;
+
+	__atomic_add_fetch (&pending, 1, __ATOMIC_SEQ_CST);
+
+	Worker *w = (Worker *) pthread_getspecific (workerKey);
+	if (w != NULL && w->pool == this)
+	{
+		pthread_mutex_lock (&(w->mutex));
+		w->tasks.push_back (task);
+		pthread_mutex_unlock (&(w->mutex));
+	}
+	else if (!injection.push (task))
+	{
+		// injection queue is full, distribute task directly
+		if (workers.empty ())
+		{
+			// pool is not running, there isn't any worker to take the task
+			__atomic_sub_fetch (&pending, 1, __ATOMIC_SEQ_CST);
+			task->completion = NULL;
+			return -1;
+		}
+		size_t n = __atomic_fetch_add (&nextWorker, 1, __ATOMIC_RELAXED) % workers.size ();
+		pthread_mutex_lock (&(workers[n]->mutex));
+		workers[n]->tasks.push_back (task);
+		pthread_mutex_unlock (&(workers[n]->mutex));
+	}
+
+	// pending was increased before sleeping is checked, and workers increase sleeping before checking pending, so wakeup cannot be lost
+	if (__atomic_load_n (&sleeping, __ATOMIC_SEQ_CST) > 0)
+	{
+		pthread_mutex_lock (&sleepMutex);
+		pthread_cond_signal (&sleepCond);
+		pthread_mutex_unlock (&sleepMutex);
+	}
+	return 0;
+}
+
+void ThreadPool::wait (PoolTask *task)
+{
+	Worker *w = (Worker *) pthread_getspecific (workerKey);
+	if (w == NULL || w->pool != this)
+	{
+		task->wait ();
+		return;
+	}
+	while (!task->isFinished ())
+	{
+		PoolTask *t = take (w);
+		if (t)
+			execute (t);
+		else
+			sched_yield ();
+	}
+	task->wait ();
+}
+
+void *ThreadPool::workerThread (void *arg)
+{
+	Worker *w = (Worker *) arg;
+	pthread_setspecific (w->pool->workerKey, w);
+	w->pool->workerLoop (w);
+	return NULL;
+}
+
+void ThreadPool::workerLoop (Worker *w)
+{
+	while (true)
+	{
+		PoolTask *task = take (w);
+		if (task)
+		{
+			execute (task);
+			continue;
+		}
+
+		// task might be submitted, but not yet visible in a queue
+		if (__atomic_load_n (&pending, __ATOMIC_SEQ_CST) > 0)
+		{
+			sched_yield ();
+			continue;
+		}
+
+		pthread_mutex_lock (&sleepMutex);
+		__atomic_add_fetch (&sleeping, 1, __ATOMIC_SEQ_CST);
+		while (__atomic_load_n (&pending, __ATOMIC_SEQ_CST) == 0 && !stopping)
+			pthread_cond_wait (&sleepCond, &sleepMutex);
+		__atomic_sub_fetch (&sleeping, 1, __ATOMIC_SEQ_CST);
+		bool stop = stopping && __atomic_load_n (&pending, __ATOMIC_SEQ_CST) == 0;
+		pthread_mutex_unlock (&sleepMutex);
+
+		if (stop)
+			break;
+	}
+}
+
+PoolTask *ThreadPool::take (Worker *w)
+{
+	PoolTask *task = NULL;
+
+	pthread_mutex_lock (&(w->mutex));
+	if (!w->tasks.empty ())
+	{
+		task = w->tasks.back ();
+		w->tasks.pop_back ();
+	}
+	pthread_mutex_unlock (&(w->mutex));
+
+	if (task == NULL && !injection.pop (task))
+	{
+		task = NULL;
+		// steal oldest task, starting from the next worker
+		size_t i = 0;
+		while (workers[i] != w)
+			i++;
+		for (size_t j = 1; j < workers.size () && task == NULL; j++)
+		{
+			Worker *victim = workers[(i + j) % workers.size ()];
+			pthread_mutex_lock (&(victim->mutex));
+			if (!victim->tasks.empty ())
+			{
+				task = victim->tasks.front ();
+				victim->tasks.pop_front ();
+			}
+			pthread_mutex_unlock (&(victim->mutex));
+		}
+	}
+
+	if (task)
+		__atomic_sub_fetch (&pending, 1, __ATOMIC_SEQ_CST);
+	return task;
+}
+
+void ThreadPool::execute (PoolTask *task)
+{
+	try
+	{
+		task->run ();
+	}
+	catch (std::exception &ex)
+	{
+		task->failed = true;
+		task->error = ex.what ();
+	}
+	catch (...)
+	{
+		task->failed = true;
+		task->error = "unknown exception";
+	}
+
+	if (task->completion)
+	{
+		__atomic_store_n (&(task->finished), true, __ATOMIC_RELEASE);
+		task->completion->post (task);
+	}
+	else
+	{
+		task->finish ();
+	}
+}
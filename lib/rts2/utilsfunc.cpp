@@ -22,7 +22,9 @@
 #include "riseset.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <ftw.h>
+#include <libgen.h>
 #ifdef RTS2_HAVE_MALLOC_H
 #include <malloc.h>
 #endif
@@ -112,6 +114,113 @@ int rmdir_r (const char *dir)
 	return nftw (dir, rmfiledir, 50, FTW_DEPTH | FTW_MOUNT);
 }
 
+int replaceFile (const char *filename, const std::string &content)
+{
+	std::string tmpname = std::string (filename) + ".tmp";
+	int fd = open (tmpname.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd < 0)
+		return -1;
+
+	const char *buf = content.c_str ();
+	size_t len = content.length ();
+
+	// keep permissions of the replaced file
+	struct stat st;
+	if (stat (filename, &st) == 0 && fchmod (fd, st.st_mode & 07777))
+		goto err;
+
+	while (len > 0)
+	{
+		ssize_t ret = write (fd, buf, len);
+		if (ret < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			goto err;
+		}
+		buf += ret;
+		len -= ret;
+	}
+	if (fsync (fd))
+		goto err;
+	if (close (fd))
+	{
+		fd = -1;
+		goto err;
+	}
+	fd = -1;
+	if (rename (tmpname.c_str (), filename))
+		goto err;
+
+	// sync directory, so the rename survives crash
+	{
+		char *dn = strdup (filename);
+		int dfd = open (dirname (dn), O_RDONLY);
+		free (dn);
+		if (dfd >= 0)
+		{
+			fsync (dfd);
+			close (dfd);
+		}
+	}
+	return 0;
+
+err:
+	int err = errno;
+	if (fd >= 0)
+		close (fd);
+	unlink (tmpname.c_str ());
+	errno = err;
+	return -1;
+}
+
+int readCheckpoint (const char *filename, std::vector <std::string> &lines)
+{
+	int fd = open (filename, O_RDWR);
+	if (fd < 0)
+		return errno == ENOENT ? 0 : -1;
+
+	std::string line;
+	char buf[8192];
+	ssize_t ret;
+	// end of the last complete line
+	off_t complete = 0;
+	off_t pos = 0;
+	while ((ret = read (fd, buf, sizeof (buf))) != 0)
+	{
+		if (ret < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			goto err;
+		}
+		for (ssize_t i = 0; i < ret; i++)
+		{
+			pos++;
+			if (buf[i] == '\n')
+			{
+				lines.push_back (line);
+				line.clear ();
+				complete = pos;
+			}
+			else
+			{
+				line += buf[i];
+			}
+		}
+	}
+	if (complete < pos && (ftruncate (fd, complete) || fsync (fd)))
+		goto err;
+	close (fd);
+	return 0;
+
+err:
+	int err = errno;
+	close (fd);
+	errno = err;
+	return -1;
+}
+
 int parseLocalDate (const char *in_date, struct ln_date *out_time, bool &islocal, bool *only_date)
 {
 	int ret;
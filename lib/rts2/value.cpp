@@ -22,6 +22,7 @@
 #include <sstream>
 
 #include "libnova_cpp.h"
+#include "binvalue.h"
 #include "block.h"
 #include "configuration.h"
 #include "value.h"
@@ -85,7 +86,15 @@ int Value::sendMetaInfo (Connection * connection)
 
 void Value::send (Connection * connection)
 {
-	connection->sendValueRaw (getName (), getValue ());
+	if (connection->getBinaryValues ())
+		connection->sendBinaryValue (this);
+	else
+		connection->sendValueRaw (getName (), getValue ());
+}
+
+void Value::writeBinary (BinaryValueWriter &writer)
+{
+	writer.addText (getValue ());
 }
 
 ValueString::ValueString (std::string in_val_name): Value (in_val_name)
@@ -176,6 +185,11 @@ const char * ValueInteger::getValue ()
 	return buf;
 }
 
+void ValueInteger::writeBinary (BinaryValueWriter &writer)
+{
+	writer.addInteger (value);
+}
+
 int ValueInteger::setValue (Connection * connection)
 {
 	int new_value;
@@ -241,6 +255,11 @@ const char * ValueDouble::getValue ()
 	return buf;
 }
 
+void ValueDouble::writeBinary (BinaryValueWriter &writer)
+{
+	writer.addDouble (value);
+}
+
 const char * ValueDouble::getDisplayValue ()
 {
 	snprintf (buf, VALUE_BUF_LEN, "%.20lg", value);
@@ -382,6 +401,11 @@ const char * ValueFloat::getValue ()
 	return buf;
 }
 
+void ValueFloat::writeBinary (BinaryValueWriter &writer)
+{
+	writer.addDouble (value);
+}
+
 const char * ValueFloat::getDisplayValue ()
 {
 	double absv = fabs (value);
@@ -634,6 +658,11 @@ const char * ValueLong::getValue ()
 	return buf;
 }
 
+void ValueLong::writeBinary (BinaryValueWriter &writer)
+{
+	writer.addLong (value);
+}
+
 int ValueLong::setValue (Connection * connection)
 {
 	long int new_value;
@@ -795,6 +824,12 @@ const char * ValueRaDec::getValue ()
 	return buf;
 }
 
+void ValueRaDec::writeBinary (BinaryValueWriter &writer)
+{
+	writer.addDouble (ra);
+	writer.addDouble (decl);
+}
+
 const char * ValueRaDec::getDisplaySubValue (const char *subv)
 {
 	if (strcasecmp (subv, "ra") == 0)
@@ -912,6 +947,12 @@ const char * ValueAltAz::getValue ()
 	return buf;
 }
 
+void ValueAltAz::writeBinary (BinaryValueWriter &writer)
+{
+	writer.addDouble (alt);
+	writer.addDouble (az);
+}
+
 void ValueAltAz::setFromValue (Value * newValue)
 {
 	if (newValue->getValueType () == RTS2_VALUE_ALTAZ)
@@ -182,6 +182,12 @@ const char * DoubleArray::getValue ()
 	return _os.c_str ();
 }
 
+void DoubleArray::writeBinary (BinaryValueWriter &writer)
+{
+	for (std::vector <double>::iterator iter = value.begin (); iter != value.end (); iter++)
+		writer.addDouble (*iter);
+}
+
 void DoubleArray::setFromValue (rts2core::Value * newValue)
 {
 	if (newValue->getValueType () == (RTS2_VALUE_ARRAY | RTS2_VALUE_DOUBLE))
@@ -388,6 +394,12 @@ const char * IntegerArray::getValue ()
 	return _os.c_str ();
 }
 
+void IntegerArray::writeBinary (BinaryValueWriter &writer)
+{
+	for (std::vector <int>::iterator iter = valueBegin (); iter != valueEnd (); iter++)
+		writer.addInteger (*iter);
+}
+
 void IntegerArray::setFromValue (rts2core::Value * newValue)
 {
 	if (newValue->getValueType () == (RTS2_VALUE_ARRAY | RTS2_VALUE_INTEGER))
@@ -104,6 +104,13 @@ const char * ValueDoubleMinMax::getValue ()
 	return buf;
 }
 
+void ValueDoubleMinMax::writeBinary (BinaryValueWriter &writer)
+{
+	writer.addDouble (getValueDouble ());
+	writer.addDouble (getMin ());
+	writer.addDouble (getMax ());
+}
+
 const char * ValueDoubleMinMax::getDisplayValue ()
 {
 	sprintf (buf, "%g %g %g", getValueDouble (), getMin (), getMax ());
@@ -200,6 +207,13 @@ const char * ValueIntegerMinMax::getValue ()
 	return buf;
 }
 
+void ValueIntegerMinMax::writeBinary (BinaryValueWriter &writer)
+{
+	writer.addInteger (getValueInteger ());
+	writer.addInteger (getMin ());
+	writer.addInteger (getMax ());
+}
+
 const char * ValueIntegerMinMax::getDisplayValue ()
 {
 	sprintf (buf, "%d %d %d", getValueInteger (), getMin (), getMax ());
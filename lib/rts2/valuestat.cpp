@@ -94,6 +94,16 @@ const char * ValueDoubleStat::getValue ()
 	return buf;
 }
 
+void ValueDoubleStat::writeBinary (BinaryValueWriter &writer)
+{
+	writer.addDouble (value);
+	writer.addInteger (numMes);
+	writer.addDouble (mode);
+	writer.addDouble (min);
+	writer.addDouble (max);
+	writer.addDouble (stdev);
+}
+
 const char * ValueDoubleStat::getDisplayValue ()
 {
 	std::ostringstream os;
@@ -233,6 +243,18 @@ const char * ValueDoubleTimeserie::getValue ()
 	return buf;
 }
 
+void ValueDoubleTimeserie::writeBinary (BinaryValueWriter &writer)
+{
+	writer.addDouble (value);
+	writer.addInteger (numMes);
+	writer.addDouble (mode);
+	writer.addDouble (min);
+	writer.addDouble (max);
+	writer.addDouble (stdev);
+	writer.addDouble (alpha);
+	writer.addDouble (beta);
+}
+
 const char * ValueDoubleTimeserie::getDisplayValue ()
 {
 	sprintf (buf, "%f %i %f %f %f %f %f %f", getValueDouble (), numMes, mode, min, max, stdev, alpha, beta);
@@ -26,6 +26,8 @@
 #include "pluto/norad.h"
 #include "pluto/observe.h"
 
+#include <cmath>
+
 using namespace rts2db;
 
 TLETarget::TLETarget (int in_tar_id, struct ln_lnlat_posn *in_obs, double in_altitude):Target (in_tar_id, in_obs, in_altitude)
@@ -48,18 +50,11 @@ void TLETarget::orbitFromTLE (std::string target_tle)
 		tle1 = target_tle.substr (0, sub);
 		tle2 = target_tle.substr (sub + 1);
 
-		int ret = parse_elements (tle1.c_str (), tle2.c_str (), &tle);
+		int ret = orbit.parse (tle1.c_str (), tle2.c_str ());
 		if (ret != 0)
 			throw rts2core::Error ("cannot parse TLE " + tle1 + " " + tle2 + " for target " + getTargetName ());
 
-		ephem = 1;
-		is_deep = select_ephemeris (&tle);
-
-		if (is_deep && (ephem == 1 || ephem == 2))
-			ephem += 2;	/* switch to an SDx */
-		if (!is_deep && (ephem == 3 || ephem == 4))
-			ephem -= 2;	/* switch to an SGx */
-		setTargetName (tle.intl_desig);
+		setTargetName (orbit.getTLE ()->intl_desig);
 		setTargetInfo (target_tle.c_str ());
 		setTargetType (TYPE_TLE);
 		return;
@@ -69,51 +64,48 @@ void TLETarget::orbitFromTLE (std::string target_tle)
 
 void TLETarget::getPosition (struct ln_equ_posn *pos, double JD)
 {
-	double sat_params[N_SAT_PARAMS], observer_loc[3];
-	double t_since;
-	double sat_pos[3]; /* Satellite position vector */
 	double dist_to_satellite;
 
-	double r_s, r_c;
-
-	lat_alt_to_parallax (ln_deg_to_rad (observer->lat), obs_altitude * 1000, &r_c, &r_s);
-
-	observer_cartesian_coords (JD, ln_deg_to_rad (observer->lng), r_c, r_s, observer_loc);
+	if (orbit.getEphem () < 0)
+		throw rts2core::Error ("invalid ephem");
 
-	t_since = (JD - tle.epoch) * 1440.;
-	switch (ephem)
-	{
-		case 0:
-			SGP_init (sat_params, &tle);
-			SGP (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		case 1:
-			SGP4_init (sat_params, &tle);
-			SGP4 (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		case 2:
-			SGP8_init (sat_params, &tle);
-			SGP8 (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		case 3:
-			SDP4_init (sat_params, &tle);
-			SDP4 (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		case 4:
-			SDP8_init (sat_params, &tle);
-			SDP8 (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		default:
-			throw rts2core::Error ("invalid ephem");
-	}
-
-	get_satellite_ra_dec_delta (observer_loc, sat_pos, &(pos->ra), &(pos->dec), &dist_to_satellite);
+	orbit.getRaDec (JD, getTLEObserver (), &(pos->ra), &(pos->dec), &dist_to_satellite);
 	pos->ra = ln_rad_to_deg (pos->ra);
 	pos->dec = ln_rad_to_deg (pos->dec);
 }
 
 int TLETarget::getRST (struct ln_rst_time *rst, double JD, double horizon)
 {
+	rts2pluto::TLEObserver tobs = getTLEObserver ();
+	std::vector <rts2pluto::TLEPass> passes;
+	orbit.getPasses (JD, JD + 1, tobs, horizon, horizon, passes);
+	if (passes.empty ())
+		return orbit.getAltitude (JD, tobs) > horizon ? 1 : -1;
+	if (!std::isnan (passes[0].rise))
+	{
+		rst->rise = passes[0].rise;
+		rst->transit = passes[0].culmination;
+		rst->set = passes[0].set;
+		return 0;
+	}
+	// satellite is above horizon at JD - report set of the current pass and next rise
+	if (std::isnan (passes[0].set))
+		return 1;
+	rst->set = passes[0].set;
+	rst->transit = passes[0].culmination > JD ? passes[0].culmination : NAN;
+	if (passes.size () > 1)
+	{
+		passes.erase (passes.begin ());
+	}
+	else
+	{
+		orbit.getPasses (rst->set, rst->set + 1, tobs, horizon, horizon, passes);
+		if (passes.empty () || std::isnan (passes[0].rise))
+			return 1;
+	}
+	rst->rise = passes[0].rise;
+	if (std::isnan (rst->transit))
+		rst->transit = passes[0].culmination;
 	return 0;
 }
 
@@ -147,6 +139,13 @@ void TLETarget::writeToImage (rts2image::Image * image, double JD)
 	image->setValue ("TLE2", tle2.c_str (), "TLE 2nd line");
 }
 
+rts2pluto::TLEObserver TLETarget::getTLEObserver ()
+{
+	double r_s, r_c;
+	lat_alt_to_parallax (ln_deg_to_rad (observer->lat), obs_altitude * 1000, &r_c, &r_s);
+	return rts2pluto::TLEObserver (observer->lng, observer->lat, r_c, r_s);
+}
+
 double TLETarget::getEarthDistance (double JD)
 {
 	return 0;
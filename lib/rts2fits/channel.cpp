@@ -18,6 +18,7 @@
  */
 
 #include "rts2fits/channel.h"
+#include "bufferpool.h"
 #include "error.h"
 #include "imghdr.h"
 #include "nan.h"
@@ -25,17 +26,36 @@
 #ifdef RTS2_HAVE_MALLOC_H
 #include <malloc.h>
 #endif
+#ifdef RTS2_HAVE_ENDIAN_H
+#include <endian.h>
+#endif
 #include <string.h>
+#include <stdlib.h>
 #include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <iostream>
 
 using namespace rts2image;
 
+static int pixelByteSize (int16_t dataType)
+{
+	if (dataType == RTS2_DATA_ULONG)
+		return 4;
+	return abs (dataType) / 8;
+}
+
 Channel::Channel (int16_t _dataType)
 {
 	channelnum = 0;
 	data = NULL;
 	allocated = false;
+	pooled = NULL;
+
+	mapped = NULL;
+	mappedLength = 0;
+	raw = NULL;
 
 	dataType = _dataType;
 
@@ -51,6 +71,11 @@ Channel::Channel (int ch, char *_data, int _naxis, long *_sizes, int16_t _dataTy
 
 	data = _data;
 	allocated = dealloc;
+	pooled = NULL;
+
+	mapped = NULL;
+	mappedLength = 0;
+	raw = NULL;
 
 	naxis = _naxis;
 
@@ -67,9 +92,57 @@ Channel::Channel (int ch, char *_data, long dataSize, int _naxis, long *_sizes,
 {
 	channelnum = ch;
 
-	data = new char [dataSize];
+	pooled = rts2core::BufferPool::instance ().allocate (dataSize);
+	if (pooled == NULL)
+		throw rts2core::Error ("cannot allocate channel data");
+	data = (char *) pooled;
 	memcpy (data, _data, dataSize);
-	allocated = true;
+	allocated = false;
+
+	mapped = NULL;
+	mappedLength = 0;
+	raw = NULL;
+
+	naxis = _naxis;
+
+	dataType = _dataType;
+
+	sizes = new long [naxis];
+	memcpy (sizes, _sizes, naxis * sizeof (long));
+
+	pixelSum = average = stdev = NAN;
+}
+
+Channel::Channel (int ch, char *_data, void *poolBuffer, int _naxis, long *_sizes, int16_t _dataType)
+{
+	channelnum = ch;
+
+	rts2core::BufferPool::instance ().retain (poolBuffer);
+	pooled = poolBuffer;
+	data = _data;
+	allocated = false;
+
+	mapped = NULL;
+	mappedLength = 0;
+	raw = NULL;
+
+	naxis = _naxis;
+
+	dataType = _dataType;
+
+	sizes = new long [naxis];
+	memcpy (sizes, _sizes, naxis * sizeof (long));
+
+	pixelSum = average = stdev = NAN;
+}
+
+Channel::Channel (int ch, int fd, off_t offset, int _naxis, long *_sizes, int16_t _dataType)
+{
+	channelnum = ch;
+
+	data = NULL;
+	allocated = false;
+	pooled = NULL;
 
 	naxis = _naxis;
 
@@ -79,40 +152,149 @@ Channel::Channel (int ch, char *_data, long dataSize, int _naxis, long *_sizes,
 	memcpy (sizes, _sizes, naxis * sizeof (long));
 
 	pixelSum = average = stdev = NAN;
+
+	// mapping must start on page boundary
+	off_t pageOffset = offset % sysconf (_SC_PAGESIZE);
+	mappedLength = pageOffset + getNPixels () * pixelByteSize (dataType);
+
+	void *m = mmap (NULL, mappedLength, PROT_READ, MAP_SHARED, fd, offset - pageOffset);
+	if (m == MAP_FAILED)
+	{
+		delete[] sizes;
+		throw rts2core::Error (std::string ("cannot map channel data: ") + strerror (errno));
+	}
+	mapped = (char *) m;
+	raw = mapped + pageOffset;
 }
 
 Channel::~Channel ()
 {
 	if (allocated)
 		delete[] data;
+	rts2core::BufferPool::instance ().release (pooled);
+	if (mapped)
+		munmap (mapped, mappedLength);
 	delete[] sizes;
 }
 
-template <typename pixel_type> void computeDataStatistics (pixel_type *data, long totalPixels, long double &pixelSum, double &average, double &stdev)
+const char *Channel::getData ()
 {
-	// calculate average of all channels..
-	pixel_type *pixel = data;
-	pixel_type *fullTop = pixel + totalPixels;
+	if (data == NULL && raw != NULL)
+		convertRaw ();
+	return data;
+}
 
-	pixelSum = 0;
+// swap FITS (big endian) words to host byte order
+struct Swap8
+{
+	static inline uint8_t get (uint8_t v) { return v; }
+};
+
+#if defined(RTS2_HAVE_ENDIAN_H) && defined(be16toh)
+struct Swap16
+{
+	static inline uint16_t get (uint16_t v) { return be16toh (v); }
+};
 
-	while (pixel < fullTop)
+struct Swap32
+{
+	static inline uint32_t get (uint32_t v) { return be32toh (v); }
+};
+
+struct Swap64
+{
+	static inline uint64_t get (uint64_t v) { return be64toh (v); }
+};
+#else
+// assemble words from bytes, independently of host byte order
+struct Swap16
+{
+	static inline uint16_t get (uint16_t v)
 	{
-		pixelSum += *pixel;
-		pixel++;
+		const uint8_t *b = (const uint8_t *) &v;
+		return ((uint16_t) b[0] << 8) | b[1];
 	}
+};
+
+struct Swap32
+{
+	static inline uint32_t get (uint32_t v)
+	{
+		const uint8_t *b = (const uint8_t *) &v;
+		return ((uint32_t) b[0] << 24) | ((uint32_t) b[1] << 16) | ((uint32_t) b[2] << 8) | b[3];
+	}
+};
+
+struct Swap64
+{
+	static inline uint64_t get (uint64_t v)
+	{
+		const uint8_t *b = (const uint8_t *) &v;
+		uint64_t ret = 0;
+		for (int i = 0; i < 8; i++)
+			ret = (ret << 8) | b[i];
+		return ret;
+	}
+};
+#endif
+
+/**
+ * Reads pixel from data in native representation.
+ */
+template <typename pixel_type> struct NativePixel
+{
+	typedef pixel_type type;
+	static inline pixel_type get (const char *data, size_t i) { return ((const pixel_type *) data)[i]; }
+};
+
+/**
+ * Reads pixel from data in FITS representation. Unsigned 16 and 32 bit
+ * and signed 8 bit types are stored with BZERO offset, which is removed
+ * by flipping the sign bit. Simple loops over it are vectorized by the
+ * compiler.
+ */
+template <typename pixel_type, typename word_type, typename swap, word_type flip> struct FitsPixel
+{
+	typedef pixel_type type;
+	static inline pixel_type get (const char *data, size_t i)
+	{
+		word_type w;
+		memcpy (&w, data + i * sizeof (word_type), sizeof (word_type));
+		w = swap::get (w) ^ flip;
+		pixel_type ret;
+		memcpy (&ret, &w, sizeof (pixel_type));
+		return ret;
+	}
+};
+
+typedef FitsPixel <unsigned char, uint8_t, Swap8, 0> FitsByte;
+typedef FitsPixel <int16_t, uint16_t, Swap16, 0> FitsShort;
+typedef FitsPixel <int32_t, uint32_t, Swap32, 0> FitsLong;
+typedef FitsPixel <int64_t, uint64_t, Swap64, 0> FitsLongLong;
+typedef FitsPixel <float, uint32_t, Swap32, 0> FitsFloat;
+typedef FitsPixel <double, uint64_t, Swap64, 0> FitsDouble;
+typedef FitsPixel <signed char, uint8_t, Swap8, 0x80> FitsSByte;
+typedef FitsPixel <uint16_t, uint16_t, Swap16, 0x8000> FitsUShort;
+typedef FitsPixel <uint32_t, uint32_t, Swap32, 0x80000000> FitsULong;
+
+template <typename reader> void computeDataStatistics (const char *data, long totalPixels, long double &pixelSum, double &average, double &stdev)
+{
+	// calculate average of all channels..
+	pixelSum = 0;
+
+	for (long i = 0; i < totalPixels; i++)
+		pixelSum += reader::get (data, i);
+
 	if (totalPixels > 0)
 	{
 		average = pixelSum / totalPixels;
 		// calculate stdev
-		pixel = data;
 		stdev = 0;
-		while (pixel < fullTop)
+		for (long i = 0; i < totalPixels; i++)
 		{
-			long double tmp_s = *pixel - average;
+			long double tmp_s = reader::get (data, i) - average;
 			long double tmp_ss = tmp_s * tmp_s;
 			stdev += tmp_ss;
-			pixel++;
 		}
 		stdev = sqrt (stdev / totalPixels);
 	}
@@ -123,40 +305,137 @@ template <typename pixel_type> void computeDataStatistics (pixel_type *data, lon
 	}
 }
 
+template <typename reader> void convertPixels (const char *raw, char *data, size_t totalPixels)
+{
+	typename reader::type *out = (typename reader::type *) data;
+	for (size_t i = 0; i < totalPixels; i++)
+		out[i] = reader::get (raw, i);
+}
+
 void Channel::computeStatistics (size_t _from, size_t _dataSize)
 {
 	if (_dataSize == 0)
 		_dataSize = getNPixels ();
+	// mapped data, which were not yet converted, are read directly from the mapping
+	if (data == NULL && raw != NULL)
+	{
+		const char *d = raw + _from * pixelByteSize (dataType);
+		switch (dataType)
+		{
+			case RTS2_DATA_BYTE:
+				computeDataStatistics <FitsByte> (d, _dataSize, pixelSum, average, stdev);
+				break;
+			case RTS2_DATA_SHORT:
+				computeDataStatistics <FitsShort> (d, _dataSize, pixelSum, average, stdev);
+				break;
+			case RTS2_DATA_LONG:
+				computeDataStatistics <FitsLong> (d, _dataSize, pixelSum, average, stdev);
+				break;
+			case RTS2_DATA_LONGLONG:
+				computeDataStatistics <FitsLongLong> (d, _dataSize, pixelSum, average, stdev);
+				break;
+			case RTS2_DATA_FLOAT:
+				computeDataStatistics <FitsFloat> (d, _dataSize, pixelSum, average, stdev);
+				break;
+			case RTS2_DATA_DOUBLE:
+				computeDataStatistics <FitsDouble> (d, _dataSize, pixelSum, average, stdev);
+				break;
+			case RTS2_DATA_SBYTE:
+				computeDataStatistics <FitsSByte> (d, _dataSize, pixelSum, average, stdev);
+				break;
+			case RTS2_DATA_USHORT:
+				computeDataStatistics <FitsUShort> (d, _dataSize, pixelSum, average, stdev);
+				break;
+			case RTS2_DATA_ULONG:
+				computeDataStatistics <FitsULong> (d, _dataSize, pixelSum, average, stdev);
+				break;
+			default:
+				throw rts2core::Error ("unknow dataType");
+		}
+		return;
+	}
+
+	const char *d = getData () + _from * pixelByteSize (dataType);
 	switch (dataType)
 	{
 		case RTS2_DATA_BYTE:
-			computeDataStatistics ((unsigned char *) (getData ()) + _from, _dataSize, pixelSum, average, stdev);
+			computeDataStatistics <NativePixel <unsigned char> > (d, _dataSize, pixelSum, average, stdev);
 			break;
 		case RTS2_DATA_SHORT:
-			computeDataStatistics ((int16_t *) (getData ()) + _from, _dataSize, pixelSum, average, stdev);
+			computeDataStatistics <NativePixel <int16_t> > (d, _dataSize, pixelSum, average, stdev);
+			break;
+		case RTS2_DATA_LONG:
+			computeDataStatistics <NativePixel <int32_t> > (d, _dataSize, pixelSum, average, stdev);
+			break;
+		case RTS2_DATA_LONGLONG:
+			computeDataStatistics <NativePixel <int64_t> > (d, _dataSize, pixelSum, average, stdev);
+			break;
+		case RTS2_DATA_FLOAT:
+			computeDataStatistics <NativePixel <float> > (d, _dataSize, pixelSum, average, stdev);
+			break;
+		case RTS2_DATA_DOUBLE:
+			computeDataStatistics <NativePixel <double> > (d, _dataSize, pixelSum, average, stdev);
+			break;
+		case RTS2_DATA_SBYTE:
+			computeDataStatistics <NativePixel <signed char> > (d, _dataSize, pixelSum, average, stdev);
+			break;
+		case RTS2_DATA_USHORT:
+			computeDataStatistics <NativePixel <uint16_t> > (d, _dataSize, pixelSum, average, stdev);
+			break;
+		case RTS2_DATA_ULONG:
+			computeDataStatistics <NativePixel <uint32_t> > (d, _dataSize, pixelSum, average, stdev);
+			break;
+		default:
+			throw rts2core::Error ("unknow dataType");
+	}
+}
+
+void Channel::convertRaw ()
+{
+	size_t npix = getNPixels ();
+	// FITS bytes and big endian signed types need no conversion
+	if (dataType == RTS2_DATA_BYTE || (htobe16 (1) == 1 && dataType != RTS2_DATA_SBYTE && dataType != RTS2_DATA_USHORT && dataType != RTS2_DATA_ULONG))
+	{
+		data = (char *) raw;
+		allocated = false;
+		return;
+	}
+
+	pooled = rts2core::BufferPool::instance ().allocate (npix * pixelByteSize (dataType));
+	if (pooled == NULL)
+		throw rts2core::Error ("cannot allocate channel data");
+	data = (char *) pooled;
+
+	switch (dataType)
+	{
+		case RTS2_DATA_SHORT:
+			convertPixels <FitsShort> (raw, data, npix);
 			break;
 		case RTS2_DATA_LONG:
-			computeDataStatistics ((int32_t *) (getData ()) + _from, _dataSize, pixelSum, average, stdev);
+			convertPixels <FitsLong> (raw, data, npix);
 			break;
 		case RTS2_DATA_LONGLONG:
-			computeDataStatistics ((int64_t *) (getData ()) + _from, _dataSize, pixelSum, average, stdev);
+			convertPixels <FitsLongLong> (raw, data, npix);
 			break;
 		case RTS2_DATA_FLOAT:
-			computeDataStatistics ((float *) (getData ()) + _from, _dataSize, pixelSum, average, stdev);
+			convertPixels <FitsFloat> (raw, data, npix);
 			break;
 		case RTS2_DATA_DOUBLE:
-			computeDataStatistics ((double *) (getData ()) + _from, _dataSize, pixelSum, average, stdev);
+			convertPixels <FitsDouble> (raw, data, npix);
 			break;
 		case RTS2_DATA_SBYTE:
-			computeDataStatistics ((signed char *) (getData ()) + _from, _dataSize, pixelSum, average, stdev);
+			convertPixels <FitsSByte> (raw, data, npix);
 			break;
 		case RTS2_DATA_USHORT:
-			computeDataStatistics ((uint16_t *) (getData ()) + _from, _dataSize, pixelSum, average, stdev);
+			convertPixels <FitsUShort> (raw, data, npix);
 			break;
 		case RTS2_DATA_ULONG:
-			computeDataStatistics ((uint32_t *) (getData ()) + _from, _dataSize, pixelSum, average, stdev);
+			convertPixels <FitsULong> (raw, data, npix);
 			break;
 		default:
+			rts2core::BufferPool::instance ().release (pooled);
+			pooled = NULL;
+			data = NULL;
 			throw rts2core::Error ("unknow dataType");
 	}
 }
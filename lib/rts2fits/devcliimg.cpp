@@ -18,6 +18,7 @@
  */
 
 #include <ctype.h>
+#include <unistd.h>
 
 #include "rts2fits/devcliimg.h"
 #include "iniparser.h"
@@ -304,9 +305,17 @@ void DevClientCameraImage::allImageDataReceived (int data_conn, rts2core::DataCh
 		rts2core::DoubleArray *trim_x2 = getDoubleArray ("TRIM_X2");
 		rts2core::DoubleArray *trim_y2 = getDoubleArray ("TRIM_Y2");
 
-		for (rts2core::DataChannels::iterator di = data->begin (); di != data->end (); di++)
+		// channels are prepared and their statistics computed in parallel, FITS HDUs are written in channel order
+		std::vector <Channel *> added;
+		ci->image->addChannels (data, added, data->size () > 1 ? sysconf (_SC_NPROCESSORS_ONLN) : 1);
+
+		std::vector <Channel *>::iterator ai = added.begin ();
+		for (rts2core::DataChannels::iterator di = data->begin (); di != data->end (); di++, ai++)
 		{
-			ci->writeData ((*di)->getDataBuff (), (*di)->getDataTop (), data2fits ? data->size () : -data->size ());
+			if (*ai == NULL)
+				continue;
+
+			ci->writeChannel (*ai, (*di)->getDataBuff (), (*di)->getDataTop (), data2fits ? data->size () : -data->size ());
 
 			struct imghdr *imgh = (struct imghdr *) ((*di)->getDataBuff ());
 
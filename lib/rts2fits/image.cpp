@@ -20,6 +20,7 @@
 #include <libnova/libnova.h>
 
 #include "rts2fits/image.h"
+#include "bufferpool.h"
 #include "imghdr.h"
 
 #include "expander.h"
@@ -30,6 +31,7 @@
 #include "valuerectangle.h"
 
 #include "imgdisplay.h"
+#include "robuststat.h"
 
 #include <iomanip>
 #include <sstream>
@@ -37,9 +39,39 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <libgen.h>
+#include <unistd.h>
 
 using namespace rts2image;
 
+namespace rts2image
+{
+
+/**
+ * Creates channels from received data and computes their statistics, can run in multiple threads.
+ */
+class ChannelJob:public rts2core::StatJob
+{
+	public:
+		/**
+		 * @param shareData  channels keep reference to pool buffers of in_data instead of copying them
+		 */
+		ChannelJob (Image *_image, char **_in_data, char **_fullTop, size_t count, bool shareData = false);
+
+		virtual void run (size_t i);
+
+		std::vector <Channel *> added;
+
+	private:
+		char **in_data;
+		char **fullTop;
+		bool keepData;
+		bool shareData;
+		bool computeStat;
+		int pixelByteSize;
+};
+
+}
+
 // TODO remove this once Libnova 0.13.0 becomes mainstream
 #if !RTS2_HAVE_DECL_LN_GET_HELIOCENTRIC_TIME_DIFF
 double ln_get_heliocentric_time_diff (double JD, struct ln_equ_posn *object)
@@ -922,42 +954,89 @@ void Image::writeWCS (double mods[NUM_WCS_VALUES])
 	}
 }
 
-int Image::writeData (char *in_data, char *fullTop, int nchan)
+ChannelJob::ChannelJob (Image *_image, char **_in_data, char **_fullTop, size_t count, bool _shareData):added (count, (Channel *) NULL)
 {
-	struct imghdr *im_h = (struct imghdr *) in_data;
-	int ret;
+	in_data = _in_data;
+	fullTop = _fullTop;
+	keepData = _image->flags & IMAGE_KEEP_DATA;
+	shareData = _shareData;
+	// statistics are needed only when written to FITS header
+	computeStat = _image->writeRTS2Values && _image->getFitsFile () && (_image->flags & IMAGE_SAVE);
+	pixelByteSize = _image->getPixelByteSize ();
+}
+
+void ChannelJob::run (size_t i)
+{
+	if (in_data[i] == NULL)
+		return;
+
+	struct imghdr *im_h = (struct imghdr *) in_data[i];
+	int16_t dataType = ntohs (im_h->data_type);
 
+	long sizes[2];
+	sizes[0] = ntohl (im_h->sizes[0]);
+	sizes[1] = ntohl (im_h->sizes[1]);
+
+	long dataSize = (fullTop[i] - in_data[i]) - sizeof (struct imghdr);
+	char *pixelData = in_data[i] + sizeof (struct imghdr);
+
+	if (keepData && shareData && rts2core::BufferPool::instance ().owns (in_data[i]))
+		added[i] = new Channel (ntohs (im_h->channel), pixelData, in_data[i], 2, sizes, dataType);
+	else if (keepData)
+		added[i] = new Channel (ntohs (im_h->channel), pixelData, dataSize, 2, sizes, dataType);
+	else
+		added[i] = new Channel (ntohs (im_h->channel), pixelData, 2, sizes, dataType, false);
+
+	if (computeStat)
+		added[i]->computeStatistics (0, dataSize / pixelByteSize);
+}
+
+int Image::writeData (char *in_data, char *fullTop, int nchan)
+{
 	average = 0;
 	avg_stdev = 0;
 
 	// we have to copy data to FITS anyway, so let's do it right now..
-	if (im_h->naxes != 2)
-	{
-		logStream (MESSAGE_ERROR) << "Image::writeDate not 2D image " << im_h->naxes << sendLog;
+	if (!checkImageData (in_data))
 		return -1;
-	}
-	flags |= IMAGE_SAVE;
-	dataType = ntohs (im_h->data_type);
 
-	long sizes[2];
-	sizes[0] = ntohl (im_h->sizes[0]);
-	sizes[1] = ntohl (im_h->sizes[1]);
+	ChannelJob job (this, &in_data, &fullTop, 1);
+	job.run (0);
+	channels.push_back (job.added[0]);
 
-	long dataSize = (fullTop - in_data) - sizeof (struct imghdr);
-	char *pixelData = in_data + sizeof (struct imghdr);
+	return writeChannel (job.added[0], in_data, fullTop, nchan);
+}
 
-	Channel *ch;
+void Image::addChannels (rts2core::DataChannels *data, std::vector <Channel *> &added, int threads)
+{
+	average = 0;
+	avg_stdev = 0;
 
-	if (flags & IMAGE_KEEP_DATA)
+	std::vector <char *> in_data;
+	std::vector <char *> fullTop;
+	for (rts2core::DataChannels::iterator di = data->begin (); di != data->end (); di++)
 	{
-		ch = new Channel (ntohs (im_h->channel), pixelData, dataSize, 2, sizes, dataType);
+		// invalid data are not processed
+		in_data.push_back (checkImageData ((*di)->getDataBuff ()) ? (*di)->getDataBuff () : NULL);
+		fullTop.push_back ((*di)->getDataTop ());
 	}
-	else
+
+	// received data are not modified, channels can share them
+	ChannelJob job (this, &(in_data[0]), &(fullTop[0]), data->size (), true);
+	rts2core::runParallel (&job, data->size (), threads);
+
+	added = job.added;
+	for (std::vector <Channel *>::iterator iter = added.begin (); iter != added.end (); iter++)
 	{
-		ch = new Channel (ntohs (im_h->channel), pixelData, 2, sizes, dataType, false);
+		if (*iter)
+			channels.push_back (*iter);
 	}
+}
 
-	channels.push_back (ch);
+int Image::writeChannel (Channel *ch, char *in_data, char *fullTop, int nchan)
+{
+	struct imghdr *im_h = (struct imghdr *) in_data;
+	int ret;
 
 	if (!getFitsFile () || !(flags & IMAGE_SAVE))
 	{
@@ -967,6 +1046,15 @@ int Image::writeData (char *in_data, char *fullTop, int nchan)
 		return 0;
 	}
 
+	dataType = ch->getDataType ();
+
+	long sizes[2];
+	sizes[0] = ntohl (im_h->sizes[0]);
+	sizes[1] = ntohl (im_h->sizes[1]);
+
+	long dataSize = (fullTop - in_data) - sizeof (struct imghdr);
+	char *pixelData = in_data + sizeof (struct imghdr);
+
 	// either put it as a new extension, or keep it in primary..
 
 	if (nchan == 1)
@@ -1046,7 +1134,9 @@ int Image::writeData (char *in_data, char *fullTop, int nchan)
 
 	if (writeRTS2Values)
 	{
-		ch->computeStatistics (0, pixelSize);
+		// statistics are usually computed in addChannels
+		if (std::isnan (ch->getAverage ()))
+			ch->computeStatistics (0, pixelSize);
 
 		setValue ("AVERAGE", ch->getAverage (), "average value of image");
 		setValue ("STDEV", ch->getStDev (), "standard deviation value of image");
@@ -1054,6 +1144,19 @@ int Image::writeData (char *in_data, char *fullTop, int nchan)
 	return ret;
 }
 
+bool Image::checkImageData (char *in_data)
+{
+	struct imghdr *im_h = (struct imghdr *) in_data;
+	if (im_h->naxes != 2)
+	{
+		logStream (MESSAGE_ERROR) << "Image::writeDate not 2D image " << im_h->naxes << sendLog;
+		return false;
+	}
+	flags |= IMAGE_SAVE;
+	dataType = ntohs (im_h->data_type);
+	return true;
+}
+
 void Image::getImgHeader (struct imghdr *im_h, int chan)
 {
 	int i;
@@ -1954,54 +2057,6 @@ void Image::loadChannels ()
 		long sizes[naxis];
 		getValues ("NAXIS", sizes, naxis, true);
 
-		long pixelSize = sizes[0];
-		for (int i = 1; i < naxis; i++)
-			pixelSize *= sizes[i];
-
-		char *imageData = new char[pixelSize * getPixelByteSize ()];
-		switch (dataType)
-		{
-			case RTS2_DATA_BYTE:
-				fits_read_img_byt (getFitsFile (), 0, 1, pixelSize, 0, (unsigned char *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_SHORT:
-				fits_read_img_sht (getFitsFile (), 0, 1, pixelSize, 0, (int16_t *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_LONG:
-				fits_read_img_int (getFitsFile (), 0, 1, pixelSize, 0, (int *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_LONGLONG:
-				fits_read_img_lnglng (getFitsFile (), 0, 1, pixelSize, 0, (LONGLONG *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_FLOAT:
-				fits_read_img_flt (getFitsFile (), 0, 1, pixelSize, 0, (float *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_DOUBLE:
-				fits_read_img_dbl (getFitsFile (), 0, 1, pixelSize, 0, (double *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_SBYTE:
-				fits_read_img_sbyt (getFitsFile (), 0, 1, pixelSize, 0, (signed char *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_USHORT:
-				fits_read_img_usht (getFitsFile (), 0, 1, pixelSize, 0,(short unsigned int *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_ULONG:
-				fits_read_img_uint (getFitsFile (), 0, 1, pixelSize, 0, (unsigned int *) imageData, &anyNull, &fits_status);
-				break;
-			default:
-				logStream (MESSAGE_ERROR) << "Unknow dataType " << dataType << sendLog;
-				delete[] imageData;
-				dataType = 0;
-				throw ErrorOpeningFitsFile (getFileName ());
-		}
-		if (fits_status)
-		{
-			delete[] imageData;
-			dataType = 0;
-			throw ErrorOpeningFitsFile (getFileName ());
-		}
-		fitsStatusGetValue ("image loadChannels", true);
-
 		int ch;
 		try
 		{
@@ -2031,12 +2086,176 @@ void Image::loadChannels ()
 				ch = hdunum;
 			}
 		}
-		channels.push_back (new Channel (ch, imageData, naxis, sizes, dataType, true));
+
+		Channel *channel = NULL;
+		if (flags & IMAGE_MMAP)
+			channel = mapChannel (ch, naxis, sizes);
+
+		if (channel == NULL)
+		{
+			long pixelSize = sizes[0];
+			for (int i = 1; i < naxis; i++)
+				pixelSize *= sizes[i];
+
+			char *imageData = new char[pixelSize * getPixelByteSize ()];
+			switch (dataType)
+			{
+				case RTS2_DATA_BYTE:
+					fits_read_img_byt (getFitsFile (), 0, 1, pixelSize, 0, (unsigned char *) imageData, &anyNull, &fits_status);
+					break;
+				case RTS2_DATA_SHORT:
+					fits_read_img_sht (getFitsFile (), 0, 1, pixelSize, 0, (int16_t *) imageData, &anyNull, &fits_status);
+					break;
+				case RTS2_DATA_LONG:
+					fits_read_img_int (getFitsFile (), 0, 1, pixelSize, 0, (int *) imageData, &anyNull, &fits_status);
+					break;
+				case RTS2_DATA_LONGLONG:
+					fits_read_img_lnglng (getFitsFile (), 0, 1, pixelSize, 0, (LONGLONG *) imageData, &anyNull, &fits_status);
+					break;
+				case RTS2_DATA_FLOAT:
+					fits_read_img_flt (getFitsFile (), 0, 1, pixelSize, 0, (float *) imageData, &anyNull, &fits_status);
+					break;
+				case RTS2_DATA_DOUBLE:
+					fits_read_img_dbl (getFitsFile (), 0, 1, pixelSize, 0, (double *) imageData, &anyNull, &fits_status);
+					break;
+				case RTS2_DATA_SBYTE:
+					fits_read_img_sbyt (getFitsFile (), 0, 1, pixelSize, 0, (signed char *) imageData, &anyNull, &fits_status);
+					break;
+				case RTS2_DATA_USHORT:
+					fits_read_img_usht (getFitsFile (), 0, 1, pixelSize, 0,(short unsigned int *) imageData, &anyNull, &fits_status);
+					break;
+				case RTS2_DATA_ULONG:
+					fits_read_img_uint (getFitsFile (), 0, 1, pixelSize, 0, (unsigned int *) imageData, &anyNull, &fits_status);
+					break;
+				default:
+					logStream (MESSAGE_ERROR) << "Unknow dataType " << dataType << sendLog;
+					delete[] imageData;
+					dataType = 0;
+					throw ErrorOpeningFitsFile (getFileName ());
+			}
+			if (fits_status)
+			{
+				delete[] imageData;
+				dataType = 0;
+				throw ErrorOpeningFitsFile (getFileName ());
+			}
+			fitsStatusGetValue ("image loadChannels", true);
+			channel = new Channel (ch, imageData, naxis, sizes, dataType, true);
+		}
+		channels.push_back (channel);
 		hdunum++;
 	}
 	moveHDU (1);
 }
 
+Channel *Image::mapChannel (int ch, int naxis, long *sizes)
+{
+	if (isMemImage () || getFileName () == NULL)
+		return NULL;
+
+	// file might be modified, data unit moved, if opened for writing
+	int mode;
+	int status = 0;
+	fits_file_mode (getFitsFile (), &mode, &status);
+	if (status || mode != READONLY)
+		return NULL;
+
+	if (fits_is_compressed_image (getFitsFile (), &status) || status)
+		return NULL;
+
+	// tile compressed HDU, even if CFITSIO does not recognize it as such
+	int zimage = 0;
+	fits_read_key (getFitsFile (), TLOGICAL, "ZIMAGE", &zimage, NULL, &status);
+	if (status == KEY_NO_EXIST)
+		status = 0;
+	char zcmptype[FLEN_VALUE];
+	fits_read_key (getFitsFile (), TSTRING, "ZCMPTYPE", zcmptype, NULL, &status);
+	if (status == KEY_NO_EXIST)
+		status = 0;
+	else if (status == 0)
+		return NULL;
+	if (status || zimage)
+		return NULL;
+
+	// pixels must be stored as they are, or with standard BZERO offset for unsigned types
+	int bitpix;
+	fits_get_img_type (getFitsFile (), &bitpix, &status);
+	if (status)
+		return NULL;
+
+	double bscale = 1;
+	double bzero = 0;
+	fits_read_key (getFitsFile (), TDOUBLE, "BSCALE", &bscale, NULL, &status);
+	if (status == KEY_NO_EXIST)
+		status = 0;
+	fits_read_key (getFitsFile (), TDOUBLE, "BZERO", &bzero, NULL, &status);
+	if (status == KEY_NO_EXIST)
+		status = 0;
+	if (status || bscale != 1)
+		return NULL;
+
+	switch (dataType)
+	{
+		case RTS2_DATA_SBYTE:
+			if (bitpix != BYTE_IMG || bzero != -128)
+				return NULL;
+			break;
+		case RTS2_DATA_USHORT:
+			if (bitpix != SHORT_IMG || bzero != 32768)
+				return NULL;
+			break;
+		case RTS2_DATA_ULONG:
+			if (bitpix != LONG_IMG || bzero != 2147483648.0)
+				return NULL;
+			break;
+		default:
+			if (bitpix != dataType || bzero != 0)
+				return NULL;
+	}
+
+	LONGLONG headstart, datastart, dataend;
+	fits_get_hduaddrll (getFitsFile (), &headstart, &datastart, &dataend, &status);
+	if (status)
+		return NULL;
+
+	int fd = open (getFileName (), O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	long pixelSize = sizes[0];
+	for (int i = 1; i < naxis; i++)
+		pixelSize *= sizes[i];
+
+	// do not map truncated files, nor files other users can change
+	struct stat st;
+	if (fstat (fd, &st) || st.st_size < datastart + pixelSize * getPixelByteSize () || st.st_uid != geteuid ())
+	{
+		close (fd);
+		return NULL;
+	}
+
+	// files compressed as a whole (.fits.gz,..) are uncompressed by CFITSIO, HDU addresses are not file offsets
+	char magic[6];
+	if (pread (fd, magic, sizeof (magic), 0) != sizeof (magic) || memcmp (magic, "SIMPLE", sizeof (magic)))
+	{
+		close (fd);
+		return NULL;
+	}
+
+	Channel *ret = NULL;
+	try
+	{
+		// mapping stays valid after the file is closed
+		ret = new Channel (ch, fd, datastart, naxis, sizes, dataType);
+	}
+	catch (rts2core::Error &er)
+	{
+		logStream (MESSAGE_DEBUG) << getFileName () << ": " << er << sendLog;
+	}
+	close (fd);
+	return ret;
+}
+
 const void* Image::getChannelData (int chan)
 {
 	if (channels.size () == 0)
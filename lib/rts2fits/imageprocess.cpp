@@ -7,6 +7,7 @@
 #include <functional>
 
 #include "rts2fits/image.h"
+#include "robuststat.h"
 
 #define APP_SIZE        3
 
@@ -43,46 +44,12 @@ class comparePint
 
 using namespace rts2image;
 
-static int cmpdouble (const void *a, const void *b)
-{
-	if (*((double *) a) > *((double *) b))
-		return 1;
-	if (*((double *) a) < *((double *) b))
-		return -1;
-	return 0;
-}
-
 double Image::classicMedian (double *q, int n, double *retsigma)
 {
-	int i;
-	double *f, M, S;
-
-	f = (double *) malloc (n * sizeof (double));
-
-	memcpy (f, q, n * sizeof (double));
-	qsort (f, n, sizeof (double), cmpdouble);
-
-	if (n % 2)
-		M = f[n / 2];
-	else
-		M = f[n / 2] / 2 + f[n / 2 + 1] / 2;
-
+	double mad;
+	double M = rts2core::robustMedian (q, n, &mad);
 	if (retsigma)
-	{
-		for (i = 0; i < n; i++)
-			f[i] = fabs (f[i] - M) * 0.6745;
-
-		qsort (f, n, sizeof (double), cmpdouble);
-
-		if (n % 2)
-			S = f[n / 2];
-		else
-			S = f[n / 2] / 2 + f[n / 2 + 1] / 2;
-
-		*retsigma = S;
-	}
-	free (f);
-
+		*retsigma = mad * 0.6745;
 	return M;
 }
 
@@ -233,6 +233,8 @@ void JpegImageRequest::authorizedExecute (XmlRpc::XmlRpcSource *source, std::str
 {
 	response_type = "image/jpeg";
 	rts2image::Image image;
+	// preview only reads pixels, share them with page cache
+	image.setMapChannels (true);
 	image.openFile (path.c_str (), true, false);
 	Blob blob;
 
@@ -280,6 +282,7 @@ void JpegPreview::authorizedExecute (XmlRpc::XmlRpcSource *source, std::string p
 		response_type = "image/jpeg";
 
 		rts2image::Image image;
+		image.setMapChannels (true);
 		image.openFile (absPath, true, false);
 		Blob blob;
 
@@ -164,15 +164,26 @@ int ConnImgProcess::newProcess ()
 
 void ConnImgProcess::connectionError (int last_data_size)
 {
-	const char *telescopeName;
-	int corr_mark, corr_img;
-
 	if (last_data_size < 0 && errno == EAGAIN)
 	{
 		logStream (MESSAGE_DEBUG) << "ConnImgProcess::connectionError " << strerror (errno) << " #" << errno << " last_data_size " << last_data_size << sendLog;
 		return;
 	}
 
+#ifdef RTS2_HAVE_LIBJPEG
+	astrometryStat = rts2plan::processAstrometryResult (master, imgPath, astrometryStat, ra, dec, ra_err, dec_err, end_event, last_good_jpeg, last_trash_jpeg);
+#else
+	astrometryStat = rts2plan::processAstrometryResult (master, imgPath, astrometryStat, ra, dec, ra_err, dec_err, end_event);
+#endif
+
+	ConnImgOnlyProcess::connectionError (last_data_size);
+}
+
+astrometry_stat_t rts2plan::processAstrometryResult (rts2core::Block *master, const std::string &imgPath, astrometry_stat_t astrometryStat, double ra, double dec, double ra_err, double dec_err, int end_event, const char *last_good_jpeg, const char *last_trash_jpeg)
+{
+	const char *telescopeName;
+	int corr_mark, corr_img;
+
 #ifdef RTS2_HAVE_PGSQL
 	ImageDb *image;
 	try
@@ -195,8 +206,7 @@ void ConnImgProcess::connectionError (int last_data_size)
 			else
 			  	astrometryStat = DARK;
 			delete image;
-			ConnImgOnlyProcess::connectionError (last_data_size);
-			return;
+			return astrometryStat;
 		}
 
 		switch (astrometryStat)
@@ -275,45 +285,45 @@ void ConnImgProcess::connectionError (int last_data_size)
 	catch (rts2core::Error &er)
 	{
 		logStream (MESSAGE_ERROR) << "Processing " << imgPath << ": " << er << sendLog;
-		//delete image;
-		// move file to bad directory..
+		rts2plan::moveToBad (imgPath);
+		return BAD;
+	}
 
-		int i = 0;
-	
-		for (std::string::iterator iter = imgPath.end () - 1; iter != imgPath.begin (); iter--)
+	return astrometryStat;
+}
+
+void rts2plan::moveToBad (const std::string &imgPath)
+{
+	int i = 0;
+
+	for (std::string::const_iterator iter = imgPath.end () - 1; iter != imgPath.begin (); iter--)
+	{
+		if (*iter == '/')
 		{
-			if (*iter == '/')
-			{
-				i = iter - imgPath.begin ();
-				break;
-			}
+			i = iter - imgPath.begin ();
+			break;
 		}
+	}
 
-		std::string newPath = imgPath.substr (0, i) + std::string ("/bad/") + imgPath.substr (i + 1);
+	std::string newPath = imgPath.substr (0, i) + std::string ("/bad/") + imgPath.substr (i + 1);
 
-		int ret = mkpath (newPath.c_str (), 0777);
+	int ret = mkpath (newPath.c_str (), 0777);
+	if (ret)
+	{
+		logStream (MESSAGE_ERROR) << "Cannot create path for file: " << newPath << ":" << strerror (errno) << sendLog;
+	}
+	else
+	{
+		ret = rename (imgPath.c_str (), newPath.c_str ());
 		if (ret)
 		{
-			logStream (MESSAGE_ERROR) << "Cannot create path for file: " << newPath << ":" << strerror (errno) << sendLog;
+			logStream (MESSAGE_ERROR) << "Cannot rename " << imgPath << " to " << newPath << ":" << strerror(errno) << sendLog;
 		}
 		else
 		{
-			ret = rename (imgPath.c_str (), newPath.c_str ());
-			if (ret)
-			{
-				logStream (MESSAGE_ERROR) << "Cannot rename " << imgPath << " to " << newPath << ":" << strerror(errno) << sendLog;
-			}
-			else
-			{
-				logStream (MESSAGE_INFO) << "Renamed " << imgPath << " to " << newPath << sendLog;
-			}
+			logStream (MESSAGE_INFO) << "Renamed " << imgPath << " to " << newPath << sendLog;
 		}
-		astrometryStat = BAD;
-		ConnImgOnlyProcess::connectionError (last_data_size);
-		return;
 	}
-
-	ConnImgOnlyProcess::connectionError (last_data_size);
 }
 
 void ConnImgOnlyProcess::checkAstrometry ()
@@ -57,7 +57,7 @@ QueuedTarget::QueuedTarget (unsigned int _queue_id, unsigned int _qid, struct ln
 class sortQuedTargetByAltitude:public rts2db::sortByAltitude
 {
 	public:
-		sortQuedTargetByAltitude (struct ln_lnlat_posn *_observer = NULL, double _jd = NAN):rts2db::sortByAltitude (_observer, _jd) {}
+		sortQuedTargetByAltitude (rts2db::PositionCache *_cache):rts2db::sortByAltitude (NULL, NAN, _cache) {}
 		bool operator () (QueuedTarget &tar1, QueuedTarget &tar2) { return doSort (tar1.target, tar2.target); }
 };
 
@@ -67,7 +67,7 @@ class sortQuedTargetByAltitude:public rts2db::sortByAltitude
 class sortQuedTargetWestEast:public rts2db::sortWestEast
 {
 	public:
-		sortQuedTargetWestEast (struct ln_lnlat_posn *_observer = NULL, double _jd = NAN):rts2db::sortWestEast (_observer, _jd) {};
+		sortQuedTargetWestEast (rts2db::PositionCache *_cache):rts2db::sortWestEast (NULL, NAN, _cache) {};
 		bool operator () (QueuedTarget &tar1, QueuedTarget &tar2) { return doSort (tar1.target, tar2.target); }
 };
 
@@ -77,7 +77,7 @@ class sortQuedTargetWestEast:public rts2db::sortWestEast
 class sortByMeridianPriority:public rts2db::sortWestEast
 {
 	public:
-		sortByMeridianPriority (struct ln_lnlat_posn *_observer, double jd):rts2db::sortWestEast (_observer, jd) {};
+		sortByMeridianPriority (rts2db::PositionCache *_cache):rts2db::sortWestEast (NULL, NAN, _cache) {};
 		bool operator () (rts2db::Target *tar1, rts2db::Target *tar2) { return doSort (tar1, tar2); }
 	protected:
 		bool doSort (rts2db::Target *tar1, rts2db::Target *tar2);
@@ -85,14 +85,11 @@ class sortByMeridianPriority:public rts2db::sortWestEast
 
 bool sortByMeridianPriority::doSort (rts2db::Target *tar1, rts2db::Target *tar2)
 {
+	rts2db::TargetPosition &pos1 = cache->getPosition (tar1);
+	rts2db::TargetPosition &pos2 = cache->getPosition (tar2);
 	// if both targets did not yet pass meridian, pick the highest
-	if (tar1->getHourAngle (JD, observer) < 0 && tar2->getHourAngle (JD, observer) < 0)
-	{
-		struct ln_hrz_posn hr1, hr2;
-		tar1->getAltAz (&hr1, JD, observer);
-		tar2->getAltAz (&hr2, JD, observer);
-		return hr1.alt > hr2.alt;
-	}	
+	if (pos1.ha < 0 && pos2.ha < 0)
+		return pos1.hrz.alt > pos2.hrz.alt;
 	if (tar1->getTargetPriority () == tar2->getTargetPriority ())
 		return sortWestEast::doSort (tar1, tar2);
 	else
@@ -106,7 +103,7 @@ bool sortByMeridianPriority::doSort (rts2db::Target *tar1, rts2db::Target *tar2)
 class sortByOutOfLimits:public rts2db::sortWestEast
 {
 	public:
-		sortByOutOfLimits (struct ln_lnlat_posn *_observer, double jd):rts2db::sortWestEast (_observer, jd) {};
+		sortByOutOfLimits (rts2db::PositionCache *_cache):rts2db::sortWestEast (NULL, NAN, _cache) {};
 		bool operator () (rts2db::Target *tar1, rts2db::Target *tar2) { return doSort (tar1, tar2); }
 	protected:
 		bool doSort (rts2db::Target *tar1, rts2db::Target *tar2);
@@ -114,13 +111,8 @@ class sortByOutOfLimits:public rts2db::sortWestEast
 
 bool sortByOutOfLimits::doSort (rts2db::Target *tar1, rts2db::Target *tar2)
 {
-	time_t t_from;
-	ln_get_timet_from_julian (JD, &t_from);
-	double from = t_from;
-
-	double v1 = tar1->getSatisfiedDuration (from, from + 86400, 0, 60);
-	double v2 = tar2->getSatisfiedDuration (from, from + 86400, 0, 60);
-	std::cout << "sorting " << tar1->getTargetName () << " " << v1 << " 2: " << tar2->getTargetName () << " " << v2 << std::endl;
+	double v1 = cache->getSatisfiedDuration (tar1);
+	double v2 = cache->getSatisfiedDuration (tar2);
 	if ((std::isnan (v1) && std::isnan (v2)) || (std::isinf (v1) && std::isinf (v2)))
 	{
 		// if both are not visible, order west-east..
@@ -210,10 +202,18 @@ void TargetQueue::sortQueue (double now)
 		case QUEUE_CIRCULAR:
 			break;
 		case QUEUE_HIGHEST:
-			sort (sortQuedTargetByAltitude (*observer, now_JD));
+			{
+				rts2db::PositionCache cache (*observer, now_JD);
+				precomputePositions (cache);
+				sort (sortQuedTargetByAltitude (&cache));
+			}
 			break;
 		case QUEUE_WESTEAST:
-			sort (sortQuedTargetWestEast (*observer, now_JD));
+			{
+				rts2db::PositionCache cache (*observer, now_JD);
+				precomputePositions (cache);
+				sort (sortQuedTargetWestEast (&cache));
+			}
 			break;
 		case QUEUE_WESTEAST_MERIDIAN:
 			sortWestEastMeridian (now_JD);
@@ -295,6 +295,14 @@ void TargetQueue::orderByTargetList (std::list <rts2db::Target *> tl)
 	}
 }
 
+void TargetQueue::precomputePositions (rts2db::PositionCache &cache)
+{
+	std::vector <rts2db::Target *> targets;
+	for (TargetQueue::iterator ti = begin (); ti != end (); ti++)
+		targets.push_back (ti->target);
+	cache.precompute (targets);
+}
+
 void TargetQueue::sortWestEastMeridian (double jd)
 {
 	std::list < rts2db::Target *> preparedTargets;  
@@ -303,10 +311,14 @@ void TargetQueue::sortWestEastMeridian (double jd)
 	{
 		preparedTargets.push_back (ti->target);
 	}
+	// shared by sorts for the same JD
+	rts2db::PositionCache cache (*observer, jd);
 	while (!preparedTargets.empty ())
 	{
+		cache.setJD (jd);
+		cache.precompute (preparedTargets.begin (), preparedTargets.end ());
 		// find maximal priority in targets, and order by HA..
-		preparedTargets.sort (sortByMeridianPriority (*observer, jd));
+		preparedTargets.sort (sortByMeridianPriority (&cache));
 		// now find the first target which is on west (for HA + its duration).
 		std::list < rts2db::Target *>::iterator iter;
 
@@ -354,11 +366,15 @@ void TargetQueue::sortOutOfLimits (double jd)
 	{
 		preparedTargets.push_back (ti->target);
 	}
+	// shared by sorts for the same JD
+	rts2db::PositionCache cache (*observer, jd);
 	while (!preparedTargets.empty ())
 	{
+		cache.setJD (jd);
+		cache.precompute (preparedTargets.begin (), preparedTargets.end ());
 		std::cout << "sorting by out of limits" << std::endl;
 		// find maximal priority in targets, and order by HA..
-		preparedTargets.sort (sortByOutOfLimits (*observer, jd));
+		preparedTargets.sort (sortByOutOfLimits (&cache));
 		std::cout << "sorting finished" << std::endl;
 		// now find the first target which is on west (for HA + its duration).
 		std::list < rts2db::Target *>::iterator iter;
@@ -857,6 +873,86 @@ int ExecutorQueue::selectNextSimulation (SimulQueueTargets &sq, double from, dou
 	return -1;
 }
 
+void ExecutorQueue::fillSimulation (NightSimulator &sim, SimPolicy &policy)
+{
+	policy.queueType = getQueueType ();
+	policy.removeAfterExecution = getRemoveAfterExecution ();
+	policy.skipBelowHorizon = getSkipBelowHorizon ();
+	policy.blockUntilVisible = getBlockUntilVisible ();
+	policy.requests.clear ();
+
+	time_t tm = (sim.getFrom () + sim.getTo ()) / 2;
+	double JD = ln_get_julian_from_timet (&tm);
+
+	for (ExecutorQueue::iterator iter = begin (); iter != end (); iter++)
+	{
+		int ti = sim.findTarget (iter->target->getTargetID ());
+		if (ti < 0)
+		{
+			struct ln_equ_posn pos;
+			iter->target->getPosition (&pos, JD);
+			double md = getMaximalDuration (iter->target);
+			if (std::isnan (md))
+				md = 0;
+			ti = sim.addTarget (SimTarget (iter->target->getTargetID (), iter->target->getTargetName (), pos.ra, pos.dec, md));
+		}
+		policy.requests.push_back (SimRequest (ti, iter->t_start, iter->t_end, iter->rep_n, iter->rep_separation));
+	}
+}
+
+NightSimulator *ExecutorQueue::prepareVariants (double from, double to, const std::vector <int> &queueTypes, std::vector <SimPolicy> &policies)
+{
+	NightSimulator *sim = new NightSimulator (*observer, from, to);
+	SimPolicy base (queueType->getSelName (), getQueueType ());
+
+	try
+	{
+		fillSimulation (*sim, base);
+		// visibility is set below from target horizon
+		sim->precompute (-90);
+
+		std::vector <bool> done (sim->getTargetCount (), false);
+		for (ExecutorQueue::iterator iter = begin (); iter != end (); iter++)
+		{
+			int ti = sim->findTarget (iter->target->getTargetID ());
+			if (ti < 0 || done[ti])
+				continue;
+			done[ti] = true;
+			for (size_t s = 0; s < sim->getSteps (); s++)
+			{
+				time_t tm = sim->getStepTime (s);
+				double JD = ln_get_julian_from_timet (&tm);
+				struct ln_hrz_posn hrz;
+				iter->target->getAltAz (&hrz, JD, *observer);
+				rts2db::ConstraintsList violated;
+				sim->setVisible (ti, s, iter->target->isAboveHorizon (&hrz) && (!getTestConstraints () || iter->target->getViolatedConstraints (JD, violated) == 0));
+			}
+		}
+	}
+	catch (rts2core::Error &er)
+	{
+		delete sim;
+		throw;
+	}
+
+	policies.clear ();
+	for (std::vector <int>::const_iterator iter = queueTypes.begin (); iter != queueTypes.end (); iter++)
+	{
+		policies.push_back (base);
+		policies.back ().queueType = *iter;
+		policies.back ().name = std::string (queueType->getSelName (*iter));
+	}
+	return sim;
+}
+
+void ExecutorQueue::simulateVariants (double from, double to, const std::vector <int> &queueTypes, std::vector <SimTimeline> &timelines, rts2core::ThreadPool *pool)
+{
+	std::vector <SimPolicy> policies;
+	NightSimulator *sim = prepareVariants (from, to, queueTypes, policies);
+	sim->runParallel (policies, timelines, pool);
+	delete sim;
+}
+
 int ExecutorQueue::queueFromConn (rts2core::Connection *conn, int index, bool withTimes, bool tryFirstPossible, double n_start, bool withNRep)
 {
 	double t_start = NAN;
@@ -0,0 +1,408 @@
+/*
+ * Fast-forward night simulation engine.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "rts2script/nightsim.h"
+#include "threadpool.h"
+
+#include <list>
+
+#include <libnova/sidereal_time.h>
+#include <libnova/utility.h>
+
+using namespace rts2plan;
+
+namespace
+{
+
+/**
+ * Queue entry during simulation.
+ */
+struct SimEntry
+{
+	int request;
+	int target;
+	double t_start;
+	double t_end;
+	int rep_n;
+	double rep_separation;
+	bool started;
+};
+
+typedef std::list <SimEntry> EntryList;
+
+class sortSimByAltitude
+{
+	public:
+		sortSimByAltitude (const NightSimulator *_sim, double _t):sim (_sim), t (_t) {}
+		bool operator () (const SimEntry &e1, const SimEntry &e2) { return sim->getAltitude (e1.target, t) > sim->getAltitude (e2.target, t); }
+	private:
+		const NightSimulator *sim;
+		double t;
+};
+
+/**
+ * Visible targets first, then from west to east.
+ */
+class sortSimWestEast
+{
+	public:
+		sortSimWestEast (const NightSimulator *_sim, double _t):sim (_sim), t (_t) {}
+		bool operator () (const SimEntry &e1, const SimEntry &e2)
+		{
+			bool v1 = sim->isVisible (e1.target, t);
+			bool v2 = sim->isVisible (e2.target, t);
+			if (v1 != v2)
+				return v1;
+			return sim->getHourAngle (e1.target, t) > sim->getHourAngle (e2.target, t);
+		}
+	private:
+		const NightSimulator *sim;
+		double t;
+};
+
+/**
+ * Simulates single queue variant on a pool thread.
+ */
+class SimVariantTask:public rts2core::PoolTask
+{
+	public:
+		SimVariantTask (const NightSimulator *_sim, const SimPolicy &_policy, SimTimeline &_timeline):rts2core::PoolTask (), policy (_policy), timeline (_timeline) { sim = _sim; }
+
+		virtual void run () { sim->run (policy, timeline); }
+
+	private:
+		const NightSimulator *sim;
+		const SimPolicy &policy;
+		SimTimeline &timeline;
+};
+
+}
+
+SimTarget::SimTarget (int _tar_id, const char *_name, double _ra, double _dec, double _duration)
+{
+	tar_id = _tar_id;
+	name = std::string (_name);
+	ra = _ra;
+	dec = _dec;
+	duration = _duration;
+}
+
+SimRequest::SimRequest (int _target, double _t_start, double _t_end, int _rep_n, double _rep_separation)
+{
+	target = _target;
+	t_start = _t_start;
+	t_end = _t_end;
+	rep_n = _rep_n;
+	rep_separation = _rep_separation;
+}
+
+SimPolicy::SimPolicy (const char *_name, int _queueType)
+{
+	name = std::string (_name);
+	queueType = _queueType;
+	removeAfterExecution = true;
+	skipBelowHorizon = false;
+	blockUntilVisible = false;
+}
+
+NightSimulator::NightSimulator (struct ln_lnlat_posn *_observer, double _from, double _to, double _step)
+{
+	observer = *_observer;
+	from = _from;
+	to = _to;
+	step = _step;
+	steps = (size_t) ceil ((to - from) / step);
+	if (steps == 0)
+		steps = 1;
+}
+
+int NightSimulator::addTarget (const SimTarget &target)
+{
+	int ret = findTarget (target.tar_id);
+	if (ret >= 0)
+		return ret;
+	targets.push_back (target);
+	return targets.size () - 1;
+}
+
+int NightSimulator::findTarget (int tar_id)
+{
+	for (size_t i = 0; i < targets.size (); i++)
+	{
+		if (targets[i].tar_id == tar_id)
+			return i;
+	}
+	return -1;
+}
+
+void NightSimulator::precompute (double minAlt)
+{
+	alt.resize (targets.size () * steps);
+	ha.resize (targets.size () * steps);
+	visible.resize (targets.size () * steps);
+
+	// local sidereal time of grid steps, in degrees
+	std::vector <double> lst (steps);
+	for (size_t s = 0; s < steps; s++)
+		lst[s] = ln_get_mean_sidereal_time (getStepTime (s) / 86400.0 + 2440587.5) * 15.0 + observer.lng;
+
+	double sin_lat = sin (ln_deg_to_rad (observer.lat));
+	double cos_lat = cos (ln_deg_to_rad (observer.lat));
+
+	for (size_t i = 0; i < targets.size (); i++)
+	{
+		double sin_dec = sin (ln_deg_to_rad (targets[i].dec));
+		double cos_dec = cos (ln_deg_to_rad (targets[i].dec));
+		size_t b = i * steps;
+		for (size_t s = 0; s < steps; s++)
+		{
+			double h = ln_range_degrees (lst[s] - targets[i].ra);
+			if (h > 180)
+				h -= 360;
+			double a = ln_rad_to_deg (asin (sin_lat * sin_dec + cos_lat * cos_dec * cos (ln_deg_to_rad (h))));
+			ha[b + s] = h;
+			alt[b + s] = a;
+			visible[b + s] = a >= minAlt;
+		}
+	}
+}
+
+bool NightSimulator::isVisible (int target, double t) const
+{
+	if (t < from || t >= to)
+		return false;
+	return visible[target * steps + getStep (t)];
+}
+
+double NightSimulator::visibleUntil (int target, double t) const
+{
+	size_t s = getStep (t);
+	const char *v = &(visible[target * steps]);
+	while (s < steps && v[s])
+		s++;
+	return s >= steps ? to : getStepTime (s);
+}
+
+double NightSimulator::nextVisible (int target, double t) const
+{
+	if (t >= to)
+		return NAN;
+	size_t s = 0;
+	if (t > from)
+		s = (size_t) ceil ((t - from) / step);
+	const char *v = &(visible[target * steps]);
+	for (; s < steps; s++)
+	{
+		if (v[s])
+			return getStepTime (s);
+	}
+	return NAN;
+}
+
+void NightSimulator::run (const SimPolicy &policy, SimTimeline &timeline) const
+{
+	EntryList q;
+	for (size_t i = 0; i < policy.requests.size (); i++)
+	{
+		const SimRequest &r = policy.requests[i];
+		SimEntry e = {(int) i, r.target, r.t_start, r.t_end, r.rep_n, r.rep_separation, false};
+		q.push_back (e);
+	}
+
+	timeline.clear ();
+
+	double t = from;
+	while (t < to && !q.empty ())
+	{
+		// remove expired entries, see TargetQueue::filterExpired
+		if (policy.queueType == QUEUE_FIFO)
+		{
+			for (EntryList::iterator iter = q.begin (); iter != q.end (); iter++)
+			{
+				if ((!isnan (iter->t_start) && iter->t_start <= t) || (!isnan (iter->t_end) && iter->t_end <= t))
+					iter = q.erase (q.begin (), iter);
+			}
+		}
+		for (EntryList::iterator iter = q.begin (); iter != q.end ();)
+		{
+			if ((!isnan (iter->t_end) && iter->t_end <= t) || (iter->started && policy.removeAfterExecution))
+				iter = q.erase (iter);
+			else
+				iter++;
+		}
+
+		// sort queue, see TargetQueue::sortQueue
+		switch (policy.queueType)
+		{
+			case QUEUE_HIGHEST:
+				q.sort (sortSimByAltitude (this, t));
+				break;
+			case QUEUE_WESTEAST:
+			case QUEUE_WESTEAST_MERIDIAN:
+			case QUEUE_OUT_OF_LIMITS:
+				q.sort (sortSimWestEast (this, t));
+				break;
+		}
+
+		// skip or remove unobservable entries, see TargetQueue::filterUnobservable
+		if (policy.blockUntilVisible == false)
+		{
+			EntryList skipped;
+			for (EntryList::iterator iter = q.begin (); iter != q.end ();)
+			{
+				bool shift_circular = policy.queueType == QUEUE_CIRCULAR && !isnan (iter->t_start) && iter->t_start > t;
+				if (!shift_circular && isVisible (iter->target, (!isnan (iter->t_start) && iter->t_start > t) ? iter->t_start : t))
+					break;
+				if (policy.skipBelowHorizon || shift_circular)
+				{
+					if (policy.queueType != QUEUE_CIRCULAR && !(isnan (iter->t_start) && isnan (iter->t_end)) && iter->started)
+					{
+						iter = q.erase (iter);
+						continue;
+					}
+					skipped.push_back (*iter);
+				}
+				iter = q.erase (iter);
+			}
+			EntryList::iterator it = q.begin ();
+			if (!q.empty () && (isnan (q.front ().t_start) || q.front ().t_start <= t))
+				it++;
+			q.splice (it, skipped);
+		}
+
+		if (q.empty ())
+			break;
+
+		// select front entry, see ExecutorQueue::selectNextSimulation
+		SimEntry &f = q.front ();
+		double md = targets[f.target].duration;
+		double vt = (!isnan (f.t_start) && f.t_start > t) ? f.t_start : t;
+		bool notExpired = (isnan (f.t_start) || f.t_start <= t) && (isnan (f.t_end) || f.t_end > t);
+		if (isVisible (f.target, vt) && notExpired && t + md < to)
+		{
+			double e_end;
+			if (policy.removeAfterExecution)
+				e_end = t + md;
+			else if (!isnan (f.t_end))
+				e_end = f.t_end;
+			else
+				e_end = visibleUntil (f.target, t);
+			if (e_end > to)
+				e_end = to;
+
+			SimObservation o = {targets[f.target].tar_id, f.request, t, e_end};
+			timeline.push_back (o);
+
+			f.started = true;
+			t = e_end > t ? e_end : t + step;
+
+			// requeue repeated entries, see TargetQueue::beforeChange
+			if (policy.queueType == QUEUE_CIRCULAR || f.rep_n > 1)
+			{
+				SimEntry n = f;
+				if (n.rep_n > 0)
+				{
+					n.rep_n--;
+					if (!isnan (n.rep_separation))
+						n.t_start = t + n.rep_separation;
+				}
+				n.started = false;
+				q.pop_front ();
+				q.push_back (n);
+			}
+			continue;
+		}
+
+		// fast-forward to the next time when queue can change
+		double next = NAN;
+		bool anyVisible = false;
+		for (EntryList::iterator iter = q.begin (); iter != q.end (); iter++)
+		{
+			if (!isnan (iter->t_start) && iter->t_start > t && (isnan (next) || iter->t_start < next))
+				next = iter->t_start;
+			if (!isnan (iter->t_end) && iter->t_end > t && (isnan (next) || iter->t_end < next))
+				next = iter->t_end;
+			if (isVisible (iter->target, t))
+			{
+				anyVisible = true;
+				continue;
+			}
+			double nv = nextVisible (iter->target, t + step / 2.0);
+			if (!isnan (nv) && (isnan (next) || nv < next))
+				next = nv;
+		}
+		// ordering of visible targets changes with time, so only single step can be done
+		if (anyVisible && policy.queueType != QUEUE_FIFO && policy.queueType != QUEUE_CIRCULAR)
+			next = t + step;
+		if (isnan (next) || next <= t)
+			next = anyVisible ? t + step : to;
+		t = next;
+	}
+}
+
+void NightSimulator::runParallel (const std::vector <SimPolicy> &policies, std::vector <SimTimeline> &timelines, rts2core::ThreadPool *pool) const
+{
+	timelines.resize (policies.size ());
+
+	rts2core::ThreadPool *tmpPool = NULL;
+	if (pool == NULL && policies.size () > 1)
+	{
+		tmpPool = new rts2core::ThreadPool (policies.size ());
+		if (tmpPool->start ())
+		{
+			delete tmpPool;
+			tmpPool = NULL;
+		}
+		pool = tmpPool;
+	}
+	// run in the calling thread if pool cannot be started
+	if (pool == NULL)
+	{
+		for (size_t i = 0; i < policies.size (); i++)
+			run (policies[i], timelines[i]);
+		return;
+	}
+
+	std::vector <SimVariantTask *> tasks;
+	for (size_t i = 0; i < policies.size (); i++)
+	{
+		SimVariantTask *task = new SimVariantTask (this, policies[i], timelines[i]);
+		if (pool->submit (task))
+		{
+			task->run ();
+			delete task;
+			continue;
+		}
+		tasks.push_back (task);
+	}
+	for (std::vector <SimVariantTask *>::iterator iter = tasks.begin (); iter != tasks.end (); iter++)
+	{
+		pool->wait (*iter);
+		delete *iter;
+	}
+	delete tmpPool;
+}
+
+size_t NightSimulator::getStep (double t) const
+{
+	if (t <= from)
+		return 0;
+	size_t s = (size_t) floor ((t - from) / step);
+	return s >= steps ? steps - 1 : s;
+}
@@ -19,6 +19,7 @@
  */
 
 #include "rts2script/script.h"
+#include "rts2script/scriptcache.h"
 
 #include "elementexe.h"
 #include "elementhex.h"
@@ -122,6 +123,7 @@ Script::Script (int scriptLoopCount, rts2core::Block * _master):Object ()
 	master = _master;
 	loopCount = scriptLoopCount;
 	executedCount = 0;
+	bindTarget = true;
 	lineOffset = 0;
 	cmdBuf = NULL;
 	cmdBufTop = NULL;
@@ -141,6 +143,7 @@ Script::Script (const char *script):Object ()
 	master = NULL;
 	loopCount = 0;
 	executedCount = 0;
+	bindTarget = true;
 	lineOffset = 0;
 	cmdBuf = new char[strlen (script) + 1];
 	strcpy (cmdBuf, script);
@@ -231,10 +234,12 @@ void Script::parseScript (Rts2Target *target)
 	}
 }
 
-int Script::setTarget (const char *cam_name, Rts2Target * target)
+int Script::setTarget (const char *cam_name, Rts2Target * target, bool _bindTarget)
 {
 	std::string scriptText;
 
+	bindTarget = _bindTarget;
+
 	target->getPosition (&target_pos);
 
 	strcpy (defaultDevice, cam_name);
@@ -638,14 +643,14 @@ Element *Script::parseBuf (Rts2Target * target)
 	}
 	else if (!strcmp (commandStart, COMMAND_TARGET_DISABLE))
 	{
-		return new ElementDisable (this, target);
+		return new ElementDisable (this, bindTarget ? target : NULL);
 	}
 	else if (!strcmp (commandStart, COMMAND_TAR_TEMP_DISAB))
 	{
 		char *distime;
 		if (getNextParamString (&distime))
 			return NULL;
-		return new ElementTempDisable (this, target, distime);
+		return new ElementTempDisable (this, bindTarget ? target : NULL, distime);
 	}
 	else if (!strcmp (commandStart, COMMAND_TAR_TEMP_DISAB))
 	{
@@ -653,7 +658,7 @@ Element *Script::parseBuf (Rts2Target * target)
 		int bonus;
 		if (getNextParamInteger (&seconds) || getNextParamInteger (&bonus))
 			return NULL;
-		return new ElementTarBoost (this, target, seconds, bonus);
+		return new ElementTarBoost (this, bindTarget ? target : NULL, seconds, bonus);
 	}
 	else if (!strcmp (commandStart, COMMAND_HEX))
 	{
@@ -692,7 +697,7 @@ Element *Script::parseBuf (Rts2Target * target)
 		char *exe;
 		if (getNextParamString (&exe))
 			return NULL;
-		return new Execute (this, getMaster (), exe, target);
+		return new Execute (this, getMaster (), exe, bindTarget ? target : NULL);
 	}
 	else if (!strcmp (commandStart, COMMAND_COMMAND))
 	{
@@ -990,13 +995,11 @@ int Script::getExpectedImages ()
 double rts2script::getMaximalScriptDuration (Rts2Target *tar, rts2db::CamList &cameras, struct ln_equ_posn *tel, int runnum)
 {
   	double md = 0;
+	ScriptCache *cache = ScriptCache::instance ();
+	cache->setCameras (cameras);
 	for (rts2db::CamList::iterator cam = cameras.begin (); cam != cameras.end (); cam++)
 	{
-		std::string script_buf;
-		rts2script::Script script;
-		tar->getScript (cam->c_str(), script_buf);
-		script.setTarget (cam->c_str (), tar);
-		double d = script.getExpectedDuration (tel, runnum);
+		double d = cache->getExpectedDuration (tar, cam->c_str (), tel, runnum);
 		if (d > md)
 			md = d;  
 	}
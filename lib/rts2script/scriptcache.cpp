@@ -0,0 +1,214 @@
+/*
+ * Cache of parsed target scripts.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "rts2script/scriptcache.h"
+#include "rts2db/target.h"
+
+#include <algorithm>
+
+using namespace rts2script;
+
+ScriptCache *ScriptCache::pInstance = NULL;
+
+ScriptCache *ScriptCache::instance ()
+{
+	if (!pInstance)
+		pInstance = new ScriptCache ();
+	return pInstance;
+}
+
+ScriptCache::ScriptCache ()
+{
+	pthread_mutex_init (&cacheMutex, NULL);
+	hits = 0;
+	misses = 0;
+}
+
+ScriptCache::~ScriptCache ()
+{
+	pthread_mutex_destroy (&cacheMutex);
+}
+
+ScriptPtr ScriptCache::getScript (Rts2Target *tar, const char *cam_name)
+{
+	pthread_mutex_lock (&cacheMutex);
+	CacheEntry *entry = findEntry (tar, cam_name);
+	ScriptPtr ret;
+	if (entry)
+		ret = entry->script;
+	pthread_mutex_unlock (&cacheMutex);
+	return ret;
+}
+
+double ScriptCache::getExpectedDuration (Rts2Target *tar, const char *cam_name, struct ln_equ_posn *tel, int runnum)
+{
+	pthread_mutex_lock (&cacheMutex);
+	CacheEntry *entry = findEntry (tar, cam_name);
+	if (entry == NULL)
+	{
+		pthread_mutex_unlock (&cacheMutex);
+		return 0;
+	}
+
+	double ret;
+	std::map <int, double>::iterator di = entry->durations.find (runnum);
+	if (di == entry->durations.end ())
+	{
+		ret = entry->script->getExpectedDuration (NULL, runnum);
+		entry->durations[runnum] = ret;
+	}
+	else
+	{
+		ret = di->second;
+	}
+
+	// telescope movement is the only part which depends on current position
+	if (tel)
+	{
+		struct ln_equ_posn target_pos;
+		tar->getPosition (&target_pos);
+		if (!std::isnan (target_pos.ra) && !std::isnan (target_pos.dec))
+			ret += entry->script->getTelescopeSettleTime () + ln_get_angular_separation (tel, &target_pos) * entry->script->getTelescopeSpeed ();
+	}
+	pthread_mutex_unlock (&cacheMutex);
+	return ret;
+}
+
+void ScriptCache::setCameras (rts2db::CamList &_cameras)
+{
+	pthread_mutex_lock (&cacheMutex);
+	if (cameras == _cameras)
+	{
+		pthread_mutex_unlock (&cacheMutex);
+		return;
+	}
+	cameras = _cameras;
+	for (std::map <CacheKey, CacheEntry>::iterator iter = entries.begin (); iter != entries.end ();)
+	{
+		if (std::find (cameras.begin (), cameras.end (), iter->first.second) == cameras.end ())
+			eraseEntry (iter++);
+		else
+			iter++;
+	}
+	pthread_mutex_unlock (&cacheMutex);
+}
+
+void ScriptCache::invalidate (int tar_id)
+{
+	pthread_mutex_lock (&cacheMutex);
+	std::map <CacheKey, CacheEntry>::iterator iter = entries.lower_bound (CacheKey (tar_id, std::string ()));
+	while (iter != entries.end () && iter->first.first == tar_id)
+		eraseEntry (iter++);
+	pthread_mutex_unlock (&cacheMutex);
+	rts2db::Target::invalidateDBScripts ();
+}
+
+void ScriptCache::clear ()
+{
+	pthread_mutex_lock (&cacheMutex);
+	entries.clear ();
+	lru.clear ();
+	pthread_mutex_unlock (&cacheMutex);
+	rts2db::Target::invalidateDBScripts ();
+}
+
+ScriptCache::CacheEntry *ScriptCache::findEntry (Rts2Target *tar, const char *cam_name)
+{
+	bool acquired = tar->isAcquired ();
+	// must be read before script text, so invalidation during retrieval is not lost
+	unsigned int generation = rts2db::Target::getDBScriptsGeneration ();
+	time_t now = time (NULL);
+
+	CacheKey key (tar->getTargetID (), std::string (cam_name));
+	std::map <CacheKey, CacheEntry>::iterator iter = entries.find (key);
+	if (iter != entries.end () && iter->second.acquired == acquired && iter->second.generation == generation && now < iter->second.validUntil)
+	{
+		hits++;
+		lru.splice (lru.begin (), lru, iter->second.lruPos);
+		return &(iter->second);
+	}
+
+	// script can be split to multiple lines, see Rts2Target::getScript
+	std::string text;
+	try
+	{
+		std::string line;
+		bool more;
+		do
+		{
+			more = tar->getScript (cam_name, line);
+			text += line;
+			text += '\n';
+		}
+		while (more);
+	}
+	catch (rts2core::Error &er)
+	{
+		logStream (MESSAGE_ERROR) << "cannot load script for device " << cam_name << " and target " << tar->getTargetName () << " (# " << tar->getTargetID () << "): " << er << sendLog;
+		return NULL;
+	}
+
+	if (iter != entries.end () && iter->second.text == text && iter->second.acquired == acquired)
+	{
+		hits++;
+		iter->second.generation = generation;
+		iter->second.validUntil = now + SCRIPTCACHE_TTL;
+		lru.splice (lru.begin (), lru, iter->second.lruPos);
+		return &(iter->second);
+	}
+
+	misses++;
+
+	ScriptPtr script (new Script ());
+	if (script->setTarget (cam_name, tar, false))
+	{
+		if (iter != entries.end ())
+			eraseEntry (iter);
+		return NULL;
+	}
+
+	if (iter == entries.end ())
+	{
+		iter = entries.insert (std::pair <CacheKey, CacheEntry> (key, CacheEntry ())).first;
+		lru.push_front (key);
+		iter->second.lruPos = lru.begin ();
+		// drop least recently used entries
+		while (entries.size () > SCRIPTCACHE_MAX_ENTRIES)
+			eraseEntry (entries.find (lru.back ()));
+	}
+	else
+	{
+		lru.splice (lru.begin (), lru, iter->second.lruPos);
+	}
+
+	CacheEntry &entry = iter->second;
+	entry.text = text;
+	entry.generation = generation;
+	entry.validUntil = now + SCRIPTCACHE_TTL;
+	entry.acquired = acquired;
+	entry.script = script;
+	entry.durations.clear ();
+	return &entry;
+}
+
+void ScriptCache::eraseEntry (std::map <CacheKey, CacheEntry>::iterator iter)
+{
+	lru.erase (iter->second.lruPos);
+	entries.erase (iter);
+}
@@ -17,9 +17,11 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <errno.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
 #include <time.h>
 #include <libnova/libnova.h>
@@ -53,6 +55,8 @@
 #define OPT_RTS2_MODEL	OPT_LOCAL + 123
 #define OPT_T_POINT_MODEL	 OPT_LOCAL + 124
 #define OPT_DUT1_USNO       OPT_LOCAL + 125
+#define OPT_TELEMETRY       OPT_LOCAL + 126
+#define OPT_TELEMETRY_SIZE  OPT_LOCAL + 127
 
 #define EVENT_TELD_MPEC_REFRESH  RTS2_LOCAL_EVENT + 1200
 #define EVENT_TRACKING_TIMER	 RTS2_LOCAL_EVENT + 1201
@@ -79,6 +83,8 @@ Telescope::Telescope (int in_argc, char **in_argv, bool diffTrack, bool hasTrack
 	
 	decUpperLimit = NULL;
 	dut1fn = NULL;
+	telemetryFile = NULL;
+	telemetrySize = 100000;
 
 	createValue (telPressure, "PRESSURE", "observatory atmospheric pressure", false, RTS2_VALUE_WRITABLE | RTS2_VALUE_AUTOSAVE);
 	telPressure->setValueFloat (1000);
@@ -283,6 +289,9 @@ Telescope::Telescope (int in_argc, char **in_argv, bool diffTrack, bool hasTrack
 	createValue (trackingLogInterval, "tracking_log_interval", "[s] interval for tracking logs", false, RTS2_VALUE_WRITABLE);
 	trackingLogInterval->setValueDouble (30);
 
+	createValue (trackingTextLog, "tracking_text_log", "write tracking records to the text log", false, RTS2_VALUE_WRITABLE);
+	trackingTextLog->setValueBool (true);
+
 	createValue (tle_l1, "tle_l1_target", "TLE target line 1", false);
 	createValue (tle_l2, "tle_l2_target", "TLE target line 2", false);
 	createValue (tle_ephem, "tle_ephem", "TLE emphemeris type", false);
@@ -425,6 +434,8 @@ Telescope::Telescope (int in_argc, char **in_argv, bool diffTrack, bool hasTrack
 	addOption (OPT_WCS_MULTI, "wcs-multi", 1, "letter for multiple WCS (A-Z,-)");
 	addOption (OPT_DEC_UPPER_LIMIT, "dec-upper-limit", 1, "maximal declination the telescope is able to point to");
 	addOption (OPT_DUT1_USNO, "dut1-filename", 1, "filename of USNO DUT1 offset file");
+	addOption (OPT_TELEMETRY, "telemetry", 1, "record every tracking update to binary telemetry ring file");
+	addOption (OPT_TELEMETRY_SIZE, "telemetry-size", 1, "number of records in telemetry ring file (default 100000)");
 
 	setIdleInfoInterval (refreshIdle->getValueDouble ());
 
@@ -769,6 +780,17 @@ int Telescope::processOption (int in_opt)
 		case OPT_DUT1_USNO:
 			dut1fn = optarg;
 			break;
+		case OPT_TELEMETRY:
+			telemetryFile = optarg;
+			break;
+		case OPT_TELEMETRY_SIZE:
+			telemetrySize = atoi (optarg);
+			if (telemetrySize <= 0)
+			{
+				std::cerr << "invalid telemetry ring size: " << optarg << std::endl;
+				return -1;
+			}
+			break;
 		default:
 			return rts2core::Device::processOption (in_opt);
 	}
@@ -1385,6 +1407,19 @@ int Telescope::init ()
 		hardHorizon = new ObjectCheck (horizonFile);
 	}
 
+	if (telemetryFile)
+	{
+		if (telemetry.create (telemetryFile, telemetrySize))
+		{
+			logStream (MESSAGE_ERROR) << "cannot create telemetry file " << telemetryFile << ": " << strerror (errno) << sendLog;
+			return -1;
+		}
+		createValue (telemetry_file, "telemetry_file", "binary tracking telemetry ring file", false);
+		telemetry_file->setValueCharArr (telemetryFile);
+		// binary telemetry replaces text log
+		trackingTextLog->setValueBool (false);
+	}
+
 	return 0;
 }
 
@@ -1746,7 +1781,9 @@ void Telescope::stopTracking (const char *msg)
 void Telescope::runTracking ()
 {
 	double n = getNow ();
-	if (lastTrackLog < n)
+	if (telemetry.isOpen ())
+		writeTelemetry (n);
+	if (trackingTextLog->getValueBool () && lastTrackLog < n)
 	{
 		logTracking ();
 		lastTrackLog = n + trackingLogInterval->getValueDouble ();
@@ -1792,6 +1829,44 @@ void Telescope::logTracking ()
 	ls << sendLog;
 }
 
+void Telescope::writeTelemetry (double t)
+{
+	rts2core::TelemetryRecord rec;
+	rec.time = t;
+	rec.tarRa = tarRaDec->getRa ();
+	rec.tarDec = tarRaDec->getDec ();
+	rec.modelRa = modelRaDec->getRa ();
+	rec.modelDec = modelRaDec->getDec ();
+	rec.telRa = telRaDec->getRa ();
+	rec.telDec = telRaDec->getDec ();
+	if (tarTelRaDec != NULL)
+	{
+		rec.telTarRa = tarTelRaDec->getRa ();
+		rec.telTarDec = tarTelRaDec->getDec ();
+
+		struct ln_equ_posn tel, tar;
+		tel.ra = rec.telRa;
+		tel.dec = rec.telDec;
+		tar.ra = rec.telTarRa;
+		tar.dec = rec.telTarDec;
+		rec.error = ln_get_angular_separation (&tel, &tar);
+	}
+	else
+	{
+		rec.telTarRa = rec.telTarDec = rec.error = NAN;
+	}
+	if (tarTelAltAz != NULL)
+	{
+		rec.telTarAz = tarTelAltAz->getAz ();
+		rec.telTarAlt = tarTelAltAz->getAlt ();
+	}
+	else
+	{
+		rec.telTarAz = rec.telTarAlt = NAN;
+	}
+	telemetry.write (rec);
+}
+
 void Telescope::updateTrackingFrequency ()
 {
 	double n = getNow ();
@@ -1809,7 +1884,7 @@ void Telescope::updateTrackingFrequency ()
 
 int Telescope::moveTLE (const char *l1, const char *l2)
 {
-	int ret = parse_elements (l1, l2, &tle);
+	int ret = tleOrbit.parse (l1, l2);
 	if (ret != 0)
 	{
 		logStream (MESSAGE_ERROR) << "cannot target on TLEs" << sendLog;
@@ -1828,14 +1903,7 @@ int Telescope::parseTLE (rts2core::Connection *conn, const char *l1, const char
 
 	setTLE (l1, l2);
 
-	int ephem = 1;
-
-	int is_deep = select_ephemeris (&tle);
-	if (is_deep && (ephem == 1 || ephem == 2))
-		ephem += 2;	/* switch to an SDx */
-	if (!is_deep && (ephem == 3 || ephem == 4))
-		ephem -= 2;	/* switch to an SGx */
-	tle_ephem->setValueInteger (ephem);
+	tle_ephem->setValueInteger (tleOrbit.getEphem ());
 
 	startTracking (true);
 
@@ -1854,39 +1922,12 @@ void Telescope::setTLE (const char *l1, const char *l2)
 
 void Telescope::calculateTLE (double JD, double &ra, double &dec, double &dist_to_satellite)
 {
-	double sat_params[N_SAT_PARAMS], observer_loc[3];
-	double t_since;
-	double sat_pos[3]; /* Satellite position vector */
+	rts2pluto::TLEObserver observer (getLongitude (), getLatitude (), tle_rho_cos_phi->getValueDouble (), tle_rho_sin_phi->getValueDouble ());
 
-	observer_cartesian_coords (JD, ln_deg_to_rad (getLongitude ()), tle_rho_cos_phi->getValueDouble (), tle_rho_sin_phi->getValueDouble (), observer_loc);
+	if (tleOrbit.getEphem () < 0)
+		logStream (MESSAGE_ERROR) << "invalid tle_ephem " << tle_ephem->getValueInteger () << sendLog;
 
-	t_since = (JD - tle.epoch) * 1440.;
-	switch (tle_ephem->getValueInteger ())
-	{
-		case 0:
-			SGP_init (sat_params, &tle);
-			SGP (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		case 1:
-			SGP4_init (sat_params, &tle);
-			SGP4 (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		case 2:
-			SGP8_init (sat_params, &tle);
-			SGP8 (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		case 3:
-			SDP4_init (sat_params, &tle);
-			SDP4 (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		case 4:
-			SDP8_init (sat_params, &tle);
-			SDP8 (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		default:
-			logStream (MESSAGE_ERROR) << "invalid tle_ephem " << tle_ephem->getValueInteger () << sendLog;
-	}
-	get_satellite_ra_dec_delta (observer_loc, sat_pos, &ra, &dec, &dist_to_satellite);
+	tleOrbit.getRaDec (JD, observer, &ra, &dec, &dist_to_satellite);
 }
 
 void Telescope::setDiffTrack (double dra, double ddec)
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <unistd.h>
 
 UCAC5Idx::UCAC5Idx ():band(-1), fd(-1), data(NULL), dataSize(0), current(NULL), currentEnd(NULL)
@@ -21,11 +22,14 @@ UCAC5Idx::~UCAC5Idx ()
 		close(fd);
 }
 
-int UCAC5Idx::openIdx (int dec_band)
+int UCAC5Idx::openIdx (int dec_band, const char *base)
 {
-	char idx[9];
+	char idx[PATH_MAX];
 	memset(idx, 0, sizeof(idx));
-	snprintf(idx, 9, "z%03d.xyz", dec_band + 1);
+	if (base)
+		snprintf(idx, PATH_MAX, "%s/z%03d.xyz", base, dec_band + 1);
+	else
+		snprintf(idx, PATH_MAX, "z%03d.xyz", dec_band + 1);
 	fd = open(idx, O_RDONLY);
 	if (fd == -1)
 		return -1;
@@ -20,7 +20,9 @@
 #include "bb.h"
 #include "rts2json/directory.h"
 
-#define OPT_WWW_DIR    OPT_LOCAL + 1
+#define OPT_WWW_DIR          OPT_LOCAL + 1
+#define OPT_REQUEST_TIMEOUT  OPT_LOCAL + 2
+#define OPT_OBS_CACHE        OPT_LOCAL + 3
 
 using namespace XmlRpc;
 using namespace rts2bb;
@@ -40,11 +42,12 @@ BB::BB (int argc, char ** argv):
 	cssRequests ("/css", this, this),
 	tarRequests ("/targets", this, this),
 	addTarget ("/addtarget", this, this),
-	task_queue (this)
+	task_queue (this),
+	requests (30, 300)
 {
 	rpcPort = 8889;
 
-	createValue (queueSize, "queue_size", "task queue size", false);
+	createValue (queueSize, "queue_size", "number of pending requests to observatories", false);
 
 	createValue (debugConn, "debug_conn", "debug connections calls", false, RTS2_VALUE_WRITABLE | RTS2_DT_ONOFF);
 	debugConn->setValueBool (false);
@@ -55,6 +58,8 @@ BB::BB (int argc, char ** argv):
 
 	addOption ('p', NULL, 1, "RPC listening port");
 	addOption (OPT_WWW_DIR, "www-directory", 1, "default directory for BB requests");
+	addOption (OPT_REQUEST_TIMEOUT, "request-timeout", 1, "timeout (in seconds) of requests to observatories; default to 30 seconds");
+	addOption (OPT_OBS_CACHE, "observatory-cache", 1, "how long (in seconds) observatory records are cached; default to 300 seconds");
 }
 
 void BB::postEvent (rts2core::Event *event)
@@ -62,7 +67,7 @@ void BB::postEvent (rts2core::Event *event)
 	switch (event->getType ())
 	{
 		case EVENT_TASK_SCHEDULE:
-			task_queue.push ((BBTask *) event->getArg ());
+			task_queue.queueTask ((BBTask *) event->getArg ());
 			break;
 		case EVENT_SCHEDULING_DONE:
 			processSchedule ((ObservatorySchedule *) event->getArg ());
@@ -86,6 +91,12 @@ int BB::processOption (int opt)
 		case OPT_WWW_DIR:
 			XmlRpcServer::setDefaultGetRequest (new rts2json::Directory (NULL, this, optarg, "index.html", NULL));
 			break;
+		case OPT_REQUEST_TIMEOUT:
+			requests.setTimeout (atoi (optarg));
+			break;
+		case OPT_OBS_CACHE:
+			requests.setCacheTime (atoi (optarg));
+			break;
 		default:
 			return rts2db::DeviceDb::processOption (opt);
 	}
@@ -106,6 +117,12 @@ int BB::init ()
 	XmlRpcServer::bindAndListen (rpcPort);
 	XmlRpcServer::enableIntrospection (true);
 
+	if (requests.start ())
+	{
+		logStream (MESSAGE_ERROR) << "cannot start observatory requests thread" << sendLog;
+		return -1;
+	}
+
 #ifdef RTS2_HAVE_LIBJPEG
 	Magick::InitializeMagick (".");
 #endif /* RTS2_HAVE_LIBJPEG */
@@ -115,7 +132,7 @@ int BB::init ()
 
 int BB::info ()
 {
-	queueSize->setValueInteger (task_queue.size ());
+	queueSize->setValueInteger (requests.getPending ());
 	return rts2db::DeviceDb::info ();
 }
 
@@ -129,12 +146,15 @@ void BB::addPollSocks ()
 {
 	rts2db::DeviceDb::addPollSocks ();
 	XmlRpcServer::addToFd (&getMasterAddPollFD);
+	addPollFD (requests.getNotifyFd (), POLLIN | POLLPRI);
 }
 
 void BB::pollSuccess ()
 {
 	rts2db::DeviceDb::pollSuccess ();
 	XmlRpcServer::checkFd (&getMasterGetEvents);
+	if (isForRead (requests.getNotifyFd ()))
+		requests.processFinished ();
 }
 
 void BB::processSchedule (ObservatorySchedule *obs_sched)
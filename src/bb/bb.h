@@ -81,6 +81,8 @@ class BB:public rts2db::DeviceDb, XmlRpc::XmlRpcServer, rts2json::HTTPServer
 
 		bool getDebugConn () { return debugConn->getValueBool (); }
 
+		BBRequests *getRequests () { return &requests; }
+
 	protected:
 		virtual int processOption (int opt);
 
@@ -113,6 +115,7 @@ class BB:public rts2db::DeviceDb, XmlRpc::XmlRpcServer, rts2json::HTTPServer
 		rts2core::ValueInteger *queueSize;
 
 		BBTasks task_queue;
+		BBRequests requests;
 
 		void processSchedule (ObservatorySchedule *obs_sched);
 };
@@ -79,12 +79,11 @@ void ConnBBQueue::processCommand (char *cmd)
 		if (paramNextInteger (&observatory_id))
 			return;
 
-		Observatory obs (observatory_id);
-		obs.load ();
+		Observatory *obs = ((BB *) getMasterApp ())->getRequests ()->getObservatory (observatory_id);
 
-		writeToProcess (obs.getURL ());
-		writeToProcess (obs.getUser ());
-		writeToProcess (obs.getPassword ());
+		writeToProcess (obs->getURL ());
+		writeToProcess (obs->getUser ());
+		writeToProcess (obs->getPassword ());
 	}
 	else if (!strcasecmp (cmd, "schedule_from"))
 	{
@@ -35,6 +35,12 @@ class Observatory
 {
 	public:
 		Observatory (int id);
+
+		/**
+		 * Observatory with known API URL and credentials, which is not loaded from the database.
+		 */
+		Observatory (int id, const char *_url, const char *_user, const char *_password);
+
 		void load ();
 
 		struct ln_lnlat_posn * getPosition () { return &position; }
@@ -0,0 +1,306 @@
+/*
+ * Asynchronous requests to observatories.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "bbrequests.h"
+#include "app.h"
+
+#include <fcntl.h>
+#include <sstream>
+#include <unistd.h>
+
+using namespace rts2bb;
+
+ObservatoryRequest::ObservatoryRequest (int _observatory_id, std::string _path)
+{
+	observatory_id = _observatory_id;
+	path = _path;
+	session = NULL;
+	requests = NULL;
+	status = SOUP_STATUS_NONE;
+	duration = NAN;
+	result = NULL;
+}
+
+ObservatoryRequest::~ObservatoryRequest ()
+{
+	if (result)
+		g_object_unref (result);
+}
+
+BBRequests::BBRequests (int _timeout, int _cacheTime)
+{
+	timeout = _timeout;
+	cacheTime = _cacheTime;
+	pending = 0;
+
+	context = NULL;
+	loop = NULL;
+	running = false;
+
+	notifyPipe[0] = -1;
+	notifyPipe[1] = -1;
+}
+
+BBRequests::~BBRequests ()
+{
+	if (running)
+	{
+		g_main_loop_quit (loop);
+		pthread_join (thread, NULL);
+	}
+
+	for (std::map <int, Site>::iterator iter = sites.begin (); iter != sites.end (); iter++)
+	{
+		soup_session_abort (iter->second.session);
+		g_object_unref (iter->second.session);
+		delete iter->second.observatory;
+	}
+
+	while (!done.empty ())
+		delete done.pop ();
+
+	if (loop)
+		g_main_loop_unref (loop);
+	if (context)
+		g_main_context_unref (context);
+
+	if (notifyPipe[0] >= 0)
+	{
+		close (notifyPipe[0]);
+		close (notifyPipe[1]);
+	}
+}
+
+int BBRequests::start ()
+{
+	if (pipe (notifyPipe))
+		return -1;
+	fcntl (notifyPipe[0], F_SETFL, O_NONBLOCK);
+	fcntl (notifyPipe[1], F_SETFL, O_NONBLOCK);
+
+	g_type_init ();
+
+	context = g_main_context_new ();
+	loop = g_main_loop_new (context, FALSE);
+
+	if (pthread_create (&thread, NULL, requestsThread, (void *) this))
+		return -1;
+	running = true;
+	return 0;
+}
+
+void BBRequests::que (ObservatoryRequest *req)
+{
+	pending++;
+	req->requests = this;
+
+	Site *site;
+	try
+	{
+		site = getSite (req->getObservatoryId ());
+	}
+	catch (rts2core::Error &er)
+	{
+		std::ostringstream os;
+		os << "cannot load observatory " << req->getObservatoryId () << ": " << er;
+		req->status = BB_STATUS_UNKNOWN_OBSERVATORY;
+		req->error = os.str ();
+		req->duration = 0;
+		// finish request with an error in the next main loop iteration
+		done.push (req);
+		write (notifyPipe[1], "E", 1);
+		return;
+	}
+
+	req->url = std::string (site->observatory->getURL ()) + req->getPath ();
+	req->user = site->observatory->getUser ();
+	req->password = site->observatory->getPassword ();
+	req->session = site->session;
+	req->duration = getNow ();
+
+	GSource *source = g_idle_source_new ();
+	g_source_set_callback (source, sendRequest, req, NULL);
+	g_source_attach (source, context);
+	g_source_unref (source);
+}
+
+Observatory *BBRequests::getObservatory (int observatory_id)
+{
+	return getSite (observatory_id)->observatory;
+}
+
+void BBRequests::invalidate (int observatory_id)
+{
+	std::map <int, Site>::iterator iter = sites.find (observatory_id);
+	if (iter != sites.end ())
+		iter->second.loaded = 0;
+}
+
+void BBRequests::processFinished ()
+{
+	char buf[50];
+	while (read (notifyPipe[0], buf, 50) > 0)
+	{
+	}
+
+	while (!done.empty ())
+	{
+		ObservatoryRequest *req;
+		try
+		{
+			req = done.pop ();
+		}
+		catch (rts2core::Error &er)
+		{
+			break;
+		}
+		pending--;
+		if (req->status == BB_STATUS_UNKNOWN_OBSERVATORY)
+		{
+			logStream (MESSAGE_ERROR) << req->error << sendLog;
+		}
+		else if (!SOUP_STATUS_IS_SUCCESSFUL (req->status))
+		{
+			logStream (MESSAGE_ERROR) << "error calling " << req->url << ": " << req->status << " : " << soup_status_get_phrase (req->status) << sendLog;
+			// reload URL and credentials before the next request
+			if (SOUP_STATUS_IS_TRANSPORT_ERROR (req->status) || req->status == SOUP_STATUS_UNAUTHORIZED)
+				invalidate (req->getObservatoryId ());
+		}
+		else if (req->result == NULL)
+			logStream (MESSAGE_ERROR) << "unable to parse " << req->url << sendLog;
+		try
+		{
+			req->finished (req->result);
+		}
+		catch (rts2core::Error &er)
+		{
+			logStream (MESSAGE_ERROR) << "while processing reply from observatory " << req->getObservatoryId () << ": " << er << sendLog;
+		}
+		delete req;
+	}
+}
+
+BBRequests::Site *BBRequests::getSite (int observatory_id)
+{
+	std::map <int, Site>::iterator iter = sites.find (observatory_id);
+	if (iter != sites.end ())
+	{
+		Site *site = &(iter->second);
+		if (site->loaded + cacheTime < time (NULL))
+		{
+			Observatory *obs = loadObservatory (observatory_id);
+			delete site->observatory;
+			site->observatory = obs;
+			site->loaded = time (NULL);
+		}
+		return site;
+	}
+
+	Observatory *obs = loadObservatory (observatory_id);
+
+	Site site;
+	site.observatory = obs;
+	site.loaded = time (NULL);
+	// each observatory has its own session, so connections to slow sites do not block others
+	site.session = soup_session_async_new_with_options (
+		SOUP_SESSION_ASYNC_CONTEXT, context,
+		SOUP_SESSION_TIMEOUT, timeout,
+		SOUP_SESSION_ADD_FEATURE_BY_TYPE, SOUP_TYPE_CONTENT_DECODER,
+		SOUP_SESSION_ADD_FEATURE_BY_TYPE, SOUP_TYPE_COOKIE_JAR,
+		SOUP_SESSION_USER_AGENT, "rts2 bb",
+		NULL);
+
+	g_signal_connect (site.session, "authenticate", G_CALLBACK (authenticate), NULL);
+
+	return &(sites[observatory_id] = site);
+}
+
+Observatory *BBRequests::loadObservatory (int observatory_id)
+{
+	Observatory *obs = new Observatory (observatory_id);
+	try
+	{
+		obs->load ();
+	}
+	catch (rts2core::Error &er)
+	{
+		delete obs;
+		throw;
+	}
+	return obs;
+}
+
+void *BBRequests::requestsThread (void *arg)
+{
+	BBRequests *requests = (BBRequests *) arg;
+	g_main_context_push_thread_default (requests->context);
+	g_main_loop_run (requests->loop);
+	g_main_context_pop_thread_default (requests->context);
+	return NULL;
+}
+
+gboolean BBRequests::sendRequest (gpointer data)
+{
+	ObservatoryRequest *req = (ObservatoryRequest *) data;
+	SoupMessage *msg = soup_message_new (SOUP_METHOD_GET, req->url.c_str ());
+	if (msg == NULL)
+	{
+		req->status = SOUP_STATUS_MALFORMED;
+		req->duration = 0;
+		req->requests->done.push (req);
+		write (req->requests->notifyPipe[1], "E", 1);
+		return FALSE;
+	}
+	g_object_set_data (G_OBJECT (msg), "rts2-request", req);
+	soup_session_queue_message (req->session, msg, requestFinished, req);
+	return FALSE;
+}
+
+void BBRequests::requestFinished (SoupSession *session, SoupMessage *msg, gpointer data)
+{
+	ObservatoryRequest *req = (ObservatoryRequest *) data;
+
+	req->status = msg->status_code;
+	req->duration = getNow () - req->duration;
+
+	if (SOUP_STATUS_IS_SUCCESSFUL (msg->status_code))
+	{
+		req->result = json_parser_new ();
+		GError *error = NULL;
+		json_parser_load_from_data (req->result, msg->response_body->data, msg->response_body->length, &error);
+		if (error)
+		{
+			g_error_free (error);
+			g_object_unref (req->result);
+			req->result = NULL;
+		}
+	}
+
+	req->requests->done.push (req);
+	write (req->requests->notifyPipe[1], "F", 1);
+}
+
+void BBRequests::authenticate (SoupSession *session, SoupMessage *msg, SoupAuth *auth, gboolean retrying, gpointer data)
+{
+	if (retrying)
+		return;
+	ObservatoryRequest *req = (ObservatoryRequest *) g_object_get_data (G_OBJECT (msg), "rts2-request");
+	if (req)
+		soup_auth_authenticate (auth, req->user.c_str (), req->password.c_str ());
+}
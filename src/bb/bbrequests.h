@@ -0,0 +1,207 @@
+/*
+ * Asynchronous requests to observatories.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_BB_REQUESTS__
+#define __RTS2_BB_REQUESTS__
+
+#include "tsqueue.h"
+
+#include "bbdb.h"
+
+#include <map>
+#include <string>
+#include <pthread.h>
+#include <glib-object.h>
+#include <json-glib/json-glib.h>
+#include <libsoup/soup.h>
+
+/**
+ * Status of request to observatory, which record cannot be loaded from
+ * the database. Request is not sent.
+ */
+#define BB_STATUS_UNKNOWN_OBSERVATORY  99
+
+namespace rts2bb
+{
+
+class BBRequests;
+
+/**
+ * Single HTTP request to an observatory. Request is sent from the
+ * requests thread, finished method is called from the main thread.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class ObservatoryRequest
+{
+	public:
+		/**
+		 * @param _observatory_id  observatory ID
+		 * @param _path            path (including query) appended to observatory API URL
+		 */
+		ObservatoryRequest (int _observatory_id, std::string _path);
+		virtual ~ObservatoryRequest ();
+
+		/**
+		 * Called in the main thread after the request was finished. Result is NULL on error.
+		 */
+		virtual void finished (JsonParser *result) = 0;
+
+		int getObservatoryId () { return observatory_id; }
+		const std::string &getPath () { return path; }
+
+		/**
+		 * HTTP status, libsoup transport error code, or BB_STATUS_UNKNOWN_OBSERVATORY.
+		 */
+		guint getStatus () { return status; }
+
+		/**
+		 * Reason why request was not sent, empty if it was sent.
+		 */
+		const std::string &getError () { return error; }
+
+		/**
+		 * Request duration in seconds.
+		 */
+		double getDuration () { return duration; }
+
+	private:
+		int observatory_id;
+		std::string path;
+
+		// filled in the main thread by BBRequests::que
+		std::string url;
+		std::string user;
+		std::string password;
+		SoupSession *session;
+		BBRequests *requests;
+
+		// filled in the requests thread
+		guint status;
+		std::string error;
+		double duration;
+		JsonParser *result;
+
+		friend class BBRequests;
+};
+
+/**
+ * Engine sending requests to observatories concurrently.
+ *
+ * Every observatory has its own keep-alive session with a timeout, so a
+ * slow or unresponsive site does not delay others. Sessions run in a
+ * dedicated thread with its own GLib main context. Observatory records
+ * are cached and reloaded from the database only after cacheTime seconds.
+ * Finished requests are returned to the main thread through a queue,
+ * with a byte written to notification pipe, so the main loop can include
+ * it in its poll call.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class BBRequests
+{
+	public:
+		/**
+		 * @param _timeout    timeout of a single request (seconds)
+		 * @param _cacheTime  how long observatory records are cached (seconds)
+		 */
+		BBRequests (int _timeout, int _cacheTime);
+		virtual ~BBRequests ();
+
+		/**
+		 * Creates notification pipe and starts requests thread.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int start ();
+
+		/**
+		 * Queue request. Must be called from the main thread, as it might
+		 * load observatory record from the database. Engine takes ownership of the request.
+		 */
+		void que (ObservatoryRequest *req);
+
+		/**
+		 * Return observatory record, loading it from database if it is not cached or the cache expired.
+		 */
+		Observatory *getObservatory (int observatory_id);
+
+		/**
+		 * Drop cached observatory record; next request reloads it. Called
+		 * when observatory cannot be reached or refuses credentials, as its
+		 * URL or credentials might have changed.
+		 */
+		void invalidate (int observatory_id);
+
+		/**
+		 * Read pending notifications and call finished method of all finished requests.
+		 */
+		void processFinished ();
+
+		int getNotifyFd () { return notifyPipe[0]; }
+
+		/**
+		 * Number of requests queued or in progress.
+		 */
+		int getPending () { return pending; }
+
+		void setTimeout (int _timeout) { timeout = _timeout; }
+		void setCacheTime (int _cacheTime) { cacheTime = _cacheTime; }
+
+	protected:
+		/**
+		 * Load observatory record from the database.
+		 *
+		 * @throw rts2core::Error when observatory cannot be loaded
+		 */
+		virtual Observatory *loadObservatory (int observatory_id);
+
+	private:
+		int timeout;
+		int cacheTime;
+		int pending;
+
+		struct Site
+		{
+			Observatory *observatory;
+			time_t loaded;
+			SoupSession *session;
+		};
+
+		std::map <int, Site> sites;
+
+		GMainContext *context;
+		GMainLoop *loop;
+		pthread_t thread;
+		bool running;
+
+		TSQueue <ObservatoryRequest *> done;
+		int notifyPipe[2];
+
+		Site *getSite (int observatory_id);
+
+		static void *requestsThread (void *arg);
+		static gboolean sendRequest (gpointer data);
+		static void requestFinished (SoupSession *session, SoupMessage *msg, gpointer data);
+		static void authenticate (SoupSession *session, SoupMessage *msg, SoupAuth *auth, gboolean retrying, gpointer data);
+};
+
+}
+
+#endif // !__RTS2_BB_REQUESTS__
@@ -26,61 +26,6 @@
 
 using namespace rts2bb;
 
-static void auth (SoupSession *session, SoupMessage *msg, SoupAuth *_auth, gboolean retrying, gpointer data)
-{
-	if (retrying)
-		return;
-	((Observatory *) data)->auth (_auth);
-}
-
-JsonParser *BBTask::jsonRequest (int observatory_id, std::string path)
-{
-	Observatory obs (observatory_id);
-	obs.load ();
-
-	std::ostringstream request;
-	request << obs.getURL () << path;
-
-	g_type_init ();
-
-	SoupMessage *msg = soup_message_new (SOUP_METHOD_GET, request.str ().c_str ());
-
-	SoupSession *session = soup_session_sync_new_with_options (
-		SOUP_SESSION_ADD_FEATURE_BY_TYPE, SOUP_TYPE_CONTENT_DECODER,
-		SOUP_SESSION_ADD_FEATURE_BY_TYPE, SOUP_TYPE_COOKIE_JAR,
-		SOUP_SESSION_USER_AGENT, "rts2 bb",
-		NULL);
-
-	g_signal_connect (session, "authenticate", G_CALLBACK (auth), &obs);
-
-	soup_session_send_message (session, msg);
-
-	if (!SOUP_STATUS_IS_SUCCESSFUL (msg->status_code))
-	{
-		logStream (MESSAGE_ERROR) << "error calling " << path << ": " << msg->status_code << " : " << msg->reason_phrase << sendLog;
-		return NULL;
-	}
-
-	JsonParser *result = json_parser_new ();
-
-	GError *error = NULL;
-
-	json_parser_load_from_data (result, msg->response_body->data, strlen (msg->response_body->data), &error);
-	if (error)
-	{
-		logStream (MESSAGE_ERROR) << "unable to parse " << path << sendLog;
-		g_error_free (error);
-		g_object_unref (msg);
-		g_object_unref (session);
-		return NULL;
-	}
-
-	g_object_unref (msg);
-	g_object_unref (session);
-
-	return result;
-}
-
 int BBTaskSchedule::run ()
 {
 	switch (obs_sched->getState ())
@@ -126,32 +71,25 @@ void BBConfirmTask::confirmTarget (BBSchedules &bbsch, ObservatorySchedule &sche
 	std::ostringstream url;
 
 	url << "/bbapi/confirm?id=" << findObservatoryMapping (schedule.getObservatoryId (), bbsch.getTargetId ()) << "&schedule_id=" << schedule.getScheduleId () << "&observatory_id=" << schedule.getObservatoryId ();
-	JsonParser *ret = jsonRequest (schedule.getObservatoryId (), url.str ().c_str ());
-	if (ret)
-	{
-		schedule.updateState (BB_SCHEDULE_CONFIRMED, json_node_get_int (json_parser_get_root (ret)), schedule.getTo ());
-		g_object_unref (ret);
-	}
+	((BB *) getMasterApp ())->getRequests ()->que (new BBConfirmRequest (schedule.getScheduleId (), schedule.getObservatoryId (), url.str ()));
 }
 
-BBTasks::BBTasks (BB *_server):TSQueue <BBTask *> ()
+void BBConfirmRequest::finished (JsonParser *result)
 {
-	send_thread = 0;
-	server = _server;
+	if (result == NULL)
+		return;
+	ObservatorySchedule schedule (schedule_id, getObservatoryId ());
+	schedule.load ();
+	schedule.updateState (BB_SCHEDULE_CONFIRMED, json_node_get_int (json_parser_get_root (result)), schedule.getTo ());
 }
 
-BBTasks::~BBTasks ()
+BBTasks::BBTasks (BB *_server)
 {
-	while (!empty ())
-	{
-		BBTask *task = pop ();
-		delete task;
-	}
+	server = _server;
 }
 
-void BBTasks::run ()
+void BBTasks::queueTask (BBTask *t)
 {
-	BBTask *t = pop (true);
 	int ret = t->run ();
 	if (ret)
 	{
@@ -162,25 +100,3 @@ void BBTasks::run ()
 		delete t;
 	}
 }
-
-void *processTasks (void *arg)
-{
-	char *conn_name;
-	asprintf (&conn_name, "thread_%ld", pthread_self ());
-
-	((rts2db::DeviceDb *) getMasterApp ())->initDB (conn_name);
-
-	while (true)
-	{
-		((BBTasks *) arg)->run ();
-	}
-	return NULL;
-}
-
-void BBTasks::queueTask (BBTask *t)
-{
-	if (send_thread == 0)
-		pthread_create (&send_thread, NULL, processTasks, (void *) this);
-
-	push (t);
-}
@@ -20,15 +20,9 @@
 #ifndef __RTS2_BB_TASKS__
 #define __RTS2_BB_TASKS__
 
-#include "tsqueue.h"
-
 #include "bbdb.h"
 #include "bbconn.h"
-
-#include <pthread.h>
-#include <glib-object.h>
-#include <json-glib/json-glib.h>
-#include <libsoup/soup.h>
+#include "bbrequests.h"
 
 namespace rts2bb
 {
@@ -36,7 +30,9 @@ namespace rts2bb
 class BB;
 
 /**
- * Abstract class for tasks scheduled inside BB.
+ * Abstract class for tasks scheduled inside BB. Tasks run in the main
+ * thread, so they must not block; requests to observatories are sent
+ * through BBRequests.
  */
 class BBTask
 {
@@ -51,9 +47,6 @@ class BBTask
 		 * @return 0 if task should not be re-run. > 0 specifies seconds after which task should be rescheduled.
 		 */
 		virtual int run () = 0;
-	
-	protected:
-		JsonParser *jsonRequest (int observatory_id, std::string url);
 };
 
 /**
@@ -108,20 +101,37 @@ class BBConfirmTask:public BBTask
 
 
 /**
- * Queue holding all tasks.
+ * Confirmation request, updates schedule state after observatory replies.
  */
-class BBTasks:public TSQueue <BBTask *>
+class BBConfirmRequest:public ObservatoryRequest
 {
 	public:
-		BBTasks (BB *_server);
-		~BBTasks ();
+		BBConfirmRequest (int _schedule_id, int _observatory_id, std::string _path):ObservatoryRequest (_observatory_id, _path)
+		{
+			schedule_id = _schedule_id;
+		}
 
-		void run ();
+		virtual void finished (JsonParser *result);
 
+	private:
+		int schedule_id;
+};
+
+/**
+ * Runs tasks and reschedules them.
+ */
+class BBTasks
+{
+	public:
+		BBTasks (BB *_server);
+
+		/**
+		 * Run task. If task asks to be re-run, it is scheduled with a timer,
+		 * otherwise it is deleted.
+		 */
 		void queueTask (BBTask *t);
 	
 	private:
-		pthread_t send_thread;
 		BB *server;
 };
 
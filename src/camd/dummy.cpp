@@ -20,6 +20,7 @@
 #include "camd.h"
 #include "utilsfunc.h"
 #include "rts2fits/image.h"
+#include "starfield.h"
 
 #define OPT_WIDTH        OPT_LOCAL + 1
 #define OPT_HEIGHT       OPT_LOCAL + 2
@@ -29,10 +30,55 @@
 #define OPT_INFOSLEEP    OPT_LOCAL + 6
 #define OPT_READSLEEP    OPT_LOCAL + 7
 #define OPT_FRAMETRANS   OPT_LOCAL + 8
+#define OPT_UCAC5        OPT_LOCAL + 9
+#define OPT_MOUNT        OPT_LOCAL + 10
+#define OPT_SIM_THREADS  OPT_LOCAL + 11
+#define OPT_SIM_SEED     OPT_LOCAL + 12
 
 namespace rts2camd
 {
 
+/**
+ * Reads catalogue stars of the simulated field, so the catalogue is not read from the event loop.
+ */
+class CatalogueTask:public rts2core::PoolTask
+{
+	public:
+		CatalogueTask (StarField *_field, const char *_catalogue, double _ra, double _dec, double _scale, double _cx, double _cy, double _width, double _height, double _zeroPoint, double _magLimit):rts2core::PoolTask ()
+		{
+			field = _field;
+			catalogue = _catalogue;
+			ra = _ra;
+			dec = _dec;
+			scale = _scale;
+			cx = _cx;
+			cy = _cy;
+			width = _width;
+			height = _height;
+			zeroPoint = _zeroPoint;
+			magLimit = _magLimit;
+			added = -1;
+		}
+
+		virtual void run () { added = field->addCatalogueStars (catalogue, ra, dec, scale, cx, cy, width, height, zeroPoint, magLimit); }
+
+		// number of stars added, -1 on error
+		int added;
+
+	private:
+		StarField *field;
+		const char *catalogue;
+		double ra;
+		double dec;
+		double scale;
+		double cx;
+		double cy;
+		double width;
+		double height;
+		double zeroPoint;
+		double magLimit;
+};
+
 /**
  * Class for a dummy camera.
  *
@@ -70,6 +116,7 @@ class Dummy:public Camera
 			genType->addSelVal ("flats dusk");
 			genType->addSelVal ("flats dawn");
 			genType->addSelVal ("astar");
+			genType->addSelVal ("catalogue");
 			genType->setValueInteger (5);
 
 			createValue (fitsTransfer, "fits_transfer", "write FITS file directly in camera", false, RTS2_VALUE_WRITABLE);
@@ -96,6 +143,27 @@ class Dummy:public Camera
 			createValue (noiseRange, "noise_range", "readout noise range", false, RTS2_VALUE_WRITABLE);
 			noiseRange->setValueDouble (300);
 
+			createValue (simSky, "sim_sky", "[ADU] simulated sky level", false, RTS2_VALUE_WRITABLE);
+			simSky->setValueDouble (0);
+
+			createValue (simGain, "sim_gain", "[e/ADU] simulated gain, photon noise is not simulated if 0", false, RTS2_VALUE_WRITABLE);
+			simGain->setValueDouble (0);
+
+			createValue (simBeta, "sim_beta", "Moffat beta of simulated stars", false, RTS2_VALUE_WRITABLE);
+			simBeta->setValueDouble (2.5);
+
+			createValue (simPointing, "sim_pointing", "simulated field centre, updated from mount", false, RTS2_VALUE_WRITABLE);
+			simPointing->setValueRaDec (0, 0);
+
+			createValue (simScale, "sim_scale", "[arcsec/pixel] simulated pixel scale", false, RTS2_VALUE_WRITABLE);
+			simScale->setValueDouble (1);
+
+			createValue (simZero, "sim_zero", "magnitude of catalogue star giving 1 ADU flux", false, RTS2_VALUE_WRITABLE);
+			simZero->setValueDouble (25);
+
+			createValue (simMagLimit, "sim_mag_limit", "faintest simulated catalogue star", false, RTS2_VALUE_WRITABLE);
+			simMagLimit->setValueDouble (16);
+
 			createValue (hasError, "has_error", "if true, info will report error", false, RTS2_VALUE_WRITABLE);
 			hasError->setValueBool (false);
 
@@ -108,6 +176,15 @@ class Dummy:public Camera
 			dataSize = -1;
 			written = NULL;
 
+			field = NULL;
+			simThreads = 1;
+			simSeed = 0;
+			seedOption = -1;
+			ucac5 = NULL;
+			catPool = NULL;
+			catTask = NULL;
+			mountName = NULL;
+
 			addOption (OPT_FRAMETRANS, "frame-transfer", 0, "when set, dummy CCD will act as frame transfer device");
 			addOption (OPT_INFOSLEEP, "info-sleep", 1, "device will sleep <param> seconds before each info and baseInfo return");
 			addOption (OPT_READSLEEP, "read-sleep", 1, "device will sleep <parame> seconds before each readout");
@@ -116,12 +193,20 @@ class Dummy:public Camera
 			addOption (OPT_DATA_SIZE, "datasize", 1, "size of data block transmitted over TCP/IP");
 			addOption (OPT_CHANNELS, "channels", 1, "number of data channels");
 			addOption (OPT_REMOVE_TEMP, "no-temp", 0, "do not show temperature related fields");
+			addOption (OPT_UCAC5, "ucac5", 1, "UCAC5 catalogue directory, used to simulate stars around pointing");
+			addOption (OPT_MOUNT, "mount", 1, "mount providing pointing of the simulated field; default is the first mount");
+			addOption (OPT_SIM_THREADS, "sim-threads", 1, "number of threads simulating images, 0 for number of processors");
+			addOption (OPT_SIM_SEED, "sim-seed", 1, "seed of simulated stars and noise, for reproducible images; default is seeded from time");
 		}
 
 		virtual ~Dummy (void)
 		{
 			readoutSleep = NULL;
 			delete[] written;
+			// finish catalogue read before field is deleted
+			delete catPool;
+			delete catTask;
+			delete field;
 		}
 
 		virtual int processOption (int in_opt)
@@ -153,6 +238,18 @@ class Dummy:public Camera
 				case OPT_REMOVE_TEMP:
 					showTemp = false;
 					break;
+				case OPT_UCAC5:
+					ucac5 = optarg;
+					break;
+				case OPT_MOUNT:
+					mountName = optarg;
+					break;
+				case OPT_SIM_THREADS:
+					simThreads = atoi (optarg);
+					break;
+				case OPT_SIM_SEED:
+					seedOption = atol (optarg);
+					break;
 				default:
 					return Camera::processOption (in_opt);
 			}
@@ -196,6 +293,18 @@ class Dummy:public Camera
 			serialNumber->setValueCharArr ("1");
 
 			srand (time (NULL));
+			// exposure seeds are drawn from random ()
+			srandom (seedOption >= 0 ? seedOption : time (NULL) ^ getpid ());
+
+			field = new StarField (simThreads);
+
+			catPool = new rts2core::ThreadPool (1);
+			if (catPool->start ())
+			{
+				logStream (MESSAGE_WARNING) << "cannot start catalogue thread, catalogue will be read at exposure start" << sendLog;
+				delete catPool;
+				catPool = NULL;
+			}
 
 			return initChips ();
 		}
@@ -227,6 +336,7 @@ class Dummy:public Camera
 		{
 			if (fitsTransfer->getValueBool ())
 				setFitsTransfer ();
+			prepareField ();
 			written[0] = -1;
 			if (channels)
 			{
@@ -319,6 +429,26 @@ class Dummy:public Camera
 
 		rts2core::ValueBool *fitsTransfer;
 
+		rts2core::ValueDouble *simSky;
+		rts2core::ValueDouble *simGain;
+		rts2core::ValueDouble *simBeta;
+		rts2core::ValueRaDec *simPointing;
+		rts2core::ValueDouble *simScale;
+		rts2core::ValueDouble *simZero;
+		rts2core::ValueDouble *simMagLimit;
+
+		StarField *field;
+		int simThreads;
+		// noise seed of the current exposure
+		uint64_t simSeed;
+		long seedOption;
+		const char *ucac5;
+
+		rts2core::ThreadPool *catPool;
+		// catalogue read of the current exposure
+		CatalogueTask *catTask;
+		const char *mountName;
+
 		int width;
 		int height;
 
@@ -326,6 +456,21 @@ class Dummy:public Camera
 
 		bool showTemp;
 
+		/**
+		 * Prepare stars of the simulated field for the next exposure.
+		 * All channels show parts of the same field.
+		 */
+		void prepareField ();
+
+		/**
+		 * Wait for catalogue stars and report simulated star positions.
+		 *
+		 * @param submitted  true if catTask was submitted to catPool
+		 */
+		void finishCatalogue (bool submitted);
+
+		void sendStars ();
+
 		void generateImage (size_t pixelsize, int chan);
 
 		template <typename dt> void generateData (dt *data, size_t pixelsize);
@@ -387,6 +532,8 @@ int Dummy::doReadout ()
 	size_t pixelSize = chipUsedSize ();
 	int nch = 0;
 	rts2image::Image *image = NULL;
+	// all stars must be known before image is generated
+	finishCatalogue (true);
 	if (fitsTransfer->getValueBool ())
 	{
 		struct timeval expStart;
@@ -528,20 +675,103 @@ int Dummy::doReadout ()
 	return 0;					 // imediately send new data
 }
 
-void Dummy::generateImage (size_t pixelsize, int chan)
+void Dummy::prepareField ()
+{
+	int g = genType->getValueInteger ();
+	if (g != 0 && g != 5 && g != 6)
+		return;
+
+	// catalogue read of the aborted exposure
+	finishCatalogue (true);
+
+	int nch = channels ? getNumChannels () : 1;
+	int w = getUsedWidthBinned ();
+	int h = getUsedHeightBinned ();
+
+	field->setPSF (2.3548 * astarX->getValueDouble (), 2.3548 * astarY->getValueDouble (), simBeta->getValueDouble ());
+	// readout noise of the uniform distribution used before
+	field->setDetector (noiseBias->getValueDouble (), simSky->getValueDouble (), noiseRange->getValueDouble () / sqrt (12), simGain->getValueDouble ());
+	field->clearStars ();
+
+	simSeed = random ();
+	NoiseGenerator gen (simSeed);
+
+	switch (g)
+	{
+		case 5:
+			field->addRandomStars (astar_num->getValueInteger (), w * nch, h, aamp->getValueDouble (), gen);
+			break;
+		case 6:
+			{
+				rts2core::Connection *mount = mountName ? getOpenConnection (mountName) : getOpenConnection (DEVICE_TYPE_MOUNT);
+				if (mount)
+				{
+					rts2core::ValueRaDec *tel = dynamic_cast <rts2core::ValueRaDec *> (mount->getValue ("TEL"));
+					if (tel && !std::isnan (tel->getRa ()) && !std::isnan (tel->getDec ()))
+					{
+						simPointing->setValueRaDec (tel->getRa (), tel->getDec ());
+						sendValueAll (simPointing);
+					}
+				}
+				if (ucac5 == NULL)
+				{
+					logStream (MESSAGE_WARNING) << "cannot read catalogue stars, catalogue not specified" << sendLog;
+					break;
+				}
+				// stars are read during exposure, and waited for in doReadout
+				catTask = new CatalogueTask (field, ucac5, simPointing->getRa (), simPointing->getDec (), simScale->getValueDouble () * binningHorizontal (), w * nch / 2.0, h / 2.0, w * nch, h, simZero->getValueDouble (), simMagLimit->getValueDouble ());
+				if (catPool == NULL || catPool->submit (catTask))
+				{
+					catTask->run ();
+					finishCatalogue (false);
+				}
+			}
+			break;
+	}
+
+	if (catTask == NULL)
+		sendStars ();
+}
+
+void Dummy::finishCatalogue (bool submitted)
+{
+	if (catTask == NULL)
+		return;
+	if (submitted)
+		catPool->wait (catTask);
+	if (catTask->added < 0)
+		logStream (MESSAGE_WARNING) << "cannot read catalogue stars from " << ucac5 << sendLog;
+	delete catTask;
+	catTask = NULL;
+	sendStars ();
+}
+
+void Dummy::sendStars ()
 {
-	// artifical star center
 	astar_Xp->clear ();
 	astar_Yp->clear ();
 
-	for (int i = 0; i < astar_num->getValueInteger (); i++)
+	for (std::vector <SimStar>::const_iterator iter = field->getStars ().begin (); iter != field->getStars ().end (); iter++)
 	{
-		astar_Xp->addValue (random_num () * getUsedWidthBinned ());
-		astar_Yp->addValue (random_num () * getUsedHeightBinned ());
+		astar_Xp->addValue (iter->x);
+		astar_Yp->addValue (iter->y);
 	}
 
 	sendValueAll (astar_Xp);
 	sendValueAll (astar_Yp);
+}
+
+void Dummy::generateImage (size_t pixelsize, int chan)
+{
+	switch (genType->getValueInteger ())
+	{
+		case 0:
+		case 5:
+		case 6:
+			// each channel is a part of the mosaic
+			field->render (getDataBuffer (chan), getDataType (), getUsedWidthBinned (), getUsedHeightBinned (), chan * getUsedWidthBinned (), 0, simSeed + chan);
+			return;
+	}
 
 	switch (getDataType ())
 	{
@@ -577,26 +807,12 @@ void Dummy::generateImage (size_t pixelsize, int chan)
 
 template <typename dt> void Dummy::generateData (dt *data, size_t pixelSize)
 {
-	double sx = astarX->getValueDouble ();
-	int xmax = ceil (sx * 10);
-	sx *= sx;
-
-	double sy = astarY->getValueDouble ();
-	int ymax = ceil (sy * 10);
-	sy *= sy;
-
+	double n = noiseRange->getValueDouble ();
 	for (size_t i = 0; i < pixelSize; i++, data++)
 	{
-		double n;
-		if (genType->getValueInteger () != 1 && genType->getValueInteger () != 2)
-			n = noiseRange->getValueDouble ();
 		// generate data
 		switch (genType->getValueInteger ())
 		{
-			case 0:  // random
-			case 5:  // artificial star
-				*data = noiseBias->getValueDouble () + n * random_num () - n / 2;
-				break;
 			case 1:  // linear
 				*data = i;
 				break;
@@ -621,26 +837,6 @@ template <typename dt> void Dummy::generateData (dt *data, size_t pixelSize)
 				*data -= n / 2;
 				break;
 		}
-		// genarate artificial star - using cos
-		if (genType->getValueInteger () == 5)
-		{
-			int x = i % getUsedWidthBinned ();
-			int y = i / getUsedWidthBinned ();
-
-			for (int j = 0; j < astar_num->getValueInteger (); j++)
-			{
-				double aax = x - (*astar_Xp)[j];
-				double aay = y - (*astar_Yp)[j];
-
-				if (fabs (aax) < xmax && fabs (aay) < ymax)
-				{
-					aax *= aax;
-					aay *= aay;
-
-					*data += aamp->getValueDouble () * exp (-(aax / (2 * sx) + aay / (2 * sy)));
-				}
-			}
-		}
 	}
 }
 
@@ -0,0 +1,505 @@
+/*
+ * Star field simulator for the dummy camera.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "starfield.h"
+#include "imghdr.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#ifdef RTS2_LIBERFA
+#include "ucac5/UCAC5Bands.hpp"
+#include "ucac5/UCAC5Idx.hpp"
+#include "ucac5/UCAC5Record.hpp"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// below this number of electrons, photon noise is drawn from Poisson distribution
+#define POISSON_LIMIT    20.0
+// [ADU] stamps are rendered to the radius where PSF drops below this level
+#define STAMP_LEVEL      0.1
+// [pixels] maximal stamp radius
+#define STAMP_MAX        250.0
+// numbers generated at once by gaussian
+#define GAUSS_CHUNK      256
+// rows rendered by a task; bands do not depend on number of threads, so frame does not either
+#define BAND_ROWS        64
+
+using namespace rts2camd;
+
+static uint64_t splitmix (uint64_t &x)
+{
+	uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+NoiseGenerator::NoiseGenerator (uint64_t _seed)
+{
+	seed (_seed);
+}
+
+void NoiseGenerator::seed (uint64_t _seed)
+{
+	for (int l = 0; l < NOISE_LANES; l++)
+	{
+		s0[l] = splitmix (_seed);
+		s1[l] = splitmix (_seed);
+	}
+	unext = NOISE_LANES;
+}
+
+inline void NoiseGenerator::block (float *out)
+{
+	int32_t r[NOISE_LANES];
+	for (int l = 0; l < NOISE_LANES; l++)
+	{
+		uint64_t x = s0[l];
+		uint64_t y = s1[l];
+		s0[l] = y;
+		x ^= x << 23;
+		x ^= x >> 17;
+		x ^= y ^ (y >> 26);
+		s1[l] = x;
+		// 24 bits, which fit float mantissa
+		r[l] = (x + y) >> 40;
+	}
+	for (int l = 0; l < NOISE_LANES; l++)
+		out[l] = (r[l] + 1) * (1.0f / 16777216.0f);
+}
+
+void NoiseGenerator::uniform (float *out, size_t n)
+{
+	size_t i;
+	for (i = 0; i + NOISE_LANES <= n; i += NOISE_LANES)
+		block (out + i);
+	if (i < n)
+	{
+		float tmp[NOISE_LANES];
+		block (tmp);
+		memcpy (out + i, tmp, (n - i) * sizeof (float));
+	}
+}
+
+void NoiseGenerator::gaussian (float *out, size_t n)
+{
+	float u1[GAUSS_CHUNK];
+	float u2[GAUSS_CHUNK];
+	// Box-Muller, each pair of uniform numbers gives two normal numbers
+	for (size_t i = 0; i < n; i += 2 * GAUSS_CHUNK)
+	{
+		size_t m = std::min ((size_t) GAUSS_CHUNK, (n - i + 1) / 2);
+		uniform (u1, m);
+		uniform (u2, m);
+		for (size_t j = 0; j < m; j++)
+		{
+			float r = sqrtf (-2.0f * logf (u1[j]));
+			float a = (float) (2 * M_PI) * u2[j];
+			u1[j] = r * cosf (a);
+			u2[j] = r * sinf (a);
+		}
+		memcpy (out + i, u1, m * sizeof (float));
+		if (i + 2 * m <= n)
+			memcpy (out + i + m, u2, m * sizeof (float));
+		else
+			memcpy (out + i + m, u2, (n - i - m) * sizeof (float));
+	}
+}
+
+int NoiseGenerator::poisson (float mean)
+{
+	float l = expf (-mean);
+	float p = 1;
+	int k = -1;
+	do
+	{
+		if (unext == NOISE_LANES)
+		{
+			block (ubuf);
+			unext = 0;
+		}
+		p *= ubuf[unext++];
+		k++;
+	}
+	while (p > l);
+	return k;
+}
+
+namespace rts2camd
+{
+
+/**
+ * Renders band of rows and stores it in frame data.
+ */
+class BandTask:public rts2core::PoolTask
+{
+	public:
+		BandTask (StarField *_field, void *_data, int _dataType, int _width, int _x0, int _y0, int _row, int _rows, uint64_t _seed):PoolTask ()
+		{
+			field = _field;
+			data = _data;
+			dataType = _dataType;
+			width = _width;
+			x0 = _x0;
+			y0 = _y0;
+			row = _row;
+			rows = _rows;
+			seed = _seed;
+		}
+
+		virtual void run ();
+
+	private:
+		StarField *field;
+		void *data;
+		int dataType;
+		int width;
+		int x0;
+		int y0;
+		int row;
+		int rows;
+		uint64_t seed;
+};
+
+}
+
+template <typename dt> void storeBand (dt *out, const float *in, size_t n, float lo, float hi)
+{
+	for (size_t i = 0; i < n; i++)
+		out[i] = (dt) (std::min (hi, std::max (lo, in[i])) + 0.5f);
+}
+
+template <typename dt> void storeBand (dt *out, const float *in, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		out[i] = in[i];
+}
+
+void BandTask::run ()
+{
+	std::vector <float> buf ((size_t) width * rows);
+	field->renderBand (&(buf[0]), width, x0, y0 + row, rows, seed);
+
+	size_t off = (size_t) row * width;
+	size_t n = buf.size ();
+	// the same types as used by the dummy camera
+	switch (dataType)
+	{
+		case RTS2_DATA_BYTE:
+		case RTS2_DATA_SBYTE:
+			storeBand ((uint8_t *) data + off, &(buf[0]), n, 0, UINT8_MAX);
+			break;
+		case RTS2_DATA_SHORT:
+		case RTS2_DATA_USHORT:
+			storeBand ((uint16_t *) data + off, &(buf[0]), n, 0, UINT16_MAX);
+			break;
+		case RTS2_DATA_LONG:
+			storeBand ((int32_t *) data + off, &(buf[0]), n, INT32_MIN, INT32_MAX);
+			break;
+		case RTS2_DATA_ULONG:
+			storeBand ((uint32_t *) data + off, &(buf[0]), n, 0, UINT32_MAX);
+			break;
+		case RTS2_DATA_LONGLONG:
+			storeBand ((int64_t *) data + off, &(buf[0]), n, INT64_MIN, INT64_MAX);
+			break;
+		case RTS2_DATA_FLOAT:
+			storeBand ((float *) data + off, &(buf[0]), n);
+			break;
+		case RTS2_DATA_DOUBLE:
+			storeBand ((double *) data + off, &(buf[0]), n);
+			break;
+	}
+}
+
+StarField::StarField (int threads)
+{
+	setPSF (3, 3, 2.5);
+	setDetector (400, 0, 80, 2);
+
+	pool = NULL;
+	if (threads != 1)
+	{
+		pool = new rts2core::ThreadPool (threads);
+		if (pool->start ())
+		{
+			delete pool;
+			pool = NULL;
+		}
+	}
+}
+
+StarField::~StarField ()
+{
+	delete pool;
+}
+
+void StarField::setPSF (double fwhmX, double fwhmY, double _beta)
+{
+	beta = _beta > 1 ? _beta : 1.01;
+	double f = 2 * sqrt (pow (2, 1 / beta) - 1);
+	alphaX = fwhmX / f;
+	alphaY = fwhmY / f;
+}
+
+void StarField::setDetector (double _bias, double _sky, double _readNoise, double _gain)
+{
+	bias = _bias;
+	sky = _sky > 0 ? _sky : 0;
+	readNoise = _readNoise;
+	gain = _gain;
+}
+
+void StarField::addStar (double x, double y, double flux)
+{
+	SimStar s;
+	s.x = x;
+	s.y = y;
+	s.flux = flux;
+	stars.push_back (s);
+}
+
+void StarField::addRandomStars (int num, double width, double height, double maxPeak, NoiseGenerator &gen)
+{
+	// N(>F) ~ F^-a, number doubles per magnitude
+	const double a = log10 (2) / 0.4;
+	double fmax = maxPeak * M_PI * alphaX * alphaY / (beta - 1);
+	double fmin = fmax / 1000;
+	double c = 1 - pow (fmin / fmax, a);
+
+	float u[3];
+	for (int i = 0; i < num; i++)
+	{
+		gen.uniform (u, 3);
+		addStar (u[0] * width, u[1] * height, fmin * pow (1 - u[2] * c, -1 / a));
+	}
+}
+
+#ifdef RTS2_LIBERFA
+// gnomonic projection to standard coordinates, all values in radians
+static bool project (double ra0, double dec0, double ra, double dec, double &xi, double &eta)
+{
+	double cd = cos (dec);
+	double den = sin (dec0) * sin (dec) + cos (dec0) * cd * cos (ra - ra0);
+	if (den <= 0)
+		return false;
+	xi = cd * sin (ra - ra0) / den;
+	eta = (cos (dec0) * sin (dec) - sin (dec0) * cd * cos (ra - ra0)) / den;
+	return true;
+}
+#endif
+
+int StarField::addCatalogueStars (const char *catalogue, double ra, double dec, double scale, double cx, double cy, double width, double height, double zeroPoint, double magLimit)
+{
+#ifdef RTS2_LIBERFA
+	std::string base (catalogue);
+	UCAC5Bands bands;
+	if (bands.openBand ((base + "/u5index.unf").c_str ()))
+		return -1;
+
+	double ra0 = ra * M_PI / 180.0;
+	double dec0 = dec * M_PI / 180.0;
+	double s = scale * M_PI / (180.0 * 3600.0);
+	double radius = 0.5 * hypot (width, height) * s;
+
+	Vector tar;
+	eraS2c (ra0, dec0, tar.data);
+
+	int added = 0;
+	UCAC5Idx *index = NULL;
+	uint16_t dec_b = 0, ra_b = 0;
+	uint32_t ra_start = 0;
+	int32_t len;
+	while (bands.nextBand (ra0, dec0, radius, dec_b, ra_b, ra_start, len) == 0)
+	{
+		if (len < 0)
+			continue;
+		if (index == NULL || index->getBand () != dec_b)
+		{
+			delete index;
+			index = new UCAC5Idx ();
+			if (index->openIdx (dec_b, catalogue))
+			{
+				delete index;
+				index = NULL;
+				continue;
+			}
+		}
+		if (index->select (ra_start, len))
+			continue;
+
+		char fn[PATH_MAX];
+		snprintf (fn, PATH_MAX, "%s/z%03d", catalogue, dec_b + 1);
+		int fd = open (fn, O_RDONLY);
+		if (fd < 0)
+			continue;
+		struct stat sb;
+		struct ucac5 *cdata = NULL;
+		if (fstat (fd, &sb) == 0)
+			cdata = (struct ucac5 *) mmap (NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (cdata == NULL || cdata == MAP_FAILED)
+		{
+			close (fd);
+			continue;
+		}
+
+		double d;
+		int star;
+		while ((star = index->nextMatched (&tar, 0, radius, d)) >= 0)
+		{
+			UCAC5Record rec (cdata + star);
+			double mag = rec.getMag ();
+			if (mag <= 0 || mag > magLimit)
+				continue;
+			double xi, eta;
+			if (!project (ra0, dec0, rec.getRARad (), rec.getDecRad (), xi, eta))
+				continue;
+			// north up, east left
+			double x = cx - xi / s;
+			double y = cy + eta / s;
+			if (x < -STAMP_MAX || x > width + STAMP_MAX || y < -STAMP_MAX || y > height + STAMP_MAX)
+				continue;
+			addStar (x, y, pow (10, -0.4 * (mag - zeroPoint)));
+			added++;
+		}
+		munmap (cdata, sb.st_size);
+		close (fd);
+	}
+	delete index;
+	return added;
+#else
+	return -1;
+#endif
+}
+
+void StarField::render (void *data, int dataType, int width, int height, int x0, int y0, uint64_t seed)
+{
+	std::vector <BandTask *> tasks;
+	for (int row = 0; row < height; row += BAND_ROWS)
+	{
+		BandTask *t = new BandTask (this, data, dataType, width, x0, y0, row, std::min (BAND_ROWS, height - row), seed * 7919 + row / BAND_ROWS);
+		if (pool)
+			pool->submit (t);
+		else
+			t->run ();
+		tasks.push_back (t);
+	}
+	for (std::vector <BandTask *>::iterator iter = tasks.begin (); iter != tasks.end (); iter++)
+	{
+		if (pool)
+			pool->wait (*iter);
+		delete *iter;
+	}
+}
+
+void StarField::renderBand (float *out, int width, int x0, int y0, int rows, uint64_t seed)
+{
+	std::fill (out, out + (size_t) width * rows, 0.0f);
+
+	for (std::vector <SimStar>::iterator iter = stars.begin (); iter != stars.end (); iter++)
+	{
+		double r = stampRadius (*iter);
+		if (iter->y + r < y0 || iter->y - r >= y0 + rows || iter->x + r < x0 || iter->x - r >= x0 + width)
+			continue;
+		addStamp (out, width, x0, y0, rows, *iter, r);
+	}
+
+	NoiseGenerator gen (seed);
+	std::vector <float> g (width);
+
+	float b = bias;
+	float s = sky;
+	float rn = readNoise;
+	float rn2 = rn * rn;
+
+	for (int y = 0; y < rows; y++)
+	{
+		float *o = out + (size_t) y * width;
+		gen.gaussian (&(g[0]), width);
+		if (gain <= 0)
+		{
+			for (int x = 0; x < width; x++)
+				o[x] = b + s + o[x] + g[x] * rn;
+		}
+		else if (sky * gain >= POISSON_LIMIT)
+		{
+			float ig = 1 / gain;
+			for (int x = 0; x < width; x++)
+			{
+				float v = s + o[x];
+				o[x] = b + v + g[x] * sqrtf (v * ig + rn2);
+			}
+		}
+		else
+		{
+			float ig = 1 / gain;
+			for (int x = 0; x < width; x++)
+			{
+				float v = s + o[x];
+				float e = v * gain;
+				if (e < POISSON_LIMIT)
+					o[x] = b + gen.poisson (e) * ig + g[x] * rn;
+				else
+					o[x] = b + v + g[x] * sqrtf (v * ig + rn2);
+			}
+		}
+	}
+}
+
+double StarField::stampRadius (const SimStar &star)
+{
+	double peak = star.flux * (beta - 1) / (M_PI * alphaX * alphaY);
+	if (peak <= STAMP_LEVEL)
+		return 1;
+	double r = std::max (alphaX, alphaY) * sqrt (pow (peak / STAMP_LEVEL, 1 / beta) - 1);
+	return std::max (1.0, std::min (STAMP_MAX, r));
+}
+
+void StarField::addStamp (float *signal, int width, int x0, int y0, int rows, const SimStar &star, double radius)
+{
+	int xa = std::max (0, (int) floor (star.x - radius) - x0);
+	int xb = std::min (width - 1, (int) ceil (star.x + radius) - x0);
+	int ya = std::max (0, (int) floor (star.y - radius) - y0);
+	int yb = std::min (rows - 1, (int) ceil (star.y + radius) - y0);
+
+	float norm = star.flux * (beta - 1) / (M_PI * alphaX * alphaY);
+	float ax = 1 / (alphaX * alphaX);
+	float ay = 1 / (alphaY * alphaY);
+	float nb = -beta;
+	float sx = star.x - x0;
+
+	for (int y = ya; y <= yb; y++)
+	{
+		float dy = y0 + y - star.y;
+		float dy2 = 1 + dy * dy * ay;
+		float *row = signal + (size_t) y * width;
+		for (int x = xa; x <= xb; x++)
+		{
+			float dx = x - sx;
+			row[x] += norm * expf (nb * logf (dy2 + dx * dx * ax));
+		}
+	}
+}
@@ -0,0 +1,209 @@
+/*
+ * Star field simulator for the dummy camera.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_STARFIELD__
+#define __RTS2_STARFIELD__
+
+#include "threadpool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// number of generator lanes advanced together
+#define NOISE_LANES    8
+
+namespace rts2camd
+{
+
+/**
+ * Pseudo-random number generator for image noise.
+ *
+ * Keeps NOISE_LANES independent xorshift128+ generators, which are
+ * advanced together in plain loops over the lanes. Such loops are
+ * vectorized by the compiler, so numbers are produced for the whole
+ * block at once, without locks of random().
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class NoiseGenerator
+{
+	public:
+		NoiseGenerator (uint64_t seed = 42);
+
+		void seed (uint64_t seed);
+
+		/**
+		 * Fill buffer with numbers uniformly distributed in (0,1].
+		 */
+		void uniform (float *out, size_t n);
+
+		/**
+		 * Fill buffer with normally distributed numbers, mean 0, sigma 1.
+		 */
+		void gaussian (float *out, size_t n);
+
+		/**
+		 * Returns Poisson distributed number. Intended for small means,
+		 * larger means shall use normal approximation.
+		 */
+		int poisson (float mean);
+
+	private:
+		uint64_t s0[NOISE_LANES];
+		uint64_t s1[NOISE_LANES];
+
+		// numbers not yet used by poisson
+		float ubuf[NOISE_LANES];
+		int unext;
+
+		void block (float *out);
+};
+
+/**
+ * Simulated star.
+ */
+struct SimStar
+{
+	// position in pixels, relative to the field origin
+	double x;
+	double y;
+	// total flux in ADU
+	double flux;
+};
+
+/**
+ * Renders star field with Moffat PSF, sky background, photon and
+ * readout noise.
+ *
+ * Stars are rendered as stamps only around their centres; stamp radius
+ * is given by the level at which the PSF drops below a fraction of ADU.
+ * Frame is split to bands of rows, which are rendered in parallel on
+ * the thread pool. Every band uses its own generator seeded from the
+ * frame seed, so the frame does not depend on the number of threads.
+ *
+ * Photon noise of pixels with more than POISSON_LIMIT electrons is
+ * approximated by normal distribution.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class StarField
+{
+	public:
+		/**
+		 * @param threads  number of rendering threads, 0 for number of processors
+		 */
+		StarField (int threads = 1);
+		~StarField ();
+
+		/**
+		 * Set PSF parameters.
+		 *
+		 * @param fwhmX  [pixels] FWHM along X axis
+		 * @param fwhmY  [pixels] FWHM along Y axis
+		 * @param beta   Moffat beta parameter
+		 */
+		void setPSF (double fwhmX, double fwhmY, double beta);
+
+		/**
+		 * Set detector and background parameters.
+		 *
+		 * @param bias       [ADU] bias level
+		 * @param sky        [ADU] sky level per pixel
+		 * @param readNoise  [ADU] readout noise sigma
+		 * @param gain       [e/ADU] detector gain, photon noise is not simulated if it is not positive
+		 */
+		void setDetector (double bias, double sky, double readNoise, double gain);
+
+		void clearStars () { stars.clear (); }
+
+		void addStar (double x, double y, double flux);
+
+		const std::vector <SimStar> &getStars () { return stars; }
+
+		/**
+		 * Add random stars with field luminosity function (number of
+		 * stars rises by factor of 2 per magnitude).
+		 *
+		 * @param num      number of stars
+		 * @param width    [pixels] width of the field
+		 * @param height   [pixels] height of the field
+		 * @param maxPeak  [ADU] peak value of the brightest stars
+		 * @param gen      generator of star positions and fluxes
+		 */
+		void addRandomStars (int num, double width, double height, double maxPeak, NoiseGenerator &gen);
+
+		/**
+		 * Add stars from UCAC5 catalogue.
+		 *
+		 * @param catalogue  directory with UCAC5 files (u5index.unf, zNNN, zNNN.idx)
+		 * @param ra         [deg] RA of the field centre
+		 * @param dec        [deg] DEC of the field centre
+		 * @param scale      [arcsec/pixel] pixel scale
+		 * @param cx         [pixels] X of the field centre
+		 * @param cy         [pixels] Y of the field centre
+		 * @param width      [pixels] width of the field
+		 * @param height     [pixels] height of the field
+		 * @param zeroPoint  magnitude giving 1 ADU total flux
+		 * @param magLimit   faintest magnitude included
+		 *
+		 * @return number of stars added, -1 on error
+		 */
+		int addCatalogueStars (const char *catalogue, double ra, double dec, double scale, double cx, double cy, double width, double height, double zeroPoint, double magLimit);
+
+		/**
+		 * Render frame, or its part for a channel of a mosaic.
+		 *
+		 * @param data      frame data
+		 * @param dataType  RTS2_DATA_xxx type of the frame data
+		 * @param width     [pixels] frame width
+		 * @param height    [pixels] frame height
+		 * @param x0        [pixels] X of the frame origin in the field
+		 * @param y0        [pixels] Y of the frame origin in the field
+		 * @param seed      noise seed
+		 */
+		void render (void *data, int dataType, int width, int height, int x0, int y0, uint64_t seed);
+
+		/**
+		 * Render single band of rows to float buffer. Used by band tasks.
+		 */
+		void renderBand (float *out, int width, int x0, int y0, int rows, uint64_t seed);
+
+	private:
+		std::vector <SimStar> stars;
+
+		double alphaX;
+		double alphaY;
+		double beta;
+
+		double bias;
+		double sky;
+		double readNoise;
+		double gain;
+
+		rts2core::ThreadPool *pool;
+
+		// returns stamp radius of the star
+		double stampRadius (const SimStar &star);
+		void addStamp (float *signal, int width, int x0, int y0, int rows, const SimStar &star, double radius);
+};
+
+}
+
+#endif // !__RTS2_STARFIELD__
@@ -0,0 +1,285 @@
+/*
+ * Precomputed device blocking matrix for centrald.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "blockmatrix.h"
+
+#include <algorithm>
+
+using namespace rts2centrald;
+
+BlockMatrix::BlockMatrix ()
+{
+	requiredMissing = 0;
+	otherBad = 0;
+	nwords = 0;
+}
+
+int BlockMatrix::addSlot (const char *name, rts2core::IniParser *config)
+{
+	int slot;
+	if (freeSlots.empty ())
+	{
+		slot = names.size ();
+		if ((size_t) slot >= nwords * 32)
+			grow ();
+		names.push_back (std::string (name));
+		used.push_back (true);
+		bopStates.push_back (0);
+		computedBop.push_back (0);
+		required.push_back (false);
+		weatherGood.push_back (true);
+		rows.push_back (std::vector <uint32_t> (nwords, 0));
+		cols.push_back (std::vector <uint32_t> (nwords, 0));
+	}
+	else
+	{
+		slot = freeSlots.back ();
+		freeSlots.pop_back ();
+		names[slot] = std::string (name);
+		used[slot] = true;
+		bopStates[slot] = 0;
+		computedBop[slot] = 0;
+		required[slot] = false;
+		weatherGood[slot] = true;
+	}
+
+	fillRelations (slot, config);
+	computedBop[slot] = composeBop (slot);
+
+	required[slot] = isRequired (names[slot]);
+	// required device is missing until it reports good weather
+	weatherGood[slot] = !required[slot];
+
+	return slot;
+}
+
+void BlockMatrix::removeSlot (int slot, std::vector <int> &dependents)
+{
+	if (!isUsed (slot))
+		return;
+
+	// drop BOP and weather contributions
+	setBopState (slot, 0, dependents);
+	setWeather (slot, true);
+	// required device without slot is missing
+	updateRequired (slot, false);
+
+	// clear relations
+	for (size_t i = 0; i < names.size (); i++)
+	{
+		setBit (rows[i], slot, false);
+		setBit (cols[i], slot, false);
+	}
+	std::fill (rows[slot].begin (), rows[slot].end (), 0);
+	std::fill (cols[slot].begin (), cols[slot].end (), 0);
+
+	names[slot] = std::string ();
+	used[slot] = false;
+	freeSlots.push_back (slot);
+}
+
+void BlockMatrix::rebuild (rts2core::IniParser *config, std::vector <int> &dependents)
+{
+	for (size_t i = 0; i < names.size (); i++)
+	{
+		std::fill (rows[i].begin (), rows[i].end (), 0);
+		std::fill (cols[i].begin (), cols[i].end (), 0);
+	}
+	for (size_t i = 0; i < names.size (); i++)
+	{
+		if (used[i])
+			fillRelations (i, config);
+	}
+	for (size_t i = 0; i < names.size (); i++)
+	{
+		if (!used[i])
+			continue;
+		rts2_status_t nb = composeBop (i);
+		if (nb != computedBop[i])
+		{
+			computedBop[i] = nb;
+			dependents.push_back (i);
+		}
+	}
+}
+
+bool BlockMatrix::setBopState (int slot, rts2_status_t bop, std::vector <int> &dependents)
+{
+	if (!isUsed (slot))
+		return false;
+	bop &= BOP_MASK;
+	if (bopStates[slot] == bop)
+		return false;
+
+	bopStates[slot] = bop;
+	setBit (bopNonZero, slot, bop != 0);
+
+	// only slots blocked by changed slot need recalculation
+	const std::vector <uint32_t> &col = cols[slot];
+	for (size_t w = 0; w < col.size (); w++)
+	{
+		uint32_t bits = col[w];
+		while (bits)
+		{
+			int b = __builtin_ctz (bits);
+			bits &= bits - 1;
+			int i = w * 32 + b;
+			rts2_status_t nb = composeBop (i);
+			if (nb != computedBop[i])
+			{
+				computedBop[i] = nb;
+				dependents.push_back (i);
+			}
+		}
+	}
+	return true;
+}
+
+void BlockMatrix::setRequired (const std::vector <std::string> &_required)
+{
+	requiredNames = _required;
+	std::sort (requiredNames.begin (), requiredNames.end ());
+	requiredNames.erase (std::unique (requiredNames.begin (), requiredNames.end ()), requiredNames.end ());
+
+	requiredGood.clear ();
+	requiredMissing = requiredNames.size ();
+	otherBad = 0;
+	for (size_t i = 0; i < names.size (); i++)
+	{
+		if (!used[i])
+			continue;
+		required[i] = isRequired (names[i]);
+		if (required[i])
+		{
+			if (weatherGood[i])
+				countRequired (names[i], 1);
+		}
+		else if (weatherGood[i] == false)
+		{
+			otherBad++;
+		}
+	}
+}
+
+bool BlockMatrix::setWeather (int slot, bool good)
+{
+	if (!isUsed (slot) || weatherGood[slot] == good)
+		return false;
+	weatherGood[slot] = good;
+	if (required[slot])
+		countRequired (names[slot], good ? 1 : -1);
+	else
+		otherBad += good ? -1 : 1;
+	return true;
+}
+
+void BlockMatrix::getWeatherFailed (const std::vector <std::string> &_required, std::vector <std::string> &failed) const
+{
+	for (std::vector <std::string>::const_iterator iter = _required.begin (); iter != _required.end (); iter++)
+	{
+		std::map <std::string, int>::const_iterator mi = requiredGood.find (*iter);
+		if (mi == requiredGood.end () || mi->second == 0)
+			failed.push_back (*iter);
+	}
+	for (size_t i = 0; i < names.size (); i++)
+	{
+		if (used[i] && required[i] == false && weatherGood[i] == false)
+			failed.push_back (names[i]);
+	}
+}
+
+void BlockMatrix::grow ()
+{
+	for (std::vector <std::vector <uint32_t> >::iterator iter = rows.begin (); iter != rows.end (); iter++)
+		iter->push_back (0);
+	for (std::vector <std::vector <uint32_t> >::iterator iter = cols.begin (); iter != cols.end (); iter++)
+		iter->push_back (0);
+	bopNonZero.push_back (0);
+	nwords++;
+}
+
+void BlockMatrix::fillRelations (int slot, rts2core::IniParser *config)
+{
+	for (size_t j = 0; j < names.size (); j++)
+	{
+		if (!used[j])
+			continue;
+		// j blocks slot
+		bool b = config->blockDevice (names[slot].c_str (), names[j].c_str ());
+		setBit (rows[slot], j, b);
+		setBit (cols[j], slot, b);
+		// slot blocks j
+		b = config->blockDevice (names[j].c_str (), names[slot].c_str ());
+		setBit (rows[j], slot, b);
+		setBit (cols[slot], j, b);
+	}
+}
+
+rts2_status_t BlockMatrix::composeBop (int slot) const
+{
+	rts2_status_t ret = 0;
+	const std::vector <uint32_t> &row = rows[slot];
+	for (size_t w = 0; w < row.size (); w++)
+	{
+		uint32_t bits = row[w] & bopNonZero[w];
+		while (bits)
+		{
+			int b = __builtin_ctz (bits);
+			bits &= bits - 1;
+			ret |= bopStates[w * 32 + b];
+		}
+	}
+	return ret;
+}
+
+bool BlockMatrix::isRequired (const std::string &name) const
+{
+	return std::binary_search (requiredNames.begin (), requiredNames.end (), name);
+}
+
+void BlockMatrix::countRequired (const std::string &name, int delta)
+{
+	int &good = requiredGood[name];
+	if (good == 0 && delta > 0)
+		requiredMissing--;
+	good += delta;
+	if (good == 0 && delta < 0)
+		requiredMissing++;
+}
+
+void BlockMatrix::updateRequired (int slot, bool req)
+{
+	if (required[slot] == req)
+		return;
+	if (req)
+	{
+		if (weatherGood[slot])
+			countRequired (names[slot], 1);
+		else
+			otherBad--;
+	}
+	else
+	{
+		if (weatherGood[slot])
+			countRequired (names[slot], -1);
+		else
+			otherBad++;
+	}
+	required[slot] = req;
+}
@@ -0,0 +1,184 @@
+/*
+ * Precomputed device blocking matrix for centrald.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_BLOCKMATRIX__
+#define __RTS2_BLOCKMATRIX__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "iniparser.h"
+#include "status.h"
+
+namespace rts2centrald
+{
+
+/**
+ * Holds which connections can block other connections, together with
+ * incrementally maintained BOP and weather aggregates.
+ *
+ * Every connection registered to centrald receives a slot. Blocking
+ * relations are evaluated through IniParser::blockDevice only when a
+ * connection is added or when configuration is reloaded, and stored as bit
+ * rows (devices blocking given slot) and bit columns (devices blocked by
+ * given slot). BOP state of the device is then computed by OR of BOP states
+ * of slots from its row which have non-zero BOP state.
+ *
+ * Weather aggregate tracks number of required device names without any
+ * connected slot reporting good weather, and number of other connections
+ * reporting bad weather, so weather state can be decided without walking
+ * all connections.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class BlockMatrix
+{
+	public:
+		BlockMatrix ();
+
+		/**
+		 * Allocate slot for a new connection.
+		 *
+		 * @param name    connection (device) name
+		 * @param config  configuration used to resolve blocked_by relations
+		 *
+		 * @return slot number
+		 */
+		int addSlot (const char *name, rts2core::IniParser *config);
+
+		/**
+		 * Release slot. Returns list of slots which had the released slot in their blocking row.
+		 */
+		void removeSlot (int slot, std::vector <int> &dependents);
+
+		/**
+		 * Recalculate all blocking relations. Called after configuration was (re)loaded.
+		 *
+		 * @param dependents  filled with slots which computed BOP state changed
+		 */
+		void rebuild (rts2core::IniParser *config, std::vector <int> &dependents);
+
+		/**
+		 * Returns true if slot querying is blocked by slot blocking.
+		 */
+		bool blocks (int querying, int blocking) const
+		{
+			return testBit (rows[querying], blocking);
+		}
+
+		/**
+		 * Set BOP state of the slot.
+		 *
+		 * @param dependents  filled with slots which computed BOP state changed by this call
+		 *
+		 * @return true if BOP state of the slot changed
+		 */
+		bool setBopState (int slot, rts2_status_t bop, std::vector <int> &dependents);
+
+		/**
+		 * Return cached BOP state composed from all slots which can block given slot.
+		 */
+		rts2_status_t getBopFor (int slot) const { return computedBop[slot]; }
+
+		/**
+		 * Set list of required devices. Those are considered to have bad weather until connected.
+		 * Weather state of the slots is kept - caller shall call setWeather for all
+		 * slots, as goodness of the weather of required device depends on its
+		 * connection state.
+		 */
+		void setRequired (const std::vector <std::string> &required);
+
+		/**
+		 * Update weather state of the slot.
+		 *
+		 * @param good  true if slot reports good weather (and is connected for required devices)
+		 *
+		 * @return true if weather contribution of the slot changed
+		 */
+		bool setWeather (int slot, bool good);
+
+		/**
+		 * Returns true if no device blocks weather.
+		 */
+		bool isGoodWeather () const { return requiredMissing == 0 && otherBad == 0; }
+
+		/**
+		 * Fill names of devices causing bad weather - required devices
+		 * which are not ready first, followed by other connections reporting
+		 * bad weather.
+		 */
+		void getWeatherFailed (const std::vector <std::string> &required, std::vector <std::string> &failed) const;
+
+		size_t size () const { return names.size (); }
+
+		bool isRequired (int slot) const { return required[slot]; }
+
+		bool isUsed (int slot) const { return slot >= 0 && (size_t) slot < used.size () && used[slot]; }
+
+	private:
+		std::vector <std::string> names;
+		std::vector <bool> used;
+		std::vector <int> freeSlots;
+
+		// rows[i] has bit j set if j blocks i, cols[j] has bit i set if j blocks i
+		std::vector <std::vector <uint32_t> > rows;
+		std::vector <std::vector <uint32_t> > cols;
+
+		// BOP state reported by slot and BOP state composed for slot
+		std::vector <rts2_status_t> bopStates;
+		std::vector <rts2_status_t> computedBop;
+		// slots with non-zero BOP state
+		std::vector <uint32_t> bopNonZero;
+
+		std::vector <bool> required;
+		std::vector <bool> weatherGood;
+
+		// sorted list of required device names
+		std::vector <std::string> requiredNames;
+		// number of slots with good weather for each required name - devices can share name (e.g. reconnecting device with its old connection not yet removed)
+		std::map <std::string, int> requiredGood;
+		int requiredMissing;
+		int otherBad;
+
+		// number of 32 bit words in rows and columns
+		size_t nwords;
+
+		static bool testBit (const std::vector <uint32_t> &bits, int i) { return bits[i >> 5] & (1u << (i & 0x1f)); }
+		static void setBit (std::vector <uint32_t> &bits, int i, bool v)
+		{
+			if (v)
+				bits[i >> 5] |= (1u << (i & 0x1f));
+			else
+				bits[i >> 5] &= ~(1u << (i & 0x1f));
+		}
+
+		void grow ();
+		void fillRelations (int slot, rts2core::IniParser *config);
+		rts2_status_t composeBop (int slot) const;
+		bool isRequired (const std::string &name) const;
+		void updateRequired (int slot, bool req);
+		void countRequired (const std::string &name, int delta);
+};
+
+}
+
+#endif // !__RTS2_BLOCKMATRIX__
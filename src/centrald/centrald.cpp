@@ -30,11 +30,11 @@ void ConnCentrald::setState (rts2_status_t in_value, char *msg)
 	rts2core::Connection::setState (in_value, msg);
 	// distribute weather updates..
 	if (serverState->maskValueChanged (WEATHER_MASK))
-		master->weatherChanged (getName (), msg);
+		master->weatherChanged (this, msg);
 	if (serverState->maskValueChanged (STOP_MASK))
 	  	master->stopChanged (getName (), msg);
 	if (serverState->maskValueChanged (BOP_MASK))
-		master->bopMaskChanged ();
+		master->bopMaskChanged (this);
 	if (serverState->maskValueChanged (DEVICE_BLOCK_OPEN) || serverState->maskValueChanged (DEVICE_BLOCK_CLOSE))
 		master->openCloseChanged (getName (), msg);
 }
@@ -46,6 +46,7 @@ ConnCentrald::ConnCentrald (int in_sock, Centrald * in_master, int in_centrald_i
 	messageMask = 0x00;
 
 	statusCommandRunning = 0;
+	matrixSlot = -1;
 }
 
 ConnCentrald::~ConnCentrald (void)
@@ -516,6 +517,12 @@ int Centrald::reloadConfig ()
 	observerLat->setValueDouble (observer->lat);
 
 	requiredDevices->setValueArray (config->observatoryRequiredDevices ());
+	// blocked_by might change
+	std::vector <int> dependents;
+	blockMatrix.rebuild (config, dependents);
+	sendBopUpdates (dependents);
+	updateRequired ();
+	weatherChanged (NULL, "configuration reloaded");
 	openSequence->setValueArray (config->openSequence ());
 
 	nightHorizon->setValueDouble (config->getDoubleDefault ("observatory", "night_horizon", -10));
@@ -630,11 +637,21 @@ int Centrald::initValues ()
 
 void Centrald::connectionRemoved (rts2core::Connection * conn)
 {
+	ConnCentrald *c_conn = (ConnCentrald *) conn;
+	std::vector <int> dependents;
+	if (blockMatrix.isUsed (c_conn->getMatrixSlot ()))
+	{
+		matrixConnections[c_conn->getMatrixSlot ()] = NULL;
+		blockMatrix.removeSlot (c_conn->getMatrixSlot (), dependents);
+		c_conn->setMatrixSlot (-1);
+	}
 	// update weather
-	weatherChanged (conn->getName (), "connection removed");
+	weatherChanged (conn, "connection removed");
 	stopChanged (conn->getName (), "connection removed");
 	// make sure we will change BOP mask..
-	bopMaskChanged ();
+	maskState (BOP_MASK, 0, "changed BOP state");
+	sendBopUpdates (dependents);
+	sendStatusMessage (getState ());
 	// and make sure we aren't the last who block status info
 	for (connections_t::iterator iter = getConnections ()->begin (); iter != getConnections ()->end (); iter++)
 	{
@@ -718,6 +735,18 @@ void Centrald::connAdded (ConnCentrald * added)
 		rts2core::Connection *conn = *iter;
 		added->sendConnectedInfo (conn);
 	}
+
+	int slot = blockMatrix.addSlot (added->getName (), Configuration::instance ());
+	added->setMatrixSlot (slot);
+	if ((size_t) slot >= matrixConnections.size ())
+		matrixConnections.resize (slot + 1, NULL);
+	matrixConnections[slot] = added;
+
+	// account current state of the new connection
+	std::vector <int> dependents;
+	if (blockMatrix.setBopState (slot, added->getBopState (), dependents))
+		sendBopUpdates (dependents);
+	weatherChanged (added, "connection added");
 }
 
 rts2core::Connection * Centrald::getConnection (int conn_num)
@@ -840,7 +869,7 @@ void Centrald::deviceReady (rts2core::Connection * conn)
 {
 	Daemon::deviceReady (conn);
 	// check again for weather state..
-	weatherChanged (conn->getName (), "device ready");
+	weatherChanged (conn, "device ready");
 	stopChanged (conn->getName (), "device ready");
 }
 
@@ -894,59 +923,88 @@ void Centrald::signaledHUP ()
 	Daemon::signaledHUP ();
 }
 
-void Centrald::weatherChanged (const char * device, const char * msg)
+void Centrald::valueChanged (rts2core::Value *changed_value)
 {
-	// state of the required devices
-	std::vector <std::string> failedArr;
-	std::vector <std::string>::iterator namIter;
-	for (namIter = requiredDevices->valueBegin (); namIter != requiredDevices->valueEnd (); namIter++)
-		failedArr.push_back (*namIter);
+	if (changed_value == requiredDevices)
+	{
+		updateRequired ();
+		weatherChanged (NULL, "required devices changed");
+	}
+	Daemon::valueChanged (changed_value);
+}
 
-	connections_t::iterator iter;
-	// check if some connection block weather
-	for (iter = getConnections ()->begin (); iter != getConnections ()->end (); iter ++)
+void Centrald::updateRequired ()
+{
+	std::vector <std::string> required (requiredDevices->valueBegin (), requiredDevices->valueEnd ());
+	blockMatrix.setRequired (required);
+	// required devices might become optional and vice versa
+	for (size_t slot = 0; slot < matrixConnections.size (); slot++)
 	{
-		// if connection is required..
-		namIter = std::find (failedArr.begin (), failedArr.end (), std::string ((*iter)->getName ()));
-		if (namIter != failedArr.end ())
-		{
-			if ((*iter)->isGoodWeather () == true && (*iter)->isConnState (CONN_CONNECTED))
-				failedArr.erase (namIter);
-			// otherwise, connection name will not be erased from
-			// failedArr, so failedArr size will be larger then 0,
-			// so newWeather will be set to false in size check - few lines
-			// bellow.
-		}
-		else  if ((*iter)->isGoodWeather () == false)
-		{
-			failedArr.push_back ((*iter)->getName ());
-		}
-		if (!strcmp ((*iter)->getName (), device))
+		if (matrixConnections[slot] != NULL)
+			blockMatrix.setWeather (slot, isWeatherGood (matrixConnections[slot], slot));
+	}
+}
+
+bool Centrald::isWeatherGood (rts2core::Connection *conn, int slot)
+{
+	// required device must be connected to be considered as good
+	return conn->isGoodWeather () && (blockMatrix.isRequired (slot) == false || conn->isConnState (CONN_CONNECTED));
+}
+
+void Centrald::sendBopUpdates (std::vector <int> &slots)
+{
+	for (std::vector <int>::iterator iter = slots.begin (); iter != slots.end (); iter++)
+	{
+		ConnCentrald *conn = matrixConnections[*iter];
+		if (conn != NULL && conn->getType () == DEVICE_SERVER)
+			sendBopMessage (getState (), getStateForConnection (conn), conn);
+	}
+}
+
+void Centrald::weatherChanged (rts2core::Connection *conn, const char * msg)
+{
+	// if state of the connection does not change weather aggregate, list of failed devices remains same
+	bool changed = true;
+	int slot = -1;
+	if (conn != NULL)
+	{
+		slot = ((ConnCentrald *) conn)->getMatrixSlot ();
+		if (blockMatrix.isUsed (slot))
 		{
+			changed = blockMatrix.setWeather (slot, isWeatherGood (conn, slot));
+
 			// device which causes bad weather..
-			if ((*iter)->isGoodWeather () == false && strlen (badWeatherReason->getValue ()) == 0)
+			if (conn->isGoodWeather () == false && strlen (badWeatherReason->getValue ()) == 0)
 			{
 				if (msg == NULL)
 					msg = "NULL";
 				badWeatherReason->setValueCharArr (msg);
-				badWeatherDevice->setValueCharArr (device);
-				logStream (MESSAGE_INFO) << "received bad weather from " << device << " claiming that " << device << ": '" << msg << "'" << sendLog;
+				badWeatherDevice->setValueCharArr (conn->getName ());
+				logStream (MESSAGE_INFO) << "received bad weather from " << conn->getName () << " claiming that " << conn->getName () << ": '" << msg << "'" << sendLog;
 			}
 		}
 	}
-	badWeatherDevices->setValueArray (failedArr);
-	sendValueAll (badWeatherDevices);
 
-	setWeatherState (failedArr.size () > 0 ? false : true, "weather state update from weatherChanged");
-	if (failedArr.size () > 0)
+	if (changed)
 	{
-		rts2core::LogStream ls = logStream (MESSAGE_DEBUG);
-		ls << "failed devices:";
-		for (namIter = failedArr.begin (); namIter != failedArr.end (); namIter++)
-			ls << " " << (*namIter);
-		ls << sendLog;
+		std::vector <std::string> failedArr;
+		std::vector <std::string> required (requiredDevices->valueBegin (), requiredDevices->valueEnd ());
+		blockMatrix.getWeatherFailed (required, failedArr);
+		badWeatherDevices->setValueArray (failedArr);
+		sendValueAll (badWeatherDevices);
+
+		if (failedArr.size () > 0)
+		{
+			rts2core::LogStream ls = logStream (MESSAGE_DEBUG);
+			ls << "failed devices:";
+			for (std::vector <std::string>::iterator namIter = failedArr.begin (); namIter != failedArr.end (); namIter++)
+				ls << " " << (*namIter);
+			ls << sendLog;
+		}
 	}
-	else
+
+	setWeatherState (blockMatrix.isGoodWeather (), "weather state update from weatherChanged");
+	if (blockMatrix.isGoodWeather ())
 	{
 		badWeatherReason->setValueCharArr ("");
 		badWeatherDevice->setValueCharArr ("");
@@ -1010,17 +1068,13 @@ void Centrald::stopChanged (const char * device, const char * msg)
 	}
 }
 
-void Centrald::bopMaskChanged ()
+void Centrald::bopMaskChanged (rts2core::Connection *conn)
 {
-	int bopState = 0;
-	connections_t::iterator iter;
-	maskState (BOP_MASK, bopState, "changed BOP state");
-	for (iter = getConnections ()->begin (); iter != getConnections ()->end (); iter++)
-	{
-		bopState |= (*iter)->getBopState ();
-		if ((*iter)->getType () == DEVICE_SERVER)
-			sendBopMessage (getState (), getStateForConnection (*iter), *iter);
-	}
+	std::vector <int> dependents;
+	maskState (BOP_MASK, 0, "changed BOP state");
+	// only devices which can be blocked by the connection receive new BOP state
+	blockMatrix.setBopState (((ConnCentrald *) conn)->getMatrixSlot (), conn->getBopState (), dependents);
+	sendBopUpdates (dependents);
 	sendStatusMessage (getState ());
 }
 
@@ -1053,8 +1107,15 @@ int Centrald::statusInfo (rts2core::Connection * conn)
 		{
 			if (conn->getType () == DEVICE_SERVER)
 			{
-				if (Configuration::instance ()->blockDevice (conn->getName (), test_conn->getName ()) == false)
+				if (blockMatrix.isUsed (c_conn->getMatrixSlot ()) && blockMatrix.isUsed (test_conn->getMatrixSlot ()))
+				{
+					if (blockMatrix.blocks (c_conn->getMatrixSlot (), test_conn->getMatrixSlot ()) == false)
+						continue;
+				}
+				else if (Configuration::instance ()->blockDevice (conn->getName (), test_conn->getName ()) == false)
+				{
 					continue;
+				}
 			}
 			rts2core::CommandStatusInfo *cs = new rts2core::CommandStatusInfo (this, c_conn);
 			cs->setOriginator (conn);
@@ -1081,6 +1142,10 @@ int Centrald::getStateForConnection (rts2core::Connection * conn)
 	int sta = getState ();
 	// get rid of BOP mask
 	sta &= ~BOP_MASK & ~DEVICE_ERROR_MASK;
+	int slot = ((ConnCentrald *) conn)->getMatrixSlot ();
+	if (blockMatrix.isUsed (slot))
+		return sta | blockMatrix.getBopFor (slot);
+	// connection was not yet added to blocking matrix
 	connections_t::iterator iter;
 	// cretae BOP mask for device
 	for (iter = getConnections ()->begin (); iter != getConnections ()->end (); iter++)
@@ -28,6 +28,7 @@
 #include "daemon.h"
 #include "configuration.h"
 #include "status.h"
+#include "blockmatrix.h"
 
 using namespace rts2core;
 
@@ -146,12 +147,15 @@ class Centrald:public Daemon
 		 * will not be broken, but will not transwer any usable data to
 		 * centrald.
 		 *
-		 * @param deviceName  Name of device triggering weather change.
+		 * Weather state is kept in BlockMatrix aggregate, so only state
+		 * of the connection which triggered change is examined.
+		 *
+		 * @param conn        Connection triggering weather change.
 		 * @param msg         Message associated with weather change.
 		 *
 		 * @callgraph
 		 */
-		void weatherChanged (const char * device, const char * msg);
+		void weatherChanged (rts2core::Connection *conn, const char * msg);
 
 		/**
 		 * Call to update weather state of a connection.
@@ -166,11 +170,13 @@ class Centrald:public Daemon
 		void stopChanged (const char *device, const char *msg);
 
 		/**
-		 * Called when block of operation device mask changed. It checks
-		 * blocking state of all devices and updates accordingly master
-		 * blocking state.
+		 * Called when block of operation device mask changed. Updates
+		 * BOP state of the connection in blocking matrix, and sends new
+		 * BOP state to devices which can be blocked by the connection.
+		 *
+		 * @param conn Connection which BOP state changed.
 		 */
-		void bopMaskChanged ();
+		void bopMaskChanged (rts2core::Connection *conn);
 
 		/**
 		 * Called when open/close block on any device changed.
@@ -241,6 +247,8 @@ class Centrald:public Daemon
 
 		virtual void signaledHUP ();
 
+		virtual void valueChanged (rts2core::Value *changed_value);
+
 	private:
 		// called to change state, check if last_night_on should be set
 		void maskCentralState (rts2_status_t state_mask, rts2_status_t new_state, const char *description = NULL, double start = NAN, double end = NAN, Connection *commandedConn = NULL);
@@ -326,6 +334,14 @@ class Centrald:public Daemon
 
 		void processMessage (Message & msg);
 
+		// blocking relations and BOP/weather aggregates, indexed by ConnCentrald::getMatrixSlot
+		BlockMatrix blockMatrix;
+		std::vector <ConnCentrald *> matrixConnections;
+
+		void updateRequired ();
+		bool isWeatherGood (rts2core::Connection *conn, int slot);
+		void sendBopUpdates (std::vector <int> &slots);
+
 		// order of devices during opening - if any device signals block_open, its open method is called
 		rts2core::StringArray *openSequence;
 };
@@ -370,6 +386,9 @@ class ConnCentrald:public rts2core::Connection
 		int sendAValue (const char *name, int value);
 		int messageMask;
 
+		// slot in centrald blocking matrix, -1 if not allocated
+		int matrixSlot;
+
 	protected:
 		virtual void setState (rts2_status_t in_value, char * msg);
 
@@ -391,6 +410,9 @@ class ConnCentrald:public rts2core::Connection
 		{
 			statusCommandRunning++;
 		}
+
+		int getMatrixSlot () { return matrixSlot; }
+		void setMatrixSlot (int _slot) { matrixSlot = _slot; }
 };
 
 }
@@ -27,11 +27,22 @@
 #endif							 /* RTS2_HAVE_PGSQL */
 #include "configuration.h"
 #include "rts2format.h"
+#ifdef RTS2_HAVE_PGSQL
+#include "threadpool.h"
+#include "utilsfunc.h"
+#endif							 /* RTS2_HAVE_PGSQL */
 
 #include <iostream>
 #include <iomanip>
 
+#include <algorithm>
 #include <list>
+#include <set>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
 
 #ifdef RTS2_HAVE_LIBJPEG
 #include <Magick++.h>
@@ -72,11 +83,143 @@
 #define OPT_RTS2OPERA_WCS       OPT_LOCAL + 18
 #define OPT_ADD_TEMPLATE        OPT_LOCAL + 19
 #define OPT_APPEND_EXTENSIONS   OPT_LOCAL + 20
+#define OPT_INGEST              OPT_LOCAL + 21
+#define OPT_THREADS             OPT_LOCAL + 22
+#define OPT_IO_THREADS          OPT_LOCAL + 23
+#define OPT_BATCH               OPT_LOCAL + 24
+#define OPT_CHECKPOINT          OPT_LOCAL + 25
+
+// file descriptors kept free for database connection, logs and moved files, when batch size is limited by limit of open files
+#define INGEST_RESERVED_FDS     64
 
 namespace rts2image
 {
 
 #ifdef RTS2_HAVE_PGSQL
+// NULL mutex is passed when CFITSIO was built thread-safe
+static void lockFits (pthread_mutex_t *fitsMutex) { if (fitsMutex) pthread_mutex_lock (fitsMutex); }
+static void unlockFits (pthread_mutex_t *fitsMutex) { if (fitsMutex) pthread_mutex_unlock (fitsMutex); }
+
+/**
+ * Image being ingested. Its headers are read in a header worker thread.
+ */
+class IngestOpen:public rts2core::PoolTask
+{
+	public:
+		IngestOpen (const std::string &_path, bool _readOnly, pthread_mutex_t *_fitsMutex):rts2core::PoolTask (), path (_path)
+		{
+			readOnly = _readOnly;
+			fitsMutex = _fitsMutex;
+			image = NULL;
+			size = 0;
+			ingested = false;
+		}
+
+		virtual ~IngestOpen () { delete image; }
+
+		virtual void run ()
+		{
+			struct stat sb;
+			if (stat (path.c_str (), &sb) == 0)
+				size = sb.st_size;
+			lockFits (fitsMutex);
+			ImageDb *imagedb = new ImageDb ();
+			imagedb->setMapChannels (readOnly);
+			try
+			{
+				imagedb->openFile (path.c_str (), readOnly, false);
+				image = getValueImageType (imagedb);
+			}
+			catch (...)
+			{
+				delete imagedb;
+				unlockFits (fitsMutex);
+				throw;
+			}
+			unlockFits (fitsMutex);
+		}
+
+		std::string path;
+		bool readOnly;
+		pthread_mutex_t *fitsMutex;
+		ImageDb *image;
+		// [bytes] file size
+		off_t size;
+		// image was inserted, moved and linked
+		bool ingested;
+};
+
+/**
+ * Moves and links ingested image. Run in I/O worker thread, after
+ * image was inserted to the database. Does not access the database -
+ * new path is written to it from the main thread.
+ */
+class IngestFileOps:public rts2core::PoolTask
+{
+	public:
+		IngestFileOps (IngestOpen *_file, const char *_move_expr, const char *_link_expr):rts2core::PoolTask ()
+		{
+			file = _file;
+			move_expr = _move_expr;
+			link_expr = _link_expr;
+			moved = false;
+			crossDevice = false;
+		}
+
+		virtual void run ()
+		{
+			lockFits (file->fitsMutex);
+			try
+			{
+				fileOps ();
+			}
+			catch (...)
+			{
+				unlockFits (file->fitsMutex);
+				throw;
+			}
+			unlockFits (file->fitsMutex);
+		}
+
+		IngestOpen *file;
+		const char *move_expr;
+		const char *link_expr;
+
+		std::string movePath;
+		bool moved;
+		// image shall be moved to other filesystem
+		bool crossDevice;
+
+	private:
+		void fileOps ()
+		{
+			ImageDb *image = file->image;
+			if (move_expr)
+			{
+				movePath = image->expandPath (move_expr);
+				if (movePath != image->getFileName ())
+				{
+					if (mkpath (movePath.c_str (), 0777))
+						throw rts2core::Error (std::string ("cannot create path for ") + movePath + ": " + strerror (errno));
+					if (rename (image->getFileName (), movePath.c_str ()))
+					{
+						// copy is done in the main thread
+						if (errno == EXDEV)
+						{
+							crossDevice = true;
+							return;
+						}
+						throw rts2core::Error (std::string ("cannot move ") + image->getFileName () + " to " + movePath + ": " + strerror (errno));
+					}
+					image->openFile (movePath.c_str (), file->readOnly, false);
+					moved = true;
+				}
+			}
+			if (link_expr && image->symlinkImageExpand (link_expr))
+				throw rts2core::Error (std::string ("cannot link ") + image->getFileName () + ": " + strerror (errno));
+		}
+};
+
 class AppImage:public AppDbImage
 #else
 class AppImage:public rts2image::AppImageCore
@@ -94,6 +237,8 @@ class AppImage:public rts2image::AppImageCore
 #ifdef RTS2_HAVE_PGSQL
 		virtual bool doInitDB ();
 
+		virtual int doProcessing ();
+
 		virtual int processImage (rts2image::ImageDb * image);
 #else
 		virtual int processImage (rts2image::Image * image);
@@ -144,6 +289,35 @@ class AppImage:public rts2image::AppImageCore
 		double err;
 
 		std::vector <rts2core::IniParser *> fitsTemplates;
+
+#ifdef RTS2_HAVE_PGSQL
+		bool ingest;
+		int headerThreads;
+		int ioThreads;
+		int batchSize;
+		const char *checkpointFile;
+
+		// true if CFITSIO was built thread-safe
+		bool fitsReentrant;
+		// serializes CFITSIO calls of the ingest workers and the main thread
+		pthread_mutex_t fitsMutex;
+
+		pthread_mutex_t *getFitsMutex () { return fitsReentrant ? NULL : &fitsMutex; }
+
+		/**
+		 * Insert images from given files and directories. Headers
+		 * are read in parallel, images are inserted in batches
+		 * committed in a single transaction, then moved and linked in
+		 * parallel. Files of the committed batches are appended to
+		 * the checkpoint file and skipped by the next run.
+		 */
+		int doIngest ();
+
+		void scanPath (const std::string &path, std::vector <std::string> &files);
+		int loadCheckpoint (std::set <std::string> &done);
+		// move and link images of the batch, returns number of failures
+		int ingestFileOps (std::vector <IngestOpen *> &batch, rts2core::ThreadPool &ioPool);
+#endif
 };
 
 }
@@ -309,6 +483,32 @@ int AppImage::processOption (int in_opt)
 		case 'i':
 			operation |= IMAGEOP_INSERT;
 			break;
+		case OPT_INGEST:
+			operation |= IMAGEOP_INSERT;
+			ingest = true;
+			break;
+		case OPT_THREADS:
+			headerThreads = atoi (optarg);
+			break;
+		case OPT_IO_THREADS:
+			ioThreads = atoi (optarg);
+			if (ioThreads < 1)
+			{
+				std::cerr << "number of I/O threads must be positive" << std::endl;
+				return -1;
+			}
+			break;
+		case OPT_BATCH:
+			batchSize = atoi (optarg);
+			if (batchSize < 1)
+			{
+				std::cerr << "batch size must be positive" << std::endl;
+				return -1;
+			}
+			break;
+		case OPT_CHECKPOINT:
+			checkpointFile = optarg;
+			break;
 #endif					 /* RTS2_HAVE_PGSQL */
 		case OPT_OBSID:
 			obsid = atoi (optarg);
@@ -424,6 +624,280 @@ bool AppImage::doInitDB ()
 {
 	return (operation & IMAGEOP_MOVE) || (operation & IMAGEOP_INSERT);
 }
+
+int AppImage::doProcessing ()
+{
+	if (ingest)
+		return doIngest ();
+	return AppDbImage::doProcessing ();
+}
+
+static double now ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static bool isFitsName (const char *name)
+{
+	const char *ext = strrchr (name, '.');
+	return ext && (!strcasecmp (ext, ".fits") || !strcasecmp (ext, ".fit") || !strcasecmp (ext, ".fts"));
+}
+
+void AppImage::scanPath (const std::string &path, std::vector <std::string> &files)
+{
+	struct stat sb;
+	if (stat (path.c_str (), &sb))
+	{
+		logStream (MESSAGE_ERROR) << "cannot access " << path << ": " << strerror (errno) << sendLog;
+		return;
+	}
+	if (!S_ISDIR (sb.st_mode))
+	{
+		files.push_back (path);
+		return;
+	}
+	DIR *d = opendir (path.c_str ());
+	if (d == NULL)
+	{
+		logStream (MESSAGE_ERROR) << "cannot open directory " << path << ": " << strerror (errno) << sendLog;
+		return;
+	}
+	struct dirent *de;
+	while ((de = readdir (d)) != NULL)
+	{
+		if (de->d_name[0] == '.')
+			continue;
+		std::string p = path + "/" + de->d_name;
+		if (de->d_type == DT_DIR || (de->d_type == DT_UNKNOWN && stat (p.c_str (), &sb) == 0 && S_ISDIR (sb.st_mode)))
+			scanPath (p, files);
+		else if (isFitsName (de->d_name))
+			files.push_back (p);
+	}
+	closedir (d);
+}
+
+int AppImage::loadCheckpoint (std::set <std::string> &done)
+{
+	std::vector <std::string> lines;
+	if (readCheckpoint (checkpointFile, lines))
+		return -1;
+	done.insert (lines.begin (), lines.end ());
+	return 0;
+}
+
+int AppImage::ingestFileOps (std::vector <IngestOpen *> &batch, rts2core::ThreadPool &ioPool)
+{
+	std::vector <IngestFileOps *> ops;
+	for (std::vector <IngestOpen *>::iterator iter = batch.begin (); iter != batch.end (); iter++)
+	{
+		IngestFileOps *op = new IngestFileOps (*iter, move_expr, link_expr);
+		ops.push_back (op);
+		ioPool.submit (op);
+	}
+
+	int failed = 0;
+	for (std::vector <IngestFileOps *>::iterator iter = ops.begin (); iter != ops.end (); iter++)
+	{
+		IngestFileOps *op = *iter;
+		ioPool.wait (op);
+		ImageDb *image = op->file->image;
+		int ret = 0;
+		lockFits (getFitsMutex ());
+		if (op->isFailed ())
+		{
+			logStream (MESSAGE_ERROR) << op->getError () << sendLog;
+			ret = -1;
+		}
+		else if (op->crossDevice)
+		{
+			ret = image->renameImage (op->movePath.c_str ());
+			if (ret == 0 && link_expr)
+				ret = image->symlinkImageExpand (link_expr);
+		}
+		else if (op->moved)
+		{
+			ret = image->updatePath ();
+		}
+		unlockFits (getFitsMutex ());
+		if (ret)
+		{
+			failed++;
+			op->file->ingested = false;
+		}
+		delete op;
+	}
+	return failed;
+}
+
+int AppImage::doIngest ()
+{
+	std::vector <std::string> files;
+	for (std::list <const char *>::iterator iter = imageNames.begin (); iter != imageNames.end (); iter++)
+	{
+		// checkpoint must match for any working directory
+		char *rp = realpath (*iter, NULL);
+		scanPath (rp ? rp : *iter, files);
+		free (rp);
+	}
+	std::sort (files.begin (), files.end ());
+
+	std::set <std::string> done;
+	FILE *checkpoint = NULL;
+	if (checkpointFile)
+	{
+		if (loadCheckpoint (done))
+		{
+			logStream (MESSAGE_ERROR) << "cannot read checkpoint " << checkpointFile << ": " << strerror (errno) << sendLog;
+			return -1;
+		}
+		checkpoint = fopen (checkpointFile, "a");
+		if (checkpoint == NULL)
+		{
+			logStream (MESSAGE_ERROR) << "cannot open checkpoint " << checkpointFile << ": " << strerror (errno) << sendLog;
+			return -1;
+		}
+	}
+
+	std::vector <std::string> todo;
+	for (std::vector <std::string>::iterator iter = files.begin (); iter != files.end (); iter++)
+	{
+		if (done.find (*iter) == done.end ())
+			todo.push_back (*iter);
+	}
+	if (todo.size () < files.size ())
+		std::cout << "skipping " << (files.size () - todo.size ()) << " files ingested by previous run" << std::endl;
+
+	// all files of the batch are open until it is committed
+	struct rlimit rl;
+	if (getrlimit (RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY && (rlim_t) batchSize + INGEST_RESERVED_FDS > rl.rlim_cur)
+	{
+		int maxBatch = rl.rlim_cur > 2 * INGEST_RESERVED_FDS ? rl.rlim_cur - INGEST_RESERVED_FDS : rl.rlim_cur / 2;
+		if (maxBatch < 1)
+			maxBatch = 1;
+		logStream (MESSAGE_WARNING) << "batch size " << batchSize << " exceeds limit of " << rl.rlim_cur << " open files, using batch of " << maxBatch << " images" << sendLog;
+		batchSize = maxBatch;
+	}
+
+	// moves and links are done after the insert
+	bool fileOps = operation & (IMAGEOP_MOVE | IMAGEOP_SYMLINK);
+	int imageOps = operation & ~(IMAGEOP_INSERT | IMAGEOP_MOVE | IMAGEOP_SYMLINK);
+
+	rts2core::ThreadPool headerPool (headerThreads);
+	rts2core::ThreadPool ioPool (ioThreads);
+	if (headerPool.start () || (fileOps && ioPool.start ()))
+	{
+		logStream (MESSAGE_ERROR) << "cannot start worker threads" << sendLog;
+		if (checkpoint)
+			fclose (checkpoint);
+		return -1;
+	}
+
+	ImageDb::setBatch (true);
+
+	size_t processed = 0;
+	size_t failed = 0;
+	double bytes = 0;
+	double start = now ();
+	int ret = 0;
+
+	for (size_t b = 0; b < todo.size () && ret == 0; b += batchSize)
+	{
+		size_t e = std::min (todo.size (), b + batchSize);
+		std::vector <IngestOpen *> opened;
+		for (size_t i = b; i < e; i++)
+		{
+			IngestOpen *t = new IngestOpen (todo[i], readOnly, getFitsMutex ());
+			opened.push_back (t);
+			headerPool.submit (t);
+		}
+
+		// insert in the order of files
+		std::vector <IngestOpen *> inserted;
+		for (std::vector <IngestOpen *>::iterator iter = opened.begin (); iter != opened.end (); iter++)
+		{
+			IngestOpen *t = *iter;
+			headerPool.wait (t);
+			if (t->isFailed ())
+			{
+				logStream (MESSAGE_ERROR) << "cannot open " << t->path << ": " << t->getError () << sendLog;
+				failed++;
+				continue;
+			}
+			// other images of the batch are still read by the header workers
+			lockFits (getFitsMutex ());
+			int saveOp = operation;
+			operation = imageOps;
+			if (operation != IMAGEOP_NOOP)
+				processImage (t->image);
+			operation = saveOp;
+			unsigned long sqlErrors = ImageDb::getSqlErrors ();
+			int iret = insert (t->image);
+			unlockFits (getFitsMutex ());
+			if (iret || ImageDb::getSqlErrors () != sqlErrors)
+			{
+				failed++;
+				continue;
+			}
+			t->ingested = true;
+			inserted.push_back (t);
+		}
+
+		if (ImageDb::commitBatch ())
+		{
+			logStream (MESSAGE_ERROR) << "cannot commit batch of " << inserted.size () << " images, stopping; rerun to continue" << sendLog;
+			ret = -1;
+		}
+		else
+		{
+			if (fileOps)
+			{
+				failed += ingestFileOps (inserted, ioPool);
+				if (ImageDb::commitBatch ())
+				{
+					logStream (MESSAGE_ERROR) << "cannot commit new paths of " << inserted.size () << " images, stopping; rerun to continue" << sendLog;
+					ret = -1;
+				}
+			}
+
+			for (std::vector <IngestOpen *>::iterator iter = inserted.begin (); iter != inserted.end () && ret == 0; iter++)
+			{
+				if (!(*iter)->ingested)
+					continue;
+				processed++;
+				bytes += (*iter)->size;
+				if (checkpoint)
+					fprintf (checkpoint, "%s\n", (*iter)->path.c_str ());
+			}
+			if (checkpoint && (fflush (checkpoint) || fsync (fileno (checkpoint))))
+			{
+				logStream (MESSAGE_ERROR) << "cannot write checkpoint " << checkpointFile << ": " << strerror (errno) << sendLog;
+				ret = -1;
+			}
+		}
+
+		for (std::vector <IngestOpen *>::iterator iter = opened.begin (); iter != opened.end (); iter++)
+			delete *iter;
+
+		double elapsed = now () - start;
+		std::cout << "ingested " << processed << " of " << todo.size () << " files, " << failed << " failed, "
+			<< std::fixed << std::setprecision (1) << (elapsed > 0 ? processed / elapsed : 0) << " files/s, "
+			<< (elapsed > 0 ? bytes / elapsed / 1048576.0 : 0) << " MB/s" << std::endl;
+	}
+
+	ImageDb::setBatch (false);
+	headerPool.stop ();
+	if (fileOps)
+		ioPool.stop ();
+
+	if (checkpoint)
+		fclose (checkpoint);
+
+	if (ret == 0 && failed > 0)
+		ret = -1;
+	return ret;
+}
 #endif
 
 #ifdef RTS2_HAVE_PGSQL
@@ -486,7 +960,11 @@ void AppImage::usage ()
 		<< "  rts2-image -w -o 20.12:10.56 123.fits      .. same as above, but add X offset of 20.12 pixels and Y offset of 10.56 pixels to WCS" << std::endl
 		<< "  rts2-image -P @DATE_OBS/@POS_ERR 123.fits  .. prints DATE_OBS and POS_ERR keywords" << std::endl
 		<< "  rts2-image -d 10:15-20:25 123.fits         .. prints RA DEC distance between pixel (10,15) and (20,25)" << std::endl
-		<< "  rts2-image --label '%H:%M' -j out.jpeg 123.fits  .. creates out.jpeg, add label consisting of exposure hour and minute" << std::endl;
+		<< "  rts2-image --label '%H:%M' -j out.jpeg 123.fits  .. creates out.jpeg, add label consisting of exposure hour and minute" << std::endl
+#ifdef RTS2_HAVE_PGSQL
+		<< "  rts2-image --ingest --checkpoint ingest.log -m '/archive/%f' /data/night  .. inserts images from /data/night to the database and moves them to archive; rerun with the same checkpoint continues interrupted ingest" << std::endl
+#endif
+		;
 }
 
 AppImage::AppImage (int in_argc, char **in_argv, bool in_readOnly):
@@ -522,6 +1000,18 @@ rts2image::AppImageCore (in_argc, in_argv, in_readOnly)
 
 	err_ra = err_dec = err = NAN;
 
+#ifdef RTS2_HAVE_PGSQL
+	ingest = false;
+	headerThreads = 0;
+	ioThreads = 4;
+	batchSize = 100;
+	checkpointFile = NULL;
+
+	// CFITSIO built with thread support does not need to be serialized
+	fitsReentrant = fits_is_reentrant ();
+	pthread_mutex_init (&fitsMutex, NULL);
+#endif
+
 	addOption (OPT_APPEND_EXTENSIONS, "append-extensions", 1, "append images specified as arguments to the given (new) image specified as option");
 	addOption ('p', NULL, 1, "print image expression");
 	addOption ('P', NULL, 1, "print filename followed by expression");
@@ -532,6 +1022,13 @@ rts2image::AppImageCore (in_argc, in_argv, in_readOnly)
 	addOption (OPT_ADDDATE, "add-date", 0, "add DATE-OBS to image header");
 	addOption (OPT_ADDHELIO, "add-heliocentric", 0, "add JD_HELIO to image header (contains heliocentric time)");
 	addOption ('i', NULL, 0, "insert/update image(s) in the database");
+#ifdef RTS2_HAVE_PGSQL
+	addOption (OPT_INGEST, "ingest", 0, "insert images from directories (scanned recursively) and files given as arguments in parallel batches");
+	addOption (OPT_THREADS, "threads", 1, "number of threads reading image headers during ingest (default to number of processors)");
+	addOption (OPT_IO_THREADS, "io-threads", 1, "number of threads moving and linking images during ingest (default to 4)");
+	addOption (OPT_BATCH, "batch", 1, "number of images committed in a single transaction during ingest (default to 100)");
+	addOption (OPT_CHECKPOINT, "checkpoint", 1, "file recording ingested images; images recorded in it are skipped, so interrupted ingest can be resumed");
+#endif
 	addOption (OPT_OBSID, "obsid", 1, "force observation ID for image operations");
 	addOption (OPT_IMGID, "imgid", 1, "force image ID for image operations");
 	addOption (OPT_CAMNAME, "camera", 1, "force camera name for image operations");
@@ -561,6 +1058,10 @@ AppImage::~AppImage ()
 
 	delete appendOutput;
 
+#ifdef RTS2_HAVE_PGSQL
+	pthread_mutex_destroy (&fitsMutex);
+#endif
+
 #ifdef RTS2_HAVE_LIBJPEG
   	MagickLib::DestroyMagick ();
 #endif /* RTS2_HAVE_LIBJPEG */
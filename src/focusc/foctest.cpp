@@ -32,7 +32,8 @@ int main (int argc, char **argv)
 	rts2image::Image *image;
 	long naxes[2];
 	image = new rts2image::Image ();
-	image->openFile (argv[1]);
+	image->setMapChannels (true);
+	image->openFile (argv[1], true);
 	std::cout << "average: " << image->getAverage () << std::endl;
 	image->getValues ("NAXIS", naxes, 2);
 	std::cout << "NAXIS: " << naxes[0] << "x" << naxes[1] << std::endl;
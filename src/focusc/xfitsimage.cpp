@@ -19,6 +19,7 @@
 
 #include "xfitsimage.h"
 #include "command.h"
+#include "robuststat.h"
 
 #include <rts2-config.h>
 
@@ -30,24 +31,6 @@
 
 #include <iomanip>
 
-int cmpbyte (const void *a, const void *b)
-{
-#define A (*((uint8_t*) a))
-#define B (*((uint8_t*) b))
-	return A > B ? 1 : -1;
-#undef A
-#undef B
-}
-
-int cmpuint16_t (const void *a, const void *b)
-{
-#define A (*((uint16_t*) a))
-#define B (*((uint16_t*) b))
-	return A > B ? 1 : -1;
-#undef A
-#undef B
-}
-
 XFitsImage::XFitsImage (rts2core::Connection *_connection, rts2core::DevClient *_client)
 {
 	connection = _connection;
@@ -518,78 +501,16 @@ void XFitsImage::drawImage (rts2image::Image * image, int chan, Display * _displ
 
 double XFitsImage::classical_median (void *q, int16_t dataType, int n, double *sigma, double sf)
 {
-	int i;
-	double M,S;
-	char *f;
+	rts2core::RobustStat st;
+	rts2core::robustStatistics (q, dataType, n, 1, n, st, 0, 0);
 
-	switch (dataType)
-	{
-		case RTS2_DATA_BYTE:
-			f = (char *) new uint8_t[n];
-			memcpy (f, q, n * sizeof (uint8_t));
-			qsort (f, n, sizeof (uint8_t), cmpbyte);
-#define F ((char *) f)
-			if (n % 2)
-				M = F[n / 2];
-			else
-		 	 	M = (F[n / 2] + F[n / 2 + 1]) / 2;
-			min = F[0];
-			max = F[n - 1];
-#undef F
-			break;
-		case RTS2_DATA_USHORT:
-			f = (char *) new uint16_t[n];
-			memcpy (f, q, n * sizeof (uint16_t));
-			qsort (f, n, sizeof (uint16_t), cmpuint16_t);
-#define F ((uint16_t *) f)
-			if (n % 2)
-				M = F[n / 2];
-			else
-		 	 	M = (F[n / 2] + F[n / 2 + 1]) / 2;
-			min = F[0];
-			max = F[n - 1];	
-#undef F
-			break;
-		default:
-			throw rts2core::Error ("unsuported data type");
-	}
+	min = st.min;
+	max = st.max;
 
 	if (sigma)
-	{
-		switch (dataType)
-		{
-			case RTS2_DATA_BYTE:
-#define F ((uint8_t *) f)
-				for (i = 0; i < n; i++)
-					F[i] = (uint8_t) fabs(F[i] - M);
-				qsort (f, n, sizeof(uint8_t), cmpbyte);
-				if (n % 2)
-					S = F[n / 2];
-				else
-					S = (F[n / 2] + F[n / 2 + 1]) / 2;
-
-#undef F
-				break;
-
-			case RTS2_DATA_USHORT:
-#define F ((uint16_t *) f)
-				for (i = 0; i < n; i++)
-					F[i] = (uint16_t) fabs(F[i] - M);
-				qsort (f, n, sizeof(uint16_t), cmpuint16_t);
-				if (n % 2)
-					S = F[n / 2];
-				else
-					S = (F[n / 2] + F[n / 2 + 1]) / 2;
-
-#undef F
-				break;
-		}
-		*sigma = S * sf;
-	}
-
-	delete[] f;
+		*sigma = st.mad * sf;
 
-	return M;
+	return st.median;
 }
 
 void XFitsImage::buildWindow ()
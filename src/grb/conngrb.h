@@ -21,21 +21,119 @@
 #define __RTS2_GRBCONN__
 
 #include "connnosend.h"
+#include "threadpool.h"
 
+#include "gcnparser.h"
+#include "gcntracker.h"
 #include "grbconst.h"
 #include "grbd.h"
 
+#include <sstream>
+#include <vector>
+
 namespace rts2grbd
 {
 
 class Grbd;
 
+/**
+ * Stores GCN notice in the database. Runs in the GRB daemon store
+ * thread, so target can be passed to executor without waiting for the
+ * database. Results are processed in completed from the daemon event
+ * loop.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class GcnStore:public rts2core::PoolTask
+{
+	public:
+		/**
+		 * @param _master   GRB daemon
+		 * @param _packet   notice packet (host byte order)
+		 * @param _received time notice was received
+		 * @param _point    parsed notice
+		 * @param _hasPoint if false, only raw packet is stored
+		 */
+		GcnStore (Grbd *_master, int32_t *_packet, struct timeval *_received, GcnPoint &_point, bool _hasPoint = true);
+
+		virtual void run ();
+		virtual void completed ();
+
+		/**
+		 * Store notice with the default connection of the calling thread.
+		 */
+		void store ();
+
+		Grbd *master;
+
+		int32_t packet[SIZ_PKT];
+		struct timeval received;
+
+		bool hasPoint;
+		GcnPoint point;
+
+		// snapshot of daemon settings
+		bool createDisabled;
+		bool followTransients;
+
+		// in-memory decision
+		gcnAction_t action;
+		int fast_tar_id;
+		// reserve target ID for the next new GRB
+		bool reserveNext;
+		// target was passed to executor before it was stored
+		bool dispatched;
+		// time notice was parsed
+		double parsed;
+
+		// results
+		int ret;
+		// GRB was stored, and known holds its database values
+		bool stored;
+		GcnKnown known;
+		bool isnew;
+		// known source was disabled
+		bool disabled;
+		// GRB does not have error box, or the update was ignored
+		bool noErrorbox;
+		// next reserved grb_tar_id, -1 if not reserved
+		int nextReserve;
+		double storedTime;
+
+		// store thread was not connected, store from the event loop
+		bool retryInline;
+		bool failed;
+		std::string error;
+
+		// log messages are sent from the event loop
+		std::vector <std::pair <messageType_t, std::string> > messages;
+
+	private:
+		void addMessage (messageType_t type, std::ostringstream &_os) { messages.push_back (std::pair <messageType_t, std::string> (type, _os.str ())); }
+		void storeRaw ();
+};
+
+/**
+ * Connects store thread to the database. Must be the first task submitted to the store thread.
+ */
+class GcnStoreConnect:public rts2core::PoolTask
+{
+	public:
+		GcnStoreConnect (Grbd *_master):rts2core::PoolTask () { master = _master; }
+
+		virtual void run ();
+		virtual void completed ();
+
+	private:
+		Grbd *master;
+};
+
 /**
  * GCN sokcet connection.
  *
  * @author Petr Kubanek <petr@kubanek.net>
  */
-class ConnGrb:public rts2core::ConnNoSend
+class ConnGrb:public rts2core::ConnNoSend, public GcnParser
 {
 	public:
 		ConnGrb (char *in_gcn_hostname, int in_gcn_port, rts2core::ValueBool *in_do_hete_test, char *in_addExe, int in_execFollowups, Grbd * in_master);
@@ -48,6 +146,34 @@ class ConnGrb:public rts2core::ConnNoSend
 		virtual void connectionError (int last_data_size);
 		virtual int receive (rts2core::Block *block);
 
+		/**
+		 * Process recorded packet as if it was received from GCN. Packet
+		 * is not echoed back nor forwarded, and kill socket requests are
+		 * ignored.
+		 *
+		 * @param packet  packet in network byte order
+		 */
+		void replayPacket (int32_t *packet);
+
+		/**
+		 * Only parse and log replayed packets, do not touch the
+		 * database nor the executor.
+		 */
+		void setDryRun (bool _dryRun) { dryRun = _dryRun; }
+
+		/**
+		 * Append received packets to file. The file descriptor is owned
+		 * (and closed) by the caller.
+		 *
+		 * @param fd  file descriptor, -1 to stop recording
+		 */
+		void setRecordFile (int fd) { recordFd = fd; }
+
+		/**
+		 * Called from the event loop after notice was stored in the database.
+		 */
+		void storeCompleted (GcnStore *task);
+
 		double lastPacket ();
 		double delta ();
 		char *lastTarget ();
@@ -58,9 +184,25 @@ class ConnGrb:public rts2core::ConnNoSend
 		double lastDec () { return last_dec; }
 		double lastTargetErrobox () { return last_target_errorbox; }
 
-		void setGbmError (double _error) { gbm_error = _error; }
-		void setGbmRecordAboveError (bool _record) { gbm_record_above = _record; }
-		void setGbmEnabledAboveError (bool _enabled) { gbm_enable_above = _enabled; }
+	protected:
+		virtual bool processTests () { return do_hete_test->getValueBool (); }
+		virtual void imAlive ();
+
+		// DB operations
+		// insert GCN position
+		// that's for notices with which we are sure they contain position
+		// if they are various NACK types, we set insertOnly flag to true and will
+		// only produce insert when it's new GRB (when packet with detection get lost, as
+		// was cause of GRB060929 and most probably others).
+		// Return -1 on error, 1 when insertOnly flag is true and it's update packet
+		virtual int addGcnPoint (int grb_id, int grb_seqn, int grb_type, double grb_ra, double grb_dec, bool grb_is_grb, time_t * grb_date, long grb_date_usec, float grb_errorbox, bool insertOnly, bool enabled);
+		virtual int addGcnRaw (int grb_id, int grb_seqn, int grb_type);
+		virtual int setNotGrb (int grb_id, int grb_seqn, int grb_type);
+
+		virtual int addSwiftPoint (double roll, char *name, float obstime, float merit);
+		virtual int addIntegralPoint (double ra, double dec, const time_t * t);
+
+		virtual void killSocket ();
 
 	private:
 		Grbd * master;
@@ -71,7 +213,6 @@ class ConnGrb:public rts2core::ConnNoSend
 
 		int gcnReceivedBytes;	 // number of bytes received
 
-		int32_t lbuf[SIZ_PKT];		 // local buffer - swaped for Linux
 		int32_t nbuf[SIZ_PKT];		 // network buffer
 		struct timeval last_packet;
 		double here_sod;		 // machine SOD (seconds after 0 GMT)
@@ -92,47 +233,24 @@ class ConnGrb:public rts2core::ConnNoSend
 		int init_listen ();
 		int init_call ();
 
-		// utility functions..
-		double getPktSod ();
-
-		void getTimeTfromTJD (long TJD, double SOD, time_t * in_time, long *usec = NULL);
-
-		double getJDfromTJD (long TJD, double SOD) { return TJD + 2440000.5 + SOD / 86400.0; }
-		// process various messages..
-		int pr_test ();
-		int pr_imalive ();
-		int pr_swift_point ();	 // swift pointing.
-		int pr_integral_point ();// integral pointing
-		int pr_agile_point ();
-		int pr_fermi_point ();
-		// burst messages
-		int pr_hete ();
-		int pr_integral ();
-		int pr_integral_spicas ();
-		int pr_swift_with_radec ();
-		int pr_swift_without_radec ();
-		int pr_agile ();  // AGILE messages (100-102)
-		int pr_fermi_gbm ();
-		int pr_fermi_lat ();
-		int pr_fermi_sc ();
-
-		// GRB db stuff
-		int addSwiftPoint (double roll, char *name, float obstime, float merit);
-		int addIntegralPoint (double ra, double dec, const time_t * t);
-
-		void getGrbBound (int grb_type, int &grb_start, int &grb_end);
-		bool gcnContainsGrbPos (int grb_type);
-		float getInstrumentErrorBox (int grb_type);
+		// process packet in nbuf
+		void processPacket (bool echo);
 
-		// DB operations
-		// insert GCN position
-		// that's for notices with which we are sure they contain position
-		// if they are various NACK types, we set insertOnly flag to true and will
-		// only produce insert when it's new GRB (when packet with detection get lost, as
-		// was cause of GRB060929 and most probably others).
-		// Return -1 on error, 1 when insertOnly flag is true and it's update packet
-		int addGcnPoint (int grb_id, int grb_seqn, int grb_type, double grb_ra, double grb_dec, bool grb_is_grb, time_t * grb_date, long grb_date_usec, float grb_errorbox, bool insertOnly, bool enabled);
-		int addGcnRaw (int grb_id, int grb_seqn, int grb_type);
+		// GRBs known in memory, for dispatch before GRB is stored
+		GcnTracker tracker;
+		bool trackerLoaded;
+		void loadTracker ();
+		// load GRB from the database to tracker
+		void loadKnown (GcnPoint &point);
+
+		// if GRB shall be passed to executor
+		bool shouldExecute (GcnPoint &point, float errorbox, bool noErrorbox, bool report);
+
+		int recordFd;
+
+		// packet is replayed from the file
+		bool replaying;
+		bool dryRun;
 
 		int gcn_port;
 		char *gcn_hostname;
@@ -140,15 +258,7 @@ class ConnGrb:public rts2core::ConnNoSend
 
 		int gcn_listen_sock;
 
-		time_t swiftLastPoint;
-		double swiftLastRa;
-		double swiftLastDec;
-
 		time_t nextTime;
-
-		double gbm_error;
-		bool gbm_record_above;
-		bool gbm_enable_above;
 };
 
 }
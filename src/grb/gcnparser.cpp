@@ -0,0 +1,677 @@
+/*
+ * Parser of GCN socket packets.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "gcnparser.h"
+#include "app.h"
+
+#include <arpa/inet.h>
+#include <math.h>
+#include <string.h>
+
+#include <libnova/libnova.h>
+
+using namespace rts2grbd;
+
+GcnParser::GcnParser ()
+{
+	memset (lbuf, 0, sizeof (lbuf));
+
+	swiftLastPoint = 0;
+	swiftLastRa = NAN;
+	swiftLastDec = NAN;
+
+	gbm_error = 0.25;
+	gbm_record_above = true;
+	gbm_enable_above = false;
+}
+
+int GcnParser::parsePacket (const int32_t *packet)
+{
+	// swap bytes..
+	for (int i = 0; i < SIZ_PKT; i++)
+	{
+		lbuf[i] = ntohl (packet[i]);
+	}
+
+	// switch based on packet content
+	switch (lbuf[PKT_TYPE])
+	{
+		case TYPE_TEST_COORDS:
+			pr_test ();
+			break;
+		case TYPE_IM_ALIVE:
+			imAlive ();
+			break;
+			// pondtirs messages with history..
+		case TYPE_INTEGRAL_POINTDIR_SRC:
+			pr_integral_point ();
+			break;
+							 // 83  // Swift Pointing Direction
+		case TYPE_SWIFT_POINTDIR_SRC:
+			pr_swift_point ();
+			break;
+		case TYPE_AGILE_POINTDIR:
+			pr_agile_point ();
+			break;
+		case TYPE_FERMI_POINTDIR:
+			pr_fermi_point ();
+			break;
+		// hete, integral & swift GRB observations
+		case TYPE_HETE_ALERT_SRC:
+		case TYPE_HETE_UPDATE_SRC:
+		case TYPE_HETE_FINAL_SRC:
+		case TYPE_HETE_GNDANA_SRC:
+		case TYPE_HETE_TEST:
+		case TYPE_GRB_CNTRPART_SRC:
+			pr_hete ();
+			break;
+		case TYPE_INTEGRAL_WAKEUP_SRC:
+		case TYPE_INTEGRAL_REFINED_SRC:
+		case TYPE_INTEGRAL_OFFLINE_SRC:
+			pr_integral ();
+			break;
+			// integral spiacs
+		case TYPE_INTEGRAL_SPIACS_SRC:
+			pr_integral_spicas ();
+			break;
+		case TYPE_SWIFT_BAT_GRB_POS_ACK_SRC:
+		case TYPE_SWIFT_BAT_GRB_LC_SRC:
+		case TYPE_SWIFT_FOM_2OBSAT_SRC:
+		case TYPE_SWIFT_FOSC_2OBSAT_SRC:
+		case TYPE_SWIFT_XRT_POSITION_SRC:
+		case TYPE_SWIFT_XRT_SPECTRUM_SRC:
+		case TYPE_SWIFT_XRT_IMAGE_SRC:
+		case TYPE_SWIFT_XRT_LC_SRC:
+		case TYPE_SWIFT_UVOT_SLIST_SRC:
+			// processed messages
+		case TYPE_SWIFT_BAT_GRB_LC_PROC_SRC:
+		case TYPE_SWIFT_XRT_SPECTRUM_PROC_SRC:
+		case TYPE_SWIFT_XRT_IMAGE_PROC_SRC:
+		case TYPE_SWIFT_UVOT_SLIST_PROC_SRC:
+		case TYPE_SWIFT_UVOT_POS_SRC:
+			// transient
+		case TYPE_SWIFT_BAT_TRANS:
+			pr_swift_with_radec ();
+			break;
+		case TYPE_SWIFT_BAT_GRB_ALERT_SRC:
+		case TYPE_SWIFT_BAT_GRB_POS_NACK_SRC:
+		case TYPE_SWIFT_SCALEDMAP_SRC:
+		case TYPE_SWIFT_XRT_CENTROID_SRC:
+		case TYPE_SWIFT_UVOT_IMAGE_SRC:
+			// processed messages
+		case TYPE_SWIFT_UVOT_IMAGE_PROC_SRC:
+		case TYPE_SWIFT_UVOT_NACK_POSITION:
+			pr_swift_without_radec ();
+			break;
+		case TYPE_AGILE_GRB_WAKEUP:
+		case TYPE_AGILE_GRB_PROMPT:
+		case TYPE_AGILE_GRB_REFINED:
+		case TYPE_AGILE_TRANS:
+		case TYPE_AGILE_GRB_POS_TEST:
+			pr_agile ();
+			break;
+		case TYPE_FERMI_GBM_ALERT:
+			break;
+		case TYPE_FERMI_GBM_FLT_POS:
+		case TYPE_FERMI_GBM_GND_POS:
+		case TYPE_FERMI_GBM_LC:
+		case TYPE_FERMI_GBM_TRANS:
+			pr_fermi_gbm ();
+			break;
+		case TYPE_FERMI_LAT_POS_INI:
+		case TYPE_FERMI_LAT_POS_UPD:
+		case TYPE_FERMI_LAT_POS_DIAG:
+		case TYPE_FERMI_LAT_TRANS:
+			pr_fermi_lat ();
+			break;
+		case TYPE_FERMI_OBS_REQ:
+		case TYPE_FERMI_SC_SLEW:
+			pr_fermi_sc ();
+			break;
+		case TYPE_KILL_SOCKET:
+			killSocket ();
+			break;
+		default:
+			logStream (MESSAGE_ERROR) << "GcnParser::parsePacket unknow packet type: " << lbuf[PKT_TYPE] << sendLog;
+			break;
+	}
+	return lbuf[PKT_TYPE];
+}
+
+double GcnParser::getPktSod ()
+{
+	return lbuf[PKT_SOD]/100.0;
+}
+
+void GcnParser::getTimeTfromTJD (long TJD, double SOD, time_t * in_time, long * usec)
+{
+	double JD = getJDfromTJD (TJD, SOD);
+	ln_get_timet_from_julian (JD, in_time);
+	if (usec)
+		*usec = (int)((SOD - int (SOD)) * USEC_SEC);
+}
+
+int GcnParser::pr_test ()
+{
+	logStream (MESSAGE_INFO) << "Test GCN notice Trig#: " << (lbuf[BURST_TRIG])
+		<< " TJD: " << (lbuf[BURST_TJD])
+		<< " RA: " << (lbuf[BURST_RA] / 10000.0)
+		<< " DEC: " << (lbuf[BURST_DEC] / 10000.0)
+		<< " Error: " << (lbuf[BURST_ERROR])
+		<< sendLog;
+	return 0;
+}
+
+int GcnParser::pr_swift_point ()
+{
+	double roll;
+	char *obs_name;
+	float obstime;
+	float merit;
+	swiftLastRa  = lbuf[7]/10000.0;
+	swiftLastDec = lbuf[8]/10000.0;
+	roll = lbuf[9]/10000.0;
+	getTimeTfromTJD (lbuf[5], lbuf[6]/100.0, &swiftLastPoint);
+	obs_name = (char*) (&lbuf[BURST_URL]);
+	obstime = lbuf[14]/100.0;
+	merit = lbuf[15]/100.0;
+	return addSwiftPoint (roll, obs_name, obstime, merit);
+}
+
+int GcnParser::pr_integral_point ()
+{
+	struct ln_equ_posn pos_int, pos_j2000;
+	time_t t;
+	pos_int.ra = lbuf[14]/10000.0;
+	pos_int.dec = lbuf[15]/10000.0;
+	// precess to J2000
+	ln_get_equ_prec2 (&pos_int, ln_get_julian_from_sys (), JD2000, &pos_j2000);
+	getTimeTfromTJD (lbuf[5], lbuf[6]/100.0, &t);
+	return addIntegralPoint (pos_j2000.ra, pos_j2000.dec, &t);
+}
+
+int GcnParser::pr_agile_point ()
+{
+	return -1;
+}
+
+int GcnParser::pr_fermi_point ()
+{
+	return -1;
+}
+
+int GcnParser::pr_hete ()
+{
+	int grb_id;
+	int grb_seqn;
+	int grb_type;
+	struct ln_equ_posn pos_int, pos_j2000;
+	int grb_is_grb = 1;
+	time_t grb_date;
+	long grb_date_usec;
+	float grb_errorbox;
+
+	grb_id = ((lbuf[BURST_TRIG] & H_TRIGNUM_MASK) >> H_TRIGNUM_SHIFT);
+	grb_seqn = ((lbuf[BURST_TRIG] & H_SEQNUM_MASK) >> H_SEQNUM_SHIFT);
+	grb_type = lbuf[PKT_TYPE];
+
+	pos_int.ra = lbuf[BURST_RA] / 10000.0;
+	pos_int.dec = lbuf[BURST_DEC] / 10000.0;
+
+	getTimeTfromTJD (lbuf[BURST_TJD], lbuf[BURST_SOD]/100.0, &grb_date, &grb_date_usec);
+
+	grb_errorbox = (lbuf[H_WXM_DIM_NSIG] >> 16) / 3600.0;
+
+	if (!processTests ()
+		&& (grb_type == TYPE_HETE_TEST
+		|| (lbuf[H_TRIG_FLAGS] & H_ART_TRIG)
+		)
+		)
+	{
+		logStream (MESSAGE_DEBUG) << "GcnParser::pr_hete test packet" << sendLog;
+		return 0;
+	}
+
+	// convert to J2000 only when it's true GRB
+	// HETE non GRB notices (GRB retraction notices) have ra and dec -999.99, and we
+	// need to pass that value futher to addGcnPoint, so it will not update RA & DEC in DB.
+	if (pos_int.ra > -300 && pos_int.dec > -300)
+	{
+		ln_get_equ_prec2 (&pos_int, ln_get_julian_from_timet (&grb_date), JD2000, &pos_j2000);
+	}
+	else
+	{
+		pos_j2000.ra = pos_int.ra;
+		pos_j2000.dec = pos_int.dec;
+	}
+
+	if ((lbuf[H_TRIG_FLAGS] & H_DEF_NOT_GRB)
+		|| (lbuf[H_TRIG_FLAGS] & H_DEF_SGR)
+		|| (lbuf[H_TRIG_FLAGS] & H_DEF_XRB))
+		grb_is_grb = 0;
+
+	return addGcnPoint (grb_id, grb_seqn, grb_type, pos_j2000.ra, pos_j2000.dec, grb_is_grb, &grb_date, grb_date_usec, grb_errorbox, false, true);
+}
+
+int GcnParser::pr_integral ()
+{
+	int grb_id;
+	int grb_seqn;
+	int grb_type;
+	struct ln_equ_posn pos_int, pos_j2000;
+	int grb_is_grb = 1;
+	time_t grb_date;
+	long grb_date_usec;
+	float grb_errorbox;
+
+	if (!processTests ()
+		&& ((lbuf[12] & (1 << 31))
+		)
+		)
+	{
+		logStream (MESSAGE_DEBUG) << "GcnParser::pr_integral test packet (" << lbuf[12] << ")" << sendLog;
+		return 0;
+	}
+
+	grb_id = (lbuf[BURST_TRIG] & I_TRIGNUM_MASK) >> I_TRIGNUM_SHIFT;
+	grb_seqn = (lbuf[BURST_TRIG] & I_SEQNUM_MASK) >> I_SEQNUM_SHIFT;
+	grb_type = lbuf[PKT_TYPE];
+
+	pos_int.ra = lbuf[BURST_RA]/10000.0;
+	pos_int.dec = lbuf[BURST_DEC]/10000.0;
+
+	getTimeTfromTJD (lbuf[BURST_TJD], lbuf[BURST_SOD]/100.0, &grb_date, &grb_date_usec);
+
+	ln_get_equ_prec2 (&pos_int, ln_get_julian_from_timet (&grb_date), JD2000, &pos_j2000);
+
+	grb_errorbox = (float) lbuf[BURST_ERROR] / 3600.0;
+
+	if (grb_errorbox < 0 && grb_type == TYPE_INTEGRAL_OFFLINE_SRC)
+	{
+		grb_is_grb = 0;
+		grb_errorbox *= -1;
+	}
+
+	return addGcnPoint (grb_id, grb_seqn, grb_type, pos_j2000.ra, pos_j2000.dec, grb_is_grb, &grb_date, grb_date_usec, grb_errorbox, false, true);
+}
+
+int GcnParser::pr_integral_spicas ()
+{
+	logStream (MESSAGE_INFO) << "INTEGRAL SPIACS" << sendLog;
+	return 0;
+}
+
+int GcnParser::pr_swift_with_radec ()
+{
+	int grb_id;
+	int grb_seqn;
+	int grb_type;
+	double grb_ra;
+	double grb_dec;
+	int grb_is_grb = 1;
+	time_t grb_date;
+	long grb_date_usec;
+	float grb_errorbox;
+
+	grb_type = (int) (lbuf[PKT_TYPE]);
+	grb_id = (lbuf[BURST_TRIG] >> S_TRIGNUM_SHIFT) & S_TRIGNUM_MASK;
+	grb_seqn = (lbuf[BURST_TRIG] >> S_SEGNUM_SHIFT) & S_SEGNUM_MASK;
+	grb_ra = lbuf[BURST_RA] / 10000.0;
+	grb_dec = lbuf[BURST_DEC] / 10000.0;
+
+	// we will set grb_is_grb to true in some special cases..
+	switch (grb_type)
+	{
+		case TYPE_SWIFT_BAT_GRB_POS_ACK_SRC:
+		case TYPE_SWIFT_BAT_GRB_LC_SRC:
+		case TYPE_SWIFT_SCALEDMAP_SRC:
+			if ((lbuf[TRIGGER_ID] & 0x00000002)
+				&& ((lbuf[TRIGGER_ID] & 0x00000020) == 0)
+				&& !(lbuf[TRIGGER_ID] & 0x00000100))
+			{
+				grb_is_grb = 1;
+			}
+			else
+			{
+				grb_is_grb = 0;
+			}
+			break;
+		case TYPE_SWIFT_XRT_POSITION_SRC:
+			// if it's not a grb, or if its in ground cat, ignore it..
+			if ((lbuf[TRIGGER_ID] & 0x00000020)
+				|| (lbuf[TRIGGER_ID] & 0x00000100))
+			{
+				grb_is_grb = 0;
+			}
+			break;
+	}
+
+	getTimeTfromTJD (lbuf[BURST_TJD], lbuf[BURST_SOD]/100.0, &grb_date, &grb_date_usec);
+	switch (grb_type)
+	{
+		case TYPE_SWIFT_BAT_GRB_POS_ACK_SRC:
+		case TYPE_SWIFT_XRT_POSITION_SRC:
+		case TYPE_SWIFT_UVOT_POS_SRC:
+			grb_errorbox = (float) lbuf[BURST_ERROR] / 10000.0;
+			break;
+		default:
+			grb_errorbox = getInstrumentErrorBox (grb_type);
+	}
+
+	// ignore wrong packets.. (2^10 or 2^11 set)
+	if (lbuf[MISC] & 0xC00)
+	{
+		logStream (MESSAGE_INFO) << "setting error box to 360 degrees, as GCN packet, as it's MISC field suggest it is not correct: " << std::hex << lbuf[MISC] << " at RA " << std::dec << grb_ra << " DEC " << grb_dec << sendLog;
+		grb_errorbox = 360;
+	}
+
+	return addGcnPoint (grb_id, grb_seqn, grb_type, grb_ra, grb_dec, grb_is_grb, &grb_date, grb_date_usec, grb_errorbox, false, true);
+}
+
+int GcnParser::pr_swift_without_radec ()
+{
+	// those messages have only sence, when they set grb_is_grb flag to false
+	int d_grb_id;
+	int d_grb_seqn;
+	int d_grb_type;
+
+	time_t grb_date;
+	long grb_date_usec;
+
+	double grb_ra;
+	double grb_dec;
+
+	int ret;
+
+	d_grb_type = (int)(lbuf[PKT_TYPE]);
+	d_grb_id = (lbuf[BURST_TRIG] >> S_TRIGNUM_SHIFT) & S_TRIGNUM_MASK;
+	d_grb_seqn = (lbuf[BURST_TRIG] >> S_SEGNUM_SHIFT) & S_SEGNUM_MASK;
+
+	getTimeTfromTJD (lbuf[BURST_TJD], lbuf[BURST_SOD]/100.0, &grb_date, &grb_date_usec);
+
+	switch (d_grb_type)
+	{
+		case TYPE_SWIFT_BAT_GRB_ALERT_SRC:
+			// get S/C coordinates to slew on
+			// that's special in big errror-box
+			// but as we specify last know ra/dec, we will slew to best location we know about burst
+			// assume that swift will never spend more then three hours on one location, due to orbit parameters
+			// as burst can happen during slew, we have to put in fabs - otherwise we will not respond to burst
+			// catched during/before slew, but after pointdir notice was send
+			if (fabs (grb_date - swiftLastPoint) < 3 * 3600)
+				addGcnPoint (d_grb_id, d_grb_seqn, d_grb_type, swiftLastRa, swiftLastDec, 1, &grb_date, grb_date_usec, getInstrumentErrorBox (d_grb_type), false, true);
+			break;
+		case TYPE_SWIFT_BAT_GRB_POS_NACK_SRC:
+			// update if not grb..
+			setNotGrb (d_grb_id, d_grb_seqn, d_grb_type);
+			break;
+		case TYPE_SWIFT_UVOT_IMAGE_SRC:
+		case TYPE_SWIFT_UVOT_IMAGE_PROC_SRC:
+			if (lbuf[MISC] & (0x01L << 29))
+			{
+				logStream (MESSAGE_INFO) << "ignoring SWIFT UVOT SRC with UVOT_SrcList Noticed forced-out via the watchdog timeout" << sendLog;
+				return -1;
+			}
+		case TYPE_SWIFT_SCALEDMAP_SRC:
+		case TYPE_SWIFT_XRT_CENTROID_SRC:
+		case TYPE_SWIFT_UVOT_SLIST_SRC:
+		case TYPE_SWIFT_UVOT_SLIST_PROC_SRC:
+			grb_ra = lbuf[BURST_RA] / 10000.0;
+			grb_dec = lbuf[BURST_DEC] / 10000.0;
+			ret = addGcnPoint (d_grb_id, d_grb_seqn, d_grb_type, grb_ra, grb_dec, 1, &grb_date, grb_date_usec, getInstrumentErrorBox(d_grb_type), true, true);
+			// when it was sucessfullt added
+			// we don't have to add raw, as it was added in GcnPoint
+			if (!ret)
+				return ret;
+			break;
+	}
+
+	return addGcnRaw (d_grb_id, d_grb_seqn, d_grb_type);
+}
+
+int GcnParser::pr_agile ()
+{
+	int grb_id;
+	int grb_type;
+	double grb_ra;
+	double grb_dec;
+
+	int grb_is_grb = 1;
+	time_t grb_date;
+	long grb_date_usec;
+	float grb_errorbox;
+
+	grb_type = (int) (lbuf[PKT_TYPE]);
+	grb_id = lbuf[BURST_TRIG];
+	grb_ra = lbuf[BURST_RA] / 10000.0;
+	grb_dec = lbuf[BURST_DEC] / 10000.0;
+
+	if (!processTests ()
+		&& (grb_type == TYPE_AGILE_GRB_POS_TEST))
+	{
+		logStream (MESSAGE_DEBUG) << "GcnParser::pr_agile test packet" << sendLog;
+		return 0;
+	}
+
+	getTimeTfromTJD (lbuf[BURST_TJD], lbuf[BURST_SOD]/100.0, &grb_date, &grb_date_usec);
+
+	grb_errorbox = (float) lbuf[BURST_ERROR] / 10000.0;
+
+	grb_is_grb = lbuf[TRIGGER_ID] & 0x0022;
+
+	return addGcnPoint (grb_id, 1, grb_type, grb_ra, grb_dec, grb_is_grb, &grb_date, grb_date_usec, grb_errorbox, false, true);
+}
+
+int GcnParser::pr_fermi_gbm ()
+{
+	time_t grb_date;
+	long grb_date_usec;
+
+	getTimeTfromTJD (lbuf[BURST_TJD], lbuf[BURST_SOD]/100.0, &grb_date, &grb_date_usec);
+
+	double _error = lbuf[BURST_ERROR] / 10000.0;
+
+	bool enabled = false;
+	if (gbm_error < 0 || _error <= gbm_error || gbm_enable_above)
+		enabled = true;
+
+	if (gbm_record_above || gbm_error < 0 || _error <= gbm_error)
+		return addGcnPoint (lbuf[BURST_TRIG], lbuf[PKT_SERNUM], (int) lbuf[PKT_TYPE], lbuf[BURST_RA] / 10000.0, lbuf[BURST_DEC] / 10000.0, true, &grb_date, grb_date_usec, _error, false, enabled);
+	logStream (MESSAGE_INFO) << "ignoring GBM above error limit - " << gbm_error << " > " << _error << sendLog;
+	return 0;
+}
+
+int GcnParser::pr_fermi_lat ()
+{
+	logStream (MESSAGE_INFO) << "LAT messagye, type " << lbuf[PKT_TYPE] << sendLog;
+	return 0;
+}
+
+int GcnParser::pr_fermi_sc ()
+{
+	return -1;
+}
+
+void GcnParser::getGrbBound (int grb_type, int &grb_start, int &grb_end)
+{
+	if (grb_type <= TYPE_FERMI_POINTDIR)
+	{
+		if (grb_type >= TYPE_FERMI_GBM_ALERT)
+		{
+			grb_start = TYPE_FERMI_GBM_ALERT;
+			grb_end = TYPE_FERMI_POINTDIR;
+		}
+		else if (grb_type >= TYPE_AGILE_GRB_WAKEUP)
+		{
+			grb_start = TYPE_AGILE_GRB_WAKEUP;
+			grb_end = TYPE_AGILE_GRB_POS_TEST;
+		}
+		else if (grb_type >= TYPE_SWIFT_BAT_GRB_ALERT_SRC)
+		{
+			grb_start = TYPE_SWIFT_BAT_GRB_ALERT_SRC;
+			grb_end = TYPE_SWIFT_BAT_SLEW_POS_SRC;
+		}
+		else if (grb_type >= TYPE_MILAGRO_POS_SRC)
+		{
+			grb_start = TYPE_MILAGRO_POS_SRC;
+			grb_end = TYPE_KONUS_LC_SRC;
+		}
+		else if (grb_type >= TYPE_INTEGRAL_POINTDIR_SRC)
+		{
+			grb_start = TYPE_INTEGRAL_POINTDIR_SRC;
+			grb_end = TYPE_INTEGRAL_OFFLINE_SRC;
+		}
+		else if (grb_type >= TYPE_HETE_ALERT_SRC)
+		{
+			grb_start = TYPE_HETE_ALERT_SRC;
+			grb_end = TYPE_GRB_CNTRPART_SRC;
+		}
+		else if (grb_type == TYPE_IPN_POS_SRC)
+		{
+			grb_start = TYPE_IPN_POS_SRC;
+			grb_end = TYPE_IPN_POS_SRC;
+		}
+		else
+		{
+			// all fields counts - unknow type
+			logStream (MESSAGE_ERROR) << "GcnParser::getGrbBound cannot get type for grb_type " << grb_type << sendLog;
+			grb_start = 0;
+			grb_end = 5000;
+		}
+	}
+	else
+	{
+		// all fields counts - unknow type
+		logStream (MESSAGE_ERROR) << "GcnParser::getGrbBound cannot get type for grb_type " << grb_type << sendLog;
+		grb_start = 0;
+		grb_end = 5000;
+	}
+}
+
+bool GcnParser::gcnContainsGrbPos (int grb_type)
+{
+	switch (grb_type)
+	{
+		case TYPE_INTEGRAL_POINTDIR_SRC:
+		case TYPE_INTEGRAL_SPIACS_SRC:
+		case TYPE_SWIFT_SCALEDMAP_SRC:
+		case TYPE_SWIFT_XRT_CENTROID_SRC:
+		case TYPE_SWIFT_UVOT_IMAGE_SRC:
+		case TYPE_SWIFT_UVOT_SLIST_SRC:
+		case TYPE_SWIFT_UVOT_SLIST_PROC_SRC:
+		case TYPE_SWIFT_POINTDIR_SRC:
+		case TYPE_SWIFT_UVOT_NACK_POSITION:
+		case TYPE_AGILE_POINTDIR:
+		case TYPE_FERMI_POINTDIR:
+			return false;
+		default:
+			return true;
+	}
+}
+
+float GcnParser::getInstrumentErrorBox (int grb_type)
+{
+	// rules:
+	//  if it's only detection, return FOV of instrument
+	//  if it's position, return some conservative instrument everage position error
+	switch (grb_type)
+	{
+		// INTEGRAL FOV
+		case TYPE_INTEGRAL_POINTDIR_SRC:
+			return 30.0;
+			// Swift FOV
+		case TYPE_SWIFT_POINTDIR_SRC:
+			return 60.0;
+			// HETE instrumental error..
+		case TYPE_HETE_ALERT_SRC:
+		case TYPE_HETE_UPDATE_SRC:
+		case TYPE_HETE_FINAL_SRC:
+		case TYPE_HETE_GNDANA_SRC:
+		case TYPE_HETE_TEST:
+		case TYPE_GRB_CNTRPART_SRC:
+			// .. is 4 arcmin
+			return 4.0 / 60.0;
+		case TYPE_INTEGRAL_WAKEUP_SRC:
+		case TYPE_INTEGRAL_REFINED_SRC:
+		case TYPE_INTEGRAL_OFFLINE_SRC:
+			//INTEGRAL instrument error is 4 armin
+			return 4.0 / 60.0;
+		case TYPE_INTEGRAL_SPIACS_SRC:
+			// SPIACS is in fact all sky detector
+			return 180.0;
+		case TYPE_SWIFT_BAT_GRB_ALERT_SRC:
+			// BAT have 60 deg
+			return 60.0;
+		case TYPE_SWIFT_BAT_GRB_POS_ACK_SRC:
+		case TYPE_SWIFT_BAT_GRB_LC_SRC:
+		case TYPE_SWIFT_FOM_2OBSAT_SRC:
+		case TYPE_SWIFT_FOSC_2OBSAT_SRC:
+		case TYPE_SWIFT_BAT_GRB_LC_PROC_SRC:
+		case TYPE_SWIFT_BAT_TRANS:
+		case TYPE_SWIFT_BAT_GRB_POS_NACK_SRC:
+		case TYPE_SWIFT_SCALEDMAP_SRC:
+			// BAT have 4 arcmin
+			return 4.0 / 60.0;
+		case TYPE_SWIFT_XRT_POSITION_SRC:
+		case TYPE_SWIFT_XRT_SPECTRUM_SRC:
+		case TYPE_SWIFT_XRT_IMAGE_SRC:
+		case TYPE_SWIFT_XRT_LC_SRC:
+		case TYPE_SWIFT_XRT_SPECTRUM_PROC_SRC:
+		case TYPE_SWIFT_XRT_IMAGE_PROC_SRC:
+			// conservative estimate for XRT is 20 arcsec, including uncertanities
+			return 20.0 / 3600.0;
+		case TYPE_SWIFT_XRT_CENTROID_SRC:
+			// XRT FOV
+			return 15.0 / 60.0;
+		case TYPE_SWIFT_UVOT_SLIST_PROC_SRC:
+		case TYPE_SWIFT_UVOT_POS_SRC:
+			// that's VERY conservative estimate, we might refine it
+			return 19.0 / 3600.0;
+		case TYPE_SWIFT_UVOT_SLIST_SRC:
+		case TYPE_SWIFT_UVOT_IMAGE_SRC:
+		case TYPE_SWIFT_UVOT_IMAGE_PROC_SRC:
+			// UVOT FOV
+			return 15.0 / 60.0;
+		case TYPE_AGILE_GRB_WAKEUP:
+		case TYPE_AGILE_GRB_PROMPT:
+		case TYPE_AGILE_GRB_REFINED:
+		case TYPE_AGILE_TRANS:
+			return 3;
+		case TYPE_AGILE_POINTDIR:
+			return 60;
+		case TYPE_FERMI_GBM_ALERT:
+		case TYPE_FERMI_GBM_FLT_POS:
+		case TYPE_FERMI_GBM_GND_POS:
+		case TYPE_FERMI_GBM_LC:
+		case TYPE_FERMI_GBM_TRANS:
+		case TYPE_FERMI_GBM_POS_TEST:
+		case TYPE_FERMI_LAT_POS_INI:
+		case TYPE_FERMI_LAT_POS_UPD:
+		case TYPE_FERMI_LAT_POS_DIAG:
+		case TYPE_FERMI_LAT_TRANS:
+		case TYPE_FERMI_OBS_REQ:
+		case TYPE_FERMI_SC_SLEW:
+			// TODO fill that with FERMI S/C specifications, when it will be
+			// on launch pad
+			return 3.0;
+	}
+	logStream (MESSAGE_WARNING) << "GcnParser::getInstrumentErrorBox unknow type: " << grb_type
+		<< ", returning 180.0" << sendLog;
+	return 180.0;
+}
@@ -0,0 +1,133 @@
+/*
+ * Parser of GCN socket packets.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_GCNPARSER__
+#define __RTS2_GCNPARSER__
+
+#include "grbconst.h"
+
+#include <stdint.h>
+#include <time.h>
+
+namespace rts2grbd
+{
+
+/**
+ * Decodes GCN socket packets. The pr_* methods extract GRB and pointing
+ * informations from the packet and pass them to the handler methods,
+ * which are implemented by ConnGrb to store them and by tests to inspect
+ * them. The parser does not touch the database.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class GcnParser
+{
+	public:
+		GcnParser ();
+		virtual ~GcnParser () {}
+
+		/**
+		 * Decode packet and call handler for its type.
+		 *
+		 * @param packet  packet in network byte order
+		 *
+		 * @return packet type
+		 */
+		int parsePacket (const int32_t *packet);
+
+		void setGbmError (double _error) { gbm_error = _error; }
+		void setGbmRecordAboveError (bool _record) { gbm_record_above = _record; }
+		void setGbmEnabledAboveError (bool _enabled) { gbm_enable_above = _enabled; }
+
+		static void getGrbBound (int grb_type, int &grb_start, int &grb_end);
+		static bool gcnContainsGrbPos (int grb_type);
+		static float getInstrumentErrorBox (int grb_type);
+
+	protected:
+		int32_t lbuf[SIZ_PKT];		 // local buffer - swaped for Linux
+
+		double getPktSod ();
+
+		void getTimeTfromTJD (long TJD, double SOD, time_t * in_time, long *usec = NULL);
+
+		double getJDfromTJD (long TJD, double SOD) { return TJD + 2440000.5 + SOD / 86400.0; }
+
+		/**
+		 * Returns true if test notices shall be processed.
+		 */
+		virtual bool processTests () { return false; }
+
+		// handlers
+		virtual void imAlive () {}
+
+		/**
+		 * Store GCN position. See ConnGrb::addGcnPoint.
+		 *
+		 * @return -1 on error, 1 when insertOnly flag is true and it's update packet
+		 */
+		virtual int addGcnPoint (int grb_id, int grb_seqn, int grb_type, double grb_ra, double grb_dec, bool grb_is_grb, time_t * grb_date, long grb_date_usec, float grb_errorbox, bool insertOnly, bool enabled) = 0;
+
+		/**
+		 * Store raw packet of notice, which does not carry GRB position.
+		 */
+		virtual int addGcnRaw (int grb_id, int grb_seqn, int grb_type) = 0;
+
+		/**
+		 * Mark GRB as not being GRB (Swift POS_NACK notice).
+		 */
+		virtual int setNotGrb (int grb_id, int grb_seqn, int grb_type) = 0;
+
+		virtual int addSwiftPoint (double roll, char *name, float obstime, float merit) = 0;
+		virtual int addIntegralPoint (double ra, double dec, const time_t * t) = 0;
+
+		/**
+		 * GCN asked to close the connection.
+		 */
+		virtual void killSocket () = 0;
+
+		time_t swiftLastPoint;
+		double swiftLastRa;
+		double swiftLastDec;
+
+		double gbm_error;
+		bool gbm_record_above;
+		bool gbm_enable_above;
+
+	private:
+		// process various messages..
+		int pr_test ();
+		int pr_swift_point ();	 // swift pointing.
+		int pr_integral_point ();// integral pointing
+		int pr_agile_point ();
+		int pr_fermi_point ();
+		// burst messages
+		int pr_hete ();
+		int pr_integral ();
+		int pr_integral_spicas ();
+		int pr_swift_with_radec ();
+		int pr_swift_without_radec ();
+		int pr_agile ();  // AGILE messages (100-102)
+		int pr_fermi_gbm ();
+		int pr_fermi_lat ();
+		int pr_fermi_sc ();
+};
+
+}
+
+#endif // !__RTS2_GCNPARSER__
@@ -0,0 +1,108 @@
+/*
+ * Tracks GRBs received from GCN, so alerts can be dispatched before they are stored.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "gcntracker.h"
+
+using namespace rts2grbd;
+
+GcnPoint::GcnPoint ()
+{
+	grb_id = -1;
+	seqn = 0;
+	type = -1;
+	type_start = 0;
+	type_end = 5000;
+	ra = dec = NAN;
+	is_grb = true;
+	date = NAN;
+	errorbox = NAN;
+	insertOnly = false;
+	enabled = true;
+	containsPos = true;
+}
+
+gcnAction_t GcnTracker::process (GcnPoint &point, bool followTransients, bool createDisabled, int &tar_id)
+{
+	tar_id = -1;
+
+	std::map <std::pair <int, int>, GcnKnown>::iterator iter = known.find (std::pair <int, int> (point.grb_id, point.type_start));
+	if (iter == known.end ())
+	{
+		// insert only notices are rare, and known sources without transient following are not created
+		if (point.insertOnly || (point.is_grb == false && followTransients == false) || !point.hasPosition () || reserved < 0)
+			return GCN_SLOW;
+
+		GcnKnown k;
+		k.tar_id = reserved;
+		k.ra = point.ra;
+		k.dec = point.dec;
+		k.errorbox = point.errorbox;
+		k.is_grb = point.is_grb;
+		k.enabled = point.enabled && !createDisabled;
+		known[std::pair <int, int> (point.grb_id, point.type_start)] = k;
+
+		tar_id = reserved;
+		reserved = -1;
+		return GCN_NEW;
+	}
+
+	GcnKnown &k = iter->second;
+	tar_id = k.tar_id;
+
+	if (point.insertOnly)
+		return GCN_INSERT_ONLY;
+
+	// update only when new position is better than old one
+	if ((std::isnan (k.errorbox) || std::isnan (point.errorbox) || point.errorbox <= k.errorbox) && point.hasPosition ())
+	{
+		k.ra = point.ra;
+		k.dec = point.dec;
+		if (point.containsPos && !std::isnan (point.errorbox))
+		{
+			k.errorbox = point.errorbox;
+			k.is_grb = point.is_grb;
+		}
+		if (!createDisabled)
+			k.enabled = point.enabled;
+		return GCN_UPDATE;
+	}
+
+	k.is_grb = point.is_grb;
+	return GCN_IGNORED;
+}
+
+void GcnTracker::stored (int grb_id, int type_start, GcnKnown &_known)
+{
+	GcnKnown &k = known[std::pair <int, int> (grb_id, type_start)];
+	k = _known;
+	k.inDatabase = true;
+}
+
+void GcnTracker::forget (int grb_id, int type_start)
+{
+	known.erase (std::pair <int, int> (grb_id, type_start));
+}
+
+GcnKnown *GcnTracker::find (int grb_id, int type_start)
+{
+	std::map <std::pair <int, int>, GcnKnown>::iterator iter = known.find (std::pair <int, int> (grb_id, type_start));
+	if (iter == known.end ())
+		return NULL;
+	return &(iter->second);
+}
@@ -0,0 +1,158 @@
+/*
+ * Tracks GRBs received from GCN, so alerts can be dispatched before they are stored.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_GCNTRACKER__
+#define __RTS2_GCNTRACKER__
+
+#include <map>
+#include <math.h>
+
+namespace rts2grbd
+{
+
+/**
+ * GRB position parsed from GCN notice.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class GcnPoint
+{
+	public:
+		GcnPoint ();
+
+		int grb_id;
+		int seqn;
+		int type;
+		// range of types of the same GRB, see ConnGrb::getGrbBound
+		int type_start;
+		int type_end;
+		double ra;
+		double dec;
+		bool is_grb;
+		// GRB time (ctime)
+		double date;
+		float errorbox;
+		// update only if GRB is not known
+		bool insertOnly;
+		bool enabled;
+		// notice position is GRB position, not only instrument pointing
+		bool containsPos;
+
+		/**
+		 * HETE retraction notices have RA and DEC set to -999.
+		 */
+		bool hasPosition () { return ra > -300 && dec > -300; }
+};
+
+/**
+ * GRB known to the tracker.
+ */
+class GcnKnown
+{
+	public:
+		GcnKnown () { tar_id = -1; ra = dec = NAN; errorbox = NAN; is_grb = true; enabled = true; inDatabase = false; }
+
+		int tar_id;
+		double ra;
+		double dec;
+		// NAN if not known
+		float errorbox;
+		bool is_grb;
+		bool enabled;
+		// target is stored in the database
+		bool inDatabase;
+};
+
+typedef enum
+{
+	// GRB must be processed in the database first
+	GCN_SLOW,
+	// new GRB, target ID was assigned from the reserved ID
+	GCN_NEW,
+	// known GRB, position was improved
+	GCN_UPDATE,
+	// known GRB, position is not better than the known one
+	GCN_IGNORED,
+	// known GRB, notice is used only to create GRB
+	GCN_INSERT_ONLY
+} gcnAction_t;
+
+/**
+ * Keeps GRBs received from GCN in memory, so target of new or updated
+ * GRB can be passed to executor immediately after notice is parsed,
+ * before GRB is stored in the database. Decisions follow
+ * ConnGrb::addGcnPoint database logic; database stays the authority
+ * and is reported back with stored.
+ *
+ * Target IDs of new GRBs are taken from the ID reserved from the
+ * grb_tar_id sequence in advance. When there is not any reserved ID,
+ * the new GRB must wait for the database.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class GcnTracker
+{
+	public:
+		GcnTracker () { reserved = -1; }
+
+		/**
+		 * Decide how GRB from the notice shall be processed, and update known GRBs.
+		 *
+		 * @param point            parsed notice
+		 * @param followTransients if false, targets are not created for known sources
+		 * @param createDisabled   if true, enabled state of known targets is not updated
+		 * @param tar_id           returned target ID, -1 for GCN_SLOW
+		 */
+		gcnAction_t process (GcnPoint &point, bool followTransients, bool createDisabled, int &tar_id);
+
+		/**
+		 * Record GRB as stored in the database.
+		 */
+		void stored (int grb_id, int type_start, GcnKnown &known);
+
+		/**
+		 * Forget GRB, which was not stored in the database.
+		 */
+		void forget (int grb_id, int type_start);
+
+		/**
+		 * Returns known GRB, NULL if GRB is not known.
+		 */
+		GcnKnown *find (int grb_id, int type_start);
+
+		/**
+		 * Reserve target ID for the next new GRB.
+		 */
+		void reserve (int tar_id) { reserved = tar_id; }
+
+		/**
+		 * Returns reserved target ID, -1 if it was used.
+		 */
+		int getReserved () { return reserved; }
+
+		size_t size () { return known.size (); }
+
+	private:
+		std::map <std::pair <int, int>, GcnKnown> known;
+		int reserved;
+};
+
+}
+
+#endif // !__RTS2_GCNTRACKER__
@@ -20,6 +20,8 @@
 #include "command.h"
 #include "grbd.h"
 
+#include <fcntl.h>
+
 using namespace rts2grbd;
 
 #define OPT_GRB_DISABLE         OPT_LOCAL + 49
@@ -31,6 +33,10 @@ using namespace rts2grbd;
 #define OPT_GCN_EXE             OPT_LOCAL + 55
 #define OPT_GCN_FOLLOUPS        OPT_LOCAL + 56
 #define OPT_QUEUE               OPT_LOCAL + 57
+#define OPT_GCN_REPLAY          OPT_LOCAL + 58
+#define OPT_GCN_REPLAY_INTERVAL OPT_LOCAL + 59
+#define OPT_GCN_RECORD          OPT_LOCAL + 60
+#define OPT_GCN_DRY_RUN         OPT_LOCAL + 61
 
 Grbd::Grbd (int in_argc, char **in_argv):DeviceDb (in_argc, in_argv, DEVICE_TYPE_GRB, "GRB")
 {
@@ -43,6 +49,16 @@ Grbd::Grbd (int in_argc, char **in_argv):DeviceDb (in_argc, in_argv, DEVICE_TYPE
 	queueName = NULL;
 	execC = NULL;
 
+	storePool = NULL;
+	storeCompletion = NULL;
+
+	replayFile = NULL;
+	replayFd = -1;
+	replayInterval = 1;
+	recordFile = NULL;
+	recordFd = -1;
+	dryRun = false;
+
 	createValue (grb_enabled, "enabled", "if true, GRB reception is enabled", false, RTS2_VALUE_WRITABLE);
 	grb_enabled->setValueBool (true);
 
@@ -54,6 +70,13 @@ Grbd::Grbd (int in_argc, char **in_argv):DeviceDb (in_argc, in_argv, DEVICE_TYPE
 
 	createValue (last_packet, "last_packet", "time from last packet", false);
 
+	createValue (alert_received, "alert_received", "time when the last GRB notice was received", false);
+	createValue (alert_parsed, "alert_parsed", "[s] time from notice reception to parsed GRB position", false, RTS2_DT_TIMEINTERVAL);
+	createValue (alert_dispatched, "alert_dispatched", "[s] time from notice reception to sending GRB to executor", false, RTS2_DT_TIMEINTERVAL);
+	createValue (alert_accepted, "alert_accepted", "[s] time from notice reception to executor accepting GRB", false, RTS2_DT_TIMEINTERVAL);
+	createValue (alert_stored, "alert_stored", "[s] time from notice reception to GRB stored in the database", false, RTS2_DT_TIMEINTERVAL);
+	alert_tar_id = -1;
+
 	createValue (last_target, "last_target", "name of the last GRB target", false);
 	createValue (last_target_id, "last_target_id", "ID of the last GRB target", false);
 
@@ -86,10 +109,20 @@ Grbd::Grbd (int in_argc, char **in_argv):DeviceDb (in_argc, in_argv, DEVICE_TYPE
 	addOption (OPT_GCN_EXE, "add-exec", 1, "execute that command when new GCN packet arrives");
 	addOption (OPT_GCN_FOLLOUPS, "exec-followups", 0, "execute observation and add-exec script even for follow-ups without error box (currently Swift follow-ups of INTEGRAL and HETE GRBs)");
 	addOption (OPT_QUEUE, "queue-to", 1, "queue GRBs to following queue (using now command)");
+	addOption (OPT_GCN_REPLAY, "replay", 1, "replay GCN packets recorded with --record from the file");
+	addOption (OPT_GCN_REPLAY_INTERVAL, "replay-interval", 1, "interval between replayed packets (in seconds, default to 1)");
+	addOption (OPT_GCN_RECORD, "record", 1, "append received GCN packets to the file");
+	addOption (OPT_GCN_DRY_RUN, "dry-run", 0, "with --replay, only parse and log replayed packets; do not connect to GCN, touch the database nor the executor");
 }
 
 Grbd::~Grbd (void)
 {
+	// finish pending stores
+	delete storePool;
+	if (replayFd >= 0)
+		close (replayFd);
+	if (recordFd >= 0)
+		close (recordFd);
 	delete[]gcn_host;
 }
 
@@ -125,6 +158,18 @@ int Grbd::processOption (int in_opt)
 		case OPT_QUEUE:
 			queueName = optarg;
 			break;	
+		case OPT_GCN_REPLAY:
+			replayFile = optarg;
+			break;
+		case OPT_GCN_REPLAY_INTERVAL:
+			replayInterval = atof (optarg);
+			break;
+		case OPT_GCN_RECORD:
+			recordFile = optarg;
+			break;
+		case OPT_GCN_DRY_RUN:
+			dryRun = true;
+			break;
 		default:
 			return DeviceDb::processOption (in_opt);
 	}
@@ -185,6 +230,11 @@ int Grbd::reloadConfig ()
 	gcncnn->setGbmError (config->getDoubleDefault ("grbd", "gbm_error_limit", 0.25));
 	gcncnn->setGbmRecordAboveError (config->getBoolean ("grbd", "gbm_record_above_error", true));
 	gcncnn->setGbmEnabledAboveError (config->getBoolean ("grbd", "gbm_enabled_above_error", false));
+	gcncnn->setRecordFile (recordFd);
+	gcncnn->setDryRun (dryRun);
+	// replayed packets are fed directly to gcncnn, no connection to GCN is needed
+	if (dryRun)
+		return 0;
 	// setup..
 	// wait till grb connection init..
 	ret = gcncnn->init ();
@@ -204,10 +254,41 @@ int Grbd::reloadConfig ()
 int Grbd::init ()
 {
 	int ret;
+
+	if (dryRun && (replayFile == NULL || recordFile != NULL))
+	{
+		logStream (MESSAGE_ERROR) << "--dry-run must be used with --replay and cannot be used with --record" << sendLog;
+		return -1;
+	}
+
+	if (recordFile)
+	{
+		recordFd = open (recordFile, O_WRONLY | O_APPEND | O_CREAT, 0644);
+		if (recordFd < 0)
+		{
+			logStream (MESSAGE_ERROR) << "cannot open " << recordFile << " for recording GCN packets: " << strerror (errno) << sendLog;
+			return -1;
+		}
+	}
+
 	ret = DeviceDb::init ();
 	if (ret)
 		return ret;
 
+	if (!dryRun)
+		initStore ();
+
+	if (replayFile)
+	{
+		replayFd = open (replayFile, O_RDONLY);
+		if (replayFd < 0)
+		{
+			logStream (MESSAGE_ERROR) << "cannot open " << replayFile << " with recorded GCN packets: " << strerror (errno) << sendLog;
+			return -1;
+		}
+		addTimer (replayInterval, new rts2core::Event (EVENT_TIMER_GCN_REPLAY, this));
+	}
+
 	// add forward connection
 	if (forwardPort > 0)
 	{
@@ -231,12 +312,82 @@ int Grbd::init ()
 	return ret;
 }
 
+void Grbd::initStore ()
+{
+	storePool = new rts2core::ThreadPool (1);
+	storeCompletion = new rts2core::ConnCompletion (this);
+	if (storePool->start () || storeCompletion->init ())
+	{
+		logStream (MESSAGE_WARNING) << "cannot start GRB store thread, GRBs will be stored before they are passed to executor" << sendLog;
+		delete storePool;
+		delete storeCompletion;
+		storePool = NULL;
+		storeCompletion = NULL;
+		return;
+	}
+	addConnection (storeCompletion);
+	storePool->submit (new GcnStoreConnect (this), storeCompletion);
+}
+
+void Grbd::storeGcn (GcnStore *task)
+{
+	if (storePool)
+	{
+		storePool->submit (task, storeCompletion);
+		return;
+	}
+	// store from the event loop
+	task->retryInline = true;
+	task->completed ();
+	delete task;
+}
+
+void Grbd::gcnStoreCompleted (GcnStore *task)
+{
+	if (gcncnn)
+		gcncnn->storeCompleted (task);
+}
+
+void Grbd::gcnStored (int tar_id, struct timeval &received, double stored)
+{
+	if (tar_id != alert_tar_id)
+		return;
+	alert_stored->setValueDouble (stored - (received.tv_sec + (double) received.tv_usec / USEC_SEC));
+	sendValueAll (alert_stored);
+	logStream (MESSAGE_INFO) << "GRB target #" << tar_id << " stored " << alert_stored->getValueDouble () << " seconds after GCN notice reception" << sendLog;
+
+	// executor records observation of the target only after it is stored
+	rts2core::Connection *exec = getOpenConnection (DEVICE_TYPE_EXECUTOR);
+	if (exec)
+		exec->queCommand (new rts2core::CommandGrbStored (this, tar_id));
+}
+
+void Grbd::replayNext ()
+{
+	int32_t packet[SIZ_PKT];
+	ssize_t ret = read (replayFd, packet, sizeof (packet));
+	if (ret != sizeof (packet))
+	{
+		if (ret < 0)
+			logStream (MESSAGE_ERROR) << "cannot read recorded GCN packet from " << replayFile << ": " << strerror (errno) << sendLog;
+		else
+			logStream (MESSAGE_INFO) << "replay of GCN packets from " << replayFile << " finished" << sendLog;
+		close (replayFd);
+		replayFd = -1;
+		return;
+	}
+	gcncnn->replayPacket (packet);
+	addTimer (replayInterval, new rts2core::Event (EVENT_TIMER_GCN_REPLAY, this));
+}
+
 void Grbd::help ()
 {
 	DeviceDb::help ();
 	std::cout << std::endl << " Execution script, specified with --add-exec option, receives following parameters as arguments:"
 		" target-id grb-id grb-seqn grb-type grb-ra grb-dec grb-is-grb grb-date grb-errorbox." << std::endl
-		<< " Please see man page for meaning of that arguments." << std::endl;
+		<< " Please see man page for meaning of that arguments." << std::endl
+		<< " Files written with --record and read with --replay contain GCN socket packets, as received from the network." << std::endl
+		<< " With --dry-run, replayed packets are only parsed and logged; no target is created and nothing is sent to the executor." << std::endl;
 }
 
 int Grbd::info ()
@@ -271,6 +422,17 @@ void Grbd::postEvent (rts2core::Event * event)
 				addTimer (60, new rts2core::Event (EVENT_TIMER_GCNCNN_INIT, this));
 			}
 			break;
+		case EVENT_TIMER_GCN_REPLAY:
+			replayNext ();
+			break;
+		case EVENT_COMMAND_OK:
+			if (event->getArg () == execC && execC->getGrbID () == alert_tar_id && !std::isnan (alert_received->getValueDouble ()))
+			{
+				alert_accepted->setValueDouble (getNow () - alert_received->getValueDouble ());
+				sendValueAll (alert_accepted);
+				logStream (MESSAGE_INFO) << "executor accepted GRB target #" << alert_tar_id << " " << alert_accepted->getValueDouble () << " seconds after GCN notice reception" << sendLog;
+			}
+			break;
 		case EVENT_COMMAND_FAILED:
 			if (event->getArg () == execC)
 			{
@@ -312,6 +474,40 @@ int Grbd::newGcnGrb (int tar_id)
 		logStream (MESSAGE_ERROR) << "FATAL! No executor running to post grb ID " << tar_id << sendLog;
 		return -1;
 	}
+	return queueGcnGrb (tar_id);
+}
+
+int Grbd::execGcnGrb (int tar_id, GcnPoint &point, GcnKnown &known, struct timeval &received, double parsed)
+{
+	if (grb_enabled->getValueBool () != true)
+		return -1;
+	rts2core::Connection *exec = getOpenConnection (DEVICE_TYPE_EXECUTOR);
+	if (exec == NULL)
+		return -1;
+
+	double rec = received.tv_sec + (double) received.tv_usec / USEC_SEC;
+
+	execC = new rts2core::CommandExecGrbAlert (this, tar_id, point.grb_id, point.type, known.ra, known.dec, known.errorbox, point.date, known.enabled, known.inDatabase, rec);
+	exec->queCommand (execC, 0, this);
+
+	alert_tar_id = tar_id;
+	alert_received->setValueDouble (rec);
+	alert_parsed->setValueDouble (parsed - rec);
+	alert_dispatched->setValueDouble (getNow () - rec);
+	alert_accepted->setValueDouble (NAN);
+	alert_stored->setValueDouble (NAN);
+	sendValueAll (alert_received);
+	sendValueAll (alert_parsed);
+	sendValueAll (alert_dispatched);
+	sendValueAll (alert_accepted);
+	sendValueAll (alert_stored);
+
+	logStream (MESSAGE_INFO) << "GRB target #" << tar_id << " passed to executor " << alert_dispatched->getValueDouble () << " seconds after GCN notice reception (parsed after " << alert_parsed->getValueDouble () << " seconds)" << sendLog;
+	return 0;
+}
+
+int Grbd::queueGcnGrb (int tar_id)
+{
 	if (queueName)
 	{
 		int num = 0;
@@ -21,17 +21,22 @@
 #define __RTS2_GRBD__
 
 #include "rts2db/devicedb.h"
+#include "conncompletion.h"
+#include "threadpool.h"
 #include "conngrb.h"
+#include "gcntracker.h"
 #include "rts2grbfw.h"
 
 // when we get GRB packet..
 #define RTS2_EVENT_GRB_PACKET      RTS2_LOCAL_EVENT + 600
 #define EVENT_TIMER_GCNCNN_INIT    RTS2_LOCAL_EVENT + 601
+#define EVENT_TIMER_GCN_REPLAY     RTS2_LOCAL_EVENT + 602
 
 namespace rts2grbd
 {
 
 class ConnGrb;
+class GcnStore;
 
 /**
  * Receive info from GCN via socket, put them to DB.
@@ -60,6 +65,41 @@ class Grbd:public rts2db::DeviceDb
 
 		int newGcnGrb (int tar_id);
 
+		/**
+		 * Pass GRB from GCN notice to executor, before it is stored in the database.
+		 *
+		 * @param tar_id    target ID
+		 * @param point     parsed notice
+		 * @param known     GRB position and state
+		 * @param received  time notice was received
+		 * @param parsed    time notice was parsed
+		 *
+		 * @return -1 if GRB was not passed to executor, 0 on success
+		 */
+		int execGcnGrb (int tar_id, GcnPoint &point, GcnKnown &known, struct timeval &received, double parsed);
+
+		/**
+		 * Queue GRB to selector queue, if it was specified.
+		 *
+		 * @return -2 if selector cannot be found, 0 otherwise
+		 */
+		int queueGcnGrb (int tar_id);
+
+		/**
+		 * Store GCN notice in the store thread. Takes ownership of the task.
+		 */
+		void storeGcn (GcnStore *task);
+
+		/**
+		 * Called from the event loop after notice was stored.
+		 */
+		void gcnStoreCompleted (GcnStore *task);
+
+		/**
+		 * Record time GRB was stored in the database.
+		 */
+		void gcnStored (int tar_id, struct timeval &received, double stored);
+
 		virtual int commandAuthorized (rts2core::Connection * conn);
 
 		void updateSwift (double lastTime, double ra, double dec);
@@ -80,6 +120,22 @@ class Grbd:public rts2db::DeviceDb
 		virtual void help ();
 	private:
 		ConnGrb * gcncnn;
+
+		// thread storing GCN notices to the database
+		rts2core::ThreadPool *storePool;
+		rts2core::ConnCompletion *storeCompletion;
+		void initStore ();
+
+		// file with recorded GCN packets to replay
+		const char *replayFile;
+		int replayFd;
+		double replayInterval;
+		const char *recordFile;
+		int recordFd;
+		// only parse replayed packets
+		bool dryRun;
+
+		void replayNext ();
 		char *gcn_host;
 		int gcn_port;
 		int do_hete_test;
@@ -98,6 +154,14 @@ class Grbd:public rts2db::DeviceDb
 		rts2core::ValueBool *doHeteTests;
 
 		rts2core::ValueTime *last_packet;
+
+		// alert to executor timing
+		rts2core::ValueTime *alert_received;
+		rts2core::ValueDouble *alert_parsed;
+		rts2core::ValueDouble *alert_dispatched;
+		rts2core::ValueDouble *alert_accepted;
+		rts2core::ValueDouble *alert_stored;
+		int alert_tar_id;
 		rts2core::ValueString *last_target;
 		rts2core::ValueInteger *last_target_id;
 		rts2core::ValueTime *last_target_time;
@@ -63,6 +63,10 @@ digraph "JSON API calls handling" {
 
 #include "httpd.h"
 #include "rts2json/jsonvalue.h"
+#include "telemetry.h"
+
+#include <limits.h>
+#include <stdlib.h>
 
 #include "rts2db/constraints.h"
 #include "rts2db/planset.h"
@@ -76,6 +80,9 @@ digraph "JSON API calls handling" {
 
 using namespace rts2xmlrpc;
 
+// maximal number of telemetry records returned by single call
+#define TELEMETRY_MAX_RECORDS    10000
+
 void getCameraParameters (XmlRpc::HttpParams *params, const char *&camera, long &smin, long &smax, rts2image::scaling_type &scaling, int &newType)
 {
 	camera = params->getString ("ccd","");
@@ -560,6 +567,73 @@ void API::executeJSON (XmlRpc::XmlRpcSource *source, std::string path, XmlRpc::H
 					sendOwnValues (os, params, from, ext);
 				}
 			}
+			// tracking telemetry records, read directly from mount telemetry ring file
+			else if (vals[0] == "telemetry")
+			{
+				const char *device = params->getString ("d", "");
+				conn = master->getOpenConnection (device);
+				if (conn == NULL)
+					throw JSONException ("cannot find device");
+				rts2core::Value *tf = conn->getValue ("telemetry_file");
+				if (tf == NULL)
+					throw JSONException ("device does not record telemetry");
+
+				// device reports the path, only files in configured directory are served
+				std::string telemetryPath;
+				Configuration::instance ()->getString ("xmlrpcd", "telemetry_path", telemetryPath, "");
+				if (telemetryPath.empty ())
+					throw JSONException ("telemetry_path is not configured");
+				char rdir[PATH_MAX];
+				char rfile[PATH_MAX];
+				if (realpath (telemetryPath.c_str (), rdir) == NULL || realpath (tf->getValue (), rfile) == NULL)
+					throw JSONException ("cannot find telemetry file");
+				size_t dl = strlen (rdir);
+				if (strncmp (rfile, rdir, dl) || (rdir[dl - 1] != '/' && rfile[dl] != '/'))
+					throw JSONException ("telemetry file is not in telemetry_path");
+
+				rts2core::TelemetryRing ring;
+				if (ring.open (rfile))
+					throw JSONException ("cannot open telemetry file");
+
+				long from = params->getLong ("from", -1);
+				int maxRecords = params->getInteger ("n", 1000);
+				if (maxRecords < 1)
+					maxRecords = 1;
+				else if (maxRecords > TELEMETRY_MAX_RECORDS)
+					maxRecords = TELEMETRY_MAX_RECORDS;
+				double decimate = params->getDouble ("decimate", 0);
+
+				uint64_t first;
+				if (from < 0)
+					first = ring.getCount () > (uint64_t) maxRecords ? ring.getCount () - maxRecords : 0;
+				else
+					first = from;
+
+				std::vector <rts2core::TelemetryRecord> recs;
+				uint64_t next = ring.read (first, recs, maxRecords, decimate);
+
+				os << "\"h\":[";
+				for (const char **c = rts2core::telemetryColumns; *c; c++)
+				{
+					if (c != rts2core::telemetryColumns)
+						os << ",";
+					os << "\"" << *c << "\"";
+				}
+				os << "],\"r\":[" << std::fixed;
+				for (std::vector <rts2core::TelemetryRecord>::iterator iter = recs.begin (); iter != recs.end (); iter++)
+				{
+					if (iter != recs.begin ())
+						os << ",";
+					os << "[" << iter->seq << "," << iter->time
+						<< "," << rts2json::JsonDouble (iter->tarRa) << "," << rts2json::JsonDouble (iter->tarDec)
+						<< "," << rts2json::JsonDouble (iter->modelRa) << "," << rts2json::JsonDouble (iter->modelDec)
+						<< "," << rts2json::JsonDouble (iter->telTarRa) << "," << rts2json::JsonDouble (iter->telTarDec)
+						<< "," << rts2json::JsonDouble (iter->telTarAz) << "," << rts2json::JsonDouble (iter->telTarAlt)
+						<< "," << rts2json::JsonDouble (iter->telRa) << "," << rts2json::JsonDouble (iter->telDec)
+						<< "," << rts2json::JsonDouble (iter->error) << "]";
+				}
+				os << "],\"next\":" << next;
+			}
 			else if (vals[0] == "push")
 			{
 				rts2json::AsyncValueAPI *aa = new rts2json::AsyncValueAPI (this, connection, params);
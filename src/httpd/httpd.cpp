@@ -49,6 +49,8 @@ using namespace Magick;
 #define OPT_BB_QUEUE            OPT_LOCAL + 80
 #define OPT_SSL_CERT            OPT_LOCAL + 81
 #define OPT_SSL_KEY             OPT_LOCAL + 82
+#define OPT_MESSAGE_QUEUE       OPT_LOCAL + 83
+#define OPT_MESSAGE_DUPLICATES  OPT_LOCAL + 84
 
 using namespace XmlRpc;
 
@@ -454,6 +456,14 @@ int HttpD::info ()
 {
 	bbQueueSize->setValueInteger (events.bbServers.queueSize ());
 #ifdef RTS2_HAVE_PGSQL
+	if (messageSink)
+	{
+		msgdbQueue->setValueInteger (messageSink->getQueueSize ());
+		msgdbInserted->setValueLong (messageSink->getInserted ());
+		msgdbDropped->setValueLong (messageSink->getDropped ());
+		msgdbSuppressed->setValueLong (messageSink->getSuppressed ());
+		msgdbFailed->setValueLong (messageSink->getFailed ());
+	}
 	return DeviceDb::info ();
 #else
 	return rts2core::Device::info ();
@@ -464,6 +474,13 @@ int HttpD::idle ()
 {
 	rts2json::HTTPServer::asyncIdle ();
 #ifdef RTS2_HAVE_PGSQL
+	if (messageSink)
+	{
+		// errors of the writer thread
+		std::string err;
+		while (messageSink->popError (err))
+			logStream (MESSAGE_ERROR) << err << sendLog;
+	}
 	return DeviceDb::idle ();
 #else
 	return rts2core::Device::idle ();
@@ -512,6 +529,12 @@ int HttpD::processOption (int in_opt)
 			bbQueueName = optarg;
 			break;
 #ifdef RTS2_HAVE_PGSQL
+		case OPT_MESSAGE_QUEUE:
+			messageQueueSize = atoi (optarg);
+			break;
+		case OPT_MESSAGE_DUPLICATES:
+			messageDuplicates = atof (optarg);
+			break;
 		default:
 			return DeviceDb::processOption (in_opt);
 #else
@@ -535,6 +558,22 @@ int HttpD::init ()
 	if (ret)
 		return ret;
 
+#ifdef RTS2_HAVE_PGSQL
+	if (messageQueueSize > 0 && !emptyConnectString ())
+	{
+		messageSink = new rts2db::MessageSink (getConnectString (), messageQueueSize, 500, 1, messageDuplicates);
+		if (messageSink->start ())
+		{
+			std::string err;
+			while (messageSink->popError (err))
+				logStream (MESSAGE_ERROR) << err << sendLog;
+			logStream (MESSAGE_WARNING) << "cannot start background message writer, messages will be written to the database directly" << sendLog;
+			delete messageSink;
+			messageSink = NULL;
+		}
+	}
+#endif
+
 	ret = notifyConn->init ();
 	if (ret)
 		return ret;
@@ -804,7 +843,20 @@ HttpD::HttpD (int argc, char **argv): rts2core::Device (argc, argv, DEVICE_TYPE_
 
 	bbQueueName = NULL;
 
-#ifndef RTS2_HAVE_PGSQL
+#ifdef RTS2_HAVE_PGSQL
+	messageSink = NULL;
+	messageQueueSize = 10000;
+	messageDuplicates = 10;
+
+	createValue (msgdbQueue, "msgdb_queue", "number of messages waiting to be written to the database", false);
+	createValue (msgdbInserted, "msgdb_inserted", "number of messages written to the database", false);
+	createValue (msgdbDropped, "msgdb_dropped", "number of messages dropped as database queue was full", false);
+	createValue (msgdbSuppressed, "msgdb_suppressed", "number of duplicate messages not written to the database", false);
+	createValue (msgdbFailed, "msgdb_failed", "number of messages which cannot be written to the database", false);
+
+	addOption (OPT_MESSAGE_QUEUE, "message-queue", 1, "size of queue of messages written to the database; 0 to write messages directly. Default to 10000");
+	addOption (OPT_MESSAGE_DUPLICATES, "message-duplicates", 1, "do not write to the database duplicate messages received in that many seconds; 0 to write all. Default to 10");
+#else
 	config_file = NULL;
 
 	addOption (OPT_CONFIG, "config", 1, "configuration file");
@@ -826,6 +878,11 @@ HttpD::HttpD (int argc, char **argv): rts2core::Device (argc, argv, DEVICE_TYPE_
 
 HttpD::~HttpD ()
 {
+#ifdef RTS2_HAVE_PGSQL
+	// flush queued messages
+	delete messageSink;
+#endif
+
 	for (std::vector <rts2json::Directory *>::iterator id = directories.begin (); id != directories.end (); id++)
 		delete *id;
 
@@ -961,8 +1018,15 @@ void HttpD::message (Message & msg)
 #ifdef RTS2_HAVE_PGSQL
 	if (msg.isNotDebug ())
 	{
-		rts2db::MessageDB msgDB (msg);
-		msgDB.insertDB ();
+		if (messageSink)
+		{
+			messageSink->push (msg);
+		}
+		else
+		{
+			rts2db::MessageDB msgDB (msg);
+			msgDB.insertDB ();
+		}
 	}
 #endif
 	switch (msg.getID ())
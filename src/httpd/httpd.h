@@ -27,6 +27,7 @@
 
 #ifdef RTS2_HAVE_PGSQL
 #include "rts2db/devicedb.h"
+#include "rts2db/messagesink.h"
 #include "rts2db/plan.h"
 #include "rts2json/addtargetreq.h"
 #include "bbapi.h"
@@ -528,7 +529,18 @@ class HttpD:public rts2core::Device, XmlRpc::XmlRpcServer, rts2json::HTTPServer
 
 		rts2core::ValueInteger *messageBufferSize;
 
-#ifndef RTS2_HAVE_PGSQL
+#ifdef RTS2_HAVE_PGSQL
+		// writes messages to the database on background
+		rts2db::MessageSink *messageSink;
+		int messageQueueSize;
+		double messageDuplicates;
+
+		rts2core::ValueInteger *msgdbQueue;
+		rts2core::ValueLong *msgdbInserted;
+		rts2core::ValueLong *msgdbDropped;
+		rts2core::ValueLong *msgdbSuppressed;
+		rts2core::ValueLong *msgdbFailed;
+#else
 		const char *config_file;
 #endif
 		// user - login fields
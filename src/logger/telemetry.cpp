@@ -0,0 +1,179 @@
+/*
+ * Dump records from binary tracking telemetry ring.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "app.h"
+#include "telemetry.h"
+
+#include <errno.h>
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+class TelemetryDump:public rts2core::App
+{
+	public:
+		TelemetryDump (int argc, char **argv);
+
+		virtual int run ();
+
+	protected:
+		virtual int processOption (int opt);
+		virtual int processArgs (const char *arg);
+
+		virtual void usage ();
+
+	private:
+		const char *ringFile;
+		long last;
+		double from;
+		double decimate;
+		bool follow;
+		bool header;
+
+		// last printed record is kept for decimation
+		std::vector <rts2core::TelemetryRecord> recs;
+
+		void printRecords (rts2core::TelemetryRing &ring, uint64_t &next);
+};
+
+TelemetryDump::TelemetryDump (int argc, char **argv):App (argc, argv)
+{
+	ringFile = NULL;
+	last = -1;
+	from = NAN;
+	decimate = 0;
+	follow = false;
+	header = true;
+
+	addOption ('n', NULL, 1, "print only last n records");
+	addOption ('t', NULL, 1, "print records recorded after given time (ctime)");
+	addOption ('d', NULL, 1, "print at most one record per given number of seconds");
+	addOption ('f', NULL, 0, "follow - wait for and print new records");
+	addOption ('H', NULL, 0, "do not print header line");
+}
+
+int TelemetryDump::run ()
+{
+	int ret = init ();
+	if (ret)
+		return ret;
+
+	if (ringFile == NULL)
+	{
+		std::cerr << "missing telemetry file, please see -h for details" << std::endl;
+		return -1;
+	}
+
+	rts2core::TelemetryRing ring;
+	if (ring.open (ringFile))
+	{
+		std::cerr << "cannot open telemetry file " << ringFile << ": " << strerror (errno) << std::endl;
+		return -1;
+	}
+
+	uint64_t next = ring.getFirst ();
+	if (!std::isnan (from))
+		next = ring.find (from);
+	if (last >= 0 && ring.getCount () - next > (uint64_t) last)
+		next = ring.getCount () - last;
+
+	if (header)
+	{
+		std::cout << "#";
+		for (const char **c = rts2core::telemetryColumns; *c; c++)
+			std::cout << " " << *c;
+		std::cout << std::endl;
+	}
+
+	std::cout << std::fixed << std::setprecision (6);
+
+	printRecords (ring, next);
+	while (follow)
+	{
+		usleep (USEC_SEC / 10);
+		printRecords (ring, next);
+	}
+
+	return 0;
+}
+
+int TelemetryDump::processOption (int opt)
+{
+	switch (opt)
+	{
+		case 'n':
+			last = atol (optarg);
+			break;
+		case 't':
+			from = atof (optarg);
+			break;
+		case 'd':
+			decimate = atof (optarg);
+			break;
+		case 'f':
+			follow = true;
+			break;
+		case 'H':
+			header = false;
+			break;
+		default:
+			return App::processOption (opt);
+	}
+	return 0;
+}
+
+int TelemetryDump::processArgs (const char *arg)
+{
+	if (ringFile != NULL)
+		return -1;
+	ringFile = arg;
+	return 0;
+}
+
+void TelemetryDump::usage ()
+{
+	std::cout << "Print tracking records from telemetry file written by telescope driver started with --telemetry option:" << std::endl
+		<< std::endl
+		<< "Example:" << std::endl
+		<< "\trts2-telemetry -n 1000 -d 1 /var/lib/rts2/T0.telemetry" << std::endl;
+}
+
+void TelemetryDump::printRecords (rts2core::TelemetryRing &ring, uint64_t &next)
+{
+	size_t num;
+	do
+	{
+		if (recs.size () > 1)
+			recs.erase (recs.begin (), recs.end () - 1);
+		size_t start = recs.size ();
+		next = ring.read (next, recs, 1000, decimate);
+		num = recs.size () - start;
+		for (std::vector <rts2core::TelemetryRecord>::iterator iter = recs.begin () + start; iter != recs.end (); iter++)
+			std::cout << *iter << std::endl;
+	}
+	while (num == 1000);
+}
+
+int main (int argc, char **argv)
+{
+	TelemetryDump app (argc, argv);
+	return app.run ();
+}
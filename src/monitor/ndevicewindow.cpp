@@ -37,6 +37,9 @@ NDeviceWindow::NDeviceWindow (rts2core::Connection * in_connection, bool _hide_d
 	valueBox = NULL;
 	valueBegins = 20;
 	hide_debug = _hide_debug;
+	fullRedraw = true;
+	drawnGeneration = 0;
+	drawnSecond = 0;
 
 	draw ();
 }
@@ -194,9 +197,6 @@ void NDeviceWindow::printValue (rts2core::Value * value)
 
 void NDeviceWindow::drawValuesList ()
 {
-	gettimeofday (&tvNow, NULL);
-	now = tvNow.tv_sec + tvNow.tv_usec / USEC_SEC;
-
 	maxrow = 0;
 
 	displayValues.clear ();
@@ -212,6 +212,25 @@ void NDeviceWindow::drawValuesList ()
 	}
 }
 
+void NDeviceWindow::drawChangedValues ()
+{
+	bool tick = tvNow.tv_sec != drawnSecond;
+	if (dirtyValues.empty () && !tick)
+		return;
+	for (size_t i = 0; i < displayValues.size (); i++)
+	{
+		rts2core::Value *val = displayValues[i];
+		// script display depends on scriptPosition and scriptLen values
+		if ((tick && val->getValueType () == RTS2_VALUE_TIME)
+			|| (!dirtyValues.empty () && val->getValueDisplayType () == RTS2_DT_SCRIPT)
+			|| dirtyValues.find (val) != dirtyValues.end ())
+		{
+			wmove (getWriteWindow (), i, 0);
+			printValue (val);
+		}
+	}
+}
+
 rts2core::Value * NDeviceWindow::getSelValue ()
 {
 	int s = getSelRow ();
@@ -304,6 +323,8 @@ keyRet NDeviceWindow::injectKey (int key)
 {
 	keyRet
 		ret;
+	// selection and edit box change rows outside of value updates
+	fullRedraw = true;
 	switch (key)
 	{
 		case KEY_ENTER:
@@ -335,8 +356,26 @@ keyRet NDeviceWindow::injectKey (int key)
 void NDeviceWindow::draw ()
 {
 	NSelWindow::draw ();
-	werase (getWriteWindow ());
-	drawValuesList ();
+
+	gettimeofday (&tvNow, NULL);
+	now = tvNow.tv_sec + tvNow.tv_usec / USEC_SEC;
+
+	// values might be replaced by metainfo, displayValues are invalid then
+	if (fullRedraw || drawnGeneration != connection->getValuesGeneration ())
+	{
+		werase (getWriteWindow ());
+		drawValuesList ();
+		fullRedraw = false;
+		drawnGeneration = connection->getValuesGeneration ();
+	}
+	else
+	{
+		drawChangedValues ();
+		// window frame was erased, copy unchanged rows to screen as well
+		touchwin (getWriteWindow ());
+	}
+	dirtyValues.clear ();
+	drawnSecond = tvNow.tv_sec;
 
 	wcolor_set (getWriteWindow (), CLR_DEFAULT, NULL);
 	mvwvline (getWriteWindow (), 0, valueBegins, ACS_VLINE,	(maxrow > getHeight () ? maxrow + 1 : getHeight ()));
@@ -389,6 +428,15 @@ void NDeviceCentralWindow::printValues ()
 	}
 }
 
+void NDeviceCentralWindow::drawChangedValues ()
+{
+	NDeviceWindow::drawChangedValues ();
+	// state changes are printed after values
+	wmove (getWriteWindow (), maxrow, 0);
+	printValues ();
+	wclrtobot (getWriteWindow ());
+}
+
 void NDeviceCentralWindow::drawValuesList ()
 {
 	NDeviceWindow::drawValuesList ();
@@ -23,6 +23,8 @@
 #include "daemonwindow.h"
 #include "nvaluebox.h"
 
+#include <set>
+
 namespace rts2ncurses
 {
 
@@ -38,6 +40,24 @@ class NDeviceWindow:public NSelWindow
 		virtual bool setCursor ();
 		virtual bool hasEditBox () { return valueBox != NULL; }
 
+		/**
+		 * Mark value as changed. Next draw will redraw only rows of
+		 * changed values, unless full redraw is needed.
+		 *
+		 * @param value  changed value of window connection
+		 */
+		void valueChanged (rts2core::Value *value) { dirtyValues.insert (value); }
+
+		/**
+		 * Redraw all values on next draw call.
+		 */
+		void invalidate () { fullRedraw = true; }
+
+		/**
+		 * Returns true if window displays values of the given connection.
+		 */
+		bool displays (rts2core::Connection *conn) { return conn == connection; }
+
 	protected:
 		double now;
 		struct timeval tvNow;
@@ -67,6 +87,12 @@ class NDeviceWindow:public NSelWindow
 
 		virtual void drawValuesList ();
 
+		/**
+		 * Redraw rows of values changed since the last draw. Values
+		 * displaying time difference are redrawn every second.
+		 */
+		virtual void drawChangedValues ();
+
 	private:
 		WINDOW * valueList;
 		rts2core::Connection *connection;
@@ -82,6 +108,14 @@ class NDeviceWindow:public NSelWindow
 		
 		// draw only those values
 		std::vector <rts2core::Value *> displayValues;
+
+		// values received since the last draw
+		std::set <rts2core::Value *> dirtyValues;
+		bool fullRedraw;
+		// generation of connection values when the list was drawn
+		unsigned int drawnGeneration;
+		// second of the last draw
+		time_t drawnSecond;
 };
 
 /**
@@ -112,6 +146,7 @@ class NDeviceCentralWindow:public NDeviceWindow
 
 	protected:
 		virtual void drawValuesList ();
+		virtual void drawChangedValues ();
 
 	private:
 		std::vector < FutureStateChange > stateChanges;
@@ -418,6 +418,9 @@ NMonitor::NMonitor (int in_argc, char **in_argv):rts2core::Client (in_argc, in_a
 	setXtermTitle (_os.str ());
 
 	refresh_rate = MONITOR_REFRESH;
+
+	damaged = true;
+	repaintSecond = 0;
 }
 
 NMonitor::~NMonitor (void)
@@ -441,6 +444,9 @@ NMonitor::~NMonitor (void)
 
 int NMonitor::repaint ()
 {
+	damaged = false;
+	repaintSecond = time (NULL);
+
 	curs_set (0);
 	if (getConnections ()->size () != orderedConn.size ())
 		refreshConnections ();
@@ -571,7 +577,9 @@ void NMonitor::postEvent (rts2core::Event *event)
 	switch (event->getType ())
 	{
 		case EVENT_MONITOR_REFRESH:
-			repaint ();
+			// values received since the last refresh are drawn in a single update
+			if (damaged || time (NULL) != repaintSecond)
+				repaint ();
 			if (!std::isnan (refresh_rate) && refresh_rate >= 0)
 				addTimer (refresh_rate, event);
 			return;
@@ -624,6 +632,18 @@ void NMonitor::deleteClient (int p_centraldId)
 void NMonitor::message (rts2core::Message & msg)
 {
 	*msgwindow << msg;
+	damaged = true;
+}
+
+void NMonitor::valueChanged (rts2core::Connection *conn, const char *v_name)
+{
+	NDeviceWindow *devWindow = dynamic_cast <NDeviceWindow *> (daemonWindow);
+	if (devWindow == NULL || !devWindow->displays (conn))
+		return;
+	rts2core::Value *val = conn->getValue (v_name);
+	if (val)
+		devWindow->valueChanged (val);
+	damaged = true;
 }
 
 void NMonitor::resize ()
@@ -771,7 +791,11 @@ void NMonitor::commandReturn (rts2core::Command * cmd, int cmd_status)
 	if (oldCommand == cmd)
 	{
 		comWindow->commandReturn (cmd, cmd_status);
-		repaint ();
+		// without refresh timer, nobody else will draw it
+		if (std::isnan (refresh_rate) || refresh_rate < 0)
+			repaint ();
+		else
+			damaged = true;
 	}
 }
 
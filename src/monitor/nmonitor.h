@@ -110,6 +110,21 @@ class NMonitor:public rts2core::Client
 
 		void commandReturn (rts2core::Command * cmd, int cmd_status);
 
+		/**
+		 * Called when value was received from a connection. Changes
+		 * are drawn on next refresh, so burst of values results in a
+		 * single screen update.
+		 *
+		 * @param conn    connection which received the value
+		 * @param v_name  value name
+		 */
+		void valueChanged (rts2core::Connection *conn, const char *v_name);
+
+		/**
+		 * Request repaint on next refresh.
+		 */
+		void damage () { damaged = true; }
+
 		virtual void addPollSocks ();
 		virtual void pollSuccess ();
 
@@ -188,6 +203,11 @@ class NMonitor:public rts2core::Client
 
 		double refresh_rate;
 
+		// something changed since the last repaint
+		bool damaged;
+		// second of the last repaint, clock is updated every second
+		time_t repaintSecond;
+
 		std::map <std::string, std::list <std::string> > initCommands;
 };
 
@@ -207,6 +227,22 @@ class NMonConn:public rts2core::ConnClient
 			master->commandReturn (cmd, in_status);
 			return rts2core::ConnClient::commandReturn (cmd, in_status);
 		}
+
+		virtual int commandValue (const char *v_name)
+		{
+			int ret = rts2core::ConnClient::commandValue (v_name);
+			if (ret == 0)
+				master->valueChanged (this, v_name);
+			return ret;
+		}
+
+	protected:
+		virtual void setState (rts2_status_t in_value, char * msg)
+		{
+			rts2core::ConnClient::setState (in_value, msg);
+			master->damage ();
+		}
+
 	private:
 		NMonitor * master;
 };
@@ -238,6 +274,22 @@ class NMonCentralConn:public rts2core::ConnCentraldClient
 			master->commandReturn (cmd, in_status);
 			rts2core::ConnCentraldClient::commandReturn (cmd, in_status);
 		}
+
+		virtual int commandValue (const char *v_name)
+		{
+			int ret = rts2core::ConnCentraldClient::commandValue (v_name);
+			if (ret == 0)
+				master->valueChanged (this, v_name);
+			return ret;
+		}
+
+	protected:
+		virtual void setState (rts2_status_t in_value, char * msg)
+		{
+			rts2core::ConnCentraldClient::setState (in_value, msg);
+			master->damage ();
+		}
+
 	private:
 		NMonitor * master;
 };
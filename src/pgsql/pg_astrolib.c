@@ -22,6 +22,8 @@
 
 #include <libnova/libnova.h>
 
+#include "skypix.h"
+
 #include <math.h>
 #include <postgres.h>
 #include <fmgr.h>
@@ -31,6 +33,7 @@ PG_MODULE_MAGIC;
 
 PG_FUNCTION_INFO_V1 (ln_angular_separation);
 PG_FUNCTION_INFO_V1 (ln_airmass);
+PG_FUNCTION_INFO_V1 (sky_pixel);
 
 Datum
 ln_angular_separation (PG_FUNCTION_ARGS)
@@ -69,3 +72,28 @@ ln_airmass (PG_FUNCTION_ARGS)
 
   PG_RETURN_FLOAT4 (ln_get_airmass (hrz.alt, 750));
 }
+
+/*!
+ * Returns sky pixel of given position, see skypix.h.
+ *
+ * @pg_arg	ra [float8]
+ * @pg_arg	dec [float8]
+ *
+ * @pg_ret [int4] pixel number, NULL if position is not known
+ */
+Datum
+sky_pixel (PG_FUNCTION_ARGS)
+{
+  double ra, dec;
+
+  if (PG_ARGISNULL (0) || PG_ARGISNULL (1))
+    PG_RETURN_NULL ();
+
+  ra = PG_GETARG_FLOAT8 (0);
+  dec = PG_GETARG_FLOAT8 (1);
+
+  if (isnan (ra) || isnan (dec))
+    PG_RETURN_NULL ();
+
+  PG_RETURN_INT32 (skypix (ra, dec));
+}
@@ -82,6 +82,8 @@ PG_FUNCTION_INFO_V1 (img_wcs2_equinox);
 // center RA and DEC
 PG_FUNCTION_INFO_V1 (img_wcs2_center_ra);
 PG_FUNCTION_INFO_V1 (img_wcs2_center_dec);
+// distance of the farthest corner from reference pixel
+PG_FUNCTION_INFO_V1 (img_wcs2_radius);
 
 // helper
 char *
@@ -496,3 +498,52 @@ img_wcs2_center_dec (PG_FUNCTION_ARGS)
   arg = PG_GETARG_KWCS2_P (0);
   PG_RETURN_FLOAT8 (arg->crval2);
 }
+
+/*!
+ * Returns distance of the farthest image corner from the reference
+ * pixel, in degrees. Every position on the image is closer to the
+ * reference pixel coordinates.
+ *
+ * @pg_arg	wcs [kwcs2]
+ *
+ * @pg_ret [float8] radius in degrees
+ */
+Datum
+img_wcs2_radius (PG_FUNCTION_ARGS)
+{
+  struct kwcs2 *arg;
+  double x[4], y[4];
+  double ra, dec, d, crdec, ret = 0;
+  int i;
+
+  if (PG_ARGISNULL (0))
+    PG_RETURN_NULL ();
+
+  arg = PG_GETARG_KWCS2_P (0);
+
+  x[0] = 0;
+  y[0] = 0;
+  x[1] = arg->naxis1;
+  y[1] = 0;
+  x[2] = 0;
+  y[2] = arg->naxis2;
+  x[3] = arg->naxis1;
+  y[3] = arg->naxis2;
+
+  crdec = deg2rad (arg->crval2);
+
+  for (i = 0; i < 4; i++)
+    {
+      RTS2pix2wcs (arg, x[i], y[i], &ra, &dec);
+      ra = deg2rad (ra);
+      dec = deg2rad (dec);
+      // haversine formula, stable for small distances
+      d =
+	2 * asin (sqrt (pow (sin ((dec - crdec) / 2), 2) +
+			cos (dec) * cos (crdec) * pow (sin ((ra - deg2rad (arg->crval1)) / 2), 2)));
+      if (d > ret)
+	ret = d;
+    }
+
+  PG_RETURN_FLOAT8 (rad2deg (ret));
+}
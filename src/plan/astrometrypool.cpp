@@ -0,0 +1,681 @@
+/*
+ * In-process astrometry worker pool.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "astrometrypool.h"
+#include "block.h"
+#include "conncompletion.h"
+
+#include "sep/sep.h"
+#include "ucac5/UCAC5Bands.hpp"
+#include "ucac5/UCAC5Idx.hpp"
+#include "ucac5/UCAC5Record.hpp"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+#include <erfa.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fitsio.h>
+#include <limits.h>
+#include <math.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace rts2plan;
+
+// minimal number of matched stars to accept the solution
+#define MIN_MATCHED      5
+
+// number of refinement iterations of plate solution
+#define FIT_ITERATIONS   3
+
+// number of image rows read by a single CFITSIO call
+#define READ_ROWS        64
+
+namespace
+{
+
+struct DetStar
+{
+	double x;
+	double y;
+	double flux;
+};
+
+struct CatStar
+{
+	double mag;
+	// standard coordinates (radians)
+	double xi;
+	double eta;
+	// projected pixel position
+	double x;
+	double y;
+};
+
+struct Match
+{
+	const DetStar *det;
+	const CatStar *cat;
+};
+
+// plate solution, x = a[0] + a[1] * xi + a[2] * eta; y = b[0] + b[1] * xi + b[2] * eta
+struct Plate
+{
+	double a[3];
+	double b[3];
+};
+
+bool fluxCompare (const DetStar &s1, const DetStar &s2)
+{
+	return s1.flux > s2.flux;
+}
+
+bool magCompare (const CatStar &s1, const CatStar &s2)
+{
+	return s1.mag < s2.mag;
+}
+
+/**
+ * Gnomonic projection of ra, dec to standard coordinates around ra0, dec0. All values are in radians.
+ */
+bool project (double ra0, double dec0, double ra, double dec, double &xi, double &eta)
+{
+	double cosc = sin (dec0) * sin (dec) + cos (dec0) * cos (dec) * cos (ra - ra0);
+	if (cosc <= 0)
+		return false;
+	xi = cos (dec) * sin (ra - ra0) / cosc;
+	eta = (cos (dec0) * sin (dec) - sin (dec0) * cos (dec) * cos (ra - ra0)) / cosc;
+	return true;
+}
+
+void deproject (double ra0, double dec0, double xi, double eta, double &ra, double &dec)
+{
+	double d = cos (dec0) - eta * sin (dec0);
+	ra = ra0 + atan2 (xi, d);
+	dec = atan2 (sin (dec0) + eta * cos (dec0), sqrt (xi * xi + d * d));
+	ra = fmod (ra, 2 * M_PI);
+	if (ra < 0)
+		ra += 2 * M_PI;
+}
+
+// solve 3x3 linear system by Cramer's rule
+bool solve3 (double m[3][3], double v[3], double r[3])
+{
+	double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+		- m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+		+ m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+	if (fabs (det) < 1e-300)
+		return false;
+	for (int c = 0; c < 3; c++)
+	{
+		double t[3][3];
+		memcpy (t, m, sizeof (t));
+		for (int i = 0; i < 3; i++)
+			t[i][c] = v[i];
+		r[c] = (t[0][0] * (t[1][1] * t[2][2] - t[1][2] * t[2][1])
+			- t[0][1] * (t[1][0] * t[2][2] - t[1][2] * t[2][0])
+			+ t[0][2] * (t[1][0] * t[2][1] - t[1][1] * t[2][0])) / det;
+	}
+	return true;
+}
+
+bool fitPlate (std::vector <Match> &matches, Plate &plate)
+{
+	if (matches.size () < 3)
+		return false;
+	// scale standard coordinates to avoid badly conditioned matrix
+	double s = 0;
+	for (std::vector <Match>::iterator iter = matches.begin (); iter != matches.end (); iter++)
+		s = std::max (s, std::max (fabs (iter->cat->xi), fabs (iter->cat->eta)));
+	if (s == 0)
+		s = 1;
+
+	double m[3][3];
+	double vx[3] = {0, 0, 0};
+	double vy[3] = {0, 0, 0};
+	memset (m, 0, sizeof (m));
+	for (std::vector <Match>::iterator iter = matches.begin (); iter != matches.end (); iter++)
+	{
+		double r[3] = {1, iter->cat->xi / s, iter->cat->eta / s};
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+				m[i][j] += r[i] * r[j];
+			vx[i] += r[i] * iter->det->x;
+			vy[i] += r[i] * iter->det->y;
+		}
+	}
+	if (!solve3 (m, vx, plate.a) || !solve3 (m, vy, plate.b))
+		return false;
+	for (int i = 1; i < 3; i++)
+	{
+		plate.a[i] /= s;
+		plate.b[i] /= s;
+	}
+	return true;
+}
+
+void applyPlate (Plate &plate, std::vector <CatStar> &cat)
+{
+	for (std::vector <CatStar>::iterator iter = cat.begin (); iter != cat.end (); iter++)
+	{
+		iter->x = plate.a[0] + plate.a[1] * iter->xi + plate.a[2] * iter->eta;
+		iter->y = plate.b[0] + plate.b[1] * iter->xi + plate.b[2] * iter->eta;
+	}
+}
+
+// match detected stars to the closest catalogue stars, shifted by dx and dy
+void matchStars (std::vector <DetStar> &det, std::vector <CatStar> &cat, double dx, double dy, double tolerance, std::vector <Match> &matches)
+{
+	matches.clear ();
+	double t2 = tolerance * tolerance;
+	for (std::vector <DetStar>::iterator di = det.begin (); di != det.end (); di++)
+	{
+		const CatStar *best = NULL;
+		double bd = t2;
+		for (std::vector <CatStar>::iterator ci = cat.begin (); ci != cat.end (); ci++)
+		{
+			double ex = di->x - ci->x - dx;
+			double ey = di->y - ci->y - dy;
+			double d = ex * ex + ey * ey;
+			if (d < bd)
+			{
+				bd = d;
+				best = &(*ci);
+			}
+		}
+		if (best)
+		{
+			Match m;
+			m.det = &(*di);
+			m.cat = best;
+			matches.push_back (m);
+		}
+	}
+}
+
+// find most probable shift between detected and catalogue stars by voting in tolerance sized bins
+int findShift (std::vector <DetStar> &det, std::vector <CatStar> &cat, double maxShift, double tolerance, double &dx, double &dy)
+{
+	std::map <std::pair <int, int>, int> votes;
+	int best = 0;
+	for (std::vector <DetStar>::iterator di = det.begin (); di != det.end (); di++)
+	{
+		for (std::vector <CatStar>::iterator ci = cat.begin (); ci != cat.end (); ci++)
+		{
+			double sx = di->x - ci->x;
+			double sy = di->y - ci->y;
+			if (fabs (sx) > maxShift || fabs (sy) > maxShift)
+				continue;
+			std::pair <int, int> bin ((int) floor (sx / tolerance), (int) floor (sy / tolerance));
+			int v = ++votes[bin];
+			if (v > best)
+			{
+				best = v;
+				dx = (bin.first + 0.5) * tolerance;
+				dy = (bin.second + 0.5) * tolerance;
+			}
+		}
+	}
+	return best;
+}
+
+}
+
+AstrometryJob::AstrometryJob (const char *_path):rts2core::PoolTask ()
+{
+	path = std::string (_path);
+	astrometryStat = NOT_ASTROMETRY;
+	expEnd = NAN;
+	ra = dec = ra_err = dec_err = NAN;
+	detected = 0;
+	matched = 0;
+	fallback = false;
+	pool = NULL;
+}
+
+void AstrometryJob::run ()
+{
+	pool->solve (this);
+}
+
+void AstrometryJob::completed ()
+{
+	pool->pending--;
+	finished ();
+}
+
+AstrometryPool::AstrometryPool (rts2core::Block *_master, const char *_catalogue, int _threads):pool (_threads)
+{
+	master = _master;
+	catalogue = std::string (_catalogue);
+	maxStars = 60;
+	matchTolerance = 3;
+
+	completion = NULL;
+	pending = 0;
+
+	// CFITSIO built with thread support does not need to be serialized
+	fitsReentrant = fits_is_reentrant ();
+	pthread_mutex_init (&fitsMutex, NULL);
+}
+
+AstrometryPool::~AstrometryPool ()
+{
+	// runs queued jobs; connection, owned by the block, deletes them without calling finished
+	pool.stop ();
+
+	pthread_mutex_destroy (&fitsMutex);
+}
+
+int AstrometryPool::start ()
+{
+	if (pool.start ())
+		return -1;
+	completion = new rts2core::ConnCompletion (master);
+	if (completion->init ())
+	{
+		delete completion;
+		completion = NULL;
+		return -1;
+	}
+	master->addConnection (completion);
+	return 0;
+}
+
+void AstrometryPool::que (AstrometryJob *job)
+{
+	job->pool = this;
+	pending++;
+	pool.submit (job, completion);
+}
+
+void AstrometryPool::solve (AstrometryJob *job)
+{
+	fitsfile *fptr = NULL;
+	int status = 0;
+	float *data = NULL;
+	long naxes[2] = {0, 0};
+
+	// WCS from the header - CRVAL1, CRVAL2, CRPIX1, CRPIX2, CDELT1, CDELT2, CROTA2
+	double wcs[7] = {NAN, NAN, NAN, NAN, NAN, NAN, 0};
+	const char *wcs_names[7] = {"CRVAL1", "CRVAL2", "CRPIX1", "CRPIX2", "CDELT1", "CDELT2", "CROTA2"};
+
+	lockFits ();
+	fits_open_file (&fptr, job->path.c_str (), READONLY, &status);
+	if (status == 0)
+	{
+		int shutter = 0;
+		long ctime = 0, usec = 0;
+		double exptime = 0;
+		fits_read_key (fptr, TINT, "SHUTTER", &shutter, NULL, &status);
+		status = 0;
+		fits_read_key (fptr, TLONG, "CTIME", &ctime, NULL, &status);
+		fits_read_key (fptr, TLONG, "USEC", &usec, NULL, &status);
+		fits_read_key (fptr, TDOUBLE, "EXPTIME", &exptime, NULL, &status);
+		if (status == 0)
+			job->expEnd = ctime + usec / 1000000.0 + exptime;
+		status = 0;
+
+		if (shutter == 1)
+		{
+			job->astrometryStat = DARK;
+			fits_close_file (fptr, &status);
+			unlockFits ();
+			return;
+		}
+
+		for (int i = 0; i < 7; i++)
+		{
+			int s = 0;
+			fits_read_key (fptr, TDOUBLE, (char *) wcs_names[i], wcs + i, NULL, &s);
+		}
+
+		int naxis = 0;
+		fits_get_img_dim (fptr, &naxis, &status);
+		if (status == 0 && naxis == 2)
+		{
+			fits_get_img_size (fptr, 2, naxes, &status);
+			if (status == 0)
+			{
+				data = new float[naxes[0] * naxes[1]];
+				// read by blocks of rows; other workers can access their images between the blocks
+				for (long r = 0; r < naxes[1] && status == 0; r += READ_ROWS)
+				{
+					long rows = std::min (naxes[1] - r, (long) READ_ROWS);
+					fits_read_img (fptr, TFLOAT, 1 + r * naxes[0], rows * naxes[0], NULL, data + r * naxes[0], NULL, &status);
+					if (!fitsReentrant)
+					{
+						unlockFits ();
+						sched_yield ();
+						lockFits ();
+					}
+				}
+			}
+		}
+		else if (status == 0)
+		{
+			job->error = "image is not 2D";
+			status = -1;
+		}
+	}
+	if (status)
+	{
+		if (job->error.empty ())
+		{
+			char err[31];
+			fits_get_errstatus (status, err);
+			job->error = std::string ("cannot read image: ") + err;
+		}
+		job->astrometryStat = BAD;
+		if (fptr)
+		{
+			int s = 0;
+			fits_close_file (fptr, &s);
+		}
+		unlockFits ();
+		delete[] data;
+		return;
+	}
+	fits_close_file (fptr, &status);
+	fptr = NULL;
+	unlockFits ();
+
+	for (int i = 0; i < 6; i++)
+	{
+		if (isnan (wcs[i]))
+		{
+			job->error = std::string ("missing ") + wcs_names[i];
+			job->fallback = true;
+			break;
+		}
+	}
+
+	std::vector <DetStar> det;
+	std::vector <CatStar> cat;
+
+	// detect stars
+	if (!job->fallback)
+	{
+		sep_image im = {data, NULL, NULL, SEP_TFLOAT, 0, 0, (int) naxes[0], (int) naxes[1], 0.0, SEP_NOISE_NONE, 1.0, 0.0};
+		sep_bkg *bkg = NULL;
+		sep_catalog *catalog = NULL;
+		int sstatus = sep_background (&im, 64, 64, 3, 3, 0.0, &bkg);
+		if (sstatus == 0)
+			sstatus = sep_bkg_subarray (bkg, im.data, im.dtype);
+		if (sstatus == 0)
+		{
+			float conv[] = {1, 2, 1, 2, 4, 2, 1, 2, 1};
+			sstatus = sep_extract (&im, 1.5 * bkg->globalrms, SEP_THRESH_ABS, 5, conv, 3, 3, SEP_FILTER_CONV, 32, 0.005, 1, 1.0, &catalog);
+		}
+		if (sstatus == 0)
+		{
+			for (int i = 0; i < catalog->nobj; i++)
+			{
+				if (catalog->flag[i] & (SEP_OBJ_TRUNC | SEP_OBJ_SINGU))
+					continue;
+				DetStar s;
+				// FITS pixels start at 1
+				s.x = catalog->x[i] + 1;
+				s.y = catalog->y[i] + 1;
+				s.flux = catalog->flux[i];
+				det.push_back (s);
+			}
+		}
+		else
+		{
+			std::ostringstream os;
+			os << "SEP error " << sstatus;
+			job->error = os.str ();
+		}
+		if (catalog)
+			sep_catalog_free (catalog);
+		if (bkg)
+			sep_bkg_free (bkg);
+	}
+	delete[] data;
+
+	job->detected = det.size ();
+	std::sort (det.begin (), det.end (), fluxCompare);
+	if ((int) det.size () > maxStars)
+		det.resize (maxStars);
+
+	double ra0 = wcs[0] * M_PI / 180.0;
+	double dec0 = wcs[1] * M_PI / 180.0;
+
+	// CD matrix from CDELT and CROTA, pixel = CD^-1 * standard (degrees)
+	double rot = wcs[6] * M_PI / 180.0;
+	double cd[2][2] = {{wcs[4] * cos (rot), -wcs[5] * sin (rot)}, {wcs[4] * sin (rot), wcs[5] * cos (rot)}};
+	double cdet = cd[0][0] * cd[1][1] - cd[0][1] * cd[1][0];
+
+	// original pointing at image center
+	double ra_orig = NAN, dec_orig = NAN;
+	if (!job->fallback && cdet != 0)
+	{
+		double px = naxes[0] / 2.0 - wcs[2];
+		double py = naxes[1] / 2.0 - wcs[3];
+		deproject (ra0, dec0, (cd[0][0] * px + cd[0][1] * py) * M_PI / 180.0, (cd[1][0] * px + cd[1][1] * py) * M_PI / 180.0, ra_orig, dec_orig);
+	}
+	else if (!job->fallback)
+	{
+		job->error = "singular WCS matrix";
+		job->fallback = true;
+	}
+
+	// catalogue stars around the field center
+	if (!job->fallback && det.size () >= MIN_MATCHED)
+	{
+		double radius = 0.75 * hypot (naxes[0] * wcs[4], naxes[1] * wcs[5]) * M_PI / 180.0;
+
+		UCAC5Bands bands;
+		if (bands.openBand ((catalogue + "/u5index.unf").c_str ()))
+		{
+			job->error = "cannot open UCAC5 band index in " + catalogue;
+			job->fallback = true;
+		}
+		else
+		{
+			Vector tar;
+			eraS2c (ra_orig, dec_orig, tar.data);
+
+			UCAC5Idx *index = NULL;
+			uint16_t dec_b = 0, ra_b = 0;
+			uint32_t ra_start = 0;
+			int32_t len;
+			while (bands.nextBand (ra_orig, dec_orig, radius, dec_b, ra_b, ra_start, len) == 0)
+			{
+				if (len < 0)
+					continue;
+				if (index == NULL || index->getBand () != dec_b)
+				{
+					delete index;
+					index = new UCAC5Idx ();
+					if (index->openIdx (dec_b, catalogue.c_str ()))
+					{
+						delete index;
+						index = NULL;
+						continue;
+					}
+				}
+				if (index->select (ra_start, len))
+					continue;
+
+				char fn[PATH_MAX];
+				snprintf (fn, PATH_MAX, "%s/z%03d", catalogue.c_str (), dec_b + 1);
+				int fd = open (fn, O_RDONLY);
+				if (fd < 0)
+					continue;
+				struct stat sb;
+				struct ucac5 *cdata = NULL;
+				if (fstat (fd, &sb) == 0)
+					cdata = (struct ucac5 *) mmap (NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+				if (cdata == NULL || cdata == MAP_FAILED)
+				{
+					close (fd);
+					continue;
+				}
+
+				double d;
+				int star;
+				while ((star = index->nextMatched (&tar, 0, radius, d)) >= 0)
+				{
+					UCAC5Record rec (cdata + star);
+					CatStar cs;
+					cs.mag = rec.getMag ();
+					if (!project (ra0, dec0, rec.getRARad (), rec.getDecRad (), cs.xi, cs.eta))
+						continue;
+					cat.push_back (cs);
+				}
+				munmap (cdata, sb.st_size);
+				close (fd);
+			}
+			delete index;
+		}
+	}
+
+	std::sort (cat.begin (), cat.end (), magCompare);
+	if ((int) cat.size () > 2 * maxStars)
+		cat.resize (2 * maxStars);
+
+	if (job->fallback)
+		return;
+
+	if ((int) det.size () < MIN_MATCHED || (int) cat.size () < MIN_MATCHED)
+	{
+		std::ostringstream os;
+		os << "not enough stars, detected " << det.size () << " catalogue " << cat.size ();
+		job->error = os.str ();
+		job->astrometryStat = TRASH;
+		return;
+	}
+
+	// initial plate from header WCS
+	Plate plate;
+	double icd[2][2] = {{cd[1][1] / cdet, -cd[0][1] / cdet}, {-cd[1][0] / cdet, cd[0][0] / cdet}};
+	double d2r = 180.0 / M_PI;
+	plate.a[0] = wcs[2];
+	plate.a[1] = icd[0][0] * d2r;
+	plate.a[2] = icd[0][1] * d2r;
+	plate.b[0] = wcs[3];
+	plate.b[1] = icd[1][0] * d2r;
+	plate.b[2] = icd[1][1] * d2r;
+	applyPlate (plate, cat);
+
+	double dx = 0, dy = 0;
+	int votes = findShift (det, cat, std::max (naxes[0], naxes[1]) / 2.0, matchTolerance, dx, dy);
+	if (votes < MIN_MATCHED)
+	{
+		std::ostringstream os;
+		os << "cannot find shift between catalogue and image, best votes " << votes;
+		job->error = os.str ();
+		job->astrometryStat = TRASH;
+		return;
+	}
+
+	std::vector <Match> matches;
+	matchStars (det, cat, dx, dy, 2 * matchTolerance, matches);
+	for (int i = 0; i < FIT_ITERATIONS && (int) matches.size () >= MIN_MATCHED; i++)
+	{
+		if (!fitPlate (matches, plate))
+			break;
+		applyPlate (plate, cat);
+		matchStars (det, cat, 0, 0, matchTolerance, matches);
+	}
+
+	job->matched = matches.size ();
+	if ((int) matches.size () < MIN_MATCHED || !fitPlate (matches, plate))
+	{
+		std::ostringstream os;
+		os << "only " << matches.size () << " stars matched";
+		job->error = os.str ();
+		job->astrometryStat = TRASH;
+		return;
+	}
+
+	// new CD matrix is inverse of plate linear part, in degrees per pixel
+	double pdet = plate.a[1] * plate.b[2] - plate.a[2] * plate.b[1];
+	if (pdet == 0)
+	{
+		job->error = "singular plate solution";
+		job->astrometryStat = TRASH;
+		return;
+	}
+	double ncd[2][2] = {{plate.b[2] / pdet * d2r, -plate.a[2] / pdet * d2r}, {-plate.b[1] / pdet * d2r, plate.a[1] / pdet * d2r}};
+
+	// sky position of the reference pixel and of the image center
+	double nra, ndec;
+	double px = wcs[2] - plate.a[0];
+	double py = wcs[3] - plate.b[0];
+	deproject (ra0, dec0, (ncd[0][0] * px + ncd[0][1] * py) / d2r, (ncd[1][0] * px + ncd[1][1] * py) / d2r, nra, ndec);
+
+	px = naxes[0] / 2.0 - plate.a[0];
+	py = naxes[1] / 2.0 - plate.b[0];
+	double cra, cdec;
+	deproject (ra0, dec0, (ncd[0][0] * px + ncd[0][1] * py) / d2r, (ncd[1][0] * px + ncd[1][1] * py) / d2r, cra, cdec);
+
+	job->ra = cra * d2r;
+	job->dec = cdec * d2r;
+	double dra = ra_orig - cra;
+	if (dra > M_PI)
+		dra -= 2 * M_PI;
+	if (dra < -M_PI)
+		dra += 2 * M_PI;
+	job->ra_err = cos (dec_orig) * dra * d2r;
+	job->dec_err = (dec_orig - cdec) * d2r;
+	job->astrometryStat = GET;
+
+	// CDELT and CROTA2, keeping sign of the original CDELT1
+	double cdelt1 = copysign (hypot (ncd[0][0], ncd[1][0]), wcs[4]);
+	double nrot = atan2 (ncd[1][0] / cdelt1, ncd[0][0] / cdelt1);
+	double cdelt2 = fabs (cos (nrot)) > 0.5 ? ncd[1][1] / cos (nrot) : -ncd[0][1] / sin (nrot);
+	double nwcs[7] = {nra * d2r, ndec * d2r, wcs[2], wcs[3], cdelt1, cdelt2, nrot * d2r};
+	const char *wcs_desc[7] = {"reference value on 1st axis", "reference value on 2nd axis", "reference pixel of the 1st axis", "reference pixel of the 2nd axis", "delta along 1st axis", "delta along 2nd axis", "rotational angle"};
+
+	lockFits ();
+	status = 0;
+	fits_open_file (&fptr, job->path.c_str (), READWRITE, &status);
+	for (int i = 0; i < 7 && status == 0; i++)
+	{
+		if (i == 2 || i == 3)
+			continue;
+		fits_update_key (fptr, TDOUBLE, (char *) wcs_names[i], nwcs + i, (char *) wcs_desc[i], &status);
+	}
+	fits_update_key (fptr, TDOUBLE, (char *) "CD1_1", &ncd[0][0], (char *) "WCS transformation matrix", &status);
+	fits_update_key (fptr, TDOUBLE, (char *) "CD1_2", &ncd[0][1], (char *) "WCS transformation matrix", &status);
+	fits_update_key (fptr, TDOUBLE, (char *) "CD2_1", &ncd[1][0], (char *) "WCS transformation matrix", &status);
+	fits_update_key (fptr, TDOUBLE, (char *) "CD2_2", &ncd[1][1], (char *) "WCS transformation matrix", &status);
+	fits_update_key (fptr, TINT, (char *) "ASTR_NUM", &(job->matched), (char *) "number of stars matched by astrometry", &status);
+	if (status)
+	{
+		char err[31];
+		fits_get_errstatus (status, err);
+		job->error = std::string ("cannot write WCS: ") + err;
+		job->astrometryStat = BAD;
+	}
+	int s = 0;
+	if (fptr)
+		fits_close_file (fptr, &s);
+	unlockFits ();
+}
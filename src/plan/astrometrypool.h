@@ -0,0 +1,167 @@
+/*
+ * In-process astrometry worker pool.
+ * Copyright (C) 2018 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_ASTROMETRYPOOL__
+#define __RTS2_ASTROMETRYPOOL__
+
+#include "threadpool.h"
+#include "rts2script/connimgprocess.h"
+
+#include <string>
+#include <pthread.h>
+
+namespace rts2core
+{
+class Block;
+class ConnCompletion;
+}
+
+namespace rts2plan
+{
+
+class AstrometryPool;
+
+/**
+ * Single image processed by AstrometryPool.
+ *
+ * Job is created in the main thread, filled by pool thread and handed back
+ * to the main thread, which moves the image and sends corrections.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class AstrometryJob:public rts2core::PoolTask
+{
+	public:
+		AstrometryJob (const char *_path);
+
+		virtual void run ();
+
+		/**
+		 * Called from the main loop after the job was run. Calls finished.
+		 */
+		virtual void completed ();
+
+		/**
+		 * Called from the main loop after the image was processed. Job is deleted after this call.
+		 */
+		virtual void finished () {}
+
+		std::string path;
+
+		astrometry_stat_t astrometryStat;
+
+		// exposure end (ctime)
+		double expEnd;
+
+		// astrometry of the image center and its offset from the original WCS, all in degrees
+		double ra;
+		double dec;
+		double ra_err;
+		double dec_err;
+
+		// number of detected and matched stars
+		int detected;
+		int matched;
+
+		// true if image cannot be solved in process (no initial WCS, no catalogue), so external script shall be used
+		bool fallback;
+
+		std::string error;
+
+	private:
+		AstrometryPool *pool;
+
+		friend class AstrometryPool;
+};
+
+/**
+ * Pool of threads performing astrometry inside rts2-imgproc, without forking external script.
+ *
+ * Each job opens FITS file once, detects stars with SEP, projects
+ * UCAC5 stars around the initial WCS position, finds shift between detected
+ * and catalogue stars, fits linear plate solution and writes updated WCS
+ * back to FITS header. Jobs run on rts2core::ThreadPool and are returned
+ * to the main loop through completion connection, which calls
+ * AstrometryJob::finished.
+ *
+ * CFITSIO calls are serialized, unless CFITSIO was compiled thread-safe.
+ * Image data are read by blocks of rows, so a large image does not block
+ * other workers.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class AstrometryPool
+{
+	public:
+		/**
+		 * @param _master     block which runs the completion connection
+		 * @param _catalogue  path to UCAC5 catalogue (directory with u5index.unf)
+		 * @param _threads    number of worker threads
+		 */
+		AstrometryPool (rts2core::Block *_master, const char *_catalogue, int _threads);
+		~AstrometryPool ();
+
+		/**
+		 * Creates completion connection and starts worker threads.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int start ();
+
+		/**
+		 * Que image for processing. Job is deleted after its finished method is called.
+		 */
+		void que (AstrometryJob *job);
+
+		/**
+		 * Number of jobs waiting or being processed. Shall be called only from the main loop.
+		 */
+		int getPending () { return pending; }
+
+		int getThreads () { return pool.getThreads (); }
+
+		void setMaxStars (int _maxStars) { maxStars = _maxStars; }
+		void setMatchTolerance (double _tolerance) { matchTolerance = _tolerance; }
+
+	private:
+		rts2core::Block *master;
+		std::string catalogue;
+		int maxStars;
+		double matchTolerance;
+
+		rts2core::ThreadPool pool;
+		rts2core::ConnCompletion *completion;
+
+		int pending;
+
+		// true if CFITSIO was built thread-safe
+		bool fitsReentrant;
+		pthread_mutex_t fitsMutex;
+
+		void lockFits () { if (!fitsReentrant) pthread_mutex_lock (&fitsMutex); }
+		void unlockFits () { if (!fitsReentrant) pthread_mutex_unlock (&fitsMutex); }
+
+		void solve (AstrometryJob *job);
+
+		friend class AstrometryJob;
+};
+
+}
+
+#endif // !__RTS2_ASTROMETRYPOOL__
@@ -89,7 +89,21 @@ class Executor:public rts2db::DeviceDb
 		int setNextPlan (int nextPlanId);
 		int queueTarget (int nextId, double t_start = NAN, double t_end = NAN, int plan_id = -1);
 		int setNow (int nextId, int plan_id);
-		int setGrb (int grbId);
+		/**
+		 * Execute GRB target.
+		 *
+		 * @param grbId        target ID
+		 * @param alertTarget  target created from GCN notice parameters; if NULL, target is loaded from the database
+		 * @param received     time GCN notice was received by GRB daemon, NAN if not known
+		 */
+		int setGrb (int grbId, rts2db::TargetGRB *alertTarget = NULL, double received = NAN);
+		int setGrbNow (rts2db::Target *grbTarget, double received);
+
+		/**
+		 * Mark GRB target as stored in the database by GRB daemon.
+		 */
+		void grbStored (int grbId);
+
 		int setShower ();
 
 		/**
@@ -115,6 +129,12 @@ class Executor:public rts2db::DeviceDb
 		rts2core::ValueDouble *grb_sep_limit;
 		rts2core::ValueDouble *grb_min_sep;
 
+		// alert to slew timing
+		rts2core::ValueTime *grb_received;
+		rts2core::ValueTime *grb_accepted;
+		rts2core::ValueTime *grb_slew_start;
+		rts2core::ValueDouble *grb_latency;
+
 		rts2core::ValueBool *enabled;
 		rts2core::ValueBool *selectorNext;
 		bool selector_next_reported;
@@ -233,6 +253,11 @@ Executor::Executor (int in_argc, char **in_argv):rts2db::DeviceDb (in_argc, in_a
 	createValue (grb_min_sep, "grb_min_sep", "[deg] when GRB is below grb_min_sep degrees from current position, telescope will not be slewed", false, RTS2_VALUE_WRITABLE | RTS2_DT_DEG_DIST);
 	grb_min_sep->setValueDouble (0);
 
+	createValue (grb_received, "grb_received", "time when GRB daemon received GCN notice of the last executed GRB", false);
+	createValue (grb_accepted, "grb_accepted", "time when executor accepted the last GRB", false);
+	createValue (grb_slew_start, "grb_slew_start", "time when slew to the last GRB started", false);
+	createValue (grb_latency, "grb_latency", "[s] time from GCN notice reception to slew start", false, RTS2_DT_TIMEINTERVAL);
+
 	addOption (OPT_IGNORE_DAY, "ignore-day", 0, "observe even during daytime");
 	addOption (OPT_DONT_DARK, "no-dark", 0, "do not take on its own dark frames");
 	addOption (OPT_DISABLE_AUTO, "no-auto", 0, "disable autolooping");
@@ -747,15 +772,42 @@ int Executor::setNow (rts2db::Target * newTarget, int plan_id)
 	return 0;
 }
 
-int Executor::setGrb (int grbId)
+int Executor::setGrbNow (rts2db::Target *grbTarget, double received)
 {
-	rts2db::Target *grbTarget = NULL;
+	grb_received->setValueDouble (received);
+	grb_slew_start->setValueDouble (NAN);
+	grb_latency->setValueDouble (NAN);
+
+	int ret = setNow (grbTarget, -1);
+
+	// target is set and telescope was commanded to move during setNow
+	grb_slew_start->setNow ();
+	if (!std::isnan (received))
+	{
+		grb_latency->setValueDouble (grb_slew_start->getValueDouble () - received);
+		logStream (MESSAGE_INFO) << "slew to GRB " << grbTarget->getTargetName () << " (#" << grbTarget->getTargetID () << ") started " << grb_latency->getValueDouble () << " seconds after GCN notice reception" << sendLog;
+	}
+	sendValueAll (grb_received);
+	sendValueAll (grb_slew_start);
+	sendValueAll (grb_latency);
+	return ret;
+}
+
+int Executor::setGrb (int grbId, rts2db::TargetGRB *alertTarget, double received)
+{
+	rts2db::Target *grbTarget = alertTarget;
 	int ret;
 
+	grb_accepted->setNow ();
+	sendValueAll (grb_accepted);
+	if (!std::isnan (received))
+		logStream (MESSAGE_INFO) << "GRB alert for target " << grbId << " accepted " << (grb_accepted->getValueDouble () - received) << " seconds after GCN notice reception" << sendLog;
+
 	// is during night and ready?
 	if (!(getMasterState () == SERVERD_NIGHT || getMasterState () == SERVERD_DUSK || getMasterState () == SERVERD_DAWN))
 	{
 		logStream (MESSAGE_DEBUG) << "daylight / not on state GRB ignored" << sendLog;
+		delete grbTarget;
 		return -2;
 	}
 	try
@@ -763,9 +815,11 @@ int Executor::setGrb (int grbId)
 		if (Configuration::instance ()->grbdValidity () == 0)
 		{
 			logStream (MESSAGE_INFO) << "GRBs has 0 validity period, grb command ignored for GRB with target id " << grbId << sendLog;
+			delete grbTarget;
 			return 0;
 		}
-		grbTarget = createTarget (grbId, observer, obs_altitude);
+		if (grbTarget == NULL)
+			grbTarget = createTarget (grbId, observer, obs_altitude);
 
 		if (!grbTarget)
 			return -2;
@@ -797,7 +851,7 @@ int Executor::setGrb (int grbId)
 		}
 		if (!currentTarget)
 		{
-			return setNow (grbTarget, -1);
+			return setGrbNow (grbTarget, received);
 		}
 
 		if (currentTarget->getTargetType () == TYPE_GRB && grbTarget->getTargetType () == TYPE_GRB)
@@ -817,7 +871,7 @@ int Executor::setGrb (int grbId)
 		ret = grbTarget->compareWithTarget (currentTarget, grb_sep_limit->getValueDouble ());
 		if (ret == 0)
 		{
-			return setNow (grbTarget, -1);
+			return setGrbNow (grbTarget, received);
 		}
 		// if that's only few arcsec update, don't change
 		ret = grbTarget->compareWithTarget (currentTarget, grb_min_sep->getValueDouble ());
@@ -844,6 +898,20 @@ int Executor::setGrb (int grbId)
 	}
 }
 
+void Executor::grbStored (int grbId)
+{
+	if (currentTarget && currentTarget->getTargetType () == TYPE_GRB && currentTarget->getTargetID () == grbId)
+		((rts2db::TargetGRB *) currentTarget)->setStored ();
+	for (std::list <ExecutorQueue>::iterator qi = queues.begin (); qi != queues.end (); qi++)
+	{
+		for (ExecutorQueue::iterator ti = qi->begin (); ti != qi->end (); ti++)
+		{
+			if (ti->target->getTargetType () == TYPE_GRB && ti->target->getTargetID () == grbId)
+				((rts2db::TargetGRB *) ti->target)->setStored ();
+		}
+	}
+}
+
 int Executor::setShower ()
 {
 	// is during night and ready?
@@ -1060,6 +1128,34 @@ int Executor::commandAuthorized (rts2core::Connection * conn)
 			return -2;
 		return setGrb (tar_id);
 	}
+	else if (conn->isCommand ("grb_alert"))
+	{
+		// GRB with position from GCN notice, target might not yet be in the database
+		int gcn_id, gcn_type, enabled, stored;
+		double ra, dec, errorbox, grb_date, received;
+		if (conn->paramNextInteger (&tar_id)
+			|| conn->paramNextInteger (&gcn_id)
+			|| conn->paramNextInteger (&gcn_type)
+			|| conn->paramNextDouble (&ra)
+			|| conn->paramNextDouble (&dec)
+			|| conn->paramNextDouble (&errorbox)
+			|| conn->paramNextDouble (&grb_date)
+			|| conn->paramNextInteger (&enabled)
+			|| conn->paramNextInteger (&stored)
+			|| conn->paramNextDouble (&received)
+			|| !conn->paramEnd ())
+			return -2;
+		rts2db::TargetGRB *alertTarget = new rts2db::TargetGRB (tar_id, observer, obs_altitude, 3600, 86400, 5 * 86400);
+		alertTarget->loadAlert (gcn_id, gcn_type, ra, dec, errorbox, grb_date, enabled, stored);
+		return setGrb (tar_id, alertTarget, received);
+	}
+	else if (conn->isCommand ("grb_stored"))
+	{
+		if (conn->paramNextInteger (&tar_id) || !conn->paramEnd ())
+			return -2;
+		grbStored (tar_id);
+		return 0;
+	}
 	else if (conn->isCommand ("shower"))
 	{
 		if (!conn->paramEnd ())
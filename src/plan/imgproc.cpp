@@ -21,6 +21,12 @@
 #include "rts2script/connimgprocess.h"
 #include "rts2script/script.h"
 
+#ifdef RTS2_LIBERFA
+#include "astrometrypool.h"
+#endif
+
+#include <deque>
+#include <errno.h>
 #include <glob.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -131,6 +137,31 @@ class ImageProc:public rts2core::Device
 		rts2core::ValueInteger *nightDarks;
 		rts2core::ValueInteger *nightFlats;
 
+		rts2core::ValueDouble *imagesPerMinute;
+		rts2core::ValueInteger *inprocThreads;
+
+		// completion times of images processed in last RATE_WINDOW seconds
+		std::deque <double> processedTimes;
+
+#ifdef RTS2_LIBERFA
+		AstrometryPool *astrometryPool;
+		std::string ucac5Path;
+
+		/**
+		 * Move image processed by in-process astrometry, send corrections and que next image.
+		 */
+		void processFinishedJob (AstrometryJob *job);
+
+		friend class ImageProcJob;
+#endif
+
+		/**
+		 * Update counters and last image values after image was processed.
+		 */
+		void countImage (astrometry_stat_t stat, double expEnd, double ra, double dec, double ra_err, double dec_err);
+
+		int getPoolPending ();
+
 		int sendStop;			 // if stop running astrometry with stop signal; it ussually doesn't work, so we will use FIFO
 
 		std::string defaultImgProcess;
@@ -144,10 +175,29 @@ class ImageProc:public rts2core::Device
 		const char *last_trash_jpeg;
 };
 
+#ifdef RTS2_LIBERFA
+/**
+ * In-process astrometry job, which passes its result to ImageProc.
+ */
+class ImageProcJob:public AstrometryJob
+{
+	public:
+		ImageProcJob (ImageProc *_master, const char *_path):AstrometryJob (_path) { master = _master; }
+
+		virtual void finished () { master->processFinishedJob (this); }
+
+	private:
+		ImageProc *master;
+};
+#endif
+
 };
 
 using namespace rts2plan;
 
+// window for images_per_minute calculation, in seconds
+#define RATE_WINDOW    300
+
 ImageProc::ImageProc (int _argc, char **_argv)
 #ifdef RTS2_HAVE_PGSQL
 :rts2db::DeviceDb (_argc, _argv, DEVICE_TYPE_IMGPROC, "IMGP")
@@ -199,6 +249,16 @@ ImageProc::ImageProc (int _argc, char **_argv)
 	createValue (nightDarks, "night_darks", "number of dark images taken during night", false);
 	createValue (nightFlats, "night_flats", "number of flat images taken during night", false);
 
+	createValue (imagesPerMinute, "images_per_minute", "number of images processed per minute, averaged over last 5 minutes", false);
+	imagesPerMinute->setValueDouble (0);
+
+	createValue (inprocThreads, "inproc_threads", "number of threads used for in-process astrometry, 0 if external script is used", false);
+	inprocThreads->setValueInteger (0);
+
+#ifdef RTS2_LIBERFA
+	astrometryPool = NULL;
+#endif
+
 	createValue (image_glob, "image_glob", "glob path for images processed in standy mode", false, RTS2_VALUE_WRITABLE);
 
 	imageGlob.gl_pathc = 0;
@@ -224,6 +284,9 @@ ImageProc::~ImageProc (void)
 		globfree (&imageGlob);
 	if (runningImage)
 		delete[] runningImage;
+#ifdef RTS2_LIBERFA
+	delete astrometryPool;
+#endif
 }
 
 int ImageProc::reloadConfig ()
@@ -277,6 +340,35 @@ int ImageProc::reloadConfig ()
 	for (int i = 0; i < np; i++)
 		runningImage[i] = NULL;
 
+#ifdef RTS2_LIBERFA
+	// in-process astrometry; threads cannot be changed once the pool is running
+	int threads = config->getIntegerDefault ("imgproc", "inprocess", 0);
+	ucac5Path = config->getStringDefault ("imgproc", "ucac5", "");
+	if (astrometryPool == NULL && threads > 0)
+	{
+		if (ucac5Path.length () == 0)
+		{
+			logStream (MESSAGE_ERROR) << "in-process astrometry requires path to UCAC5 catalogue in imgproc/ucac5, using external script" << sendLog;
+		}
+		else
+		{
+			astrometryPool = new AstrometryPool (this, ucac5Path.c_str (), threads);
+			astrometryPool->setMaxStars (config->getIntegerDefault ("imgproc", "inprocess_stars", 60));
+			astrometryPool->setMatchTolerance (config->getDoubleDefault ("imgproc", "inprocess_tolerance", 3));
+			if (astrometryPool->start ())
+			{
+				logStream (MESSAGE_ERROR) << "cannot start in-process astrometry threads: " << strerror (errno) << sendLog;
+				delete astrometryPool;
+				astrometryPool = NULL;
+			}
+			else
+			{
+				inprocThreads->setValueInteger (threads);
+			}
+		}
+	}
+#endif
+
 	return ret;
 }
 
@@ -357,8 +449,14 @@ int ImageProc::info ()
 	int np = numProc->getValueInteger ();
 	for (int i = 0; i < np; i++)
 		num_running += (runningImage[i] ? 1 : 0);
-	queSize->setValueInteger ((int) imagesQue.size () + num_running);
+	queSize->setValueInteger ((int) imagesQue.size () + num_running + getPoolPending ());
 	sendValueAll (queSize);
+
+	double now = getNow ();
+	while (!processedTimes.empty () && processedTimes.front () < now - RATE_WINDOW)
+		processedTimes.pop_front ();
+	imagesPerMinute->setValueDouble (processedTimes.size () * 60.0 / RATE_WINDOW);
+	sendValueAll (imagesPerMinute);
 #ifdef RTS2_HAVE_PGSQL
 	return rts2db::DeviceDb::info ();
 #else
@@ -435,59 +533,10 @@ int ImageProc::deleteConnection (rts2core::Connection * conn, int slot)
 	{
 		// que next image
 		// rts2core::Device::deleteConnection will delete rImage
-		switch (rImage->getAstrometryStat ())
-		{
-			case GET:
-				goodImages->inc ();
-				nightGoodImages->inc ();
-				lastRaDec->setValueRaDec (((ConnImgOnlyProcess *) rImage)->getRa (), ((ConnImgOnlyProcess *) rImage)->getDec ());
-				lastCorrections->setValueRaDec (((ConnImgOnlyProcess *) rImage)->getRaErr (), ((ConnImgOnlyProcess *) rImage)->getDecErr ());
-				sendValueAll (goodImages);
-				sendValueAll (nightGoodImages);
-				sendValueAll (lastRaDec);
-				sendValueAll (lastCorrections);
-				if (std::isnan (lastGood->getValueDouble ()) || rImage->getExposureEnd () > lastGood->getValueDouble ())
-				{
-					lastGood->setValueDouble (rImage->getExposureEnd ());
-					sendValueAll (lastGood);
-				}
-				break;
-			case NOT_ASTROMETRY:
-			case TRASH:
-				trashImages->inc ();
-				nightTrashImages->inc ();
-				sendValueAll (trashImages);
-				sendValueAll (nightTrashImages);
-				if (std::isnan (lastTrash->getValueDouble ()) || rImage->getExposureEnd () > lastTrash->getValueDouble ())
-				{
-					lastTrash->setValueDouble (rImage->getExposureEnd ());
-					sendValueAll (lastTrash);
-				}
-				break;
-			case BAD:
-				badImages->inc ();
-				nightBadImages->inc ();
-				sendValueAll (badImages);
-				sendValueAll (nightBadImages);
-				lastBad->setValueDouble (getNow ());
-				sendValueAll (lastBad);
-				break;
-			case FLAT:
-				flatImages->inc ();
-				nightFlats->inc ();
-				sendValueAll (flatImages);
-				sendValueAll (nightFlats);
-				break;
-			case DARK:
-				darkImages->inc ();
-				nightDarks->inc ();
-				sendValueAll (darkImages);
-				sendValueAll (nightDarks);
-				break;
-			default:
-				logStream (MESSAGE_ERROR) << "wrong image state: " << rImage->getAstrometryStat () << sendLog;
-				break;
-		}
+		if (rImage->getAstrometryStat () == GET)
+			countImage (GET, rImage->getExposureEnd (), ((ConnImgOnlyProcess *) rImage)->getRa (), ((ConnImgOnlyProcess *) rImage)->getDec (), ((ConnImgOnlyProcess *) rImage)->getRaErr (), ((ConnImgOnlyProcess *) rImage)->getDecErr ());
+		else
+			countImage (rImage->getAstrometryStat (), rImage->getExposureEnd (), NAN, NAN, NAN, NAN);
 		rImage = NULL;
 		img_iter = imagesQue.begin ();
 		if (img_iter != imagesQue.end ())
@@ -525,6 +574,134 @@ int ImageProc::deleteConnection (rts2core::Connection * conn, int slot)
 #endif
 }
 
+void ImageProc::countImage (astrometry_stat_t stat, double expEnd, double ra, double dec, double ra_err, double dec_err)
+{
+	switch (stat)
+	{
+		case GET:
+			goodImages->inc ();
+			nightGoodImages->inc ();
+			lastRaDec->setValueRaDec (ra, dec);
+			lastCorrections->setValueRaDec (ra_err, dec_err);
+			sendValueAll (goodImages);
+			sendValueAll (nightGoodImages);
+			sendValueAll (lastRaDec);
+			sendValueAll (lastCorrections);
+			if (std::isnan (lastGood->getValueDouble ()) || expEnd > lastGood->getValueDouble ())
+			{
+				lastGood->setValueDouble (expEnd);
+				sendValueAll (lastGood);
+			}
+			break;
+		case NOT_ASTROMETRY:
+		case TRASH:
+			trashImages->inc ();
+			nightTrashImages->inc ();
+			sendValueAll (trashImages);
+			sendValueAll (nightTrashImages);
+			if (std::isnan (lastTrash->getValueDouble ()) || expEnd > lastTrash->getValueDouble ())
+			{
+				lastTrash->setValueDouble (expEnd);
+				sendValueAll (lastTrash);
+			}
+			break;
+		case BAD:
+			badImages->inc ();
+			nightBadImages->inc ();
+			sendValueAll (badImages);
+			sendValueAll (nightBadImages);
+			lastBad->setValueDouble (getNow ());
+			sendValueAll (lastBad);
+			break;
+		case FLAT:
+			flatImages->inc ();
+			nightFlats->inc ();
+			sendValueAll (flatImages);
+			sendValueAll (nightFlats);
+			break;
+		case DARK:
+			darkImages->inc ();
+			nightDarks->inc ();
+			sendValueAll (darkImages);
+			sendValueAll (nightDarks);
+			break;
+		default:
+			logStream (MESSAGE_ERROR) << "wrong image state: " << stat << sendLog;
+			break;
+	}
+	processedTimes.push_back (getNow ());
+}
+
+int ImageProc::getPoolPending ()
+{
+#ifdef RTS2_LIBERFA
+	if (astrometryPool)
+		return astrometryPool->getPending ();
+#endif
+	return 0;
+}
+
+#ifdef RTS2_LIBERFA
+void ImageProc::processFinishedJob (AstrometryJob *job)
+{
+	if (job->fallback && defaultImgProcess.length () > 0)
+	{
+		logStream (MESSAGE_DEBUG) << "in-process astrometry cannot process " << job->path << " (" << job->error << "), using " << defaultImgProcess << sendLog;
+		que (new ConnImgProcess (this, defaultImgProcess.c_str (), job->path.c_str (), astrometryTimeout->getValueInteger ()));
+		return;
+	}
+	if (job->fallback)
+		job->astrometryStat = TRASH;
+
+	if (job->error.length () > 0)
+		logStream (job->astrometryStat == BAD ? MESSAGE_ERROR : MESSAGE_DEBUG) << "in-process astrometry of " << job->path << ": " << job->error << sendLog;
+	else
+		logStream (MESSAGE_DEBUG) << "in-process astrometry of " << job->path << " detected " << job->detected << " matched " << job->matched << " stars" << sendLog;
+
+	const char *good_jpeg = NULL;
+	const char *trash_jpeg = NULL;
+#ifdef RTS2_HAVE_LIBJPEG
+	if (std::isnan (lastGood->getValueDouble ()) || lastGood->getValueDouble () < job->expEnd)
+		good_jpeg = last_good_jpeg;
+	if (std::isnan (lastTrash->getValueDouble ()) || lastTrash->getValueDouble () < job->expEnd)
+		trash_jpeg = last_trash_jpeg;
+#endif
+	// image which cannot be read or updated is moved to bad directory, as is image which processAstrometryResult cannot open
+	if (job->astrometryStat == BAD)
+		moveToBad (job->path);
+	else
+		job->astrometryStat = processAstrometryResult (this, job->path, job->astrometryStat, job->ra, job->dec, job->ra_err, job->dec_err, -1, good_jpeg, trash_jpeg);
+
+	countImage (job->astrometryStat, job->expEnd, job->ra, job->dec, job->ra_err, job->dec_err);
+
+	// continue with reprocessing
+	if (reprocessingPossible && imageGlob.gl_pathc > 0)
+	{
+		globC++;
+		if (globC < imageGlob.gl_pathc)
+		{
+			queImage (imageGlob.gl_pathv[globC]);
+		}
+		else
+		{
+			globfree (&imageGlob);
+			imageGlob.gl_pathc = 0;
+		}
+	}
+
+	if (astrometryPool->getPending () == 0)
+	{
+		int np = numProc->getValueInteger ();
+		int i;
+		for (i = 0; i < np && runningImage[i] == NULL; i++)
+			;
+		if (i == np)
+			maskState (DEVICE_ERROR_MASK | IMGPROC_MASK_RUN, IMGPROC_IDLE);
+	}
+	infoAll ();
+}
+#endif
+
 void ImageProc::changeRunning (ConnProcess * newImage, int slot)
 {
 	int ret;
@@ -584,6 +761,15 @@ int ImageProc::que (ConnProcess * newProc)
 
 int ImageProc::queImage (const char *_path)
 {
+#ifdef RTS2_LIBERFA
+	if (astrometryPool)
+	{
+		astrometryPool->que (new ImageProcJob (this, _path));
+		maskState (DEVICE_ERROR_MASK | IMGPROC_MASK_RUN, IMGPROC_RUN);
+		infoAll ();
+		return 0;
+	}
+#endif
 	ConnImgProcess *newImageConn;
 	newImageConn = new ConnImgProcess (this, defaultImgProcess.c_str (), _path, astrometryTimeout->getValueInteger ());
 	return que (newImageConn);
@@ -624,7 +810,18 @@ int ImageProc::checkNotProcessed ()
 
 	// start files que..
 	if (imageGlob.gl_pathc > 0)
+	{
+#ifdef RTS2_LIBERFA
+		// keep all in-process threads busy
+		if (astrometryPool)
+		{
+			for (; (int) globC < astrometryPool->getThreads () - 1 && globC + 1 < imageGlob.gl_pathc; globC++)
+				queImage (imageGlob.gl_pathv[globC]);
+			return queImage (imageGlob.gl_pathv[globC]);
+		}
+#endif
 		return queImage (imageGlob.gl_pathv[0]);
+	}
 	return 0;
 }
 
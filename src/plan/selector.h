@@ -147,7 +147,7 @@ class Selector
 
 	private:
 		std::vector < TargetEntry* > possibleTargets;
-		void considerTarget (int consider_tar_id, double JD);
+		void considerTarget (rts2db::Target *newTar, double JD);
 		std::vector <char> nightDisabledTypes;
 		void checkTargetObservability ();
 		void checkTargetBonus ();
@@ -25,6 +25,8 @@
 #include "rts2script/simulque.h"
 
 #include "connnotify.h"
+#include "conncompletion.h"
+#include "threadpool.h"
 #include "devclient.h"
 #include "event.h"
 #include "command.h"
@@ -40,6 +42,8 @@
 namespace rts2selector
 {
 
+class SimulateVariantsTask;
+
 class Rts2DevClientTelescopeSel:public rts2core::DevClientTelescope
 {
 	public:
@@ -93,6 +97,8 @@ class SelectorDev:public rts2db::DeviceDb
 
 		virtual void valueChanged (rts2core::Value *value);
 
+		virtual void connectionRemoved (rts2core::Connection *conn);
+
 	private:
 		rts2plan::Selector * sel;
 
@@ -178,6 +184,54 @@ class SelectorDev:public rts2db::DeviceDb
 		bool selFailureReported;
 
 		void updateFlats ();
+
+		// runs simulate_variants command
+		rts2core::ThreadPool *simulPool;
+		rts2core::ConnCompletion *simulCompletion;
+		std::list <SimulateVariantsTask *> simulVariants;
+
+		void initSimulPool ();
+
+		/**
+		 * Log simulated variants and reply to connection which requested them.
+		 */
+		void simulateVariantsCompleted (SimulateVariantsTask *task);
+
+		friend class SimulateVariantsTask;
+};
+
+/**
+ * Runs simulation of queue variants prepared by ExecutorQueue::prepareVariants.
+ */
+class SimulateVariantsTask:public rts2core::PoolTask
+{
+	public:
+		SimulateVariantsTask (SelectorDev *_master, rts2core::Connection *_conn, const char *_name, std::vector <int> &_types, rts2plan::NightSimulator *_sim, rts2core::ThreadPool *_pool):rts2core::PoolTask (), name (_name), types (_types)
+		{
+			master = _master;
+			conn = _conn;
+			sim = _sim;
+			pool = _pool;
+			started = getNow ();
+		}
+
+		virtual ~SimulateVariantsTask () { delete sim; }
+
+		virtual void run () { sim->runParallel (policies, timelines, pool); }
+
+		virtual void completed () { master->simulateVariantsCompleted (this); }
+
+		SelectorDev *master;
+		// connection waiting for reply, NULL if it was removed
+		rts2core::Connection *conn;
+		std::string name;
+		std::vector <int> types;
+		rts2plan::NightSimulator *sim;
+		rts2core::ThreadPool *pool;
+		double started;
+
+		std::vector <rts2plan::SimPolicy> policies;
+		std::vector <rts2plan::SimTimeline> timelines;
 };
 
 }
@@ -198,6 +252,9 @@ SelectorDev::SelectorDev (int argc, char **argv):rts2db::DeviceDb (argc, argv, D
 
 	notifyConn = new rts2core::ConnNotify (this);
 	addConnection (notifyConn);
+
+	simulPool = NULL;
+	simulCompletion = NULL;
 	rts2db::MasterConstraints::setNotifyConnection (notifyConn);
 
 	createValue (next_id, "next_id", "ID of next target for selection", false);
@@ -278,6 +335,8 @@ SelectorDev::SelectorDev (int argc, char **argv):rts2db::DeviceDb (argc, argv, D
 
 SelectorDev::~SelectorDev (void)
 {
+	// finish running simulations
+	delete simulPool;
 	delete sel;
 	delete simulQueue;
 }
@@ -400,9 +459,21 @@ int SelectorDev::init ()
 
 	updateFlats ();
 
+	initSimulPool ();
+
 	return 0;
 }
 
+void SelectorDev::connectionRemoved (rts2core::Connection *conn)
+{
+	for (std::list <SimulateVariantsTask *>::iterator iter = simulVariants.begin (); iter != simulVariants.end (); iter++)
+	{
+		if ((*iter)->conn == conn)
+			(*iter)->conn = NULL;
+	}
+	rts2db::DeviceDb::connectionRemoved (conn);
+}
+
 int SelectorDev::idle ()
 {
 	if (getState () & SEL_SIMULATING)
@@ -957,6 +1028,52 @@ int SelectorDev::commandAuthorized (rts2core::Connection * conn)
 		}
 		return 0;
 	}
+	else if (conn->isCommand ("simulate_variants"))
+	{
+		// simulate queue with different queue types
+		double v_from, v_to;
+		if (conn->paramNextString (&name) || conn->paramNextDouble (&v_from) || conn->paramNextDouble (&v_to))
+			return -2;
+		rts2plan::Queues::iterator qi = findQueue (name);
+		if (qi == queues.end ())
+			return -2;
+		std::vector <int> types;
+		while (!conn->paramEnd ())
+		{
+			int qt;
+			if (conn->paramNextInteger (&qt))
+				return -2;
+			types.push_back (qt);
+		}
+		if (types.empty ())
+			return -2;
+
+		SimulateVariantsTask *task = new SimulateVariantsTask (this, conn, name, types, NULL, simulPool);
+		try
+		{
+			task->sim = qi->prepareVariants (v_from, v_to, types, task->policies);
+		}
+		catch (rts2core::Error &er)
+		{
+			delete task;
+			logStream (MESSAGE_ERROR) << "cannot prepare simulation of queue " << name << ": " << er << sendLog;
+			return -2;
+		}
+
+		// simulation does not access the queue, so it can run while the selector serves other requests
+		if (simulPool && simulPool->submit (task, simulCompletion) == 0)
+		{
+			simulVariants.push_back (task);
+			// reply is sent when simulation finishes
+			return DEVDEM_E_COMMAND;
+		}
+
+		task->run ();
+		task->conn = NULL;
+		simulateVariantsCompleted (task);
+		delete task;
+		return 0;
+	}
 	else if (conn->isCommand ("simulate") || conn->isCommand ("simulate_night"))
 	{
 		double to;
@@ -1109,6 +1226,48 @@ void SelectorDev::updateFlats ()
 	sendValueAll (flatEnding);
 }
 
+void SelectorDev::initSimulPool ()
+{
+	simulPool = new rts2core::ThreadPool ();
+	simulCompletion = new rts2core::ConnCompletion (this);
+	if (simulPool->start () || simulCompletion->init ())
+	{
+		logStream (MESSAGE_WARNING) << "cannot start simulation threads, simulate_variants will block the selector" << sendLog;
+		delete simulPool;
+		delete simulCompletion;
+		simulPool = NULL;
+		simulCompletion = NULL;
+		return;
+	}
+	addConnection (simulCompletion);
+}
+
+void SelectorDev::simulateVariantsCompleted (SimulateVariantsTask *task)
+{
+	simulVariants.remove (task);
+
+	logStream (MESSAGE_INFO) << "simulated " << task->types.size () << " variants of queue " << task->name << " in " << (getNow () - task->started) << " s" << sendLog;
+
+	for (size_t i = 0; i < task->timelines.size (); i++)
+	{
+		double observed = 0;
+		for (rts2plan::SimTimeline::iterator iter = task->timelines[i].begin (); iter != task->timelines[i].end (); iter++)
+		{
+			observed += iter->end - iter->start;
+			logStream (MESSAGE_DEBUG) << "variant " << i << " target " << iter->tar_id << " from " << LibnovaDateDouble (iter->start) << " to " << LibnovaDateDouble (iter->end) << sendLog;
+		}
+		logStream (MESSAGE_INFO) << "variant " << i << " type " << task->types[i] << ": " << task->timelines[i].size () << " observations, " << TimeDiff (0, observed) << " observed" << sendLog;
+	}
+
+	if (task->conn)
+	{
+		if (task->isFailed ())
+			task->conn->sendCommandEnd (DEVDEM_E_SYSTEM, (std::string ("simulation failed: ") + task->getError ()).c_str ());
+		else
+			task->conn->sendCommandEnd (DEVDEM_OK, "OK");
+	}
+}
+
 int main (int argc, char **argv)
 {
 	SelectorDev selector (argc, argv);
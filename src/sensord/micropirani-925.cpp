@@ -20,6 +20,7 @@
 #include "sensord.h"
 
 #include "connection/serial.h"
+#include "connection/async.h"
 
 namespace rts2sensord
 {
@@ -43,8 +44,15 @@ class MicroPirani925: public Sensor
 	private:
 		char *device_file;
 		rts2core::ConnSerial *microConn;
+		rts2core::ConnAsync *asyncConn;
 
 		rts2core::ValueDouble *pressure;
+
+		// true if the last pressure request failed
+		bool readFailed;
+
+		void pressureReceived (const char *reply, size_t len);
+		void pressureFailed (rts2core::AsyncRequest *req, int err);
 };
 
 }
@@ -81,32 +89,68 @@ int MicroPirani925::initHardware ()
 	microConn->flushPortIO ();
 	microConn->setDebug (true);
 
+	asyncConn = new rts2core::ConnAsync (this, microConn, ";FF");
+	addConnection (asyncConn);
+
 	return 0;
 }
 
 int MicroPirani925::info ()
 {
-	int ret;
-	char buf[50];
-	ret = microConn->writeRead ("@253PR1?;FF", 11, buf, 50, ";FF");
-	if (ret < 0)
-		return ret;
-	std::istringstream is (buf + 7);
+	// do not block on the serial port; value is updated when reply arrives
+	if (asyncConn->isIdle ())
+	{
+		asyncConn->queue (new rts2core::AsyncMemberRequest <MicroPirani925> (this, &MicroPirani925::pressureReceived, "@253PR1?;FF", 2, &MicroPirani925::pressureFailed));
+	}
+	else
+	{
+		// previous request is still waiting for reply, value is not current
+		logStream (MESSAGE_DEBUG) << "pressure request is still pending" << sendLog;
+		valueWarning (pressure);
+	}
+	if (readFailed)
+		return -1;
+	return Sensor::info ();
+}
+
+void MicroPirani925::pressureReceived (const char *reply, size_t len)
+{
+	if (len < 7)
+	{
+		logStream (MESSAGE_ERROR) << "too short reply " << reply << sendLog;
+		readFailed = true;
+		valueError (pressure);
+		return;
+	}
+	std::istringstream is (reply + 7);
 	double v;
 	is >> v;
 	if (is.fail ())
 	{
-		logStream (MESSAGE_ERROR) << "failed to parse buffer " << buf << sendLog;
-		return -1;
+		logStream (MESSAGE_ERROR) << "failed to parse buffer " << reply << sendLog;
+		readFailed = true;
+		valueError (pressure);
+		return;
 	}
+	readFailed = false;
 	pressure->setValueDouble (v);
-	return Sensor::info ();
+	valueGood (pressure);
+	sendValueAll (pressure);
+}
+
+void MicroPirani925::pressureFailed (rts2core::AsyncRequest *req, int err)
+{
+	logStream (MESSAGE_ERROR) << "cannot read pressure: " << strerror (err) << sendLog;
+	readFailed = true;
+	valueError (pressure);
 }
 
 MicroPirani925::MicroPirani925 (int argc, char **argv): Sensor (argc, argv)
 {
 	device_file = NULL;
 	microConn = NULL;
+	asyncConn = NULL;
+	readFailed = false;
 
 	createValue (pressure, "pressure", "sensor pressure", true);
 
@@ -0,0 +1,44 @@
+-- sky pixels for indexed cone searches, see include/skypix.h
+-- ra, dec
+CREATE OR REPLACE FUNCTION sky_pixel (float8, float8)
+  RETURNS int4 AS 'pg_astrolib.so', 'sky_pixel' LANGUAGE 'c' IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION img_wcs2_radius (wcs2)
+  RETURNS float8 AS 'pg_wcs2.so', 'img_wcs2_radius' LANGUAGE 'c' IMMUTABLE STRICT;
+
+ALTER TABLE targets ADD COLUMN tar_pix integer;
+
+CREATE OR REPLACE FUNCTION targets_sky_pixel () RETURNS trigger AS '
+BEGIN
+	NEW.tar_pix := sky_pixel (NEW.tar_ra, NEW.tar_dec);
+	RETURN NEW;
+END;
+' LANGUAGE 'plpgsql';
+
+CREATE TRIGGER targets_sky_pixel BEFORE INSERT OR UPDATE ON targets
+  FOR EACH ROW EXECUTE PROCEDURE targets_sky_pixel ();
+
+UPDATE targets SET tar_pix = sky_pixel (tar_ra, tar_dec);
+
+CREATE INDEX targets_tar_pix ON targets (tar_pix);
+
+-- pixel of image reference point and maximal distance of image point from it
+ALTER TABLE images ADD COLUMN img_pix integer;
+ALTER TABLE images ADD COLUMN img_radius float8;
+
+CREATE OR REPLACE FUNCTION images_sky_pixel () RETURNS trigger AS '
+BEGIN
+	NEW.img_pix := sky_pixel (img_wcs2_center_ra (NEW.astrometry), img_wcs2_center_dec (NEW.astrometry));
+	NEW.img_radius := img_wcs2_radius (NEW.astrometry);
+	RETURN NEW;
+END;
+' LANGUAGE 'plpgsql';
+
+CREATE TRIGGER images_sky_pixel BEFORE INSERT OR UPDATE ON images
+  FOR EACH ROW EXECUTE PROCEDURE images_sky_pixel ();
+
+-- trigger fills pixels of existing images
+UPDATE images SET img_pix = NULL WHERE astrometry IS NOT NULL;
+
+CREATE INDEX images_img_pix ON images (img_pix);
+CREATE INDEX images_img_radius ON images (img_radius);
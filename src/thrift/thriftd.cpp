@@ -21,11 +21,13 @@
 
 #include <pthread.h>
 #include "device.h"
+#include "connmailbox.h"
+#include "snapshot.h"
 #include <libnova/libnova.h>
 
 #include "ObservatoryService.h"
 #include <thrift/protocol/TBinaryProtocol.h>
-#include <thrift/server/TSimpleServer.h>
+#include <thrift/server/TThreadedServer.h>
 #include <thrift/transport/TServerSocket.h>
 #include <thrift/transport/TBufferTransports.h>
 
@@ -39,15 +41,23 @@ using boost::shared_ptr;
 using namespace  ::rts2;
 
 // RTS2 thrift service..
+//
+// Thrift server threads do not touch the device - they read snapshots
+// published from idle and post commands to the mailbox.
 class ThriftD: public rts2core::Device
 {
 	public:
 		ThriftD (int argc, char **argv);
 		virtual int idle ();
 
-		MountInfo mountInfo;
-		DerotatorInfo derotatorInfo;
-		DomeInfo domeInfo;
+		rts2core::Snapshot <MountInfo> mountInfo;
+		rts2core::Snapshot <DerotatorInfo> derotatorInfo;
+		rts2core::Snapshot <DomeInfo> domeInfo;
+
+		/**
+		 * Queue command from Thrift thread.
+		 */
+		template <typename T> void postCommand (int deviceType, T *command) { mailbox->queueCommandForType (deviceType, command); }
 
 	protected:
 		virtual int init ();
@@ -55,6 +65,12 @@ class ThriftD: public rts2core::Device
 
 	private:
 		pthread_t thrift_thr;
+		rts2core::ConnMailbox *mailbox;
+
+		// written only from the event loop
+		MountInfo mount;
+		DerotatorInfo derotator;
+		DomeInfo dome;
 };
 
 ThriftD *rts2Device;
@@ -65,56 +81,49 @@ class ObservatoryServiceHandler : virtual public ObservatoryServiceIf {
 		}
 
 		void infoMount(MountInfo& _return) {
-			_return = rts2Device->mountInfo;
+			rts2Device->mountInfo.read (_return);
 		}
 
 		void infoDerotator(DerotatorInfo& _return) {
-			_return = rts2Device->derotatorInfo;
+			rts2Device->derotatorInfo.read (_return);
 		}
 
 		void infoDome(DomeInfo& _return) {
-			_return = rts2Device->domeInfo;
+			rts2Device->domeInfo.read (_return);
 		}
 
 		int32_t Slew(const RaDec& target) {
-			rts2core::CommandMove cmd (rts2Device, NULL, target.ra, target.dec);
-			rts2Device->queueCommandForType (DEVICE_TYPE_MOUNT, cmd);
+			rts2Device->postCommand (DEVICE_TYPE_MOUNT, new rts2core::CommandMove (rts2Device, NULL, target.ra, target.dec));
 			return 0;
 		}
 
 		int32_t AdjustRADec(const RaDec& delta) {
-			rts2core::CommandChangeValue cmd (rts2Device, "OFFS", '+', delta.ra, delta.dec);
-			rts2Device->queueCommandForType (DEVICE_TYPE_MOUNT, cmd);
+			rts2Device->postCommand (DEVICE_TYPE_MOUNT, new rts2core::CommandChangeValue (rts2Device, "OFFS", '+', delta.ra, delta.dec));
 			return 0;
 		}
 
 		int32_t SlewAltAz(const AltAz& pos) {
-			rts2core::CommandMoveAltAz cmd (rts2Device, NULL, pos.alt, pos.az);
-			rts2Device->queueCommandForType (DEVICE_TYPE_MOUNT, cmd);
+			rts2Device->postCommand (DEVICE_TYPE_MOUNT, new rts2core::CommandMoveAltAz (rts2Device, NULL, pos.alt, pos.az));
 			return 0;
 		}
 
 		int32_t AdjustAltAz(const AltAz& delta) {
-			rts2core::CommandChangeValue cmd (rts2Device, "AZALOFFS", '+', delta.alt, delta.az);
-			rts2Device->queueCommandForType (DEVICE_TYPE_MOUNT, cmd);
+			rts2Device->postCommand (DEVICE_TYPE_MOUNT, new rts2core::CommandChangeValue (rts2Device, "AZALOFFS", '+', delta.alt, delta.az));
 			return 0;
 		}
 
 		int32_t RotateDome(const double angle) {
-			rts2core::CommandMoveAz cmd (rts2Device, angle);
-			rts2Device->queueCommandForType (DEVICE_TYPE_CUPOLA, cmd);
+			rts2Device->postCommand (DEVICE_TYPE_CUPOLA, new rts2core::CommandMoveAz (rts2Device, angle));
 			return 0;
 		}
 
 		int32_t TrackType(const rts2::TrackType::type val) {
-			rts2core::CommandChangeValue cmd (rts2Device, "TRACKING", '=', val);
-			rts2Device->queueCommandForType (DEVICE_TYPE_MOUNT, cmd);
+			rts2Device->postCommand (DEVICE_TYPE_MOUNT, new rts2core::CommandChangeValue (rts2Device, "TRACKING", '=', val));
 			return 0;
 		}
 
 		int32_t NonSiderealParams(const RaDec &ns_diff) {
-			rts2core::CommandChangeValue cmd (rts2Device, "DRATE", '=', ns_diff.ra, ns_diff.dec);
-			rts2Device->queueCommandForType (DEVICE_TYPE_MOUNT, cmd);
+			rts2Device->postCommand (DEVICE_TYPE_MOUNT, new rts2core::CommandChangeValue (rts2Device, "DRATE", '=', ns_diff.ra, ns_diff.dec));
 			return 0;
 		}
 
@@ -127,8 +136,7 @@ class ObservatoryServiceHandler : virtual public ObservatoryServiceIf {
 		}
 
 		int32_t Park() {
-			rts2core::Command cmd (rts2Device, COMMAND_TELD_PARK);
-			rts2Device->queueCommandForType (DEVICE_TYPE_MOUNT, cmd);
+			rts2Device->postCommand (DEVICE_TYPE_MOUNT, new rts2core::Command (rts2Device, COMMAND_TELD_PARK));
 			return 0;
 		}
 
@@ -137,26 +145,22 @@ class ObservatoryServiceHandler : virtual public ObservatoryServiceIf {
 		}
 
 		int32_t DomeLights(bool val) {
-			rts2core::CommandChangeValue cmd (rts2Device, "lights", '=', val);
-			rts2Device->queueCommandForType (DEVICE_TYPE_CUPOLA, cmd);
+			rts2Device->postCommand (DEVICE_TYPE_CUPOLA, new rts2core::CommandChangeValue (rts2Device, "lights", '=', val));
 			return 0;
 		}
 
 		int32_t DomeShutters(bool val) {
-			rts2core::Command cmd (rts2Device, val ? COMMAND_OPEN : COMMAND_CLOSE);
-			rts2Device->queueCommandForType (DEVICE_TYPE_CUPOLA, cmd);
+			rts2Device->postCommand (DEVICE_TYPE_CUPOLA, new rts2core::Command (rts2Device, val ? COMMAND_OPEN : COMMAND_CLOSE));
 			return 0;
 		}
 
 		int32_t MirrorCovers(bool val) {
-			rts2core::Command cmd (rts2Device, val ? COMMAND_OPEN : COMMAND_CLOSE);
-			rts2Device->queueCommandForType (DEVICE_TYPE_SENSOR, cmd);
+			rts2Device->postCommand (DEVICE_TYPE_SENSOR, new rts2core::Command (rts2Device, val ? COMMAND_OPEN : COMMAND_CLOSE));
 			return 0;
 		}
 
 		int32_t SelectPort(int32_t port) {
-			rts2core::CommandChangeValue cmd (rts2Device, "MIRP", '=', port);
-			rts2Device->queueCommandForType (DEVICE_TYPE_MIRROR, cmd);
+			rts2Device->postCommand (DEVICE_TYPE_MIRROR, new rts2core::CommandChangeValue (rts2Device, "MIRP", '=', port));
 			return 0;
 		}
 
@@ -165,17 +169,17 @@ class ObservatoryServiceHandler : virtual public ObservatoryServiceIf {
 		}
 
 		int32_t Abort() {
-			rts2core::Command cmd (rts2Device, COMMAND_STOP);
-			rts2Device->queueCommandForType (DEVICE_TYPE_MOUNT, cmd);
-			rts2Device->queueCommandForType (DEVICE_TYPE_CUPOLA, cmd);
-			rts2Device->queueCommandForType (DEVICE_TYPE_DOME, cmd);
-			rts2Device->queueCommandForType (DEVICE_TYPE_ROTATOR, cmd);
+			rts2Device->postCommand (DEVICE_TYPE_MOUNT, new rts2core::Command (rts2Device, COMMAND_STOP));
+			rts2Device->postCommand (DEVICE_TYPE_CUPOLA, new rts2core::Command (rts2Device, COMMAND_STOP));
+			rts2Device->postCommand (DEVICE_TYPE_DOME, new rts2core::Command (rts2Device, COMMAND_STOP));
+			rts2Device->postCommand (DEVICE_TYPE_ROTATOR, new rts2core::Command (rts2Device, COMMAND_STOP));
 			return 0;
 		}
 };
 
 ThriftD::ThriftD (int argc, char **argv): rts2core::Device (argc, argv, DEVICE_TYPE_THRIFT, "THRIFT")
 {
+	mailbox = NULL;
 }
 
 void *thrift_thread (void *args)
@@ -187,7 +191,8 @@ void *thrift_thread (void *args)
 	shared_ptr<TTransportFactory> transportFactory(new TBufferedTransportFactory());
 	shared_ptr<TProtocolFactory> protocolFactory(new TBinaryProtocolFactory());
 
-	TSimpleServer server(processor, serverTransport, transportFactory, protocolFactory);
+	// each client is served by its own thread
+	TThreadedServer server(processor, serverTransport, transportFactory, protocolFactory);
 	server.serve();
 	return NULL;
 }
@@ -202,6 +207,16 @@ int ThriftD::init ()
 	if (ret)
 		return ret;
 
+	mailbox = new rts2core::ConnMailbox (this);
+	ret = mailbox->init ();
+	if (ret)
+	{
+		delete mailbox;
+		mailbox = NULL;
+		return ret;
+	}
+	addConnection (mailbox);
+
 	pthread_create (&thrift_thr, NULL, &thrift_thread, NULL);
 	return 0;
 }
@@ -219,49 +234,49 @@ int ThriftD::idle ()
 		val = telConn->getValue ("infotime");
 		if (val != NULL)
 		{
-			mountInfo.infotime = val->getValueDouble ();
+			mount.infotime = val->getValueDouble ();
 		}
 		raDec = dynamic_cast<rts2core::ValueRaDec *> (telConn->getValue ("ORI"));
 		if (raDec != NULL)
 		{
-			mountInfo.ORI.ra = raDec->getRa ();
-			mountInfo.ORI.dec = raDec->getDec ();
+			mount.ORI.ra = raDec->getRa ();
+			mount.ORI.dec = raDec->getDec ();
 		}
 		raDec = dynamic_cast<rts2core::ValueRaDec *> (telConn->getValue ("OFFS"));
 		if (raDec != NULL)
 		{
-			mountInfo.offsets.ra = raDec->getRa ();
-			mountInfo.offsets.dec = raDec->getDec ();
+			mount.offsets.ra = raDec->getRa ();
+			mount.offsets.dec = raDec->getDec ();
 		}
 		raDec = dynamic_cast<rts2core::ValueRaDec *> (telConn->getValue ("TEL"));
 		if (raDec != NULL)
 		{
-			mountInfo.TEL.ra = raDec->getRa ();
-			mountInfo.TEL.dec = raDec->getDec ();
+			mount.TEL.ra = raDec->getRa ();
+			mount.TEL.dec = raDec->getDec ();
 		}
 		altAz = dynamic_cast<rts2core::ValueAltAz *> (telConn->getValue ("TEL_"));
 		if (altAz != NULL)
 		{
-			mountInfo.HRZ.alt = altAz->getAlt ();
-			mountInfo.HRZ.az = ln_range_degrees (altAz->getAz () + 180.0);
+			mount.HRZ.alt = altAz->getAlt ();
+			mount.HRZ.az = ln_range_degrees (altAz->getAz () + 180.0);
 		}
 		altAz = dynamic_cast<rts2core::ValueAltAz *> (telConn->getValue ("AZALOFFS"));
 		if (altAz != NULL)
 		{
-			mountInfo.altAzOffsets.alt = altAz->getAlt ();
-			mountInfo.altAzOffsets.az = ln_range_degrees (altAz->getAz () + 180.0);
+			mount.altAzOffsets.alt = altAz->getAlt ();
+			mount.altAzOffsets.az = ln_range_degrees (altAz->getAz () + 180.0);
 		}
 		val = telConn->getValue ("JD");
 		if (val != NULL)
 		{
-			mountInfo.JulianDay = val->getValueDouble ();
+			mount.JulianDay = val->getValueDouble ();
 		}
 		val = telConn->getValue ("TRACKING");
 		if (val != NULL)
 		{
-			mountInfo.TrackingType = rts2::TrackType::type (val->getValueInteger ());
+			mount.TrackingType = rts2::TrackType::type (val->getValueInteger ());
 		}
-		mountInfo.slewing = ((telConn->getState () & TEL_MASK_MOVING) == TEL_MOVING) || ((telConn->getState () & TEL_MASK_MOVING) == TEL_PARKING);
+		mount.slewing = ((telConn->getState () & TEL_MASK_MOVING) == TEL_MOVING) || ((telConn->getState () & TEL_MASK_MOVING) == TEL_PARKING);
 	}
 	rts2core::Connection *cupConn = getOpenConnection (DEVICE_TYPE_CUPOLA);
 	if (cupConn != NULL)
@@ -269,25 +284,29 @@ int ThriftD::idle ()
 		val = cupConn->getValue ("lights");
 		if (val != NULL)
 		{
-			domeInfo.lights = val->getValueInteger ();
+			dome.lights = val->getValueInteger ();
 		}
 		val = cupConn->getValue ("shutter_closed");
 		if (val != NULL && val->getValueInteger ())
 		{
-			domeInfo.domeshutters = 0;
+			dome.domeshutters = 0;
 		}
 		val = cupConn->getValue ("shutter_opened");
 		if (val != NULL && val->getValueInteger ())
 		{
-			domeInfo.domeshutters = 1;
+			dome.domeshutters = 1;
 		}
 		val = cupConn->getValue ("CUP_AZ");
 		if (val != NULL)
 		{
-			domeInfo.DomeAngle = ln_range_degrees (val->getValueDouble () + 180.0);
+			dome.DomeAngle = ln_range_degrees (val->getValueDouble () + 180.0);
 		}
 	}
-	
+
+	mountInfo.publish (mount);
+	derotatorInfo.publish (derotator);
+	domeInfo.publish (dome);
+
 	return Device::idle ();
 }
 